@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <mutex>
+#include <vector>
 #include <TaskSchedulerDeclarations.h>
 
 #include "BatteryStats.h"
@@ -22,14 +23,30 @@ public:
     void init(Scheduler&);
     void updateSettings();
 
+    // if several batteries are used, the combined view of all of them is
+    // returned. the individual batteries are included in its live view data.
     std::shared_ptr<BatteryStats const> getStats() const;
 
+    size_t getPackCount() const;
+
 private:
+    // hardware used by the providers created so far
+    struct Resources {
+        bool twai = false;
+        bool mcp2515 = false;
+        bool serialPins = false;
+        bool mqtt = false;
+    };
+
     void loop();
+    std::unique_ptr<BatteryProvider> createProvider(uint8_t provider,
+            bool verboseLogging, Resources& used);
 
     Task _loopTask;
     mutable std::mutex _mutex;
-    std::unique_ptr<BatteryProvider> _upProvider = nullptr;
+    std::vector<std::unique_ptr<BatteryProvider>> _providers;
+    std::vector<AggregatedBatteryStats::Pack> _packs;
+    std::shared_ptr<AggregatedBatteryStats> _spAggregatedStats = nullptr;
 };
 
 extern BatteryClass Battery;
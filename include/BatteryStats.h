@@ -8,6 +8,8 @@
 #include "JkBmsDataPoints.h"
 #include "VeDirectShuntController.h"
 #include <cfloat>
+#include <memory>
+#include <vector>
 
 // mandatory interface for all kinds of batteries
 class BatteryStats {
@@ -43,6 +45,9 @@ class BatteryStats {
         virtual float getChargeCurrent() const { return 0; };
         virtual float getChargeCurrentLimitation() const { return FLT_MAX; };
 
+        // the maximum current the battery (BMS) allows to be drawn from it
+        virtual float getDischargeCurrentLimitation() const { return FLT_MAX; };
+
     protected:
         virtual void mqttPublish() const;
 
@@ -78,6 +83,7 @@ class PylontechBatteryStats : public BatteryStats {
         bool getImmediateChargingRequest() const { return _chargeImmediately; } ;
         float getChargeCurrent() const { return _current; } ;
         float getChargeCurrentLimitation() const { return _chargeCurrentLimitation; } ;
+        float getDischargeCurrentLimitation() const final { return _dischargeCurrentLimitation; }
 
     private:
         void setManufacturer(String&& m) { _manufacturer = std::move(m); }
@@ -85,7 +91,7 @@ class PylontechBatteryStats : public BatteryStats {
 
         float _chargeVoltage;
         float _chargeCurrentLimitation;
-        float _dischargeCurrentLimitation;
+        float _dischargeCurrentLimitation = FLT_MAX; // until reported by the BMS
         uint16_t _stateOfHealth;
         // total current into (positive) or from (negative)
         // the battery, i.e., the charging current
@@ -127,6 +133,9 @@ class JkBmsBatteryStats : public BatteryStats {
 
         uint32_t getMqttFullPublishIntervalMs() const final { return 60 * 1000; }
 
+        float getChargeCurrent() const final;
+        float getDischargeCurrentLimitation() const final;
+
         void updateFrom(JkBms::DataPointContainer const& dp);
 
     private:
@@ -147,6 +156,8 @@ class VictronSmartShuntStats : public BatteryStats {
         void getLiveViewData(JsonVariant& root) const final;
         void mqttPublish() const final;
 
+        float getChargeCurrent() const final { return _current; }
+
         void updateFrom(VeDirectShuntController::data_t const& shuntData);
 
     private:
@@ -181,3 +192,37 @@ class MqttBatteryStats : public BatteryStats {
         // card in the live view, since the SoC is already displayed at the top
         void getLiveViewData(JsonVariant& root) const final { }
 };
+
+// combined view of several batteries (packs) connected in parallel. the
+// instance is not modified once published, a new one is created for updates.
+class AggregatedBatteryStats : public BatteryStats {
+    public:
+        struct Pack {
+            std::shared_ptr<BatteryStats const> stats;
+            float capacityAmpHours; // zero if unknown
+            // measures the current of all packs, e.g., a shunt. its current
+            // replaces the sum of the packs' currents.
+            bool currentSensor;
+        };
+
+        void getLiveViewData(JsonVariant& root) const final;
+        void mqttPublish() const final;
+
+        bool getImmediateChargingRequest() const final { return _chargeImmediately; }
+        float getChargeCurrent() const final { return _current; }
+        float getChargeCurrentLimitation() const final { return _chargeCurrentLimitation; }
+        float getDischargeCurrentLimitation() const final { return _dischargeCurrentLimitation; }
+
+        bool packsUpdated(std::vector<Pack> const& packs) const;
+        void updateFrom(std::vector<Pack> const& packs);
+
+    private:
+        static float getFreshnessWeight(uint32_t ageSeconds);
+
+        std::vector<Pack> _packs;
+        uint32_t _lastAggregation = 0;
+        float _current = 0;
+        float _chargeCurrentLimitation = FLT_MAX;
+        float _dischargeCurrentLimitation = FLT_MAX;
+        bool _chargeImmediately = false;
+};
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+#include <array>
+#include <map>
+#include <mutex>
+#include <optional>
+
+class CommandLatencyClass {
+public:
+    void init(Scheduler& scheduler);
+
+    // to be called by the DPL as soon as it decided to change the limit or
+    // power state of the given inverter. the next command(s) acknowledged by
+    // that inverter will be accounted for starting at that point in time.
+    void notifyDecision(uint64_t serial, uint32_t decisionMillis);
+
+    enum class Kind : uint8_t {
+        Limit = 0,
+        Power,
+        Count
+    };
+
+    enum class Stage : uint8_t {
+        Decision = 0, // DPL decision until the command is enqueued
+        Queue, // command enqueued until first sent over the radio
+        Radio, // first sent until acknowledged (includes retransmits)
+        Statistics, // acknowledged until the statistics show the commanded state
+        Total, // DPL decision (or enqueue) until the commanded state is shown
+        Count
+    };
+
+    static char const* getKindName(Kind kind);
+    static char const* getStageName(Stage stage);
+
+    class Histogram {
+    public:
+        static constexpr size_t BoundCount = 10;
+        static constexpr std::array<uint32_t, BoundCount> Bounds = {
+            50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 30000
+        };
+
+        void add(uint32_t valueMs);
+
+        // cumulative count of values less than or equal to the respective
+        // bound, the last element is the total count (+Inf bucket).
+        std::array<uint32_t, BoundCount + 1> getCumulativeCounts() const;
+        uint32_t getCount() const { return _count; }
+        uint64_t getSum() const { return _sum; }
+        uint32_t getMax() const { return _max; }
+
+    private:
+        std::array<uint32_t, BoundCount + 1> _buckets = {};
+        uint32_t _count = 0;
+        uint64_t _sum = 0;
+        uint32_t _max = 0;
+    };
+
+    struct KindStatistics {
+        std::array<Histogram, static_cast<size_t>(Stage::Count)> stages;
+        uint32_t commands = 0;
+        uint32_t resends = 0;
+        uint32_t retransmits = 0;
+        uint32_t unsettled = 0; // commanded state not shown within the timeout
+
+        Histogram const& get(Stage stage) const { return stages[static_cast<size_t>(stage)]; }
+    };
+
+    struct InverterStatistics {
+        std::array<KindStatistics, static_cast<size_t>(Kind::Count)> kinds;
+
+        KindStatistics const& get(Kind kind) const { return kinds[static_cast<size_t>(kind)]; }
+    };
+
+    // returns a copy of the statistics of all inverters, keyed by serial
+    std::map<uint64_t, InverterStatistics> getStatistics() const;
+
+private:
+    void loop();
+
+    Task _loopTask;
+
+    struct KindState {
+        uint32_t lastAcknowledged = 0;
+        std::optional<uint32_t> oDecisionMillis = std::nullopt;
+        std::optional<uint32_t> oPendingAckMillis = std::nullopt;
+        uint32_t pendingStartMillis = 0;
+
+        // W, the AC power to be reached for a limit command (unknown if the
+        // inverter's max power is unknown), or whether the inverter shall
+        // produce for a power command
+        std::optional<float> oTargetPower = std::nullopt;
+        bool targetProducing = true;
+    };
+
+    struct InverterState {
+        std::array<KindState, static_cast<size_t>(Kind::Count)> kinds;
+    };
+
+    std::map<uint64_t, InverterState> _states;
+    std::map<uint64_t, InverterStatistics> _statistics;
+
+    mutable std::mutex _mutex;
+};
+
+extern CommandLatencyClass CommandLatency;
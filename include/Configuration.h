@@ -1,10 +1,15 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "ConfigurationStore.h"
 #include "PinMapping.h"
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 
 #define CONFIG_FILENAME "/config.json"
+#define CONFIG_STORE_FILENAME "/config.bin"
 #define CONFIG_VERSION 0x00011c00 // 0.1.28 // make sure to clean all after change
 
 #define WIFI_MAX_SSID_STRLEN 32
@@ -30,6 +35,10 @@
 
 #define DEV_MAX_MAPPING_NAME_STRLEN 63
 
+#define BATTERY_PROVIDER_COUNT 4
+#define BATTERY_PROVIDER_NONE 255
+#define BATTERY_MAX_ADDITIONAL 3
+
 #define POWERMETER_MAX_PHASES 3
 #define POWERMETER_MAX_HTTP_URL_STRLEN 1024
 #define POWERMETER_MAX_USERNAME_STRLEN 64
@@ -38,6 +47,10 @@
 #define POWERMETER_MAX_HTTP_HEADER_VALUE_STRLEN 256
 #define POWERMETER_MAX_HTTP_JSON_PATH_STRLEN 256
 #define POWERMETER_HTTP_TIMEOUT 1000
+#define POWERMETER_SML_MAX_METERS 2
+#define POWERMETER_SML_MAX_OBIS 16
+#define POWERMETER_MAX_SOURCES 3
+#define POWERMETER_SOURCE_NONE 255
 
 #define JSON_BUFFER_SIZE 15360
 
@@ -75,6 +88,18 @@ struct POWERMETER_HTTP_PHASE_CONFIG_T {
     char JsonPath[POWERMETER_MAX_HTTP_JSON_PATH_STRLEN + 1];
 };
 
+struct POWERMETER_SML_OBIS_CONFIG_T {
+    uint8_t Meter; // index of the SML meter
+    uint8_t Value; // SmlMeter::Value, None if the entry is not used
+    uint8_t Obis[6];
+};
+
+struct BATTERY_ADDITIONAL_CONFIG_T {
+    uint8_t Provider; // BATTERY_PROVIDER_NONE if the entry is not used
+    bool CurrentSensor; // measures the current of all packs, e.g., a shunt
+    uint16_t CapacityAmpHours; // zero if unknown
+};
+
 struct CONFIG_T {
     struct {
         uint32_t Version;
@@ -117,6 +142,7 @@ struct CONFIG_T {
         char Topic[MQTT_MAX_TOPIC_STRLEN + 1];
         bool Retain;
         uint32_t PublishInterval;
+        uint32_t TaskStatsInterval; // s, zero disables publishing the task statistics
         bool CleanSession;
 
         struct {
@@ -182,6 +208,7 @@ struct CONFIG_T {
         bool Enabled;
         bool VerboseLogging;
         bool UpdatesOnly;
+        uint16_t UdpPort;
     } Vedirect;
 
     struct {
@@ -196,7 +223,15 @@ struct CONFIG_T {
         uint32_t SdmAddress;
         uint32_t HttpInterval;
         bool HttpIndividualRequests;
+        uint32_t SmaHmSerial; // zero to use the first meter seen
+        uint8_t FilterMode; // PowerMeterFilter::Mode
+        uint8_t FilterWindow;
+        float FilterHampelThreshold;
+        uint32_t FilterTimeConstant; // ms, zero to disable the smoothing
+        uint8_t FailoverSources[POWERMETER_MAX_SOURCES - 1]; // by priority, POWERMETER_SOURCE_NONE if not used
+        uint32_t FusionTimeConstant; // ms, zero to disable the fusion
         POWERMETER_HTTP_PHASE_CONFIG_T Http_Phase[POWERMETER_MAX_PHASES];
+        POWERMETER_SML_OBIS_CONFIG_T Sml_Obis[POWERMETER_SML_MAX_OBIS];
     } PowerMeter;
 
     struct {
@@ -220,16 +255,21 @@ struct CONFIG_T {
         float VoltageStartThreshold;
         float VoltageStopThreshold;
         float VoltageLoadCorrectionFactor;
+        bool VoltageLoadCorrectionAuto;
         int8_t RestartHour;
         uint32_t FullSolarPassThroughSoc;
         float FullSolarPassThroughStartVoltage;
         float FullSolarPassThroughStopVoltage;
+        bool UseBatteryDischargeLimit;
+        uint8_t BatteryDischargeLimitMargin;
     } PowerLimiter;
 
     struct {
         bool Enabled;
         bool VerboseLogging;
         uint8_t Provider;
+        uint16_t CapacityAmpHours; // of the primary battery, zero if unknown
+        BATTERY_ADDITIONAL_CONFIG_T Additional[BATTERY_MAX_ADDITIONAL];
         uint8_t JkBmsInterface;
         uint8_t JkBmsPollingInterval;
         char MqttSocTopic[MQTT_MAX_TOPIC_STRLEN + 1];
@@ -245,6 +285,10 @@ struct CONFIG_T {
         float Auto_Power_Enable_Voltage_Limit;
         float Auto_Power_Lower_Power_Limit;
         float Auto_Power_Upper_Power_Limit;
+        float Auto_Power_Target_Grid_Power;
+        float Auto_Power_Deadband;
+        float Auto_Power_Proportional_Gain;
+        float Auto_Power_Integral_Gain;
     } Huawei;
 
 
@@ -252,6 +296,28 @@ struct CONFIG_T {
     char Dev_PinMapping[DEV_MAX_MAPPING_NAME_STRLEN + 1];
 };
 
+/**
+ * immutable copy of the configuration sections read by the control loops.
+ * the members are named like the respective members of CONFIG_T, such that
+ * code can use either of them. the PowerMeter section is large (HTTP URLs
+ * and headers), so only its scalar settings are part of the snapshot.
+ */
+struct CONFIG_SNAPSHOT_T {
+    uint32_t Version; // incremented whenever a changed snapshot is published
+
+    struct {
+        bool Enabled;
+        bool VerboseLogging;
+        uint32_t Interval;
+        uint32_t Source;
+    } PowerMeter;
+
+    decltype(CONFIG_T::Vedirect) Vedirect;
+    decltype(CONFIG_T::PowerLimiter) PowerLimiter;
+    decltype(CONFIG_T::Battery) Battery;
+    decltype(CONFIG_T::Huawei) Huawei;
+};
+
 class ConfigurationClass {
 public:
     void init();
@@ -260,9 +326,37 @@ public:
     void migrate();
     CONFIG_T& get();
 
+    // returns the most recently published snapshot. it is never modified,
+    // so it may be used without further synchronization for as long as the
+    // shared pointer is held, even while the configuration is changed.
+    // a snapshot is published by read(), write() and init().
+    std::shared_ptr<CONFIG_SNAPSHOT_T const> getSnapshot() const;
+
+    // cheap check whether a snapshot held by the caller is outdated
+    uint32_t getSnapshotVersion() const { return _snapshotVersion.load(); }
+
+    // the configuration is stored in a binary file. the JSON file is only
+    // written on request, i.e., to download it as a backup, before a firmware
+    // update is activated and after a migration. it is read to convert the
+    // configuration if the binary file is missing or was written by another
+    // firmware using a different layout.
+    bool writeJson();
+
     INVERTER_CONFIG_T* getFreeInverterSlot();
     INVERTER_CONFIG_T* getInverterConfig(const uint64_t serial);
     void deleteInverterById(const uint8_t id);
+
+private:
+    bool readJson(bool fromFile);
+    void publishSnapshot();
+
+    ConfigurationStore _store;
+
+    std::mutex _jsonMutex; // serializes writers of the JSON file
+
+    std::mutex _snapshotMutex; // serializes publishers only
+    std::shared_ptr<CONFIG_SNAPSHOT_T const> _spSnapshot;
+    std::atomic<uint32_t> _snapshotVersion { 0 };
 };
 
 extern ConfigurationClass Configuration;
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <FS.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+struct CONFIG_T;
+
+/**
+ * stores the configuration in a binary file, which is split into sections,
+ * one per top-level member of CONFIG_T. each section has two slots, each
+ * protected by a CRC and a sequence number. a section is written to the slot
+ * not holding its current data, so an interrupted write leaves the previous
+ * data intact. only sections which changed since they were last read or
+ * written are written.
+ *
+ * the file starts with a table of the sections (id, size and layout
+ * version). a section whose size or layout version changed (firmware update)
+ * is not loaded, but all other sections still are. in that case, the next
+ * write re-creates the file. the layout version of a section must be
+ * incremented whenever its members change in a way which keeps its size,
+ * e.g., if members are reordered, retyped or fit into padding bytes.
+ */
+class ConfigurationStore {
+public:
+    static constexpr size_t SectionCount = 16;
+    static constexpr uint32_t AllSections = (1UL << SectionCount) - 1;
+    static constexpr uint32_t CfgSection = 1UL << 0; // holds CONFIG_T::Cfg
+
+    // checks the binary file, without modifying the configuration. returns a
+    // bitmask of the sections which are available (bit n for section n).
+    uint32_t check();
+
+    // the configuration version the binary file was written with
+    uint32_t getVersion() const { return _version; }
+
+    // false if the binary file is missing or was written by another firmware
+    // version or using another layout of any section, as found by check().
+    bool isLayoutCurrent() const { return _layoutMatches; }
+
+    // loads the given sections into the configuration. check() must be
+    // called before. returns a bitmask of the sections actually loaded.
+    uint32_t load(CONFIG_T& config, uint32_t sections);
+
+    // writes all sections which changed since they were last read or written
+    bool save(CONFIG_T const& config);
+
+private:
+    struct Section {
+        uint16_t id;
+        uint16_t layout;
+        size_t offset; // within CONFIG_T
+        uint16_t size;
+    };
+
+    static const std::array<Section, SectionCount> _sections;
+
+    struct SectionState {
+        bool valid = false;
+        uint32_t filePosition = 0; // of the first slot
+        uint8_t slot = 0; // holding the current data
+        uint32_t sequence = 0;
+        uint32_t crc = 0;
+    };
+
+    bool findSlot(File& f, size_t idx, uint16_t storedSize, uint32_t position);
+    bool rewrite(CONFIG_T const& config);
+    static uint32_t calcCrc(File& f, uint16_t size);
+
+    std::mutex _mutex; // serializes access to the file and the states
+    std::array<SectionState, SectionCount> _states;
+    uint32_t _version = 0;
+    bool _layoutMatches = false;
+};
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+struct tinfl_decompressor_tag;
+
+/**
+ * creates a firmware image from the running firmware's image (the source)
+ * and a delta, as created by pio-scripts/create_delta_bin.py. the delta is
+ * processed as it is received, i.e., neither the delta nor the new image
+ * (the target) need to be kept in memory.
+ *
+ * the delta starts with a header, followed by a zlib stream of instructions.
+ * an instruction starts with a control block of three 32 bit values, the
+ * diff length, the extra length and the seek offset. it is followed by "diff
+ * length" bytes, which are added to the respective bytes of the source
+ * image, and "extra length" bytes, which are copied as they are. afterwards,
+ * the position within the source image is moved by the seek offset.
+ */
+class DeltaPatcher {
+public:
+    using Reader = std::function<bool(size_t offset, uint8_t* data, size_t len)>;
+    using Writer = std::function<bool(uint8_t const* data, size_t len)>;
+    using Verifier = std::function<bool(size_t size, uint8_t const* sha256)>;
+
+    // the reader provides the source image, the writer receives the target
+    // image and the verifier checks whether the source image is the one the
+    // delta was created for, given its size and SHA-256 hash.
+    DeltaPatcher(Reader reader, Writer writer, Verifier verifier);
+    ~DeltaPatcher();
+
+    // processes the next part of the delta
+    bool feed(uint8_t const* data, size_t len);
+
+    bool isComplete() const;
+    size_t getTargetSize() const { return _header.targetSize; }
+    char const* getError() const { return _error; }
+
+private:
+    struct Header {
+        char magic[4];
+        uint8_t version;
+        uint8_t reserved[3];
+        uint32_t sourceSize;
+        uint8_t sourceHash[32];
+        uint32_t targetSize;
+    };
+
+    enum class State : uint8_t {
+        Control,
+        Diff,
+        Extra
+    };
+
+    bool fail(char const* error);
+    bool checkHeader();
+    bool process(uint8_t const* data, size_t len);
+    bool startInstruction();
+
+    Reader _reader;
+    Writer _writer;
+    Verifier _verifier;
+
+    Header _header = {};
+    size_t _headerLength = 0;
+
+    std::unique_ptr<tinfl_decompressor_tag> _upInflator;
+    std::unique_ptr<uint8_t[]> _upDictionary;
+    size_t _dictionaryOffset = 0;
+
+    State _state = State::Control;
+    std::array<uint8_t, 12> _control;
+    size_t _controlLength = 0;
+    uint32_t _remaining = 0;
+    uint32_t _extraLength = 0;
+    int32_t _seek = 0;
+    size_t _sourcePosition = 0;
+    size_t _written = 0;
+    std::array<uint8_t, 256> _buffer;
+
+    char const* _error = nullptr;
+};
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "DeltaPatcher.h"
+#include <Arduino.h>
+#include <SHA256.h>
+#include <TaskSchedulerDeclarations.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/**
+ * writes a firmware image to the OTA partition while it is being received,
+ * either uploaded through the web API or downloaded from an HTTP server.
+ *
+ * the image is hashed (SHA-256) as it is written, such that a client can
+ * compare the data received so far against its own copy before resuming an
+ * interrupted transfer at the reported offset. the MD5 checksum is verified
+ * when the image is complete. if a public key is built into the firmware
+ * (FIRMWARE_SIGNING_KEY, hex encoded Ed25519 key), the image is only
+ * activated if its SHA-256 hash was signed with the respective private key.
+ *
+ * instead of the image, a delta between the running firmware's image and the
+ * new image may be transferred (see DeltaPatcher.h). the new image is then
+ * created while the delta is received. offsets and sizes refer to the delta
+ * in that case, while checksum and signature refer to the new image.
+ */
+class FirmwareUpdateClass {
+public:
+    enum class State : uint8_t {
+        Idle,
+        Receiving,
+        Finished,
+        Failed
+    };
+
+    void init(Scheduler& scheduler);
+
+    // starts a new update, aborting a previous one. the size is zero if
+    // it is not known in advance. the MD5 checksum is mandatory. refused
+    // while a download is in progress, which owns the update until it ends.
+    bool begin(size_t size, String const& md5, String const& signature, bool delta);
+
+    // writes data located at the given offset of the image. data which was
+    // received already is skipped, data beyond the received part is refused.
+    // refused while a download is in progress.
+    bool write(size_t offset, uint8_t const* data, size_t len);
+
+    // verifies the complete image and marks it to be booted. refused
+    // while a download is in progress.
+    bool end();
+
+    void abort(String const& reason);
+
+    // downloads the image in a separate task. if the download is
+    // interrupted, it is resumed using an HTTP range request. the DTU is
+    // restarted once the image was downloaded and verified successfully.
+    bool startPull(String const& url, size_t size, String const& md5, String const& signature, bool delta);
+
+    State getState() const { return _state; }
+    char const* getStateText() const;
+    size_t getReceived() const { return _received; }
+    size_t getSize() const { return _size; }
+    bool isDelta() const { return _delta; }
+    bool isPulling() const { return _pulling; }
+
+    // whether images are only activated if they are signed, i.e., whether
+    // the firmware was built with FIRMWARE_SIGNING_KEY
+    static constexpr bool isSignatureRequired()
+    {
+#ifdef FIRMWARE_SIGNING_KEY
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    String getError();
+
+    // hex encoded SHA-256 hash of the data received so far
+    String getReceivedHash();
+
+private:
+    void loop();
+    static void pullTask(void* parameter);
+    void pull();
+    bool pullOnce();
+    bool start(size_t size, String const& md5, String const& signature, bool delta, bool upload);
+    bool writeData(size_t offset, uint8_t const* data, size_t len, bool upload, bool& sectorWritten);
+    bool finish(bool upload);
+    void fail(String const& reason);
+    bool verifySignature(uint8_t const* digest);
+    bool writeImage(uint8_t const* data, size_t len);
+    static bool readRunningImage(size_t offset, uint8_t* data, size_t len);
+    static bool checkRunningImage(size_t size, uint8_t const* sha256);
+
+    Task _loopTask;
+
+    std::mutex _mutex;
+    std::atomic<State> _state { State::Idle };
+    std::atomic<size_t> _received { 0 };
+    std::atomic<size_t> _size { 0 };
+    SHA256 _sha256; // of the data received
+    std::atomic<bool> _delta { false };
+    std::unique_ptr<DeltaPatcher> _upPatcher;
+    SHA256 _imageSha256; // of the image created from the delta
+    String _signature;
+    String _error;
+
+    String _pullUrl;
+    std::atomic<bool> _pulling { false };
+    std::atomic<bool> _restartPending { false };
+
+    // erasing and writing the flash stalls both cores, as the flash cache is
+    // disabled meanwhile. a pause after each flash sector leaves time for the
+    // control loops and the radio, at the cost of a longer update. only the
+    // download task pauses. uploads are written by the AsyncTCP task, which
+    // serves all web clients and must not sleep. the sender of an upload is
+    // slowed down by the TCP window while a sector is written anyway.
+    static constexpr uint32_t _sectorPauseMs = 20;
+
+    static constexpr uint8_t _maxPullAttempts = 5;
+    static constexpr uint32_t _pullTimeoutMs = 10 * 1000;
+};
+
+extern FirmwareUpdateClass FirmwareUpdate;
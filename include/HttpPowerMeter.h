@@ -1,12 +1,19 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "Configuration.h"
 #include <stdint.h>
 #include <Arduino.h>
 #include <HTTPClient.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
 
 class HttpPowerMeterClass {
 public:
+    HttpPowerMeterClass();
     void init();
     bool updateValues();
     float getPower(int8_t phase);
@@ -16,17 +23,37 @@ public:
 
 
 private:    
+    // state of the request for a single phase. with individual requests,
+    // the phases 2 and 3 are queried by their own task in parallel.
+    struct Query {
+        int phase;
+        POWERMETER_HTTP_PHASE_CONFIG_T config;
+        HTTPClient httpClient;
+        String httpResponse;
+        char error[256];
+        float power;
+        bool success;
+        std::atomic<bool> busy;
+    };
+
     float power[POWERMETER_MAX_PHASES];
-    HTTPClient httpClient;
-    String httpResponse;
-    bool httpRequest(int phase, WiFiClient &wifiClient, const String& host, uint16_t port, const String& uri, bool https, Auth authType, const char* username,
+    std::array<Query, POWERMETER_MAX_PHASES> _queries;
+    EventGroupHandle_t _queriesDone = nullptr;
+    std::mutex _resolveMutex;
+
+    static void queryTask(void* parameter);
+    bool startQueryTask(Query& query, POWERMETER_HTTP_PHASE_CONFIG_T const& config);
+    bool runQuery(Query& query, const String& url, Auth authType, const char* username, const char* password,
+        const char* httpHeader, const char* httpValue, uint32_t timeout, const char* jsonPath);
+    bool resolveHost(Query& query, const String& host, IPAddress& ipaddr);
+    bool httpRequest(Query& query, WiFiClient &wifiClient, const String& host, uint16_t port, const String& uri, bool https, Auth authType, const char* username,
            const char* password, const char* httpHeader, const char* httpValue, uint32_t timeout, const char* jsonPath);
-    bool extractUrlComponents(String url, String& _protocol, String& _hostname, String& _uri, uint16_t& uint16_t, String& _base64Authorization);
+    bool extractUrlComponents(Query& query, String url, String& _protocol, String& _hostname, String& _uri, uint16_t& uint16_t, String& _base64Authorization);
     String extractParam(String& authReq, const String& param, const char delimit);
     String getcNonce(const int len);
     String getDigestAuth(String& authReq, const String& username, const String& password, const String& method, const String& uri, unsigned int counter);
-    bool tryGetFloatValueForPhase(int phase, const char* jsonPath);
-    void prepareRequest(uint32_t timeout, const char* httpHeader, const char* httpValue);    
+    bool tryGetFloatValueForPhase(Query& query, int phase, const char* jsonPath, float& value);
+    void prepareRequest(Query& query, uint32_t timeout, const char* httpHeader, const char* httpValue);    
     String sha256(const String& data);    
 };
 
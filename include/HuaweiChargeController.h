@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cfloat>
+#include <optional>
+#include <stdint.h>
+
+/**
+ * closed-loop controller for the output of the Huawei PSU in automatic mode.
+ * a PI controller adjusts the PSU's output power such that the power measured
+ * at the grid connection matches the target, i.e., surplus (solar) power is
+ * used to charge the battery rather than being exported. the resulting output
+ * current is limited by the charge current limit reported by the BMS.
+ *
+ * this class does not depend on the hardware, such that it can be used with
+ * a simulated rectifier as well.
+ */
+class HuaweiChargeController {
+public:
+    struct Parameters {
+        float proportionalGain = 0.3; // W per W of control error
+        float integralGain = 0.2; // W per W of control error and second
+        float targetGridPower = 0; // W, positive values mean import
+        float lowerPowerLimit = 0; // W, the PSU is turned off below
+        float upperPowerLimit = 0; // W
+        float deadbandWatts = 0; // smaller changes are not sent to the PSU
+    };
+
+    struct Input {
+        float gridPower; // W, positive values mean import
+        float outputPower; // W, as reported by the PSU
+        float outputVoltage; // V, as reported by the PSU
+        float efficiency; // as reported by the PSU
+        float chargeCurrentLimit = FLT_MAX; // A, as reported by the BMS
+        float chargeCurrent = 0; // A, total battery current reported by the BMS
+        float outputCurrent = 0; // A, as reported by the PSU
+        uint32_t elapsedMillis; // since the previous update
+    };
+
+    struct Output {
+        float powerSetpoint; // W, after applying all limits
+        float current; // A, to be set at the PSU
+        bool send; // false if the change is within the deadband
+        bool bmsLimited; // the BMS charge current limit applies
+    };
+
+    void setParameters(Parameters const& params) { _params = params; }
+
+    // to be called with every new power meter reading
+    Output update(Input const& input);
+
+    // to be called when the PSU was turned off by other means
+    void reset();
+
+    float getPowerSetpoint() const { return _lastSentPower; }
+
+private:
+    Parameters _params;
+    float _integral = 0;
+    float _lastSentPower = 0;
+    bool _initialized = false;
+};
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <cstdint>
+#include "HuaweiChargeController.h"
 #include "SPI.h"
 #include <mcp_can.h>
 #include <mutex>
@@ -151,6 +152,8 @@ private:
     uint8_t _autoPowerEnabledCounter = 0;
     bool _autoPowerEnabled = false;
     bool _batteryEmergencyCharging = false;
+
+    HuaweiChargeController _chargeController;
 };
 
 extern HuaweiCanClass HuaweiCan;
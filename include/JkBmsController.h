@@ -1,7 +1,7 @@
 #pragma once
 
+#include <array>
 #include <memory>
-#include <vector>
 #include <frozen/string.h>
 
 #include "Battery.h"
@@ -38,6 +38,7 @@ class Controller : public BatteryProvider {
         void rxData(uint8_t inbyte);
         void reset();
         void frameComplete();
+        bool addToBuffer(uint8_t inbyte);
         void processDataPoints(DataPointContainer const& dataPoints);
 
         enum class Interface : unsigned {
@@ -69,7 +70,16 @@ class Controller : public BatteryProvider {
         uint32_t _lastRequest = 0;
         uint16_t _frameLength = 0;
         uint8_t _protocolVersion = -1;
-        SerialResponse::tData _buffer = {};
+
+        // frames are received into this buffer and parsed in place. the
+        // checksum is calculated while the frame is received.
+        static constexpr size_t _maxFrameSize = 512;
+        std::array<uint8_t, _maxFrameSize> _buffer = {};
+        size_t _bufferLength = 0;
+        size_t _frameSize = 0;
+        uint16_t _checksum = 0;
+        DataPointContainer _dataPoints;
+
         std::shared_ptr<JkBmsBatteryStats> _stats =
             std::make_shared<JkBmsBatteryStats>();
 };
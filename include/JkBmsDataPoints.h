@@ -1,11 +1,12 @@
 #pragma once
 
 #include <Arduino.h>
-#include <map>
+#include <algorithm>
+#include <array>
 #include <optional>
 #include <string>
-#include <unordered_map>
-#include <variant>
+#include <tuple>
+#include <utility>
 #include <frozen/map.h>
 #include <frozen/string.h>
 
@@ -121,20 +122,67 @@ enum class DataPointLabel : uint8_t {
     ProtocolVersion = 0xc0
 };
 
-using tCells = std::map<uint8_t, uint16_t>;
+/**
+ * the cell voltages are kept in a fixed-size container, such that storing
+ * them does not require heap allocations. the elements are pairs of the cell
+ * number and the respective voltage in millivolts.
+ */
+class tCells {
+    public:
+        static constexpr size_t MaxCells = 32;
+        using tCell = std::pair<uint8_t, uint16_t>;
+        using const_iterator = std::array<tCell, MaxCells>::const_iterator;
 
-template<DataPointLabel> struct DataPointLabelTraits;
+        void add(uint8_t idx, uint16_t milliVolt) {
+            if (_count >= MaxCells) { return; }
+            _cells[_count++] = { idx, milliVolt };
+        }
 
-#define LABEL_TRAIT(n, t, u) template<> struct DataPointLabelTraits<DataPointLabel::n> { \
-    using type = t; \
-    static constexpr char const name[] = #n; \
-    static constexpr char const unit[] = u; \
+        size_t size() const { return _count; }
+        const_iterator cbegin() const { return _cells.cbegin(); }
+        const_iterator cend() const { return _cells.cbegin() + _count; }
+        const_iterator begin() const { return cbegin(); }
+        const_iterator end() const { return cend(); }
+
+        bool operator==(tCells const& other) const {
+            return std::equal(cbegin(), cend(), other.cbegin(), other.cend());
+        }
+
+    private:
+        std::array<tCell, MaxCells> _cells = {};
+        size_t _count = 0;
+};
+
+/**
+ * strings reported by the BMS are short and of known maximum length, so they
+ * are kept in a fixed-size buffer as well.
+ */
+class tString {
+    public:
+        static constexpr size_t MaxLength = 31;
+
+        tString() = default;
+
+        tString(char const* str, size_t len) {
+            len = std::min(len, MaxLength);
+            std::copy(str, str + len, _value.begin());
+            _value[len] = '\0';
+        }
+
+        char const* c_str() const { return _value.data(); }
+
+        bool operator==(tString const& other) const {
+            return strcmp(c_str(), other.c_str()) == 0;
+        }
+
+    private:
+        std::array<char, MaxLength + 1> _value = {};
 };
 
 /**
  * the types associated with the labels are the types for the respective data
- * points in the JkBms::DataPoint class. they are *not* always equal to the
- * type used in the serial message.
+ * points in the JkBms::DataPointContainer class. they are *not* always equal
+ * to the type used in the serial message.
  *
  * it is unfortunate that we have to repeat all enum values here to define the
  * traits. code generation could help here (labels are defined in a single
@@ -145,110 +193,140 @@ template<DataPointLabel> struct DataPointLabelTraits;
  * the DataPointContainer class, because the traits must be available then.
  * even though this is tedious to maintain, human errors will be caught.
  */
-LABEL_TRAIT(CellsMilliVolt,                         tCells,      "mV");
-LABEL_TRAIT(BmsTempCelsius,                         int16_t,     "°C");
-LABEL_TRAIT(BatteryTempOneCelsius,                  int16_t,     "°C");
-LABEL_TRAIT(BatteryTempTwoCelsius,                  int16_t,     "°C");
-LABEL_TRAIT(BatteryVoltageMilliVolt,                uint32_t,    "mV");
-LABEL_TRAIT(BatteryCurrentMilliAmps,                int32_t,     "mA");
-LABEL_TRAIT(BatterySoCPercent,                      uint8_t,     "%");
-LABEL_TRAIT(BatteryTemperatureSensorAmount,         uint8_t,     "");
-LABEL_TRAIT(BatteryCycles,                          uint16_t,    "");
-LABEL_TRAIT(BatteryCycleCapacity,                   uint32_t,    "Ah");
-LABEL_TRAIT(BatteryCellAmount,                      uint16_t,    "");
-LABEL_TRAIT(AlarmsBitmask,                          uint16_t,    "");
-LABEL_TRAIT(StatusBitmask,                          uint16_t,    "");
-LABEL_TRAIT(TotalOvervoltageThresholdMilliVolt,     uint32_t,    "mV");
-LABEL_TRAIT(TotalUndervoltageThresholdMilliVolt,    uint32_t,    "mV");
-LABEL_TRAIT(CellOvervoltageThresholdMilliVolt,      uint16_t,    "mV");
-LABEL_TRAIT(CellOvervoltageRecoveryMilliVolt,       uint16_t,    "mV");
-LABEL_TRAIT(CellOvervoltageProtectionDelaySeconds,  uint16_t,    "s");
-LABEL_TRAIT(CellUndervoltageThresholdMilliVolt,     uint16_t,    "mV");
-LABEL_TRAIT(CellUndervoltageRecoveryMilliVolt,      uint16_t,    "mV");
-LABEL_TRAIT(CellUndervoltageProtectionDelaySeconds, uint16_t,    "s");
-LABEL_TRAIT(CellVoltageDiffThresholdMilliVolt,      uint16_t,    "mV");
-LABEL_TRAIT(DischargeOvercurrentThresholdAmperes,   uint16_t,    "A");
-LABEL_TRAIT(DischargeOvercurrentDelaySeconds,       uint16_t,    "s");
-LABEL_TRAIT(ChargeOvercurrentThresholdAmps,         uint16_t,    "A");
-LABEL_TRAIT(ChargeOvercurrentDelaySeconds,          uint16_t,    "s");
-LABEL_TRAIT(BalanceCellVoltageThresholdMilliVolt,   uint16_t,    "mV");
-LABEL_TRAIT(BalanceVoltageDiffThresholdMilliVolt,   uint16_t,    "mV");
-LABEL_TRAIT(BalancingEnabled,                       bool,        "");
-LABEL_TRAIT(BmsTempProtectionThresholdCelsius,      uint16_t,    "°C");
-LABEL_TRAIT(BmsTempRecoveryThresholdCelsius,        uint16_t,    "°C");
-LABEL_TRAIT(BatteryTempProtectionThresholdCelsius,  uint16_t,    "°C");
-LABEL_TRAIT(BatteryTempRecoveryThresholdCelsius,    uint16_t,    "°C");
-LABEL_TRAIT(BatteryTempDiffThresholdCelsius,        uint16_t,    "°C");
-LABEL_TRAIT(ChargeHighTempThresholdCelsius,         uint16_t,    "°C");
-LABEL_TRAIT(DischargeHighTempThresholdCelsius,      uint16_t,    "°C");
-LABEL_TRAIT(ChargeLowTempThresholdCelsius,          int16_t,     "°C");
-LABEL_TRAIT(ChargeLowTempRecoveryCelsius,           int16_t,     "°C");
-LABEL_TRAIT(DischargeLowTempThresholdCelsius,       int16_t,     "°C");
-LABEL_TRAIT(DischargeLowTempRecoveryCelsius,        int16_t,     "°C");
-LABEL_TRAIT(CellAmountSetting,                      uint8_t,     "");
-LABEL_TRAIT(BatteryCapacitySettingAmpHours,         uint32_t,    "Ah");
-LABEL_TRAIT(BatteryChargeEnabled,                   bool,        "");
-LABEL_TRAIT(BatteryDischargeEnabled,                bool,        "");
-LABEL_TRAIT(CurrentCalibrationMilliAmps,            uint16_t,    "mA");
-LABEL_TRAIT(BmsAddress,                             uint8_t,     "");
-LABEL_TRAIT(BatteryType,                            uint8_t,     "");
-LABEL_TRAIT(SleepWaitTime,                          uint16_t,    "s");
-LABEL_TRAIT(LowCapacityAlarmThresholdPercent,       uint8_t,     "%");
-LABEL_TRAIT(ModificationPassword,                   std::string, "");
-LABEL_TRAIT(DedicatedChargerSwitch,                 bool,        "");
-LABEL_TRAIT(EquipmentId,                            std::string, "");
-LABEL_TRAIT(DateOfManufacturing,                    std::string, "");
-LABEL_TRAIT(BmsHourMeterMinutes,                    uint32_t,    "min");
-LABEL_TRAIT(BmsSoftwareVersion,                     std::string, "");
-LABEL_TRAIT(CurrentCalibration,                     bool,        "");
-LABEL_TRAIT(ActualBatteryCapacityAmpHours,          uint32_t,    "Ah");
-LABEL_TRAIT(ProductId,                              std::string, "");
-LABEL_TRAIT(ProtocolVersion,                        uint8_t,     "");
+#define DATA_POINT_LABELS(fnc) \
+    fnc(CellsMilliVolt,                         tCells,   "mV") \
+    fnc(BmsTempCelsius,                         int16_t,  "°C") \
+    fnc(BatteryTempOneCelsius,                  int16_t,  "°C") \
+    fnc(BatteryTempTwoCelsius,                  int16_t,  "°C") \
+    fnc(BatteryVoltageMilliVolt,                uint32_t, "mV") \
+    fnc(BatteryCurrentMilliAmps,                int32_t,  "mA") \
+    fnc(BatterySoCPercent,                      uint8_t,  "%") \
+    fnc(BatteryTemperatureSensorAmount,         uint8_t,  "") \
+    fnc(BatteryCycles,                          uint16_t, "") \
+    fnc(BatteryCycleCapacity,                   uint32_t, "Ah") \
+    fnc(BatteryCellAmount,                      uint16_t, "") \
+    fnc(AlarmsBitmask,                          uint16_t, "") \
+    fnc(StatusBitmask,                          uint16_t, "") \
+    fnc(TotalOvervoltageThresholdMilliVolt,     uint32_t, "mV") \
+    fnc(TotalUndervoltageThresholdMilliVolt,    uint32_t, "mV") \
+    fnc(CellOvervoltageThresholdMilliVolt,      uint16_t, "mV") \
+    fnc(CellOvervoltageRecoveryMilliVolt,       uint16_t, "mV") \
+    fnc(CellOvervoltageProtectionDelaySeconds,  uint16_t, "s") \
+    fnc(CellUndervoltageThresholdMilliVolt,     uint16_t, "mV") \
+    fnc(CellUndervoltageRecoveryMilliVolt,      uint16_t, "mV") \
+    fnc(CellUndervoltageProtectionDelaySeconds, uint16_t, "s") \
+    fnc(CellVoltageDiffThresholdMilliVolt,      uint16_t, "mV") \
+    fnc(DischargeOvercurrentThresholdAmperes,   uint16_t, "A") \
+    fnc(DischargeOvercurrentDelaySeconds,       uint16_t, "s") \
+    fnc(ChargeOvercurrentThresholdAmps,         uint16_t, "A") \
+    fnc(ChargeOvercurrentDelaySeconds,          uint16_t, "s") \
+    fnc(BalanceCellVoltageThresholdMilliVolt,   uint16_t, "mV") \
+    fnc(BalanceVoltageDiffThresholdMilliVolt,   uint16_t, "mV") \
+    fnc(BalancingEnabled,                       bool,     "") \
+    fnc(BmsTempProtectionThresholdCelsius,      uint16_t, "°C") \
+    fnc(BmsTempRecoveryThresholdCelsius,        uint16_t, "°C") \
+    fnc(BatteryTempProtectionThresholdCelsius,  uint16_t, "°C") \
+    fnc(BatteryTempRecoveryThresholdCelsius,    uint16_t, "°C") \
+    fnc(BatteryTempDiffThresholdCelsius,        uint16_t, "°C") \
+    fnc(ChargeHighTempThresholdCelsius,         uint16_t, "°C") \
+    fnc(DischargeHighTempThresholdCelsius,      uint16_t, "°C") \
+    fnc(ChargeLowTempThresholdCelsius,          int16_t,  "°C") \
+    fnc(ChargeLowTempRecoveryCelsius,           int16_t,  "°C") \
+    fnc(DischargeLowTempThresholdCelsius,       int16_t,  "°C") \
+    fnc(DischargeLowTempRecoveryCelsius,        int16_t,  "°C") \
+    fnc(CellAmountSetting,                      uint8_t,  "") \
+    fnc(BatteryCapacitySettingAmpHours,         uint32_t, "Ah") \
+    fnc(BatteryChargeEnabled,                   bool,     "") \
+    fnc(BatteryDischargeEnabled,                bool,     "") \
+    fnc(CurrentCalibrationMilliAmps,            uint16_t, "mA") \
+    fnc(BmsAddress,                             uint8_t,  "") \
+    fnc(BatteryType,                            uint8_t,  "") \
+    fnc(SleepWaitTime,                          uint16_t, "s") \
+    fnc(LowCapacityAlarmThresholdPercent,       uint8_t,  "%") \
+    fnc(ModificationPassword,                   tString,  "") \
+    fnc(DedicatedChargerSwitch,                 bool,     "") \
+    fnc(EquipmentId,                            tString,  "") \
+    fnc(DateOfManufacturing,                    tString,  "") \
+    fnc(BmsHourMeterMinutes,                    uint32_t, "min") \
+    fnc(BmsSoftwareVersion,                     tString,  "") \
+    fnc(CurrentCalibration,                     bool,     "") \
+    fnc(ActualBatteryCapacityAmpHours,          uint32_t, "Ah") \
+    fnc(ProductId,                              tString,  "") \
+    fnc(ProtocolVersion,                        uint8_t,  "")
+
+template<DataPointLabel> struct DataPointLabelTraits;
+
+#define LABEL_TRAIT(n, t, u) template<> struct DataPointLabelTraits<DataPointLabel::n> { \
+    using type = t; \
+    static constexpr char const name[] = #n; \
+    static constexpr char const unit[] = u; \
+};
+DATA_POINT_LABELS(LABEL_TRAIT)
 #undef LABEL_TRAIT
 
-class DataPoint {
-    friend class DataPointContainer;
+// all labels with traits, in order of their storage in the DataPointContainer
+static constexpr DataPointLabel DataPointLabels[] = {
+#define LABEL_ENTRY(n, t, u) DataPointLabel::n,
+    DATA_POINT_LABELS(LABEL_ENTRY)
+#undef LABEL_ENTRY
+};
+
+static constexpr size_t DataPointLabelCount = sizeof(DataPointLabels) / sizeof(DataPointLabels[0]);
 
+constexpr size_t getDataPointIndex(DataPointLabel label) {
+    for (size_t idx = 0; idx < DataPointLabelCount; ++idx) {
+        if (DataPointLabels[idx] == label) { return idx; }
+    }
+    return DataPointLabelCount;
+}
+
+template<typename T> std::string dataPointValueToStr(T const& v);
+template<> std::string dataPointValueToStr(tString const& v);
+template<> std::string dataPointValueToStr(bool const& v);
+template<> std::string dataPointValueToStr(tCells const& v);
+
+/**
+ * a view of a data point stored in a DataPointContainer, which is only valid
+ * as long as the container is not modified. the value is converted to text
+ * only when asked for it.
+ */
+class DataPoint {
     public:
-        using tValue = std::variant<bool, uint8_t, uint16_t, uint32_t,
-              int16_t, int32_t, std::string, tCells>;
-
-        DataPoint() = delete;
-
-        DataPoint(DataPoint const& other)
-            : _strLabel(other._strLabel)
-            , _strValue(other._strValue)
-            , _strUnit(other._strUnit)
-            , _value(other._value)
-            , _timestamp(other._timestamp) { }
-
-        DataPoint(std::string const& strLabel, std::string const& strValue,
-                std::string const& strUnit, tValue value, uint32_t timestamp)
-            : _strLabel(strLabel)
-            , _strValue(strValue)
-            , _strUnit(strUnit)
-            , _value(std::move(value))
+        template<typename T>
+        DataPoint(char const* label, char const* unit, T const& value, uint32_t timestamp)
+            : _label(label)
+            , _unit(unit)
+            , _pValue(&value)
+            , _toStr([](void const* pValue) {
+                    return dataPointValueToStr(*static_cast<T const*>(pValue));
+                })
             , _timestamp(timestamp) { }
 
-        std::string const& getLabelText() const { return _strLabel; }
-        std::string const& getValueText() const { return _strValue; }
-        std::string const& getUnitText() const { return _strUnit; }
+        char const* getLabelText() const { return _label; }
+        std::string getValueText() const { return _toStr(_pValue); }
+        char const* getUnitText() const { return _unit; }
         uint32_t getTimestamp() const { return _timestamp; }
 
-        bool operator==(DataPoint const& other) const {
-            return _value == other._value;
-        }
-
     private:
-        std::string _strLabel;
-        std::string _strValue;
-        std::string _strUnit;
-        tValue _value;
+        char const* _label;
+        char const* _unit;
+        void const* _pValue;
+        std::string (*_toStr)(void const*);
         uint32_t _timestamp;
 };
 
-template<typename T> std::string dataPointValueToStr(T const& v);
+template<typename T>
+struct DataPointSlot {
+    T value = {};
+    uint32_t timestamp = 0;
+    bool valid = false;
+};
 
+/**
+ * every label has a slot of the respective type, which is located at a
+ * compile-time index. adding a data point does not allocate memory, and
+ * the size of the container is known at compile time.
+ */
 class DataPointContainer {
     public:
         DataPointContainer() = default;
@@ -258,16 +336,10 @@ class DataPointContainer {
 
         template<Label L>
         void add(typename Traits<L>::type val) {
-            _dataPoints.emplace(
-                    L,
-                    DataPoint(
-                        Traits<L>::name,
-                        dataPointValueToStr(val),
-                        Traits<L>::unit,
-                        DataPoint::tValue(std::move(val)),
-                        millis()
-                    )
-            );
+            auto& slot = getSlot<L>();
+            slot.value = std::move(val);
+            slot.timestamp = millis();
+            slot.valid = true;
         }
 
         // make sure add() is only called with the type expected for the
@@ -277,28 +349,70 @@ class DataPointContainer {
 
         template<Label L>
         std::optional<DataPoint const> getDataPointFor() const {
-            auto it = _dataPoints.find(L);
-            if (it == _dataPoints.end()) { return std::nullopt; }
-            return it->second;
+            auto const& slot = getSlot<L>();
+            if (!slot.valid) { return std::nullopt; }
+            return DataPoint(Traits<L>::name, Traits<L>::unit, slot.value, slot.timestamp);
         }
 
         template<Label L>
         std::optional<typename Traits<L>::type> get() const {
-            auto optionalDataPoint = getDataPointFor<L>();
-            if (!optionalDataPoint.has_value()) { return std::nullopt; }
-            return std::get<typename Traits<L>::type>(optionalDataPoint->_value);
+            auto const& slot = getSlot<L>();
+            if (!slot.valid) { return std::nullopt; }
+            return slot.value;
         }
 
-        using tMap = std::unordered_map<Label, DataPoint const>;
-        tMap::const_iterator cbegin() const { return _dataPoints.cbegin(); }
-        tMap::const_iterator cend() const { return _dataPoints.cend(); }
+        // calls func(Label, DataPoint const&) for every data point
+        // which holds a value, in order of the labels' declaration.
+        template<typename F>
+        void forEach(F&& func) const {
+            forEach(func, std::make_index_sequence<DataPointLabelCount>{});
+        }
 
         // copy all data points from source into this instance, overwriting
         // existing data points in this instance.
         void updateFrom(DataPointContainer const& source);
 
+        // marks all data points as not holding a value
+        void clear() {
+            std::apply([](auto&... slot) { ((slot.valid = false), ...); }, _slots);
+        }
+
     private:
-        tMap _dataPoints;
+        template<size_t... I>
+        static std::tuple<DataPointSlot<typename DataPointLabelTraits<DataPointLabels[I]>::type>...>
+            makeSlots(std::index_sequence<I...>);
+
+        using tSlots = decltype(makeSlots(std::make_index_sequence<DataPointLabelCount>{}));
+
+        template<Label L>
+        auto& getSlot() {
+            static_assert(getDataPointIndex(L) < DataPointLabelCount, "label without traits");
+            return std::get<getDataPointIndex(L)>(_slots);
+        }
+
+        template<Label L>
+        auto const& getSlot() const {
+            static_assert(getDataPointIndex(L) < DataPointLabelCount, "label without traits");
+            return std::get<getDataPointIndex(L)>(_slots);
+        }
+
+        template<typename F, size_t... I>
+        void forEach(F& func, std::index_sequence<I...>) const {
+            (forEachVisit<I>(func), ...);
+        }
+
+        template<size_t I, typename F>
+        void forEachVisit(F& func) const {
+            constexpr Label L = DataPointLabels[I];
+            auto const& slot = std::get<I>(_slots);
+            if (!slot.valid) { return; }
+            func(L, DataPoint(Traits<L>::name, Traits<L>::unit, slot.value, slot.timestamp));
+        }
+
+        template<size_t... I>
+        void updateFrom(DataPointContainer const& source, std::index_sequence<I...>);
+
+        tSlots _slots;
 };
 
 } /* namespace JkBms */
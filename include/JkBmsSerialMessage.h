@@ -1,17 +1,26 @@
 #pragma once
 
-#include <utility>
-#include <vector>
+#include <array>
 #include <Arduino.h>
 
 #include "JkBmsDataPoints.h"
 
 namespace JkBms {
 
+/**
+ * non-owning view of a frame's bytes. frames are parsed where they were
+ * received, without copying them.
+ */
+struct ByteSpan {
+    uint8_t const* data;
+    size_t size;
+
+    uint8_t const* begin() const { return data; }
+    uint8_t const* end() const { return data + size; }
+};
+
 class SerialMessage {
     public:
-        using tData = std::vector<uint8_t>;
-
         SerialMessage() = delete;
 
         enum class Command : uint8_t {
@@ -22,7 +31,7 @@ class SerialMessage {
             ReadAll = 0x06
         };
 
-        Command getCommand() const { return static_cast<Command>(_raw[8]); }
+        Command getCommand() const { return static_cast<Command>(peek<uint8_t>(8)); }
 
         enum class Source : uint8_t {
             BMS = 0x00,
@@ -30,64 +39,76 @@ class SerialMessage {
             GPS = 0x02,
             Host = 0x03
         };
-        Source getSource() const { return static_cast<Source>(_raw[9]); }
+        Source getSource() const { return static_cast<Source>(peek<uint8_t>(9)); }
 
         enum class Type : uint8_t {
             Command = 0x00,
             Response = 0x01,
             Unsolicited = 0x02
         };
-        Type getType() const { return static_cast<Type>(_raw[10]); }
+        Type getType() const { return static_cast<Type>(peek<uint8_t>(10)); }
 
         // this does *not* include the two byte start marker
-        uint16_t getFrameLength() const { return get<uint16_t>(_raw.cbegin()+2); }
+        uint16_t getFrameLength() const { return peek<uint16_t>(2); }
 
-        uint32_t getTerminalId() const { return get<uint32_t>(_raw.cbegin()+4); }
+        uint32_t getTerminalId() const { return peek<uint32_t>(4); }
 
         // there are 20 bytes of overhead. two of those are the start marker
         // bytes, which are *not* counted by the frame length.
         uint16_t getVariableFieldLength() const { return getFrameLength() - 18; }
 
         // the upper byte of the 4-byte "record number" is reserved (for encryption)
-        uint32_t getSequence() const { return get<uint32_t>(_raw.cend()-9) >> 8; }
+        uint32_t getSequence() const { return peek<uint32_t>(_frame.size - 9) >> 8; }
 
-        bool isValid() const;
-
-        uint8_t const* data() { return _raw.data(); }
-        size_t size() { return _raw.size(); }
-
-    protected:
-        template <typename... Args>
-        explicit SerialMessage(Args&&... args) : _raw(std::forward<Args>(args)...) { }
+        // the checksum is the sum of all bytes except the last four
+        static uint16_t calcChecksum(ByteSpan frame);
 
-        template<typename T, typename It> T get(It&& pos) const;
-        template<typename It> bool getBool(It&& pos) const;
-        template<typename It> int16_t getTemperature(It&& pos) const;
-        template<typename It> std::string getString(It&& pos, size_t len, bool replaceZeroes = false) const;
-        void processBatteryCurrent(tData::const_iterator& pos, uint8_t protocolVersion);
-        template<typename T> void set(tData::iterator const& pos, T val);
-        uint16_t calcChecksum() const;
-        void updateChecksum();
+        bool isValid() const { return _valid; }
 
-        tData _raw;
-        JkBms::DataPointContainer _dp;
+        uint8_t const* data() const { return _frame.data; }
+        size_t size() const { return _frame.size; }
 
         static constexpr uint16_t startMarker = 0x4e57;
         static constexpr uint8_t endMarker = 0x68;
+        static constexpr size_t minFrameSize = 20;
+
+    protected:
+        explicit SerialMessage(ByteSpan frame) : _frame(frame) { }
+
+        template<typename T> T get(uint8_t const*& pos) const;
+        template<typename T> T peek(size_t offset) const;
+        bool getBool(uint8_t const*& pos) const;
+        int16_t getTemperature(uint8_t const*& pos) const;
+        tString getString(uint8_t const*& pos, size_t len, bool replaceZeroes = false) const;
+        bool validate(uint16_t checksum) const;
+
+        ByteSpan _frame;
+        bool _valid = false;
 };
 
 class SerialResponse : public SerialMessage {
     public:
-        using tData = SerialMessage::tData;
-        explicit SerialResponse(tData&& raw, uint8_t protocolVersion = -1);
+        // the data points are decoded from the frame directly into the
+        // given container, which is *not* cleared beforehand. the checksum
+        // is calculated unless it was calculated while receiving the frame.
+        SerialResponse(ByteSpan frame, DataPointContainer& dp, uint8_t protocolVersion = -1);
+        SerialResponse(ByteSpan frame, DataPointContainer& dp, uint8_t protocolVersion, uint16_t checksum);
 
-        DataPointContainer const& getDataPoints() const { return _dp; }
+    private:
+        void processBatteryCurrent(uint8_t const*& pos, uint8_t protocolVersion);
+
+        DataPointContainer& _dp;
 };
 
 class SerialCommand : public SerialMessage {
     public:
         using Command = SerialMessage::Command;
         explicit SerialCommand(Command cmd);
+
+    private:
+        template<typename T> void set(size_t offset, T val);
+
+        std::array<uint8_t, minFrameSize> _raw = {};
 };
 
 } /* namespace JkBms */
@@ -11,8 +11,11 @@ public:
 
 private:
     void loop();
+    void publishTaskStatistics();
 
     Task _loopTask;
+
+    uint32_t _lastTaskStatsPublish = 0;
 };
 
 extern MqttHandleDtuClass MqttHandleDtu;
@@ -35,6 +35,8 @@ private:
 
     void publish_mppt_data(const VeDirectMpptController::data_t &mpptData,
                            const VeDirectMpptController::data_t &frame) const;
+    void publish_statistics(char const* serial,
+                            const VeDirectMpptController::Statistics &statistics) const;
 };
 
 extern MqttHandleVedirectClass MqttHandleVedirect;
@@ -49,6 +49,8 @@ struct PinMapping_t {
     int8_t battery_rxen;
     int8_t battery_tx;
     int8_t battery_txen;
+    int8_t battery_can_rx; // the TWAI controller uses battery_rx if not set
+    int8_t battery_can_tx;
     int8_t huawei_miso;
     int8_t huawei_mosi;
     int8_t huawei_clk;
@@ -58,6 +60,7 @@ struct PinMapping_t {
     int8_t powermeter_rx;
     int8_t powermeter_tx;
     int8_t powermeter_dere;
+    int8_t powermeter_rx2; // second SML meter
 };
 
 class PinMappingClass {
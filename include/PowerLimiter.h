@@ -2,6 +2,7 @@
 #pragma once
 
 #include "Configuration.h"
+#include "VoltageSagEstimator.h"
 #include <espMqttClient.h>
 #include <Arduino.h>
 #include <Hoymiles.h>
@@ -53,6 +54,11 @@ public:
     uint8_t getPowerLimiterState();
     int32_t getLastRequestedPowerLimit() { return _lastRequestedPowerLimit; }
 
+    // the factor used to calculate the load corrected voltage, which is
+    // either the configured one or the one estimated while running.
+    float getVoltageLoadCorrectionFactor() const;
+    VoltageSagEstimator const& getVoltageSagEstimator() const { return _voltageSagEstimator; }
+
     enum class Mode : unsigned {
         Normal = 0,
         Disabled = 1,
@@ -85,6 +91,11 @@ private:
     uint32_t _nextCalculateCheck = 5000; // time in millis for next NTP check to calulate restart
     bool _fullSolarPassThroughEnabled = false;
     bool _verboseLogging = true;
+    std::shared_ptr<CONFIG_SNAPSHOT_T const> _spConfig = nullptr; // updated in loop()
+    std::optional<float> _oBatteryDischargePowerLimit = std::nullopt;
+    VoltageSagEstimator _voltageSagEstimator;
+    uint32_t _lastVoltageSagSample = 0;
+    uint32_t _lastBatteryDischargePowerLimit = 0;
 
     frozen::string const& getStatusText(Status status);
     void announceStatus(Status status);
@@ -99,6 +110,8 @@ private:
     bool setNewPowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t newPowerLimit);
     int32_t getSolarPower();
     float getLoadCorrectedVoltage();
+    void updateVoltageSagEstimate();
+    std::optional<int32_t> getBatteryDischargeLimit(std::shared_ptr<InverterAbstract> inverter, int32_t solarPowerDC);
     bool testThreshold(float socThreshold, float voltThreshold,
             std::function<bool(float, float)> compare);
     bool isStartThresholdReached();
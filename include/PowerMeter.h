@@ -4,20 +4,26 @@
 #include "Configuration.h"
 #include <espMqttClient.h>
 #include <Arduino.h>
+#include <array>
 #include <map>
-#include <list>
 #include <mutex>
+#include <vector>
 #include "SDM.h"
-#include "sml.h"
+#include "SmlMeter.h"
+#include "PowerMeterFilter.h"
 #include <TaskSchedulerDeclarations.h>
-#include <SoftwareSerial.h>
-
-typedef struct {
-  const unsigned char OBIS[6];
-  void (*Fn)(double&);
-  float* Arg;
-} OBISHandler;
 
+/**
+ * reads the configured source and, optionally, failover sources, which are
+ * read all the time as well. the values are taken from the source with the
+ * highest priority whose values are fresh, i.e., which did not miss a sample
+ * and whose last poll did not fail.
+ *
+ * if fusion is enabled, the primary source is assumed to be fast but noisy or
+ * biased, while the first failover source is assumed to be slow but accurate.
+ * the deviation between both is then smoothed and used to correct the values
+ * of the primary source.
+ */
 class PowerMeterClass {
 public:
     enum class Source : unsigned {
@@ -29,10 +35,31 @@ public:
         SMAHM2 = 5
     };
     void init(Scheduler& scheduler);
+
+    // the output of the filter stage, see PowerMeterFilter
     float getPowerTotal(bool forceUpdate = true);
     uint32_t getLastPowerMeterUpdate();
 
+    // W/s, the trend of the total power over the last samples
+    float getRateOfChange();
+
+    // the source the values are currently taken from
+    Source getActiveSource();
+
 private:
+    // the values read from a single source
+    struct SourceValues {
+        Source source = Source::MQTT;
+        float power[3] = { 0, 0, 0 };
+        float voltage[3] = { 0, 0, 0 };
+        float frequency = 0;
+        float energyImport = 0;
+        float energyExport = 0;
+        uint32_t lastUpdate = 0;
+        bool failed = false; // the last poll failed
+        PowerMeterFilter filter;
+    };
+
     void loop();
     void mqtt();
 
@@ -46,30 +73,51 @@ private:
     // Used in Power limiter for safety check
     uint32_t _lastPowerMeterUpdate;
 
+    // the values of the active source
     float _powerMeter1Power = 0.0;
     float _powerMeter2Power = 0.0;
     float _powerMeter3Power = 0.0;
     float _powerMeter1Voltage = 0.0;
     float _powerMeter2Voltage = 0.0;
     float _powerMeter3Voltage = 0.0;
+    float _powerMeterFrequency = 0.0;
     float _powerMeterImport = 0.0;
     float _powerMeterExport = 0.0;
+    float _powerMeterTotal = 0.0; // filtered and fused
 
     std::map<String, float*> _mqttSubscriptions;
 
     mutable std::mutex _mutex;
 
+    // by priority, the primary source first
+    std::array<SourceValues, POWERMETER_MAX_SOURCES> _sources;
+    size_t _sourceCount = 0;
+    size_t _activeSource = 0;
+
+    uint32_t _fusionTimeConstant = 0;
+    float _fusionBias = 0;
+    uint32_t _fusionLastUpdate = 0;
+
     std::unique_ptr<SDM> _upSdm = nullptr;
-    std::unique_ptr<SoftwareSerial> _upSmlSerial = nullptr;
+    std::vector<std::unique_ptr<SmlMeter>> _smlMeters;
+    uint32_t _smlTelegrams = 0;
 
+    bool initSource(SourceValues& values);
     void readPowerMeter();
+    void readSource(SourceValues& values);
+    void readSdm(SourceValues& values, bool threePhases);
+    void readHttp(SourceValues& values);
 
-    bool smlReadLoop();
-    const std::list<OBISHandler> smlHandlerList{
-        {{0x01, 0x00, 0x10, 0x07, 0x00, 0xff}, &smlOBISW, &_powerMeter1Power},
-        {{0x01, 0x00, 0x01, 0x08, 0x00, 0xff}, &smlOBISWh, &_powerMeterImport},
-        {{0x01, 0x00, 0x02, 0x08, 0x00, 0xff}, &smlOBISWh, &_powerMeterExport}
-    };
+    void initSmlMeters();
+    void readSmlMeters(SourceValues& values);
+
+    void readSmaHomeManager(SourceValues& values);
+
+    void updateFilter(SourceValues& values);
+    void updateFusion();
+    bool isFresh(SourceValues const& values, uint32_t now) const;
+    void selectSource();
+    SourceValues* findSource(Source source);
 };
 
 extern PowerMeterClass PowerMeter;
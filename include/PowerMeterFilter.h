@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * keeps the most recent samples of a power meter together with the time they
+ * were taken and filters them before they are used for regulation. a single
+ * bogus reading shall not make the dynamic power limiter send a new limit.
+ *
+ * the filter stage consists of an optional outlier filter working on the
+ * last samples (median of the window, or a Hampel filter which replaces a
+ * sample by the median of the window only if it deviates by more than the
+ * threshold times the scaled median absolute deviation, which is at least
+ * 10 W or 2 % of the median), followed by an optional exponential smoothing
+ * with the given time constant, which takes the actual time between samples
+ * into account.
+ *
+ * not thread-safe, the owner serializes access.
+ */
+class PowerMeterFilter {
+public:
+    // keep the numbers stable, they are stored in the configuration
+    enum class Mode : uint8_t {
+        None = 0,
+        Median = 1,
+        Hampel = 2
+    };
+
+    static constexpr size_t MaxWindow = 15;
+
+    void configure(Mode mode, size_t window, float hampelThreshold, uint32_t timeConstantMs);
+    void reset();
+
+    void addSample(uint32_t timestamp, float value);
+
+    bool hasSamples() const { return _count > 0; }
+    uint32_t getLastTimestamp() const { return _lastTimestamp; }
+    float getLastSample() const;
+
+    // the output of the filter stage
+    float getValue() const { return _value; }
+
+    // W/s, slope of a least-squares line through the samples of the
+    // window, but at least through the last five samples
+    float getRateOfChange() const;
+
+    // W/s, between the two most recent samples
+    float getLastRateOfChange() const;
+
+    // ms, median of the intervals between the samples, zero if unknown
+    uint32_t getSampleInterval() const;
+
+    // number of samples replaced by the outlier filter since the last reset
+    uint32_t getOutliers() const { return _outliers; }
+
+private:
+    struct Sample {
+        uint32_t timestamp;
+        float value;
+    };
+
+    Sample const& at(size_t age) const;
+    float filterOutliers();
+
+    static float median(float* values, size_t count);
+
+    static constexpr size_t _minRateSamples = 5;
+
+    std::array<Sample, MaxWindow> _samples = {};
+    size_t _next = 0;
+    size_t _count = 0;
+
+    Mode _mode = Mode::None;
+    size_t _window = 1;
+    float _hampelThreshold = 3;
+    uint32_t _timeConstantMs = 0;
+
+    uint32_t _lastTimestamp = 0;
+    float _value = 0;
+    uint32_t _outliers = 0;
+};
@@ -6,16 +6,32 @@
 #include <espMqttClient.h>
 #include <driver/twai.h>
 #include <Arduino.h>
+#include <SPI.h>
+#include <mcp_can.h>
 #include <memory>
 
 class PylontechCanReceiver : public BatteryProvider {
 public:
+    // the ESP32 has a single TWAI (CAN) controller. a second battery stack
+    // is connected through the MCP2515 which otherwise serves the Huawei PSU.
+    enum class Bus : uint8_t {
+        Twai,
+        Mcp2515
+    };
+
+    explicit PylontechCanReceiver(Bus bus = Bus::Twai) : _bus(bus) { }
+
     bool init(bool verboseLogging) final;
     void deinit() final;
     void loop() final;
     std::shared_ptr<BatteryStats> getStats() const final { return _stats; }
 
 private:
+    bool initTwai();
+    bool initMcp2515();
+    bool receive(uint32_t& id, uint8_t* data, uint8_t& len);
+    void onMessage(uint32_t id, uint8_t* data, uint8_t len);
+
     uint16_t readUnsignedInt16(uint8_t *data);
     int16_t readSignedInt16(uint8_t *data);
     float scaleValue(int16_t value, float factor);
@@ -23,7 +39,10 @@ private:
 
     void dummyData();
 
+    Bus _bus;
     bool _verboseLogging = true;
+    std::unique_ptr<SPIClass> _upSpi;
+    std::unique_ptr<MCP_CAN> _upCan;
     std::shared_ptr<PylontechBatteryStats> _stats =
         std::make_shared<PylontechBatteryStats>();
 };
@@ -4,33 +4,56 @@
  */
 #pragma once
 
+#include "NetworkSettings.h"
+#include <AsyncUDP.h>
 #include <cstdint>
-#include <TaskSchedulerDeclarations.h>
+#include <mutex>
 
+/**
+ * receives the datagrams which SMA Energy Meters and Home Managers send to
+ * their multicast group. every datagram is decoded as soon as it arrives, in
+ * the context of the UDP receive task, and the time of its reception is
+ * recorded, such that the age of the values is known precisely.
+ *
+ * several meters may be present on the LAN. only the meter with the given
+ * serial number is used. if no serial number is given, the first meter seen
+ * is used.
+ */
 class SMA_HMClass {
 public:
-    void init(Scheduler& scheduler, bool verboseLogging);
-    void loop();
-    void event1();
-    float getPowerTotal() const { return _powerMeterPower; }
-    float getPowerL1() const { return _powerMeterL1; }
-    float getPowerL2() const { return _powerMeterL2; }
-    float getPowerL3() const { return _powerMeterL3; }
+    void init(bool verboseLogging, uint32_t serial);
+
+    float getPowerTotal() const;
+    float getPowerL1() const;
+    float getPowerL2() const;
+    float getPowerL3() const;
+
+    // millis() when the last datagram of the meter was received, zero if
+    // none was received yet
+    uint32_t getLastUpdate() const;
+
+    uint32_t getSerial() const;
 
 private:
-    void Soutput(int kanal, int index, int art, int tarif,
-            char const* name, float value, uint32_t timestamp);
+    void onNetworkEvent(network_event event);
+    void onPacket(AsyncUDPPacket& packet);
+    void decodeGroup(uint8_t const* data, size_t len, uint32_t receivedMillis);
 
-    uint8_t* decodeGroup(uint8_t* offset, uint16_t grouplen);
+    void Soutput(char const* name, float value, uint32_t timestamp);
+
+    AsyncUDP _udp;
 
     bool _verboseLogging = false;
+    uint32_t _configuredSerial = 0;
+
+    mutable std::mutex _mutex;
+    uint32_t _serial = 0;
     float _powerMeterPower = 0.0;
     float _powerMeterL1 = 0.0;
     float _powerMeterL2 = 0.0;
     float _powerMeterL3 = 0.0;
-    uint32_t _previousMillis = 0;
-    uint32_t _serial = 0;
-    Task _loopTask;
+    uint32_t _meterTimestamp = 0; // as sent by the meter, in ms
+    uint32_t _lastUpdate = 0;
 };
 
 extern SMA_HMClass SMA_HM;
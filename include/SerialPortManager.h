@@ -7,13 +7,16 @@ class SerialPortManagerClass {
 public:
     bool allocateMpptPort(int port);
     bool allocateBatteryPort(int port);
+    bool allocatePowerMeterPort(int port);
     void invalidateBatteryPort();
     void invalidateMpptPorts();
+    void invalidatePowerMeterPorts();
 
 private:
     enum Owner {
         BATTERY,
-        MPPT
+        MPPT,
+        POWERMETER
     };
 
     std::map<uint8_t, Owner> allocatedPorts;
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Configuration.h"
+#include <Stream.h>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * receives the SML telegrams of an electricity meter. a hardware UART is used
+ * if one is available, whose driver buffers the received data. a task of its
+ * own collects the data until a telegram is complete and parses it, such that
+ * neither the main loop nor the timing of other peripherals is affected.
+ *
+ * the values to extract are given by a table of OBIS codes. values are only
+ * taken from telegrams whose checksum is valid.
+ */
+class SmlMeter {
+public:
+    // values as configured in the OBIS table, keep the numbers stable
+    enum class Value : uint8_t {
+        None = 0,
+        PowerTotal = 1, // W
+        PowerL1 = 2,
+        PowerL2 = 3,
+        PowerL3 = 4,
+        VoltageL1 = 5, // V
+        VoltageL2 = 6,
+        VoltageL3 = 7,
+        Frequency = 8, // Hz
+        Import = 9, // Wh
+        Export = 10,
+        Count
+    };
+
+    struct Data {
+        std::array<float, static_cast<size_t>(Value::Count)> values = {};
+        uint16_t received = 0; // bit n is set if value n was received
+        uint32_t lastUpdate = 0; // millis() when the last telegram was parsed
+        uint32_t telegrams = 0; // number of telegrams parsed
+
+        bool has(Value value) const { return received & (1 << static_cast<uint8_t>(value)); }
+        float get(Value value) const { return values[static_cast<uint8_t>(value)]; }
+    };
+
+    // uses the given hardware UART, or a software serial if uart is negative
+    SmlMeter(uint8_t index, int uart, int8_t rxPin, bool verboseLogging);
+
+    bool init(POWERMETER_SML_OBIS_CONFIG_T const* obisTable, size_t obisCount);
+
+    Data getData() const;
+
+private:
+    struct ObisEntry {
+        uint8_t obis[6];
+        Value value;
+    };
+
+    static void taskEntry(void* parameter);
+    void task();
+    void receive(uint8_t byte);
+    void parseTelegram();
+
+    uint8_t _index;
+    int _uart;
+    int8_t _rxPin;
+    bool _verboseLogging;
+
+    std::unique_ptr<Stream> _upSerial;
+    TaskHandle_t _taskHandle = nullptr;
+    std::vector<ObisEntry> _obisTable;
+
+    // telegram assembly, only accessed by the task
+    std::vector<uint8_t> _telegram;
+    bool _receiving = false;
+    uint8_t _escapeCount = 0; // consecutive escape bytes
+    uint8_t _escapeBytes = 0; // still to be received after an escape sequence
+    uint8_t _startMatch = 0;
+
+    mutable std::mutex _mutex;
+    Data _data;
+
+    // the SML parser keeps its state in global variables
+    static std::mutex _parserMutex;
+
+    static constexpr size_t _maxTelegramSize = 2048;
+
+    // polling interval of the software serial, the hardware UART notifies
+    static constexpr uint32_t _softwareSerialPollMs = 20;
+};
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+#include <Arduino.h>
+#include <array>
+#include <mutex>
+#include <vector>
+
+class TaskStatisticsClass {
+public:
+    // returns a callback which executes the given callback and records its
+    // runtime and its scheduling lateness under the given name. must only be
+    // called while starting up. safe to be called from constructors of global
+    // objects, as this class is constant initialized. the name must have
+    // static storage duration.
+    TaskCallback wrap(char const* name, TaskCallback callback);
+
+    struct TaskSnapshot {
+        char const* name;
+        uint32_t runs;
+        uint32_t minUs;
+        uint32_t avgUs;
+        uint32_t maxUs;
+        uint32_t p99Us;
+        uint32_t avgLatenessUs;
+        uint32_t maxLatenessUs;
+        float cpuPercent;
+    };
+    std::vector<TaskSnapshot> getTaskSnapshots();
+
+    struct RtosTaskSnapshot {
+        String name;
+        uint32_t stackHighWaterMark; // bytes
+        float cpuPercent; // negative if unknown
+    };
+    std::vector<RtosTaskSnapshot> getRtosTaskSnapshots();
+
+private:
+    // runtimes are collected in buckets of power-of-two microseconds, i.e.,
+    // bucket n holds all runs which took [2^n, 2^(n+1)) us. the last bucket
+    // also holds all runs taking longer than that.
+    static constexpr size_t _bucketCount = 21;
+
+    struct Entry {
+        char const* name = nullptr;
+        uint32_t runs = 0;
+        uint32_t minUs = UINT32_MAX;
+        uint32_t maxUs = 0;
+        uint64_t totalUs = 0;
+        uint32_t latenessRuns = 0;
+        uint64_t totalLatenessUs = 0;
+        uint32_t maxLatenessUs = 0;
+        int64_t lastStartUs = -1;
+        std::array<uint32_t, _bucketCount> buckets = {};
+    };
+
+    void record(size_t idx, int64_t startUs, int64_t endUs, uint32_t intervalMs);
+
+    static constexpr size_t _maxEntries = 48;
+    std::array<Entry, _maxEntries> _entries = {};
+    size_t _entryCount = 0;
+
+    std::mutex _mutex;
+};
+
+extern TaskStatisticsClass TaskStatistics;
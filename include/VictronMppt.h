@@ -1,11 +1,14 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include <map>
 #include <mutex>
 #include <memory>
+#include <WiFiUdp.h>
 
 #include "VeDirectMpptController.h"
 #include "Configuration.h"
+#include "NetworkSettings.h"
 #include <TaskSchedulerDeclarations.h>
 
 class VictronMpptClass {
@@ -26,11 +29,14 @@ public:
 
     size_t controllerAmount() const { return _controllers.size(); }
     std::optional<VeDirectMpptController::data_t> getData(size_t idx = 0) const;
+    std::optional<VeDirectMpptController::Statistics> getStatistics(size_t idx) const;
 
-    // total output of all MPPT charge controllers in Watts
+    // total output of all MPPT charge controllers in Watts. the
+    // contribution of each controller is weighted by its data's freshness.
     int32_t getPowerOutputWatts() const;
 
-    // total panel input power of all MPPT charge controllers in Watts
+    // total panel input power of all MPPT charge controllers in Watts. the
+    // contribution of each controller is weighted by its data's freshness.
     int32_t getPanelPowerWatts() const;
 
     // sum of total yield of all MPPT charge controllers in kWh
@@ -56,6 +62,18 @@ private:
     std::vector<controller_t> _controllers;
 
     bool initController(int8_t rx, int8_t tx, bool logging, int hwSerialPort);
+
+    // VE.Direct data forwarded over UDP by serial-to-network bridges. each
+    // sender (IP address) is handled as an individual charge controller.
+    void loopForwarded();
+    void onNetworkEvent(network_event event);
+    void openUdp();
+    std::unique_ptr<WiFiUDP> _upUdp;
+    bool _networkReady = false;
+    std::map<uint32_t, size_t> _forwardedControllers; // IP address to index in _controllers
+    static constexpr size_t _maxForwardedControllers = 8;
+
+    float getFreshnessWeight(VeDirectMpptController const& controller) const;
 };
 
 extern VictronMpptClass VictronMppt;
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <array>
+#include <optional>
+#include <stdint.h>
+
+/**
+ * estimates the battery voltage sag caused by the inverter's load, i.e., the
+ * factor used to calculate the load corrected voltage, using recursive least
+ * squares. the model is V = V0 - k * P, where V is the battery voltage at the
+ * inverter's load P, V0 is the voltage without load and k is the factor.
+ *
+ * older samples are forgotten exponentially, such that the estimate follows
+ * the internal resistance as it changes with temperature, SoC and aging.
+ */
+class VoltageSagEstimator {
+public:
+    void reset();
+
+    void addSample(float voltage, float powerWatts);
+
+    // the estimated factor in volts per watt, if the samples
+    // seen so far allow to estimate it with sufficient confidence.
+    std::optional<float> getFactor() const;
+
+    // the estimated battery voltage without load, if the factor is known
+    std::optional<float> getUnloadedVoltage() const;
+
+    uint32_t getSampleCount() const { return _sampleCount; }
+
+private:
+    // samples are forgotten with a time constant of 1 / (1 - lambda) samples
+    static constexpr float _forgettingFactor = 0.995;
+
+    // caps the covariance, which grows while the load does not change
+    static constexpr float _maxCovarianceTrace = 1000;
+
+    // samples which deviate this much from the estimate are not used
+    static constexpr float _maxErrorVolts = 5;
+
+    // the covariance of the factor (in (V/kW)^2, relative to the variance of
+    // the voltage measurement noise) must be below this value to be trusted
+    static constexpr float _maxFactorVariance = 0.5;
+
+    static constexpr uint32_t _minSamples = 30;
+
+    // plausible range of the factor in V/kW
+    static constexpr float _maxFactor = 10;
+
+    // the parameters are the voltage at average load in volts and k in volts
+    // per kilowatt, which keeps both of them in a similar order of magnitude.
+    std::array<float, 2> _theta = {};
+    float _meanPowerKw = 0;
+    std::array<std::array<float, 2>, 2> _covariance = {};
+    uint32_t _sampleCount = 0;
+};
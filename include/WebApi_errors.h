@@ -90,4 +90,8 @@ enum WebApiError {
 
     HardwareBase = 12000,
     HardwarePinMappingLength,
+
+    FirmwareBase = 13000,
+    FirmwarePullStarted,
+    FirmwarePullFailed,
 };
@@ -11,4 +11,9 @@ public:
 private:
     void onFirmwareUpdateFinish(AsyncWebServerRequest* request);
     void onFirmwareUpdateUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final);
+    void onFirmwareStatus(AsyncWebServerRequest* request);
+    void onFirmwarePull(AsyncWebServerRequest* request);
+
+    // position of the current upload request's data within the image
+    size_t _uploadOffset = 0;
 };
@@ -11,4 +11,5 @@ public:
 private:
     void onLimitStatus(AsyncWebServerRequest* request);
     void onLimitPost(AsyncWebServerRequest* request);
+    void onLimitLatency(AsyncWebServerRequest* request);
 };
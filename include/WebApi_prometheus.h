@@ -17,6 +17,14 @@ private:
 
     void addPanelInfo(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel);
 
+    void addRadioStats(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv);
+
+    void addTaskStatistics(AsyncResponseStream* stream);
+
+    void addCommandLatency(AsyncResponseStream* stream);
+
+    void addVoltageSagEstimate(AsyncResponseStream* stream);
+
     enum MetricType_t {
         NONE = 0,
         GAUGE,
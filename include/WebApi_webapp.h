@@ -3,11 +3,41 @@
 
 #include <ESPAsyncWebServer.h>
 #include <TaskSchedulerDeclarations.h>
+#include <map>
 
+#define WEBAPP_OVERLAY_DIR "/webapp"
+
+/**
+ * serves the web application embedded in the firmware. files stored in the
+ * WEBAPP_OVERLAY_DIR directory of the filesystem take precedence, such that a
+ * newer web application can be installed without flashing the firmware.
+ *
+ * every asset is also available as "<name>.<hash>.<extension>", where <hash>
+ * are the first eight hex digits of the MD5 hash of the asset as it is sent.
+ * such URLs never change their content and may be cached for good, while the
+ * plain URLs must be revalidated using the ETag.
+ */
 class WebApiWebappClass {
 public:
     void init(AsyncWebServer& server, Scheduler& scheduler);
 
 private:
-    void responseBinaryDataWithETagCache(AsyncWebServerRequest* request, const String &contentType, const String &contentEncoding, const uint8_t *content, size_t len);
+    struct Asset {
+        String contentType;
+        String contentEncoding;
+        const uint8_t* content = nullptr; // embedded in the firmware
+        size_t len = 0;
+        String file; // stored in the overlay directory
+        String md5;
+    };
+
+    void addEmbeddedAsset(const String& url, const String& contentType, const String& contentEncoding, const uint8_t* start, const uint8_t* end);
+    void loadOverlay(const String& directory);
+    const Asset* findAsset(const String& url, bool& immutable) const;
+    void onAssetRequest(AsyncWebServerRequest* request);
+    void responseAssetWithCache(AsyncWebServerRequest* request, const Asset& asset, bool immutable);
+
+    static String getContentType(const String& url);
+
+    std::map<String, Asset> _assets;
 };
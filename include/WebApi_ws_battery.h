@@ -22,6 +22,9 @@ private:
     uint32_t _lastUpdateCheck = 0;
     static constexpr uint16_t _responseSize = 1024 + 512;
 
+    // the combined live view of several batteries includes each battery's data
+    static size_t getResponseSize();
+
     std::mutex _mutex;
 
     Task _wsCleanupTask;
@@ -14,6 +14,7 @@ public:
 
 private:
     static void generateInverterCommonJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
+    static void generateInverterRadioJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
     static void generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv);
     static void generateCommonJsonResponse(JsonVariant& root);
 
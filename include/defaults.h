@@ -78,6 +78,7 @@
 #define MQTT_LWT_OFFLINE "offline"
 #define MQTT_LWT_QOS 2U
 #define MQTT_PUBLISH_INTERVAL 5U
+#define MQTT_TASK_STATS_INTERVAL 0U
 #define MQTT_CLEAN_SESSION true
 
 #define DTU_SERIAL 0x99978563412U
@@ -113,12 +114,17 @@
 #define VEDIRECT_ENABLED false
 #define VEDIRECT_VERBOSE_LOGGING false
 #define VEDIRECT_UPDATESONLY true
+#define VEDIRECT_UDP_PORT 0
 
 #define POWERMETER_ENABLED false
 #define POWERMETER_INTERVAL 10
 #define POWERMETER_SOURCE 2
 #define POWERMETER_SDMBAUDRATE 9600
 #define POWERMETER_SDMADDRESS 1
+#define POWERMETER_FILTER_MODE 0
+#define POWERMETER_FILTER_WINDOW 5
+#define POWERMETER_FILTER_HAMPEL_THRESHOLD 3.0
+#define POWERMETER_FILTER_TIME_CONSTANT 0
 
 #define POWERLIMITER_ENABLED false
 #define POWERLIMITER_SOLAR_PASSTHROUGH_ENABLED true
@@ -139,10 +145,13 @@
 #define POWERLIMITER_VOLTAGE_START_THRESHOLD 50.0
 #define POWERLIMITER_VOLTAGE_STOP_THRESHOLD 49.0
 #define POWERLIMITER_VOLTAGE_LOAD_CORRECTION_FACTOR 0.001
+#define POWERLIMITER_VOLTAGE_LOAD_CORRECTION_AUTO false
 #define POWERLIMITER_RESTART_HOUR -1
 #define POWERLIMITER_FULL_SOLAR_PASSTHROUGH_SOC 100
 #define POWERLIMITER_FULL_SOLAR_PASSTHROUGH_START_VOLTAGE 100.0
 #define POWERLIMITER_FULL_SOLAR_PASSTHROUGH_STOP_VOLTAGE 100.0
+#define POWERLIMITER_USE_BATTERY_DISCHARGE_LIMIT false
+#define POWERLIMITER_BATTERY_DISCHARGE_LIMIT_MARGIN 10 // percent
 
 #define BATTERY_ENABLED false
 #define BATTERY_PROVIDER 0 // Pylontech CAN receiver
@@ -155,5 +164,9 @@
 #define HUAWEI_AUTO_POWER_ENABLE_VOLTAGE_LIMIT 42.0
 #define HUAWEI_AUTO_POWER_LOWER_POWER_LIMIT 150
 #define HUAWEI_AUTO_POWER_UPPER_POWER_LIMIT 2000
+#define HUAWEI_AUTO_POWER_TARGET_GRID_POWER 0
+#define HUAWEI_AUTO_POWER_DEADBAND 25
+#define HUAWEI_AUTO_POWER_PROPORTIONAL_GAIN 0.3
+#define HUAWEI_AUTO_POWER_INTEGRAL_GAIN 0.2
 
 #define VERBOSE_LOGGING true
@@ -66,7 +66,7 @@ void HoymilesClass::loop()
                 _messageOutput->print("Fetch inverter: ");
                 _messageOutput->println(iv->serial(), HEX);
 
-                if (!iv->isReachable()) {
+                if (iv->isChannelChangeRequestDue()) {
                     iv->sendChangeChannelRequest();
                 }
 
@@ -274,6 +274,28 @@ void HoymilesClass::setVerboseLogging(bool verboseLogging)
     _verboseLogging = verboseLogging;
 }
 
+// requests the statistics, the device info and the limit of all inverters
+// right away, instead of fetching them one after another by the regular poll,
+// which only starts once the poll interval elapsed. the requests require the
+// time to be set, i.e., this is effective after a software or watchdog reset.
+void HoymilesClass::requestInitialData()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& iv : _inverters) {
+        if (!iv->getRadio()->isInitialized()) {
+            continue;
+        }
+
+        if (!iv->sendStatsRequest()) {
+            continue;
+        }
+
+        iv->sendDevInfoRequest();
+        iv->sendSystemConfigParaRequest();
+    }
+}
+
 void HoymilesClass::setMessageOutput(Print* output)
 {
     _messageOutput = output;
@@ -19,6 +19,7 @@ public:
     void initNRF(SPIClass* initialisedSpiBus, const uint8_t pinCE, const uint8_t pinIRQ);
     void initCMT(const int8_t pin_sdio, const int8_t pin_clk, const int8_t pin_cs, const int8_t pin_fcs, const int8_t pin_gpio2, const int8_t pin_gpio3);
     void loop();
+    void requestInitialData();
 
     void setMessageOutput(Print* output);
     Print* getMessageOutput();
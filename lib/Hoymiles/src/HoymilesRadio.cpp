@@ -41,7 +41,15 @@ void HoymilesRadio::sendRetransmitPacket(const uint8_t fragment_id)
     CommandAbstract* requestCmd = cmd->getRequestFrameCommand(fragment_id);
 
     if (requestCmd != nullptr) {
+        cmd->incrementRetransmitCount();
         sendEsbPacket(*requestCmd);
+
+        // Wait only as long as this inverter usually needs to answer
+        auto inv = Hoymiles.getInverterBySerial(cmd->getTargetAddress());
+        if (nullptr != inv) {
+            markTransmitted(*inv, true);
+            _rxTimeout.set(inv->getRetransmitTimeout(requestCmd->getTimeout()));
+        }
     }
 }
 
@@ -60,9 +68,11 @@ void HoymilesRadio::handleReceivedPackage()
         if (nullptr != inv) {
             CommandAbstract* cmd = _commandQueue.front().get();
             uint8_t verifyResult = inv->verifyAllFragments(*cmd);
+            inv->addRadioResult(verifyResult);
             if (verifyResult == FRAGMENT_ALL_MISSING_RESEND) {
                 Hoymiles.getMessageOutput()->println("Nothing received, resend whole request");
                 sendLastPacketAgain();
+                markTransmitted(*inv, false);
 
             } else if (verifyResult == FRAGMENT_ALL_MISSING_TIMEOUT) {
                 Hoymiles.getMessageOutput()->println("Nothing received, resend count exeeded");
@@ -106,6 +116,7 @@ void HoymilesRadio::handleReceivedPackage()
             if (nullptr != inv) {
                 inv->clearRxFragmentBuffer();
                 sendEsbPacket(*cmd);
+                markTransmitted(*inv, false);
             } else {
                 Hoymiles.getMessageOutput()->println("TX: Invalid inverter found");
                 _commandQueue.pop();
@@ -114,6 +125,42 @@ void HoymilesRadio::handleReceivedPackage()
     }
 }
 
+void HoymilesRadio::handleReceivedFragment(InverterAbstract& inv, const fragment_t& fragment)
+{
+    inv.addRadioRxFragment(fragment.rssi);
+
+    // The round trip time is measured from the last request to the first
+    // fragment of its answer, fragments of other inverters do not count.
+    if (_awaitingFirstFragment && _busyFlag && !isQueueEmpty()
+        && _commandQueue.front().get()->getTargetAddress() == inv.serial()) {
+        _awaitingFirstFragment = false;
+        inv.addRadioRtt(millis() - _lastTxMillis);
+    }
+
+    inv.addRxFragment(fragment.fragment, fragment.len);
+}
+
+void HoymilesRadio::handleCorruptFragment()
+{
+    // A corrupted fragment cannot be assigned by its content. It is
+    // accounted to the inverter the current request is waiting for.
+    if (!_busyFlag || isQueueEmpty()) {
+        return;
+    }
+
+    auto inv = Hoymiles.getInverterBySerial(_commandQueue.front().get()->getTargetAddress());
+    if (nullptr != inv) {
+        inv->addRadioRxCrcError();
+    }
+}
+
+void HoymilesRadio::markTransmitted(InverterAbstract& inv, const bool isRetransmit)
+{
+    inv.addRadioTx(isRetransmit);
+    _lastTxMillis = millis();
+    _awaitingFirstFragment = true;
+}
+
 void HoymilesRadio::dumpBuf(const uint8_t buf[], const uint8_t len, const bool appendNewline)
 {
     for (uint8_t i = 0; i < len; i++) {
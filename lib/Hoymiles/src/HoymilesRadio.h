@@ -4,9 +4,12 @@
 #include "TimeoutHelper.h"
 #include "commands/CommandAbstract.h"
 #include "types.h"
+#include <Arduino.h>
 #include <memory>
 #include <ThreadSafeQueue.h>
 
+class InverterAbstract;
+
 class HoymilesRadio {
 public:
     serial_u DtuSerial() const;
@@ -18,6 +21,7 @@ public:
 
     void enqueCommand(std::shared_ptr<CommandAbstract> cmd)
     {
+        cmd->setEnqueueTime(millis());
         _commandQueue.push(cmd);
     }
 
@@ -36,6 +40,8 @@ protected:
     void sendRetransmitPacket(const uint8_t fragment_id);
     void sendLastPacketAgain();
     void handleReceivedPackage();
+    void handleReceivedFragment(InverterAbstract& inv, const fragment_t& fragment);
+    void handleCorruptFragment();
 
     serial_u _dtuSerial;
     ThreadSafeQueue<std::shared_ptr<CommandAbstract>> _commandQueue;
@@ -43,4 +49,10 @@ protected:
     bool _busyFlag = false;
 
     TimeoutHelper _rxTimeout;
+
+private:
+    void markTransmitted(InverterAbstract& inv, const bool isRetransmit);
+
+    uint32_t _lastTxMillis = 0;
+    bool _awaitingFirstFragment = false;
 };
\ No newline at end of file
@@ -169,7 +169,7 @@ void HoymilesRadio_CMT::loop()
                         dumpBuf(f.fragment, f.len, false);
                         Hoymiles.getVerboseMessageOutput()->printf("| %d dBm\r\n", f.rssi);
 
-                        inv->addRxFragment(f.fragment, f.len);
+                        handleReceivedFragment(*inv, f);
                     } else {
                         Hoymiles.getMessageOutput()->println("Inverter Not found!");
                     }
@@ -177,6 +177,7 @@ void HoymilesRadio_CMT::loop()
 
             } else {
                 Hoymiles.getMessageOutput()->println("Frame kaputt"); // ;-)
+                handleCorruptFragment();
             }
 
             // Remove paket from buffer even it was corrupted
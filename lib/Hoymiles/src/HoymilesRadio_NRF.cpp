@@ -80,13 +80,14 @@ void HoymilesRadio_NRF::loop()
                     dumpBuf(f.fragment, f.len, false);
                     Hoymiles.getVerboseMessageOutput()->printf("| %d dBm\r\n", f.rssi);
 
-                    inv->addRxFragment(f.fragment, f.len);
+                    handleReceivedFragment(*inv, f);
                 } else {
                     Hoymiles.getMessageOutput()->println("Inverter Not found!");
                 }
 
             } else {
                 Hoymiles.getMessageOutput()->println("Frame kaputt");
+                handleCorruptFragment();
             }
 
             // Remove paket from buffer even it was corrupted
@@ -79,6 +79,7 @@ bool ActivePowerControlCommand::handleResponse(InverterAbstract& inverter, const
         }
     }
     inverter.SystemConfigPara()->setLastUpdateCommand(millis());
+    inverter.SystemConfigPara()->setLastLimitCommandTiming(getTiming(millis()));
     inverter.SystemConfigPara()->setLastLimitCommandSuccess(CMD_OK);
     return true;
 }
@@ -28,6 +28,7 @@ Source Address: 80 12 23 04
 */
 #include "CommandAbstract.h"
 #include "crc.h"
+#include <Arduino.h>
 #include <string.h>
 
 CommandAbstract::CommandAbstract(const uint64_t target_address, const uint64_t router_address)
@@ -104,9 +105,33 @@ uint8_t CommandAbstract::getSendCount() const
 
 uint8_t CommandAbstract::incrementSendCount()
 {
+    if (_sendCount == 0) {
+        _firstSendTime = millis();
+    }
     return _sendCount++;
 }
 
+void CommandAbstract::setEnqueueTime(const uint32_t millis)
+{
+    _enqueueTime = millis;
+}
+
+uint8_t CommandAbstract::incrementRetransmitCount()
+{
+    return _retransmitCount++;
+}
+
+command_timing_t CommandAbstract::getTiming(const uint32_t acknowledged) const
+{
+    command_timing_t timing;
+    timing.enqueued = _enqueueTime;
+    timing.firstSent = _firstSendTime;
+    timing.acknowledged = acknowledged;
+    timing.sendCount = _sendCount;
+    timing.retransmitCount = _retransmitCount;
+    return timing;
+}
+
 CommandAbstract* CommandAbstract::getRequestFrameCommand(const uint8_t frame_no)
 {
     return nullptr;
@@ -36,6 +36,12 @@ public:
     uint8_t getSendCount() const;
     uint8_t incrementSendCount();
 
+    void setEnqueueTime(const uint32_t millis);
+    uint8_t incrementRetransmitCount();
+
+    // Returns the timing of this command, assuming it was acknowledged at the given time
+    command_timing_t getTiming(const uint32_t acknowledged) const;
+
     virtual CommandAbstract* getRequestFrameCommand(const uint8_t frame_no);
 
     virtual bool handleResponse(InverterAbstract& inverter, const fragment_t fragment[], const uint8_t max_fragment_id) = 0;
@@ -52,6 +58,9 @@ protected:
     uint8_t _payload_size;
     uint32_t _timeout;
     uint8_t _sendCount;
+    uint8_t _retransmitCount = 0;
+    uint32_t _enqueueTime = 0;
+    uint32_t _firstSendTime = 0;
 
     uint64_t _targetAddress;
     uint64_t _routerAddress;
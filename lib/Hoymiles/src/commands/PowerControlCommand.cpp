@@ -51,6 +51,8 @@ bool PowerControlCommand::handleResponse(InverterAbstract& inverter, const fragm
     }
 
     inverter.PowerCommand()->setLastUpdateCommand(millis());
+    inverter.PowerCommand()->setLastPowerCommandOn(_payload[10] != 0x01); // not TurnOff
+    inverter.PowerCommand()->setLastPowerCommandTiming(getTiming(millis()));
     inverter.PowerCommand()->setLastPowerCommandSuccess(CMD_OK);
     return true;
 }
@@ -4,14 +4,39 @@
  */
 #include "crc.h"
 
+#include <array>
+
+// Lookup tables holding the CRC of every possible byte value, generated at
+// compile time. This replaces the inner loop over the eight bits of a byte.
+static constexpr std::array<uint8_t, 256> crc8Table = [] {
+    std::array<uint8_t, 256> table = {};
+    for (uint16_t i = 0; i < 256; i++) {
+        uint8_t crc = i;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+
+static constexpr std::array<uint16_t, 256> crc16Table = [] {
+    std::array<uint16_t, 256> table = {};
+    for (uint16_t i = 0; i < 256; i++) {
+        uint16_t crc = i;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ ((crc & 0x0001) ? CRC16_MODBUS_POLYNOM : 0x0000);
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+
 uint8_t crc8(const uint8_t buf[], const uint8_t len)
 {
     uint8_t crc = CRC8_INIT;
     for (uint8_t i = 0; i < len; i++) {
-        crc ^= buf[i];
-        for (uint8_t b = 0; b < 8; b++) {
-            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
-        }
+        crc = crc8Table[crc ^ buf[i]];
     }
     return crc;
 }
@@ -19,16 +44,8 @@ uint8_t crc8(const uint8_t buf[], const uint8_t len)
 uint16_t crc16(const uint8_t buf[], const uint8_t len, const uint16_t start)
 {
     uint16_t crc = start;
-    uint8_t shift = 0;
-
     for (uint8_t i = 0; i < len; i++) {
-        crc = crc ^ buf[i];
-        for (uint8_t bit = 0; bit < 8; bit++) {
-            shift = (crc & 0x0001);
-            crc = crc >> 1;
-            if (shift != 0)
-                crc = crc ^ 0xA001;
-        }
+        crc = (crc >> 8) ^ crc16Table[(crc ^ buf[i]) & 0xff];
     }
     return crc;
 }
@@ -5,8 +5,19 @@
 #include "InverterAbstract.h"
 #include "../Hoymiles.h"
 #include "crc.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
+// Weight of a new value in the moving averages of the radio statistics
+#define RADIO_STATS_EMA_WEIGHT 0.125f
+
+// Below this link quality whole requests are resent at most once
+#define LINK_QUALITY_POOR 0.25f
+
+// Channel change requests are sent at most every 2^n poll cycles
+#define CHANNEL_CHANGE_MAX_BACKOFF 3
+
 InverterAbstract::InverterAbstract(HoymilesRadio* radio, const uint64_t serial)
 {
     _serial.u64 = serial;
@@ -223,7 +234,15 @@ uint8_t InverterAbstract::verifyAllFragments(CommandAbstract& cmd)
     // All missing
     if (_rxFragmentLastPacketId == 0) {
         Hoymiles.getMessageOutput()->println("All missing");
-        if (cmd.getSendCount() <= cmd.getMaxResendCount()) {
+
+        // Do not waste airtime on inverters which barely answer.
+        // A single resend still bridges a single lost request.
+        uint8_t maxResendCount = cmd.getMaxResendCount();
+        if (_linkQuality < LINK_QUALITY_POOR) {
+            maxResendCount = std::min<uint8_t>(maxResendCount, 1);
+        }
+
+        if (cmd.getSendCount() <= maxResendCount) {
             return FRAGMENT_ALL_MISSING_RESEND;
         } else {
             cmd.gotTimeout(*this);
@@ -261,4 +280,122 @@ uint8_t InverterAbstract::verifyAllFragments(CommandAbstract& cmd)
     }
 
     return FRAGMENT_OK;
-}
\ No newline at end of file
+}
+
+void InverterAbstract::addRadioTx(const bool isRetransmit)
+{
+    if (isRetransmit) {
+        _radioStats.TxReRequestFragment++;
+    } else {
+        _radioStats.TxRequestData++;
+    }
+}
+
+void InverterAbstract::addRadioRxFragment(const int8_t rssi)
+{
+    if (_radioStats.RxFragments++ == 0) {
+        _radioStats.RssiAverage = rssi;
+    } else {
+        _radioStats.RssiAverage += RADIO_STATS_EMA_WEIGHT * (rssi - _radioStats.RssiAverage);
+    }
+    _radioStats.RssiLast = rssi;
+}
+
+void InverterAbstract::addRadioRtt(const uint32_t rtt)
+{
+    _radioStats.RttLast = rtt;
+
+    if (!_hasRttSample) {
+        _radioStats.RttAverage = rtt;
+        _radioStats.RttVariance = rtt / 2.0f;
+        _hasRttSample = true;
+        return;
+    }
+
+    // Smoothed round trip time and its mean deviation (like RFC 6298)
+    const float deviation = std::fabs(_radioStats.RttAverage - rtt);
+    _radioStats.RttVariance += 2 * RADIO_STATS_EMA_WEIGHT * (deviation - _radioStats.RttVariance);
+    _radioStats.RttAverage += RADIO_STATS_EMA_WEIGHT * (rtt - _radioStats.RttAverage);
+}
+
+void InverterAbstract::addRadioRxCrcError()
+{
+    _radioStats.RxCrcErrors++;
+}
+
+void InverterAbstract::addRadioResult(const uint8_t verifyResult)
+{
+    float result;
+
+    switch (verifyResult) {
+    case FRAGMENT_OK:
+        _radioStats.RxSuccess++;
+        result = 1;
+        break;
+    case FRAGMENT_ALL_MISSING_TIMEOUT:
+        _radioStats.RxFailNoAnswer++;
+        result = 0;
+        break;
+    case FRAGMENT_RETRANSMIT_TIMEOUT:
+        _radioStats.RxFailPartialAnswer++;
+        result = 0;
+        break;
+    case FRAGMENT_HANDLE_ERROR:
+        _radioStats.RxFailCorruptData++;
+        result = 0;
+        break;
+    default:
+        // Request is not finished yet
+        return;
+    }
+
+    _linkQuality += RADIO_STATS_EMA_WEIGHT * (result - _linkQuality);
+}
+
+const radio_stats_t& InverterAbstract::getRadioStats() const
+{
+    return _radioStats;
+}
+
+void InverterAbstract::resetRadioStats()
+{
+    _radioStats = {};
+    _hasRttSample = false;
+    _linkQuality = 1.0;
+}
+
+uint8_t InverterAbstract::getLinkQuality() const
+{
+    return std::lround(_linkQuality * 100);
+}
+
+uint32_t InverterAbstract::getRetransmitTimeout(const uint32_t defaultTimeout) const
+{
+    if (!_hasRttSample) {
+        return defaultTimeout;
+    }
+
+    const uint32_t timeout = std::lround(_radioStats.RttAverage + 4 * _radioStats.RttVariance);
+    return std::clamp<uint32_t>(timeout, defaultTimeout / 2, defaultTimeout * 2);
+}
+
+bool InverterAbstract::isChannelChangeRequestDue()
+{
+    if (isReachable()) {
+        _channelChangeBackoff = 0;
+        _channelChangeSkipCnt = 0;
+        return false;
+    }
+
+    if (_channelChangeSkipCnt > 0) {
+        _channelChangeSkipCnt--;
+        return false;
+    }
+
+    _channelChangeSkipCnt = (1 << _channelChangeBackoff) - 1;
+    if (_channelChangeBackoff < CHANNEL_CHANGE_MAX_BACKOFF) {
+        _channelChangeBackoff++;
+    }
+
+    return true;
+}
@@ -28,6 +28,22 @@ enum {
 
 class CommandAbstract;
 
+typedef struct {
+    uint32_t TxRequestData; // whole requests sent (including resends)
+    uint32_t TxReRequestFragment; // single missing fragments requested again
+    uint32_t RxFragments; // fragments received with a valid CRC
+    uint32_t RxCrcErrors; // corrupted fragments received while waiting for this inverter
+    uint32_t RxSuccess; // requests answered completely
+    uint32_t RxFailNoAnswer; // requests not answered at all
+    uint32_t RxFailPartialAnswer; // requests which still lacked fragments after all retransmits
+    uint32_t RxFailCorruptData; // requests answered with data which could not be handled
+    int8_t RssiLast; // dBm, the NRF24 only distinguishes -30 (strong) and -80 (weak)
+    float RssiAverage;
+    uint32_t RttLast; // ms from sending a request until its first fragment was received
+    float RttAverage;
+    float RttVariance;
+} radio_stats_t;
+
 class InverterAbstract {
 public:
     explicit InverterAbstract(HoymilesRadio* radio, const uint64_t serial);
@@ -62,6 +78,26 @@ public:
     void addRxFragment(const uint8_t fragment[], const uint8_t len);
     uint8_t verifyAllFragments(CommandAbstract& cmd);
 
+    void addRadioTx(const bool isRetransmit);
+    void addRadioRxFragment(const int8_t rssi);
+    void addRadioRtt(const uint32_t rtt);
+    void addRadioRxCrcError();
+    void addRadioResult(const uint8_t verifyResult);
+    const radio_stats_t& getRadioStats() const;
+    void resetRadioStats();
+
+    // Share of recent requests which were answered completely (0-100 %)
+    uint8_t getLinkQuality() const;
+
+    // Time to wait for a single requested fragment, derived from the
+    // measured round trip time and limited to a range around the default.
+    uint32_t getRetransmitTimeout(const uint32_t defaultTimeout) const;
+
+    // Returns true if a channel change request should be sent in this poll
+    // cycle. While the inverter is not reachable the requests are sent with
+    // exponentially increasing distance to save airtime.
+    bool isChannelChangeRequestDue();
+
     virtual bool sendStatsRequest() = 0;
     virtual bool sendAlarmLogRequest(const bool force = false) = 0;
     virtual bool sendDevInfoRequest() = 0;
@@ -95,6 +131,12 @@ private:
     uint8_t _rxFragmentLastPacketId = 0;
     uint8_t _rxFragmentRetransmitCnt = 0;
 
+    radio_stats_t _radioStats = {};
+    bool _hasRttSample = false;
+    float _linkQuality = 1.0;
+    uint8_t _channelChangeBackoff = 0;
+    uint8_t _channelChangeSkipCnt = 0;
+
     bool _enablePolling = true;
     bool _enableCommands = true;
 
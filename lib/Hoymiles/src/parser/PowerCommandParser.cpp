@@ -23,4 +23,33 @@ void PowerCommandParser::setLastUpdateCommand(const uint32_t lastUpdate)
 {
     _lastUpdateCommand = lastUpdate;
     setLastUpdate(lastUpdate);
-}
\ No newline at end of file
+}
+void PowerCommandParser::setLastPowerCommandTiming(const command_timing_t& timing)
+{
+    HOY_SEMAPHORE_TAKE();
+    _lastPowerCommandTiming = timing;
+    HOY_SEMAPHORE_GIVE();
+}
+
+command_timing_t PowerCommandParser::getLastPowerCommandTiming() const
+{
+    HOY_SEMAPHORE_TAKE();
+    const command_timing_t ret = _lastPowerCommandTiming;
+    HOY_SEMAPHORE_GIVE();
+    return ret;
+}
+
+void PowerCommandParser::setLastPowerCommandOn(const bool on)
+{
+    HOY_SEMAPHORE_TAKE();
+    _lastPowerCommandOn = on;
+    HOY_SEMAPHORE_GIVE();
+}
+
+bool PowerCommandParser::getLastPowerCommandOn() const
+{
+    HOY_SEMAPHORE_TAKE();
+    const bool ret = _lastPowerCommandOn;
+    HOY_SEMAPHORE_GIVE();
+    return ret;
+}
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 #include "Parser.h"
+#include "../types.h"
 
 class PowerCommandParser : public Parser {
 public:
@@ -9,8 +10,19 @@ public:
     uint32_t getLastUpdateCommand() const;
     void setLastUpdateCommand(const uint32_t lastUpdate);
 
+    void setLastPowerCommandTiming(const command_timing_t& timing);
+    command_timing_t getLastPowerCommandTiming() const;
+
+    // whether the inverter shall produce after the last acknowledged
+    // command, i.e., it was turned on or restarted
+    void setLastPowerCommandOn(const bool on);
+    bool getLastPowerCommandOn() const;
+
 private:
     LastCommandSuccess _lastLimitCommandSuccess = CMD_OK; // Set to OK because we have to assume nothing is done at startup
 
     uint32_t _lastUpdateCommand = 0;
+
+    command_timing_t _lastPowerCommandTiming = {};
+    bool _lastPowerCommandOn = true;
 };
\ No newline at end of file
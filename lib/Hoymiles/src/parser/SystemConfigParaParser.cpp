@@ -65,6 +65,21 @@ void SystemConfigParaParser::setLastUpdateCommand(const uint32_t lastUpdate)
     setLastUpdate(lastUpdate);
 }
 
+void SystemConfigParaParser::setLastLimitCommandTiming(const command_timing_t& timing)
+{
+    HOY_SEMAPHORE_TAKE();
+    _lastLimitCommandTiming = timing;
+    HOY_SEMAPHORE_GIVE();
+}
+
+command_timing_t SystemConfigParaParser::getLastLimitCommandTiming() const
+{
+    HOY_SEMAPHORE_TAKE();
+    const command_timing_t ret = _lastLimitCommandTiming;
+    HOY_SEMAPHORE_GIVE();
+    return ret;
+}
+
 void SystemConfigParaParser::setLastLimitRequestSuccess(const LastCommandSuccess status)
 {
     _lastLimitRequestSuccess = status;
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 #include "Parser.h"
+#include "../types.h"
 
 #define SYSTEM_CONFIG_PARA_SIZE 16
 
@@ -18,6 +19,9 @@ public:
     uint32_t getLastUpdateCommand() const;
     void setLastUpdateCommand(const uint32_t lastUpdate);
 
+    void setLastLimitCommandTiming(const command_timing_t& timing);
+    command_timing_t getLastLimitCommandTiming() const;
+
     void setLastLimitRequestSuccess(const LastCommandSuccess status);
     LastCommandSuccess getLastLimitRequestSuccess() const;
     uint32_t getLastUpdateRequest() const;
@@ -35,4 +39,6 @@ private:
 
     uint32_t _lastUpdateCommand = 0;
     uint32_t _lastUpdateRequest = 0;
+
+    command_timing_t _lastLimitCommandTiming = {};
 };
\ No newline at end of file
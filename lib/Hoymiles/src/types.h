@@ -19,3 +19,11 @@ typedef struct {
     int8_t rssi;
     bool wasReceived;
 } fragment_t;
+
+typedef struct {
+    uint32_t enqueued; // millis() when the command was put into the queue
+    uint32_t firstSent; // millis() when the command was sent the first time
+    uint32_t acknowledged; // millis() when the response was handled
+    uint8_t sendCount; // how often the whole command was sent
+    uint8_t retransmitCount; // how often missing fragments were requested
+} command_timing_t;
@@ -189,6 +189,17 @@ void checkMagicByte(unsigned char &byte)
   }
 }
 
+/* discards a partially received transmission */
+void smlReset()
+{
+  currentState = SML_START;
+  currentLevel = 0;
+  crc = 0xFFFF;
+  crcReceived = 0x0000;
+  len = 4;
+  listPos = 0;
+}
+
 sml_states_t smlState(unsigned char &currentByte)
 {
   unsigned char size;
@@ -403,3 +414,11 @@ void smlOBISAmpere(double &a)
   a = val;
   smlPow(a, sc);
 }
+
+void smlOBISHertz(double &hz)
+{
+  long long int val;
+  smlOBISByUnit(val, sc, SML_HERTZ);
+  hz = val;
+  smlPow(hz, sc);
+}
@@ -92,6 +92,7 @@ typedef enum {
   SML_COUNT = 255
 } sml_units_t;
 
+void smlReset();
 sml_states_t smlState(unsigned char &byte);
 bool smlOBISCheck(const unsigned char *obis);
 void smlOBISManufacturer(unsigned char *str, int maxSize);
@@ -102,5 +103,6 @@ void smlOBISWh(double &wh);
 void smlOBISW(double &w);
 void smlOBISVolt(double &v);
 void smlOBISAmpere(double &a);
+void smlOBISHertz(double &hz);
 
 #endif
@@ -242,12 +242,14 @@ frozen::string const& VeDirectHexData::getResponseAsString() const
 frozen::string const& VeDirectHexData::getRegisterAsString() const
 {
 	using Register = VeDirectHexRegister;
-	static constexpr frozen::map<Register, frozen::string, 11> values = {
+	static constexpr frozen::map<Register, frozen::string, 13> values = {
 		{ Register::DeviceMode, "Device Mode" },
 		{ Register::DeviceState, "Device State" },
 		{ Register::RemoteControlUsed, "Remote Control Used" },
 		{ Register::PanelVoltage, "Panel Voltage" },
+		{ Register::PanelPower, "Panel Power" },
 		{ Register::ChargerVoltage, "Charger Voltage" },
+		{ Register::ChargerCurrent, "Charger Current" },
 		{ Register::NetworkTotalDcInputPower, "Network Total DC Input Power" },
 		{ Register::ChargeControllerTemperature, "Charger Controller Temperature" },
 		{ Register::SmartBatterySenseTemperature, "Smart Battery Sense Temperature" },
@@ -258,3 +260,76 @@ frozen::string const& VeDirectHexData::getRegisterAsString() const
 
 	return getAsString(values, addr);
 }
+
+using Label = VeDirectTextLabel;
+
+// the labels are resolved by a perfect hash function which is generated at
+// compile time, so no string comparisons are needed at runtime.
+static constexpr frozen::unordered_map<frozen::string, Label, 42> textLabels = {
+	{ "PID", Label::PID },
+	{ "SER", Label::SER },
+	{ "FW", Label::FW },
+	{ "V", Label::V },
+	{ "I", Label::I },
+	{ "LOAD", Label::LOAD },
+	{ "CS", Label::CS },
+	{ "ERR", Label::ERR },
+	{ "OR", Label::OR },
+	{ "MPPT", Label::MPPT },
+	{ "HSDS", Label::HSDS },
+	{ "VPV", Label::VPV },
+	{ "PPV", Label::PPV },
+	{ "H19", Label::H19 },
+	{ "H20", Label::H20 },
+	{ "H21", Label::H21 },
+	{ "H22", Label::H22 },
+	{ "H23", Label::H23 },
+	{ "T", Label::T },
+	{ "P", Label::P },
+	{ "CE", Label::CE },
+	{ "SOC", Label::SOC },
+	{ "TTG", Label::TTG },
+	{ "ALARM", Label::ALARM },
+	{ "H1", Label::H1 },
+	{ "H2", Label::H2 },
+	{ "H3", Label::H3 },
+	{ "H4", Label::H4 },
+	{ "H5", Label::H5 },
+	{ "H6", Label::H6 },
+	{ "H7", Label::H7 },
+	{ "H8", Label::H8 },
+	{ "H9", Label::H9 },
+	{ "H10", Label::H10 },
+	{ "H11", Label::H11 },
+	{ "H12", Label::H12 },
+	{ "H13", Label::H13 },
+	{ "H14", Label::H14 },
+	{ "H15", Label::H15 },
+	{ "H16", Label::H16 },
+	{ "H17", Label::H17 },
+	{ "H18", Label::H18 },
+};
+
+/*
+ * This function resolves the label of a text record (in upper case).
+ */
+VeDirectTextLabel getVeDirectTextLabel(char const* name, size_t len)
+{
+	auto pos = textLabels.find(frozen::string(name, len));
+	if (pos == textLabels.end()) { return Label::Unknown; }
+	return pos->second;
+}
+
+/*
+ * This function returns the label of a text record as text. It is only
+ * needed for logging, hence a linear search is sufficient.
+ */
+frozen::string const& getVeDirectTextLabelName(VeDirectTextLabel label)
+{
+	for (auto const& pair : textLabels) {
+		if (pair.second == label) { return pair.first; }
+	}
+
+	static constexpr frozen::string dummy("???");
+	return dummy;
+}
@@ -2,9 +2,62 @@
 
 #include <frozen/string.h>
 #include <frozen/map.h>
+#include <frozen/unordered_map.h>
 
 #define VE_MAX_VALUE_LEN 33 // VE.Direct Protocol: max value size is 33 including /0
 #define VE_MAX_HEX_LEN 100 // Maximum size of hex frame - max payload 34 byte (=68 char) + safe buffer
+#define VE_MAX_TEXT_RECORDS 32 // Maximum number of text records buffered until the frame's checksum was received
+
+// labels of the text protocol which are processed. other labels are
+// reported as unknown.
+enum class VeDirectTextLabel : uint8_t {
+    Unknown = 0,
+    PID,
+    SER,
+    FW,
+    V,
+    I,
+    LOAD,
+    CS,
+    ERR,
+    OR,
+    MPPT,
+    HSDS,
+    VPV,
+    PPV,
+    H19,
+    H20,
+    H21,
+    H22,
+    H23,
+    T,
+    P,
+    CE,
+    SOC,
+    TTG,
+    ALARM,
+    H1,
+    H2,
+    H3,
+    H4,
+    H5,
+    H6,
+    H7,
+    H8,
+    H9,
+    H10,
+    H11,
+    H12,
+    H13,
+    H14,
+    H15,
+    H16,
+    H17,
+    H18,
+};
+
+VeDirectTextLabel getVeDirectTextLabel(char const* name, size_t len);
+frozen::string const& getVeDirectTextLabelName(VeDirectTextLabel label);
 
 typedef struct {
     uint16_t PID = 0;               // product id
@@ -38,6 +91,10 @@ struct veMpptStruct : veStruct {
     // value is the timestamp the respective info was last received. if it is
     // zero, the value is deemed invalid. the timestamp is reset if no current
     // value could be retrieved.
+    std::pair<uint32_t, uint32_t> PanelPowerMilliWatts;
+    std::pair<uint32_t, uint32_t> BatteryVoltageMilliVolts;
+    std::pair<uint32_t, int32_t> BatteryCurrentMilliAmps;
+    std::pair<uint32_t, uint8_t> DeviceState;
     std::pair<uint32_t, int32_t> MpptTemperatureMilliCelsius;
     std::pair<uint32_t, int32_t> SmartBatterySenseTemperatureMilliCelsius;
     std::pair<uint32_t, uint32_t> NetworkTotalDcInputPowerMilliWatts;
@@ -114,7 +171,9 @@ enum class VeDirectHexRegister : uint16_t {
     DeviceState = 0x0201,
     RemoteControlUsed = 0x0202,
     PanelVoltage = 0xEDBB,
+    PanelPower = 0xEDBC,
     ChargerVoltage = 0xEDD5,
+    ChargerCurrent = 0xEDD7,
     NetworkTotalDcInputPower = 0x2027,
     ChargeControllerTemperature = 0xEDDB,
     SmartBatterySenseTemperature = 0xEDEC,
@@ -50,6 +50,13 @@ template<typename T>
 VeDirectFrameHandler<T>::VeDirectFrameHandler() :
 	_msgOut(&MessageOutputDummy),
 	_lastUpdate(0),
+	_hexTimeouts(0),
+	_framesValid(0),
+	_framesChecksumError(0),
+	_framesTimeout(0),
+	_hexOverflows(0),
+	_uartOverflows(0),
+	_uartErrors(0),
 	_state(State::IDLE),
 	_checksum(0),
 	_textPointer(0),
@@ -57,15 +64,60 @@ VeDirectFrameHandler<T>::VeDirectFrameHandler() :
 	_name(""),
 	_value(""),
 	_debugIn(0),
-	_lastByteMillis(0)
+	_lastByteMillis(0),
+	_textFrame(&_textFrames[0]),
+	_freeTextFrames(nullptr),
+	_validTextFrames(nullptr),
+	_textLabel(VeDirectTextLabel::Unknown),
+	_hexMessages(nullptr)
 {
+	_textFrame->count = 0;
+	_textFrame->unknown[0] = '\0';
+}
+
+template<typename T>
+VeDirectFrameHandler<T>::~VeDirectFrameHandler()
+{
+	// stops the UART driver's event task, which uses the queues
+	_vedirectSerial = nullptr;
+
+	if (_freeTextFrames) { vQueueDelete(_freeTextFrames); }
+	if (_validTextFrames) { vQueueDelete(_validTextFrames); }
+	if (_hexMessages) { vQueueDelete(_hexMessages); }
+}
+
+template<typename T>
+void VeDirectFrameHandler<T>::initQueues()
+{
+	if (_freeTextFrames != nullptr) { return; }
+
+	_freeTextFrames = xQueueCreate(TextFrameBuffers, sizeof(TextFrame*));
+	_validTextFrames = xQueueCreate(TextFrameBuffers, sizeof(TextFrame*));
+	_hexMessages = xQueueCreate(HexMessageQueueSize, sizeof(HexMessage));
+
+	// the first buffer is used to assemble the first frame
+	for (size_t i = 1; i < _textFrames.size(); ++i) {
+		TextFrame* frame = &_textFrames[i];
+		xQueueSend(_freeTextFrames, &frame, 0);
+	}
 }
 
 template<typename T>
 void VeDirectFrameHandler<T>::init(char const* who, int8_t rx, int8_t tx, Print* msgOut, bool verboseLogging, uint16_t hwSerialPort)
 {
+	initQueues();
+
 	_vedirectSerial = std::make_unique<HardwareSerial>(hwSerialPort);
+
+	// the UART driver moves received bytes from the FIFO into this buffer
+	// from its interrupt handler. its event task then assembles and verifies
+	// the frames, independent of the scheduler, which only processes the
+	// complete and valid frames. hence no data is lost while loop() is not
+	// called in time, e.g., while the web server or MQTT client are busy.
+	_vedirectSerial->setRxBufferSize(1024);
 	_vedirectSerial->begin(19200, SERIAL_8N1, rx, tx);
+	_vedirectSerial->onReceive([this]() { onUartReceive(); });
+	_vedirectSerial->onReceiveError([this](hardwareSerial_error_t error) { onUartError(error); });
 	_vedirectSerial->flush();
 	_canSend = (tx != -1);
 	_msgOut = msgOut;
@@ -75,6 +127,19 @@ void VeDirectFrameHandler<T>::init(char const* who, int8_t rx, int8_t tx, Print*
 	if (_verboseLogging) { _msgOut->printf("%s init complete\r\n", _logId); }
 }
 
+template<typename T>
+void VeDirectFrameHandler<T>::init(char const* who, char const* source, Print* msgOut, bool verboseLogging)
+{
+	initQueues();
+
+	_canSend = false;
+	_msgOut = msgOut;
+	_verboseLogging = verboseLogging;
+	_debugIn = 0;
+	snprintf(_logId, sizeof(_logId), "[VE.Direct %s %s]", who, source);
+	if (_verboseLogging) { _msgOut->printf("%s init complete\r\n", _logId); }
+}
+
 template<typename T>
 void VeDirectFrameHandler<T>::dumpDebugBuffer() {
 	_msgOut->printf("%s serial input (%d Bytes):", _logId, _debugIn);
@@ -93,32 +158,93 @@ void VeDirectFrameHandler<T>::reset()
 {
 	_checksum = 0;
 	_state = State::IDLE;
-	_textData.clear();
+	_textFrame->count = 0;
+	_textFrame->unknown[0] = '\0';
 }
 
 template<typename T>
 void VeDirectFrameHandler<T>::loop()
 {
-	while ( _vedirectSerial->available()) {
-		rxData(_vedirectSerial->read());
-		_lastByteMillis = millis();
+	TextFrame* frame;
+	while (_validTextFrames && xQueueReceive(_validTextFrames, &frame, 0) == pdTRUE) {
+		if (frame->unknown[0] != '\0') {
+			_msgOut->printf("%s Unknown text data %s\r\n", _logId, frame->unknown);
+		}
+
+		for (size_t i = 0; i < frame->count; ++i) {
+			processTextData(frame->records[i].label, frame->records[i].value);
+		}
+		xQueueSend(_freeTextFrames, &frame, 0);
+
+		_lastUpdate = millis();
+		++_framesValid;
+		frameValidEvent();
+	}
+
+	HexMessage message;
+	while (_hexMessages && xQueueReceive(_hexMessages, &message, 0) == pdTRUE) {
+		processHexMessage(message.text);
+	}
+}
+
+/*
+ *  onUartReceive
+ *  This function is called by the UART driver's event task when data was received.
+ */
+template<typename T>
+void VeDirectFrameHandler<T>::onUartReceive()
+{
+	uint8_t buffer[64];
+	while (true) {
+		size_t len = _vedirectSerial->read(buffer, std::min<size_t>(_vedirectSerial->available(), sizeof(buffer)));
+		if (len == 0) { break; }
+		receive(buffer, len);
 	}
+}
 
+template<typename T>
+void VeDirectFrameHandler<T>::receive(uint8_t const* data, size_t len)
+{
 	// there will never be a large gap between two bytes of the same frame.
 	// if such a large gap is observed, reset the state machine so it tries
-	// to decode a new frame once more data arrives.
+	// to decode a new frame from the data just received.
 	if (State::IDLE != _state && (millis() - _lastByteMillis) > 500) {
 		_msgOut->printf("%s Resetting state machine (was %d) after timeout\r\n",
 				_logId, static_cast<unsigned>(_state));
 		if (_verboseLogging) { dumpDebugBuffer(); }
+		++_framesTimeout;
 		reset();
 	}
+
+	for (size_t i = 0; i < len; ++i) { rxData(data[i]); }
+	_lastByteMillis = millis();
+}
+
+template<typename T>
+void VeDirectFrameHandler<T>::onUartError(hardwareSerial_error_t error)
+{
+	switch (error) {
+		case UART_BUFFER_FULL_ERROR:
+		case UART_FIFO_OVF_ERROR:
+			++_uartOverflows;
+			break;
+		default:
+			++_uartErrors;
+			break;
+	}
+}
+
+template<typename T>
+typename VeDirectFrameHandler<T>::Statistics VeDirectFrameHandler<T>::getStatistics() const
+{
+	return { _framesValid, _framesChecksumError.load(), _framesTimeout.load(),
+		_hexOverflows.load(), _hexTimeouts, _uartOverflows.load(), _uartErrors.load() };
 }
 
 /*
  *  rxData
- *  This function is called by loop() which passes a byte of serial data
- *  Based on Victron's example code. But using String and Map instead of pointer and arrays
+ *  This function is called by receive() which passes a byte of serial data
+ *  Based on Victron's example code.
  */
 template<typename T>
 void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
@@ -169,6 +295,10 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 					_state = State::CHECKSUM;
 					break;
 				}
+				_textLabel = getVeDirectTextLabel(_name, _textPointer - _name);
+			}
+			else {
+				_textLabel = VeDirectTextLabel::Unknown;
 			}
 			_textPointer = _value; /* Reset value pointer */
 			_state = State::RECORD_VALUE;
@@ -188,7 +318,7 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 		case '\n':
 			if ( _textPointer < (_value + sizeof(_value)) ) {
 				*_textPointer = 0; // make zero ended
-				_textData.push_back({_name, _value});
+				addTextData();
 			}
 			_state = State::RECORD_BEGIN;
 			break;
@@ -204,15 +334,19 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 	case State::CHECKSUM:
 	{
 		if (_verboseLogging) { dumpDebugBuffer(); }
-		if (_checksum == 0) {
-			for (auto const& event : _textData) {
-				processTextData(event.first, event.second);
-			}
-			_lastUpdate = millis();
-			frameValidEvent();
+		TextFrame* next;
+		if (_checksum != 0) {
+			++_framesChecksumError;
+			_msgOut->printf("%s checksum 0x%02x != 0x00, invalid frame\r\n", _logId, _checksum);
+		}
+		else if (xQueueReceive(_freeTextFrames, &next, 0) == pdTRUE) {
+			// hand the frame to loop() and assemble the next one in another buffer
+			xQueueSend(_validTextFrames, &_textFrame, 0);
+			_textFrame = next;
 		}
 		else {
-			_msgOut->printf("%s checksum 0x%02x != 0x00, invalid frame\r\n", _logId, _checksum);
+			++_uartOverflows;
+			_msgOut->printf("%s frame queue full, dropping valid frame\r\n", _logId);
 		}
 		reset();
 		break;
@@ -224,44 +358,73 @@ void VeDirectFrameHandler<T>::rxData(uint8_t inbyte)
 }
 
 /*
- * This function is called every time a new name/value is successfully parsed.  It writes the values to the temporary buffer.
+ * This function is called every time a new name/value pair was received.
+ * It buffers the value until the frame's checksum was verified. Unknown
+ * labels are collected, as a corrupted frame yields garbage labels.
  */
 template<typename T>
-void VeDirectFrameHandler<T>::processTextData(std::string const& name, std::string const& value) {
-	if (_verboseLogging) {
-		_msgOut->printf("%s Text Data '%s' = '%s'\r\n",
-				_logId, name.c_str(), value.c_str());
-	}
-
-	if (processTextDataDerived(name, value)) { return; }
-
-	if (name == "PID") {
-		_tmpFrame.PID = strtol(value.c_str(), nullptr, 0);
+void VeDirectFrameHandler<T>::addTextData()
+{
+	if (_textLabel == VeDirectTextLabel::Unknown) {
+		auto& unknown = _textFrame->unknown;
+		size_t len = strlen(unknown);
+		snprintf(unknown + len, sizeof(unknown) - len, "%s'%s'='%s'",
+				(len > 0 ? ", " : ""), _name, _value);
 		return;
 	}
 
-	if (name == "SER") {
-		strcpy(_tmpFrame.SER, value.c_str());
+	if (_textFrame->count >= _textFrame->records.size()) {
+		_msgOut->printf("%s Too many text records, dropping '%s'\r\n",
+				_logId, _name);
 		return;
 	}
 
-	if (name == "FW") {
-		strcpy(_tmpFrame.FW, value.c_str());
-		return;
-	}
+	auto& record = _textFrame->records[_textFrame->count++];
+	record.label = _textLabel;
+	strlcpy(record.value, _value, sizeof(record.value));
+}
 
-	if (name == "V") {
-		_tmpFrame.V = round(atof(value.c_str()) / 10.0) / 100.0;
-		return;
+/*
+ * This function is called for every buffered name/value pair of a valid frame.  It writes the values to the temporary buffer.
+ */
+template<typename T>
+void VeDirectFrameHandler<T>::processTextData(VeDirectTextLabel label, char const* value) {
+	if (_verboseLogging) {
+		_msgOut->printf("%s Text Data '%s' = '%s'\r\n",
+				_logId, getVeDirectTextLabelName(label).data(), value);
 	}
 
-	if (name == "I") {
-		_tmpFrame.I = round(atof(value.c_str()) / 10.0) / 100.0;
-		return;
+	if (processTextDataDerived(label, value)) { return; }
+
+	switch (label) {
+		case VeDirectTextLabel::PID:
+			_tmpFrame.PID = strtol(value, nullptr, 0);
+			return;
+
+		case VeDirectTextLabel::SER:
+			strlcpy(_tmpFrame.SER, value, sizeof(_tmpFrame.SER));
+			return;
+
+		case VeDirectTextLabel::FW:
+			strlcpy(_tmpFrame.FW, value, sizeof(_tmpFrame.FW));
+			return;
+
+		case VeDirectTextLabel::V:
+			// value in mV, rounded to 10 mV
+			_tmpFrame.V = round(strtol(value, nullptr, 10) / 10.0) / 100.0;
+			return;
+
+		case VeDirectTextLabel::I:
+			// value in mA, rounded to 10 mA
+			_tmpFrame.I = round(strtol(value, nullptr, 10) / 10.0) / 100.0;
+			return;
+
+		default:
+			break;
 	}
 
 	_msgOut->printf("%s Unknown text data '%s' (value '%s')\r\n",
-			_logId, name.c_str(), value.c_str());
+			_logId, getVeDirectTextLabelName(label).data(), value);
 }
 
 /*
@@ -275,27 +438,27 @@ typename VeDirectFrameHandler<T>::State VeDirectFrameHandler<T>::hexRxEvent(uint
 
 	switch (inbyte) {
 	case '\n':
-		// now we can analyse the hex message
+	{
+		// the hex message is analysed by loop()
 		_hexBuffer[_hexSize] = '\0';
-		VeDirectHexData data;
-		if (disassembleHexData(data) && !hexDataHandler(data) && _verboseLogging) {
-			_msgOut->printf("%s Unhandled Hex %s Response, addr: 0x%04X (%s), "
-					"value: 0x%08X, flags: 0x%02X\r\n", _logId,
-					data.getResponseAsString().data(),
-					static_cast<unsigned>(data.addr),
-					data.getRegisterAsString().data(),
-					data.value, data.flags);
+		HexMessage message;
+		strlcpy(message.text, _hexBuffer, sizeof(message.text));
+		if (xQueueSend(_hexMessages, &message, 0) != pdTRUE) {
+			++_uartOverflows;
+			_msgOut->printf("%s hex message queue full, dropping message\r\n", _logId);
 		}
 
 		// restore previous state
 		ret=_prevState;
 		break;
+	}
 
 	default:
 		_hexBuffer[_hexSize++]=inbyte;
 
 		if (_hexSize>=VE_MAX_HEX_LEN) { // oops -buffer overflow - something went wrong, we abort
 			_msgOut->printf("%s hexRx buffer overflow - aborting read\r\n", _logId);
+			++_hexOverflows;
 			_hexSize=0;
 			ret = State::IDLE;
 		}
@@ -304,6 +467,24 @@ typename VeDirectFrameHandler<T>::State VeDirectFrameHandler<T>::hexRxEvent(uint
 	return ret;
 }
 
+/*
+ *  processHexMessage
+ *  This function is called by loop() for every hex message received
+ */
+template<typename T>
+void VeDirectFrameHandler<T>::processHexMessage(char const* buffer)
+{
+	VeDirectHexData data;
+	if (disassembleHexData(buffer, data) && !hexDataHandler(data) && _verboseLogging) {
+		_msgOut->printf("%s Unhandled Hex %s Response, addr: 0x%04X (%s), "
+				"value: 0x%08X, flags: 0x%02X\r\n", _logId,
+				data.getResponseAsString().data(),
+				static_cast<unsigned>(data.addr),
+				data.getRegisterAsString().data(),
+				data.value, data.flags);
+	}
+}
+
 template<typename T>
 bool VeDirectFrameHandler<T>::isDataValid() const
 {
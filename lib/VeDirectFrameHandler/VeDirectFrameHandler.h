@@ -13,24 +13,40 @@
 #pragma once
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include <array>
+#include <atomic>
 #include <memory>
 #include <utility>
-#include <deque>
 #include "VeDirectData.h"
 
 template<typename T>
 class VeDirectFrameHandler {
 public:
-    virtual void loop();                         // main loop to read ve.direct data
+    virtual ~VeDirectFrameHandler();
+    virtual void loop();                         // main loop to process received frames
+    void receive(uint8_t const* data, size_t len); // process data received by other means than the UART
     uint32_t getLastUpdate() const;              // timestamp of last successful frame read
     bool isDataValid() const;                    // return true if data valid and not outdated
     T const& getData() const { return _tmpFrame; }
     bool sendHexCommand(VeDirectHexCommand cmd, VeDirectHexRegister addr, uint32_t value = 0, uint8_t valsize = 0);
 
+    struct Statistics {
+        uint32_t framesValid;           // text frames with a valid checksum
+        uint32_t framesChecksumError;   // text frames dropped due to a checksum mismatch
+        uint32_t framesTimeout;         // frames dropped as no more data was received
+        uint32_t hexOverflows;          // hex messages dropped as they were too long
+        uint32_t hexTimeouts;           // hex requests which were not answered in time
+        uint32_t uartOverflows;         // UART FIFO, receive buffer or frame queue overflows (data lost)
+        uint32_t uartErrors;            // UART framing, parity and break errors
+    };
+    Statistics getStatistics() const;
+
 protected:
     VeDirectFrameHandler();
     void init(char const* who, int8_t rx, int8_t tx, Print* msgOut, bool verboseLogging, uint16_t hwSerialPort);
+    void init(char const* who, char const* source, Print* msgOut, bool verboseLogging); // without UART
     virtual bool hexDataHandler(VeDirectHexData const &data) { return false; } // handles the disassembeled hex response
 
     bool _verboseLogging;
@@ -40,18 +56,34 @@ protected:
     T _tmpFrame;
 
     bool _canSend;
-    char _logId[32];
+    char _logId[40];
+    uint32_t _hexTimeouts;
 
 private:
+    void initQueues();
     void reset();
     void dumpDebugBuffer();
     void rxData(uint8_t inbyte);              // byte of serial data
-    void processTextData(std::string const& name, std::string const& value);
-    virtual bool processTextDataDerived(std::string const& name, std::string const& value) = 0;
+    void addTextData();
+    void processTextData(VeDirectTextLabel label, char const* value);
+    virtual bool processTextDataDerived(VeDirectTextLabel label, char const* value) = 0;
     virtual void frameValidEvent() { }
-    bool disassembleHexData(VeDirectHexData &data);     //return true if disassembling was possible
+    bool disassembleHexData(char const* buffer, VeDirectHexData &data); //return true if disassembling was possible
+    void processHexMessage(char const* buffer);
 
     std::unique_ptr<HardwareSerial> _vedirectSerial;
+    void onUartReceive();
+    void onUartError(hardwareSerial_error_t error);
+
+    // frames are assembled and verified by the UART driver's event task (or
+    // the caller of receive()), while they are processed by loop(). only the
+    // valid frame counter is updated by loop().
+    uint32_t _framesValid;
+    std::atomic<uint32_t> _framesChecksumError;
+    std::atomic<uint32_t> _framesTimeout;
+    std::atomic<uint32_t> _hexOverflows;
+    std::atomic<uint32_t> _uartOverflows;
+    std::atomic<uint32_t> _uartErrors;
 
     enum class State {
         IDLE = 1,
@@ -80,12 +112,41 @@ private:
      * not every frame contains every value the device is communicating, i.e.,
      * a set of values can be fragmented across multiple frames. frames can be
      * invalid. in order to only process data from valid frames, we add data
-     * to this queue and only process it once the frame was found to be valid.
+     * to this buffer and only process it once the frame was found to be valid.
      * this also handles fragmentation nicely, since there is no need to reset
-     * our data buffer. we simply update the interpreted data from this event
-     * queue, which is fine as we know the source frame was valid.
+     * our data buffer. we simply update the interpreted data from this
+     * buffer, which is fine as we know the source frame was valid. the label
+     * of a record is resolved as soon as it was received, so only its value
+     * is kept as text. the buffer has a fixed size to avoid heap allocations.
      */
-    std::deque<std::pair<std::string, std::string>> _textData;
+    struct TextRecord {
+        VeDirectTextLabel label;
+        char value[VE_MAX_VALUE_LEN];
+    };
+    struct TextFrame {
+        std::array<TextRecord, VE_MAX_TEXT_RECORDS> records;
+        size_t count;
+        // records with an unknown label as "name=value" list, which is
+        // only logged if the frame is valid. truncated if too long.
+        char unknown[128];
+    };
+
+    // a valid frame is handed to loop() by queueing a pointer to its buffer.
+    // the buffers are recycled using a second queue, so frames are neither
+    // copied nor allocated. one buffer is used to assemble the next frame.
+    static constexpr size_t TextFrameBuffers = 3;
+    std::array<TextFrame, TextFrameBuffers> _textFrames;
+    TextFrame* _textFrame;                     // frame being assembled
+    QueueHandle_t _freeTextFrames;
+    QueueHandle_t _validTextFrames;
+    VeDirectTextLabel _textLabel;              // label of the record being received
+
+    // hex messages are small, they are copied into the queue
+    struct HexMessage {
+        char text[VE_MAX_HEX_LEN];
+    };
+    static constexpr size_t HexMessageQueueSize = 4;
+    QueueHandle_t _hexMessages;
 };
 
 template class VeDirectFrameHandler<veMpptStruct>;
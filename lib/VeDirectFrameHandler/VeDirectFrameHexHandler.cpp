@@ -68,9 +68,8 @@ static uint32_t AsciiHexLE2Int(const char *ascii, const uint8_t anz) {
  *          do not aligin with VE.Diekt syntax
  */
 template<typename T>
-bool VeDirectFrameHandler<T>::disassembleHexData(VeDirectHexData &data) {
+bool VeDirectFrameHandler<T>::disassembleHexData(char const* buffer, VeDirectHexData &data) {
     bool state = false;
-    char * buffer = _hexBuffer;
     auto len = strlen(buffer);
 
     // reset hex data first
@@ -169,6 +168,8 @@ static String Int2HexLEString(uint32_t value, uint8_t anz) {
  */
 template<typename T>
 bool VeDirectFrameHandler<T>::sendHexCommand(VeDirectHexCommand cmd, VeDirectHexRegister addr, uint32_t value, uint8_t valsize) {
+    if (!_vedirectSerial) { return false; } // data is not received through the UART
+
     bool ret = false;
     uint8_t flags = 0x00;  // always 0x00
 
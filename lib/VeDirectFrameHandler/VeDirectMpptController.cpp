@@ -12,64 +12,88 @@
 
 //#define PROCESS_NETWORK_STATE
 
+VeDirectMpptController::VeDirectMpptController()
+{
+	using Register = VeDirectHexRegister;
+
+	// panel power, battery voltage and current and the charger state are
+	// polled several times per second, such that the DPL gets more recent
+	// values than the ones from the text frame sent once per second.
+	_hexPollEntries = {
+		{ Register::PanelPower, 200, 0, true },
+		{ Register::ChargerVoltage, 200, 0, true },
+		{ Register::ChargerCurrent, 200, 0, true },
+		{ Register::DeviceState, 500, 0, true },
+		{ Register::NetworkTotalDcInputPower, 1000, 0, true },
+		{ Register::ChargeControllerTemperature, 1000, 0, true },
+		{ Register::SmartBatterySenseTemperature, 1000, 0, true }
+	};
+
+#ifdef PROCESS_NETWORK_STATE
+	_hexPollEntries.push_back({ Register::NetworkInfo, 1000, 0, true });
+	_hexPollEntries.push_back({ Register::NetworkMode, 1000, 0, true });
+	_hexPollEntries.push_back({ Register::NetworkStatus, 1000, 0, true });
+#endif // PROCESS_NETWORK_STATE
+}
+
 void VeDirectMpptController::init(int8_t rx, int8_t tx, Print* msgOut, bool verboseLogging, uint16_t hwSerialPort)
 {
 	VeDirectFrameHandler::init("MPPT", rx, tx, msgOut, verboseLogging, hwSerialPort);
 }
 
-bool VeDirectMpptController::processTextDataDerived(std::string const& name, std::string const& value)
+void VeDirectMpptController::init(char const* source, Print* msgOut, bool verboseLogging)
 {
-	if (name == "LOAD") {
-		_tmpFrame.LOAD = (value == "ON");
-		return true;
-	}
-	if (name == "CS") {
-		_tmpFrame.CS = atoi(value.c_str());
-		return true;
-	}
-	if (name == "ERR") {
-		_tmpFrame.ERR = atoi(value.c_str());
-		return true;
-	}
-	if (name == "OR") {
-		_tmpFrame.OR = strtol(value.c_str(), nullptr, 0);
-		return true;
-	}
-	if (name == "MPPT") {
-		_tmpFrame.MPPT = atoi(value.c_str());
-		return true;
-	}
-	if (name == "HSDS") {
-		_tmpFrame.HSDS = atoi(value.c_str());
-		return true;
-	}
-	if (name == "VPV") {
-		_tmpFrame.VPV = round(atof(value.c_str()) / 10.0) / 100.0;
-		return true;
-	}
-	if (name == "PPV") {
-		_tmpFrame.PPV = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H19") {
-		_tmpFrame.H19 = atof(value.c_str()) / 100.0;
-		return true;
-	}
-	if (name == "H20") {
-		_tmpFrame.H20 = atof(value.c_str()) / 100.0;
-		return true;
-	}
-	if (name == "H21") {
-		_tmpFrame.H21 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H22") {
-		_tmpFrame.H22 = atof(value.c_str()) / 100.0;
-		return true;
-	}
-	if (name == "H23") {
-		_tmpFrame.H23 = atoi(value.c_str());
-		return true;
+	VeDirectFrameHandler::init("MPPT", source, msgOut, verboseLogging);
+}
+
+bool VeDirectMpptController::processTextDataDerived(VeDirectTextLabel label, char const* value)
+{
+	using Label = VeDirectTextLabel;
+
+	switch (label) {
+		case Label::LOAD:
+			_tmpFrame.LOAD = (strcmp(value, "ON") == 0);
+			return true;
+		case Label::CS:
+			_tmpFrame.CS = atoi(value);
+			return true;
+		case Label::ERR:
+			_tmpFrame.ERR = atoi(value);
+			return true;
+		case Label::OR:
+			_tmpFrame.OR = strtol(value, nullptr, 0);
+			return true;
+		case Label::MPPT:
+			_tmpFrame.MPPT = atoi(value);
+			return true;
+		case Label::HSDS:
+			_tmpFrame.HSDS = atoi(value);
+			return true;
+		case Label::VPV:
+			// value in mV, rounded to 10 mV
+			_tmpFrame.VPV = round(atoi(value) / 10.0) / 100.0;
+			return true;
+		case Label::PPV:
+			_tmpFrame.PPV = atoi(value);
+			return true;
+		case Label::H19:
+			// values in 0.01 kWh
+			_tmpFrame.H19 = atoi(value) / 100.0;
+			return true;
+		case Label::H20:
+			_tmpFrame.H20 = atoi(value) / 100.0;
+			return true;
+		case Label::H21:
+			_tmpFrame.H21 = atoi(value);
+			return true;
+		case Label::H22:
+			_tmpFrame.H22 = atoi(value) / 100.0;
+			return true;
+		case Label::H23:
+			_tmpFrame.H23 = atoi(value);
+			return true;
+		default:
+			break;
 	}
 
 	return false;
@@ -90,8 +114,20 @@ void VeDirectMpptController::frameValidEvent() {
 		_efficiency.addNumber(static_cast<float>(_tmpFrame.P * 100) / _tmpFrame.PPV);
 		_tmpFrame.E = _efficiency.getAverage();
 	}
+}
 
-	if (!_canSend) { return; }
+/*
+ *  pollHexRegisters
+ *  This function is called by loop() and requests the next register which
+ *  is due, unless a request is still pending.
+ */
+void VeDirectMpptController::pollHexRegisters()
+{
+	// a reply to a GET command is usually sent within a few dozen
+	// milliseconds, but might be delayed by a text frame being sent.
+	static constexpr uint32_t hexTimeoutMillis = 500;
+
+	if (!_canSend || _lastUpdate == 0) { return; }
 
 	// Copy from the "VE.Direct Protocol" documentation
 	// For firmware version v1.52 and below, when no VE.Direct queries are sent to the device, the
@@ -100,18 +136,79 @@ void VeDirectMpptController::frameValidEvent() {
 	// --> We just use hex commandes for firmware >= 1.53 to keep text messages alive
 	if (atoi(_tmpFrame.FW) < 153) { return; }
 
-	using Command = VeDirectHexCommand;
-	using Register = VeDirectHexRegister;
+	uint32_t now = millis();
 
-	sendHexCommand(Command::GET, Register::ChargeControllerTemperature);
-	sendHexCommand(Command::GET, Register::SmartBatterySenseTemperature);
-	sendHexCommand(Command::GET, Register::NetworkTotalDcInputPower);
+	if (_hexPending != nullptr) {
+		if ((now - _hexPending->lastRequestMillis) < hexTimeoutMillis) { return; }
 
-#ifdef PROCESS_NETWORK_STATE
-	sendHexCommand(Command::GET, Register::NetworkInfo);
-	sendHexCommand(Command::GET, Register::NetworkMode);
-	sendHexCommand(Command::GET, Register::NetworkStatus);
-#endif // PROCESS_NETWORK_STATE
+		++_hexTimeouts;
+		if (_verboseLogging) {
+			_msgOut->printf("%s Hex request for register 0x%04X timed out\r\n",
+					_logId, static_cast<unsigned>(_hexPending->reg));
+		}
+		_hexPending = nullptr;
+	}
+
+	HexPollEntry* next = nullptr;
+	uint32_t maxOverdue = 0;
+	for (auto& entry : _hexPollEntries) {
+		if (!entry.supported) { continue; }
+
+		uint32_t elapsed = now - entry.lastRequestMillis;
+		if (entry.lastRequestMillis > 0 && elapsed < entry.intervalMillis) { continue; }
+
+		uint32_t overdue = (entry.lastRequestMillis > 0) ? (elapsed - entry.intervalMillis) : UINT32_MAX;
+		if (next == nullptr || overdue > maxOverdue) {
+			next = &entry;
+			maxOverdue = overdue;
+		}
+	}
+
+	if (next == nullptr) { return; }
+
+	next->lastRequestMillis = now;
+
+	if (sendHexCommand(VeDirectHexCommand::GET, next->reg)) {
+		_hexPending = next;
+	}
+}
+
+/*
+ *  hexResponseReceived
+ *  completes the pending request if the response belongs to it. registers
+ *  which the charge controller does not know are no longer polled.
+ */
+void VeDirectMpptController::hexResponseReceived(VeDirectHexData const &data)
+{
+	// the charge controller sends some values on its own. there is no
+	// need to request them again until their poll interval elapsed.
+	if (data.rsp == VeDirectHexResponse::ASYNC) {
+		for (auto& entry : _hexPollEntries) {
+			if (entry.reg == data.addr && &entry != _hexPending) {
+				entry.lastRequestMillis = millis();
+			}
+		}
+		return;
+	}
+
+	if (_hexPending == nullptr) { return; }
+
+	if (data.rsp == VeDirectHexResponse::ERROR ||
+			data.rsp == VeDirectHexResponse::UNKNOWN) {
+		_hexPending = nullptr;
+		return;
+	}
+
+	if (data.rsp != VeDirectHexResponse::GET || data.addr != _hexPending->reg) { return; }
+
+	// flags: 0x01 unknown register, 0x02 not supported, 0x04 parameter error
+	if ((data.flags & 0x03) != 0) {
+		_hexPending->supported = false;
+		_msgOut->printf("%s Register 0x%04X is not supported, not polling it any more\r\n",
+				_logId, static_cast<unsigned>(data.addr));
+	}
+
+	_hexPending = nullptr;
 }
 
 
@@ -119,12 +216,18 @@ void VeDirectMpptController::loop()
 {
 	VeDirectFrameHandler::loop();
 
+	pollHexRegisters();
+
 	auto resetTimestamp = [this](auto& pair) {
 		if (pair.first > 0 && (millis() - pair.first) > (10 * 1000)) {
 			pair.first = 0;
 		}
 	};
 
+	resetTimestamp(_tmpFrame.PanelPowerMilliWatts);
+	resetTimestamp(_tmpFrame.BatteryVoltageMilliVolts);
+	resetTimestamp(_tmpFrame.BatteryCurrentMilliAmps);
+	resetTimestamp(_tmpFrame.DeviceState);
 	resetTimestamp(_tmpFrame.MpptTemperatureMilliCelsius);
 	resetTimestamp(_tmpFrame.SmartBatterySenseTemperatureMilliCelsius);
 	resetTimestamp(_tmpFrame.NetworkTotalDcInputPowerMilliWatts);
@@ -143,12 +246,64 @@ void VeDirectMpptController::loop()
  * Handels the received hex data from the MPPT
  */
 bool VeDirectMpptController::hexDataHandler(VeDirectHexData const &data) {
+	hexResponseReceived(data);
+
 	if (data.rsp != VeDirectHexResponse::GET &&
 			data.rsp != VeDirectHexResponse::ASYNC) { return false; }
 
 	auto regLog = static_cast<uint16_t>(data.addr);
 
+	// do not process replies flagging an error, their value is bogus
+	if (data.flags != 0) { return true; }
+
 	switch (data.addr) {
+		case VeDirectHexRegister::PanelPower:
+			// value in 0.01 W
+			_tmpFrame.PanelPowerMilliWatts = { millis(), data.value * 10 };
+
+			if (_verboseLogging) {
+				_msgOut->printf("%s Hex Data: Panel Power (0x%04X): %.2fW\r\n",
+						_logId, regLog,
+						_tmpFrame.PanelPowerMilliWatts.second / 1000.0);
+			}
+			return true;
+			break;
+
+		case VeDirectHexRegister::ChargerVoltage:
+			// value in 0.01 V
+			_tmpFrame.BatteryVoltageMilliVolts = { millis(), data.value * 10 };
+
+			if (_verboseLogging) {
+				_msgOut->printf("%s Hex Data: Charger Voltage (0x%04X): %.2fV\r\n",
+						_logId, regLog,
+						_tmpFrame.BatteryVoltageMilliVolts.second / 1000.0);
+			}
+			return true;
+			break;
+
+		case VeDirectHexRegister::ChargerCurrent:
+			// value in 0.1 A
+			_tmpFrame.BatteryCurrentMilliAmps =
+				{ millis(), static_cast<int32_t>(data.value) * 100 };
+
+			if (_verboseLogging) {
+				_msgOut->printf("%s Hex Data: Charger Current (0x%04X): %.1fA\r\n",
+						_logId, regLog,
+						_tmpFrame.BatteryCurrentMilliAmps.second / 1000.0);
+			}
+			return true;
+			break;
+
+		case VeDirectHexRegister::DeviceState:
+			_tmpFrame.DeviceState = { millis(), static_cast<uint8_t>(data.value) };
+
+			if (_verboseLogging) {
+				_msgOut->printf("%s Hex Data: Device State (0x%04X): %d\r\n",
+						_logId, regLog, _tmpFrame.DeviceState.second);
+			}
+			return true;
+			break;
+
 		case VeDirectHexRegister::ChargeControllerTemperature:
 			_tmpFrame.MpptTemperatureMilliCelsius =
 				{ millis(), static_cast<int32_t>(data.value) * 10 };
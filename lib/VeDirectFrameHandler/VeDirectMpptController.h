@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Arduino.h>
+#include <vector>
 #include "VeDirectData.h"
 #include "VeDirectFrameHandler.h"
 
@@ -38,9 +39,10 @@ private:
 
 class VeDirectMpptController : public VeDirectFrameHandler<veMpptStruct> {
 public:
-    VeDirectMpptController() = default;
+    VeDirectMpptController();
 
     void init(int8_t rx, int8_t tx, Print* msgOut, bool verboseLogging, uint16_t hwSerialPort);
+    void init(char const* source, Print* msgOut, bool verboseLogging);
 
     using data_t = veMpptStruct;
 
@@ -48,7 +50,22 @@ public:
 
 private:
     bool hexDataHandler(VeDirectHexData const &data) final;
-    bool processTextDataDerived(std::string const& name, std::string const& value) final;
+    bool processTextDataDerived(VeDirectTextLabel label, char const* value) final;
     void frameValidEvent() final;
     MovingAverage<float, 5> _efficiency;
+
+    // registers are polled using the HEX protocol in between text frames.
+    // only one request is outstanding at any time, and the register which
+    // is overdue the longest is requested next.
+    void pollHexRegisters();
+    void hexResponseReceived(VeDirectHexData const &data);
+
+    struct HexPollEntry {
+        VeDirectHexRegister reg;
+        uint16_t intervalMillis;
+        uint32_t lastRequestMillis;
+        bool supported;
+    };
+    std::vector<HexPollEntry> _hexPollEntries;
+    HexPollEntry* _hexPending = nullptr;
 };
@@ -8,104 +8,86 @@ void VeDirectShuntController::init(int8_t rx, int8_t tx, Print* msgOut, bool ver
 	VeDirectFrameHandler::init("SmartShunt", rx, tx, msgOut, verboseLogging, 2);
 }
 
-bool VeDirectShuntController::processTextDataDerived(std::string const& name, std::string const& value)
+bool VeDirectShuntController::processTextDataDerived(VeDirectTextLabel label, char const* value)
 {
-	if (name == "T") {
-		_tmpFrame.T = atoi(value.c_str());
-		_tmpFrame.tempPresent = true;
-		return true;
-	}
-	if (name == "P") {
-		_tmpFrame.P = atoi(value.c_str());
-		return true;
-	}
-	if (name == "CE") {
-		_tmpFrame.CE = atoi(value.c_str());
-		return true;
-	}
-	if (name == "SOC") {
-		_tmpFrame.SOC = atoi(value.c_str());
-		return true;
-	}
-	if (name == "TTG") {
-		_tmpFrame.TTG = atoi(value.c_str());
-		return true;
-	}
-	if (name == "ALARM") {
-		_tmpFrame.ALARM = (value == "ON");
-		return true;
-	}
-	if (name == "H1") {
-		_tmpFrame.H1 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H2") {
-		_tmpFrame.H2 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H3") {
-		_tmpFrame.H3 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H4") {
-		_tmpFrame.H4 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H5") {
-		_tmpFrame.H5 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H6") {
-		_tmpFrame.H6 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H7") {
-		_tmpFrame.H7 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H8") {
-		_tmpFrame.H8 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H9") {
-		_tmpFrame.H9 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H10") {
-		_tmpFrame.H10 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H11") {
-		_tmpFrame.H11 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H12") {
-		_tmpFrame.H12 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H13") {
-		_tmpFrame.H13 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H14") {
-		_tmpFrame.H14 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H15") {
-		_tmpFrame.H15 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H16") {
-		_tmpFrame.H16 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H17") {
-		_tmpFrame.H17 = atoi(value.c_str());
-		return true;
-	}
-	if (name == "H18") {
-		_tmpFrame.H18 = atoi(value.c_str());
-		return true;
+	using Label = VeDirectTextLabel;
+
+	switch (label) {
+		case Label::T:
+			_tmpFrame.T = atoi(value);
+			_tmpFrame.tempPresent = true;
+			return true;
+		case Label::P:
+			_tmpFrame.P = atoi(value);
+			return true;
+		case Label::CE:
+			_tmpFrame.CE = atoi(value);
+			return true;
+		case Label::SOC:
+			_tmpFrame.SOC = atoi(value);
+			return true;
+		case Label::TTG:
+			_tmpFrame.TTG = atoi(value);
+			return true;
+		case Label::ALARM:
+			_tmpFrame.ALARM = (strcmp(value, "ON") == 0);
+			return true;
+		case Label::H1:
+			_tmpFrame.H1 = atoi(value);
+			return true;
+		case Label::H2:
+			_tmpFrame.H2 = atoi(value);
+			return true;
+		case Label::H3:
+			_tmpFrame.H3 = atoi(value);
+			return true;
+		case Label::H4:
+			_tmpFrame.H4 = atoi(value);
+			return true;
+		case Label::H5:
+			_tmpFrame.H5 = atoi(value);
+			return true;
+		case Label::H6:
+			_tmpFrame.H6 = atoi(value);
+			return true;
+		case Label::H7:
+			_tmpFrame.H7 = atoi(value);
+			return true;
+		case Label::H8:
+			_tmpFrame.H8 = atoi(value);
+			return true;
+		case Label::H9:
+			_tmpFrame.H9 = atoi(value);
+			return true;
+		case Label::H10:
+			_tmpFrame.H10 = atoi(value);
+			return true;
+		case Label::H11:
+			_tmpFrame.H11 = atoi(value);
+			return true;
+		case Label::H12:
+			_tmpFrame.H12 = atoi(value);
+			return true;
+		case Label::H13:
+			_tmpFrame.H13 = atoi(value);
+			return true;
+		case Label::H14:
+			_tmpFrame.H14 = atoi(value);
+			return true;
+		case Label::H15:
+			_tmpFrame.H15 = atoi(value);
+			return true;
+		case Label::H16:
+			_tmpFrame.H16 = atoi(value);
+			return true;
+		case Label::H17:
+			_tmpFrame.H17 = atoi(value);
+			return true;
+		case Label::H18:
+			_tmpFrame.H18 = atoi(value);
+			return true;
+		default:
+			break;
 	}
 
 	return false;
@@ -13,7 +13,7 @@ public:
     using data_t = veShuntStruct;
 
 private:
-    bool processTextDataDerived(std::string const& name, std::string const& value) final;
+    bool processTextDataDerived(VeDirectTextLabel label, char const* value) final;
 };
 
 extern VeDirectShuntController VeDirectShunt;
@@ -0,0 +1,169 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Creates a delta update, which turns the firmware image of a previous release
+# (the source) into the current firmware image (the target). the delta is
+# applied by the firmware while it is being received (see DeltaPatcher.h).
+#
+# as a PlatformIO post action, the delta is created if the environment sets
+# "custom_delta_base" to the path of the previous release's firmware image.
+# it can also be used on its own:
+#
+#     python pio-scripts/create_delta_bin.py <source.bin> <target.bin> <delta.bin>
+#
+# similar to bsdiff, the target is split into regions which are similar to
+# regions of the source, and the bytes in between. for similar regions, only
+# the bytewise difference is stored, which is mostly zero if code was moved,
+# such that the zlib compressed delta is much smaller than the target image.
+
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b"ODTD"
+FORMAT_VERSION = 1
+
+SEED_LENGTH = 16  # length of the blocks used to find similar regions
+SEED_STEP = 4  # the source is indexed at every SEED_STEP-th position
+MAX_SCORE_DROP = 32  # ends a region after this many mismatches in excess
+
+
+def find_regions(source, target):
+    index = {}
+    for pos in range(0, len(source) - SEED_LENGTH + 1, SEED_STEP):
+        index.setdefault(source[pos:pos + SEED_LENGTH], pos)
+
+    regions = []
+    region_end = 0
+    target_pos = 0
+
+    while target_pos <= len(target) - SEED_LENGTH:
+        source_pos = index.get(target[target_pos:target_pos + SEED_LENGTH])
+        if source_pos is None:
+            target_pos += 1
+            continue
+
+        # extend the region backwards, as the seed might not be aligned
+        while (target_pos > region_end and source_pos > 0
+               and target[target_pos - 1] == source[source_pos - 1]):
+            target_pos -= 1
+            source_pos -= 1
+
+        # extend the region forward for as long as at least half of the bytes
+        # match, such that changed addresses within moved code are included.
+        score = best_score = 0
+        length = best_length = 0
+        limit = min(len(target) - target_pos, len(source) - source_pos)
+        while length < limit:
+            if target[target_pos + length] == source[source_pos + length]:
+                score += 1
+            else:
+                score -= 1
+            length += 1
+
+            if score > best_score:
+                best_score = score
+                best_length = length
+            elif best_score - score > MAX_SCORE_DROP:
+                break
+
+        regions.append((target_pos, source_pos, best_length))
+        target_pos += best_length
+        region_end = target_pos
+
+    return regions
+
+
+def create_delta(source, target):
+    # the first instruction copies the bytes before the first region
+    regions = [(0, 0, 0)] + find_regions(source, target)
+
+    instructions = bytearray()
+    for i, (target_pos, source_pos, length) in enumerate(regions):
+        if i + 1 < len(regions):
+            next_target_pos, next_source_pos, _ = regions[i + 1]
+        else:
+            next_target_pos, next_source_pos = len(target), source_pos + length
+
+        extra = target[target_pos + length:next_target_pos]
+        seek = next_source_pos - (source_pos + length)
+
+        instructions += struct.pack("<IIi", length, len(extra), seek)
+        instructions += bytes((t - s) & 0xff for t, s in zip(
+            target[target_pos:target_pos + length],
+            source[source_pos:source_pos + length]))
+        instructions += extra
+
+    header = struct.pack("<4sB3xI32sI", MAGIC, FORMAT_VERSION, len(source),
+                         hashlib.sha256(source).digest(), len(target))
+
+    return header + zlib.compress(bytes(instructions), 9)
+
+
+def apply_delta(source, delta):
+    magic, version, source_size, source_hash, target_size = \
+        struct.unpack_from("<4sB3xI32sI", delta)
+    if magic != MAGIC or version != FORMAT_VERSION:
+        raise ValueError("not a delta update")
+    if source_size != len(source) or source_hash != hashlib.sha256(source).digest():
+        raise ValueError("delta was created for another source")
+
+    instructions = zlib.decompress(delta[struct.calcsize("<4sB3xI32sI"):])
+    target = bytearray()
+    source_pos = 0
+    pos = 0
+
+    while len(target) < target_size:
+        diff_length, extra_length, seek = struct.unpack_from("<IIi", instructions, pos)
+        pos += 12
+        target += bytes((d + s) & 0xff for d, s in zip(
+            instructions[pos:pos + diff_length],
+            source[source_pos:source_pos + diff_length]))
+        pos += diff_length
+        target += instructions[pos:pos + extra_length]
+        pos += extra_length
+        source_pos += diff_length + seek
+
+    return bytes(target)
+
+
+def create_delta_file(source_file, target_file, delta_file):
+    with open(source_file, "rb") as f:
+        source = f.read()
+    with open(target_file, "rb") as f:
+        target = f.read()
+
+    delta = create_delta(source, target)
+    if apply_delta(source, delta) != target:
+        raise RuntimeError("delta verification failed")
+
+    with open(delta_file, "wb") as f:
+        f.write(delta)
+
+    print(f"Delta update: {delta_file}, {len(delta)} bytes "
+          f"({100 * len(delta) / len(target):.1f} % of the firmware image)")
+    print(f"MD5 of the firmware image: {hashlib.md5(target).hexdigest()}")
+
+
+try:
+    Import("env")
+except NameError:
+    env = None
+
+if env is not None:
+    def esp32_create_delta_bin(source, target, env):
+        base = env.GetProjectOption("custom_delta_base", "")
+        if not base:
+            return
+
+        print("Generating delta update from " + base)
+        create_delta_file(base, env.subst("$BUILD_DIR/${PROGNAME}.bin"),
+                          env.subst("$BUILD_DIR/${PROGNAME}.delta.bin"))
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", esp32_create_delta_bin)
+elif __name__ == "__main__":
+    if len(sys.argv) != 4:
+        print(f"usage: {sys.argv[0]} <source.bin> <target.bin> <delta.bin>")
+        sys.exit(1)
+
+    create_delta_file(sys.argv[1], sys.argv[2], sys.argv[3])
@@ -6,6 +6,9 @@
 #include "VictronSmartShunt.h"
 #include "MqttBattery.h"
 #include "SerialPortManager.h"
+#include "PinMapping.h"
+#include "Configuration.h"
+#include "TaskStatistics.h"
 
 BatteryClass Battery;
 
@@ -13,68 +16,137 @@ std::shared_ptr<BatteryStats const> BatteryClass::getStats() const
 {
     std::lock_guard<std::mutex> lock(_mutex);
 
-    if (!_upProvider) {
+    if (_providers.empty()) {
         static auto sspDummyStats = std::make_shared<BatteryStats>();
         return sspDummyStats;
     }
 
-    return _upProvider->getStats();
+    if (_spAggregatedStats) { return _spAggregatedStats; }
+
+    return _providers.front()->getStats();
+}
+
+size_t BatteryClass::getPackCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _providers.size();
 }
 
 void BatteryClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&BatteryClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("Battery", std::bind(&BatteryClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
     this->updateSettings();
 }
 
-void BatteryClass::updateSettings()
+std::unique_ptr<BatteryProvider> BatteryClass::createProvider(uint8_t provider,
+        bool verboseLogging, Resources& used)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-
-    if (_upProvider) {
-        _upProvider->deinit();
-        _upProvider = nullptr;
-    }
-    SerialPortManager.invalidateBatteryPort();
-
-    CONFIG_T& config = Configuration.get();
-    if (!config.Battery.Enabled) { return; }
+    std::unique_ptr<BatteryProvider> upProvider;
 
-    bool verboseLogging = config.Battery.VerboseLogging;
+    // the JK BMS and the SmartShunt both use the battery's serial pins, as
+    // does the TWAI controller if no dedicated CAN pins are configured.
+    bool canPins = PinMapping.get().battery_can_rx >= 0;
+    bool twai = false, mcp2515 = false, serialPins = false, mqtt = false;
 
-    switch (config.Battery.Provider) {
+    switch (provider) {
         case 0:
-            _upProvider = std::make_unique<PylontechCanReceiver>();
+            if (!used.twai && (canPins || !used.serialPins)) {
+                upProvider = std::make_unique<PylontechCanReceiver>(PylontechCanReceiver::Bus::Twai);
+                twai = true;
+                serialPins = !canPins;
+            } else if (!used.mcp2515 && !Configuration.get().Huawei.Enabled) {
+                upProvider = std::make_unique<PylontechCanReceiver>(PylontechCanReceiver::Bus::Mcp2515);
+                mcp2515 = true;
+            }
             break;
         case 1:
-            _upProvider = std::make_unique<JkBms::Controller>();
+            if (!used.serialPins) { upProvider = std::make_unique<JkBms::Controller>(); }
+            serialPins = true;
             break;
         case 2:
-            _upProvider = std::make_unique<MqttBattery>();
+            // the MQTT topics are configured once for all batteries
+            if (!used.mqtt) { upProvider = std::make_unique<MqttBattery>(); }
+            mqtt = true;
             break;
         case 3:
-            _upProvider = std::make_unique<VictronSmartShunt>();
+            if (!used.serialPins) { upProvider = std::make_unique<VictronSmartShunt>(); }
+            serialPins = true;
             break;
         default:
-            MessageOutput.printf("Unknown battery provider: %d\r\n", config.Battery.Provider);
-            return;
+            MessageOutput.printf("Unknown battery provider: %d\r\n", provider);
+            return nullptr;
     }
 
-    if(_upProvider->usesHwPort2()) {
+    if (!upProvider) {
+        MessageOutput.printf("[Battery] Provider %d cannot be used as its "
+                "interface is in use already\r\n", provider);
+        return nullptr;
+    }
+
+    if(upProvider->usesHwPort2()) {
         if (!SerialPortManager.allocateBatteryPort(2)) {
             MessageOutput.printf("[Battery] Serial port %d already in use. Initialization aborted!\r\n", 2);
-            _upProvider = nullptr;
-            return;
+            return nullptr;
         }
     }
 
-    if (!_upProvider->init(verboseLogging)) {
-        SerialPortManager.invalidateBatteryPort();
-        _upProvider = nullptr;
+    if (!upProvider->init(verboseLogging)) {
+        if (upProvider->usesHwPort2()) { SerialPortManager.invalidateBatteryPort(); }
+        return nullptr;
+    }
+
+    used.twai |= twai;
+    used.mcp2515 |= mcp2515;
+    used.serialPins |= serialPins;
+    used.mqtt |= mqtt;
+
+    return upProvider;
+}
+
+void BatteryClass::updateSettings()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& upProvider : _providers) {
+        upProvider->deinit();
+    }
+    _providers.clear();
+    _packs.clear();
+    _spAggregatedStats = nullptr;
+    SerialPortManager.invalidateBatteryPort();
+
+    CONFIG_T& config = Configuration.get();
+    if (!config.Battery.Enabled) { return; }
+
+    bool verboseLogging = config.Battery.VerboseLogging;
+
+    // the primary battery is created first, so it gets the
+    // interfaces shared by several kinds of providers.
+    std::vector<BATTERY_ADDITIONAL_CONFIG_T> batteries;
+    batteries.push_back({ config.Battery.Provider, false, config.Battery.CapacityAmpHours });
+    for (auto const& additional : config.Battery.Additional) {
+        if (additional.Provider == BATTERY_PROVIDER_NONE) { continue; }
+        batteries.push_back(additional);
+    }
+
+    Resources used;
+    for (auto const& battery : batteries) {
+        auto upProvider = createProvider(battery.Provider, verboseLogging, used);
+        if (!upProvider) { continue; }
+
+        _packs.push_back({ upProvider->getStats(),
+                static_cast<float>(battery.CapacityAmpHours),
+                battery.CurrentSensor });
+
+        _providers.push_back(std::move(upProvider));
+    }
+
+    if (_providers.size() > 1) {
+        _spAggregatedStats = std::make_shared<AggregatedBatteryStats>();
     }
 }
 
@@ -82,9 +154,24 @@ void BatteryClass::loop()
 {
     std::lock_guard<std::mutex> lock(_mutex);
 
-    if (!_upProvider) { return; }
+    for (auto& upProvider : _providers) {
+        upProvider->loop();
+    }
 
-    _upProvider->loop();
+    if (!_spAggregatedStats) {
+        if (!_providers.empty()) { _providers.front()->getStats()->mqttLoop(); }
+        return;
+    }
+
+    // the stats returned by getStats() are used by other tasks without
+    // holding the mutex, so updates are published as a new instance.
+    if (_spAggregatedStats->packsUpdated(_packs)) {
+        auto spStats = std::make_shared<AggregatedBatteryStats>(*_spAggregatedStats);
+        spStats->updateFrom(_packs);
+        _spAggregatedStats = spStats;
+    }
 
-    _upProvider->getStats()->mqttLoop();
+    // the packs' own MQTT topics would collide, so only the
+    // combined stats are published if several batteries are used.
+    _spAggregatedStats->mqttLoop();
 }
@@ -253,6 +253,29 @@ void PylontechBatteryStats::mqttPublish() const
     MqttSettings.publish(F("battery/charging/chargeImmediately"), String(_chargeImmediately));
 }
 
+float JkBmsBatteryStats::getChargeCurrent() const
+{
+    using Label = JkBms::DataPointLabel;
+
+    auto oCurrent = _dataPoints.get<Label::BatteryCurrentMilliAmps>();
+    if (!oCurrent.has_value()) { return 0; }
+
+    return static_cast<float>(*oCurrent) / 1000;
+}
+
+float JkBmsBatteryStats::getDischargeCurrentLimitation() const
+{
+    using Label = JkBms::DataPointLabel;
+
+    auto oDischargeEnabled = _dataPoints.get<Label::BatteryDischargeEnabled>();
+    if (oDischargeEnabled.has_value() && !*oDischargeEnabled) { return 0; }
+
+    // the BMS does not report a continuous discharge current limit. its
+    // overcurrent protection threshold is the current at which it cuts off
+    // the battery, which must not be used as the limit.
+    return FLT_MAX;
+}
+
 void JkBmsBatteryStats::mqttPublish() const
 {
     BatteryStats::mqttPublish();
@@ -274,16 +297,17 @@ void JkBmsBatteryStats::mqttPublish() const
     bool intervalElapsed = _lastFullMqttPublish + getMqttFullPublishIntervalMs() < millis();
     bool fullPublish = neverFullyPublished || intervalElapsed;
 
-    for (auto iter = _dataPoints.cbegin(); iter != _dataPoints.cend(); ++iter) {
+    _dataPoints.forEach([&](Label label, JkBms::DataPoint const& dataPoint) {
         // skip data points that did not change since last published
-        if (!fullPublish && iter->second.getTimestamp() < _lastMqttPublish) { continue; }
+        if (!fullPublish && dataPoint.getTimestamp() < _lastMqttPublish) { return; }
 
-        auto skipMatch = std::find(mqttSkip.begin(), mqttSkip.end(), iter->first);
-        if (skipMatch != mqttSkip.end()) { continue; }
+        auto skipMatch = std::find(mqttSkip.begin(), mqttSkip.end(), label);
+        if (skipMatch != mqttSkip.end()) { return; }
 
-        String topic((std::string("battery/") + iter->second.getLabelText()).c_str());
-        MqttSettings.publish(topic, iter->second.getValueText().c_str());
-    }
+        String topic("battery/");
+        topic += dataPoint.getLabelText();
+        MqttSettings.publish(topic, dataPoint.getValueText().c_str());
+    });
 
     auto oCellVoltages = _dataPoints.get<Label::CellsMilliVolt>();
     if (oCellVoltages.has_value() && (fullPublish || _cellVoltageTimestamp > _lastMqttPublish)) {
@@ -334,9 +358,9 @@ void JkBmsBatteryStats::updateFrom(JkBms::DataPointContainer const& dp)
     auto oProductId = dp.get<Label::ProductId>();
     if (oProductId.has_value()) {
         _manufacturer = oProductId->c_str();
-        auto pos = oProductId->rfind("JK");
-        if (pos != std::string::npos) {
-            _manufacturer = oProductId->substr(pos).c_str();
+        auto pos = _manufacturer.lastIndexOf("JK");
+        if (pos >= 0) {
+            _manufacturer = _manufacturer.substring(pos);
         }
     }
 
@@ -432,3 +456,189 @@ void VictronSmartShuntStats::mqttPublish() const {
     MqttSettings.publish(F("battery/consumedAmpHours"), String(_consumedAmpHours));
     MqttSettings.publish(F("battery/lastFullCharge"), String(_lastFullCharge));
 }
+
+float AggregatedBatteryStats::getFreshnessWeight(uint32_t ageSeconds)
+{
+    // batteries report at least every few seconds. the contribution of a
+    // pack which stopped reporting fades out, instead of the combined values
+    // jumping as soon as the pack's data is considered outdated.
+    static constexpr uint32_t freshSeconds = 30;
+    static constexpr uint32_t outdatedSeconds = 120;
+
+    if (ageSeconds <= freshSeconds) { return 1; }
+    if (ageSeconds >= outdatedSeconds) { return 0; }
+    return static_cast<float>(outdatedSeconds - ageSeconds) / (outdatedSeconds - freshSeconds);
+}
+
+bool AggregatedBatteryStats::packsUpdated(std::vector<Pack> const& packs) const
+{
+    return std::any_of(packs.cbegin(), packs.cend(),
+            [this](Pack const& pack) { return pack.stats->updateAvailable(_lastAggregation); });
+}
+
+void AggregatedBatteryStats::updateFrom(std::vector<Pack> const& packs)
+{
+    _lastAggregation = millis();
+    _packs = packs;
+
+    // the capacities are only used as weights if all of them are known
+    bool useCapacity = std::all_of(packs.cbegin(), packs.cend(),
+            [](Pack const& pack) { return pack.currentSensor || pack.capacityAmpHours > 0; });
+
+    bool currentSensorFresh = std::any_of(packs.cbegin(), packs.cend(),
+            [](Pack const& pack) { return pack.currentSensor && getFreshnessWeight(pack.stats->getAgeSeconds()) > 0; });
+
+    float socSum = 0, socWeights = 0;
+    float voltageSum = 0, voltageWeights = 0;
+    float sensorSocSum = 0, sensorSocWeights = 0;
+    float sensorVoltageSum = 0, sensorVoltageWeights = 0;
+    float limitSum = 0;
+    bool limitKnown = false;
+    float dischargeLimitSum = 0;
+    bool dischargeLimitKnown = false;
+    String manufacturer;
+
+    _current = 0;
+    _chargeImmediately = false;
+
+    for (auto const& pack : packs) {
+        auto const& stats = *pack.stats;
+        float capacity = useCapacity ? pack.capacityAmpHours : 1;
+
+        if (!manufacturer.isEmpty()) { manufacturer += " + "; }
+        manufacturer += stats.getManufacturer();
+
+        float weight = getFreshnessWeight(stats.getAgeSeconds());
+        if (weight <= 0) { continue; }
+
+        _chargeImmediately |= stats.getImmediateChargingRequest();
+
+        // a shunt measures the current into all packs. the packs' own
+        // currents are part of it and must not be added on top.
+        if (pack.currentSensor) {
+            _current += stats.getChargeCurrent();
+
+            if (stats.isSoCValid()) {
+                float socWeight = getFreshnessWeight(stats.getSoCAgeSeconds());
+                sensorSocSum += socWeight * stats.getSoC();
+                sensorSocWeights += socWeight;
+            }
+
+            if (stats.isVoltageValid()) {
+                float voltageWeight = getFreshnessWeight(stats.getVoltageAgeSeconds());
+                sensorVoltageSum += voltageWeight * stats.getVoltage();
+                sensorVoltageWeights += voltageWeight;
+            }
+
+            continue;
+        }
+
+        if (stats.isSoCValid()) {
+            float socWeight = getFreshnessWeight(stats.getSoCAgeSeconds()) * capacity;
+            socSum += socWeight * stats.getSoC();
+            socWeights += socWeight;
+        }
+
+        if (stats.isVoltageValid()) {
+            float voltageWeight = getFreshnessWeight(stats.getVoltageAgeSeconds()) * capacity;
+            voltageSum += voltageWeight * stats.getVoltage();
+            voltageWeights += voltageWeight;
+        }
+
+        // the packs are connected in parallel, so the currents add up. the
+        // charge current limits of all packs reporting one add up as well.
+        if (!currentSensorFresh) { _current += stats.getChargeCurrent(); }
+
+        if (stats.getChargeCurrentLimitation() < FLT_MAX) {
+            limitSum += stats.getChargeCurrentLimitation();
+            limitKnown = true;
+        }
+
+        if (stats.getDischargeCurrentLimitation() < FLT_MAX) {
+            dischargeLimitSum += stats.getDischargeCurrentLimitation();
+            dischargeLimitKnown = true;
+        }
+    }
+
+    _manufacturer = manufacturer;
+    _chargeCurrentLimitation = limitKnown ? limitSum : FLT_MAX;
+    _dischargeCurrentLimitation = dischargeLimitKnown ? dischargeLimitSum : FLT_MAX;
+
+    // the values of the current sensors are used if no pack reports them
+    if (socWeights > 0) {
+        setSoC(socSum / socWeights, 1/*precision*/, _lastAggregation);
+    } else if (sensorSocWeights > 0) {
+        setSoC(sensorSocSum / sensorSocWeights, 1/*precision*/, _lastAggregation);
+    }
+
+    if (voltageWeights > 0) {
+        setVoltage(voltageSum / voltageWeights, _lastAggregation);
+    } else if (sensorVoltageWeights > 0) {
+        setVoltage(sensorVoltageSum / sensorVoltageWeights, _lastAggregation);
+    }
+
+    _lastUpdate = _lastAggregation;
+}
+
+void AggregatedBatteryStats::getLiveViewData(JsonVariant& root) const
+{
+    BatteryStats::getLiveViewData(root);
+
+    addLiveViewValue(root, "current", _current, "A", 1);
+    if (_chargeCurrentLimitation < FLT_MAX) {
+        addLiveViewValue(root, "chargeCurrentLimitation", _chargeCurrentLimitation, "A", 1);
+    }
+    if (_dischargeCurrentLimitation < FLT_MAX) {
+        addLiveViewValue(root, "dischargeCurrentLimitation", _dischargeCurrentLimitation, "A", 1);
+    }
+    addLiveViewTextValue(root, "chargeImmediately", (_chargeImmediately?"yes":"no"));
+
+    // each pack is shown individually as well
+    JsonArray packs = root.createNestedArray("packs");
+    for (auto const& pack : _packs) {
+        JsonVariant packRoot = packs.createNestedObject();
+        pack.stats->getLiveViewData(packRoot);
+        packRoot["current_sensor"] = pack.currentSensor;
+        if (pack.capacityAmpHours > 0) {
+            packRoot["capacity"] = pack.capacityAmpHours;
+        }
+
+        // the issues of all packs are shown at the top, with the
+        // highest severity reported for the respective issue.
+        for (JsonPair issue : packRoot["issues"].as<JsonObject>()) {
+            int severity = issue.value().as<int>();
+            if (root["issues"][issue.key().c_str()].as<int>() < severity) {
+                root["issues"][issue.key().c_str()] = severity;
+            }
+        }
+    }
+}
+
+void AggregatedBatteryStats::mqttPublish() const
+{
+    // the packs' own topics would collide, so only the main values
+    // of each pack are published, using a topic prefix per pack.
+    BatteryStats::mqttPublish();
+
+    MqttSettings.publish(F("battery/current"), String(_current));
+    MqttSettings.publish(F("battery/charging/chargeImmediately"), String(_chargeImmediately));
+    if (_chargeCurrentLimitation < FLT_MAX) {
+        MqttSettings.publish(F("battery/settings/chargeCurrentLimitation"), String(_chargeCurrentLimitation));
+    }
+    if (_dischargeCurrentLimitation < FLT_MAX) {
+        MqttSettings.publish(F("battery/settings/dischargeCurrentLimitation"), String(_dischargeCurrentLimitation));
+    }
+
+    for (size_t idx = 0; idx < _packs.size(); ++idx) {
+        auto const& stats = *_packs[idx].stats;
+        String prefix("battery/pack");
+        prefix += String(idx + 1);
+        prefix += "/";
+
+        MqttSettings.publish(prefix + "manufacturer", stats.getManufacturer());
+        MqttSettings.publish(prefix + "dataAge", String(stats.getAgeSeconds()));
+        MqttSettings.publish(prefix + "stateOfCharge", String(stats.getSoC()));
+        MqttSettings.publish(prefix + "voltage", String(stats.getVoltage()));
+        MqttSettings.publish(prefix + "current", String(stats.getChargeCurrent()));
+    }
+}
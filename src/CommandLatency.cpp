@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "CommandLatency.h"
+#include "TaskStatistics.h"
+#include <Hoymiles.h>
+#include <cmath>
+#include <limits>
+
+CommandLatencyClass CommandLatency;
+
+static constexpr uint32_t halfOfAllMillis = std::numeric_limits<uint32_t>::max() / 2;
+
+// a decision of the DPL is only attributed to a command which
+// was enqueued within the DPL's timeout for inverter updates.
+static constexpr uint32_t maxDecisionAgeMillis = 30 * 1000;
+
+// the statistics stage of a command ends once the inverter reports the AC
+// power (within the tolerance) or power state which was commanded. a limit
+// may not be reached at all if the panels do not provide enough power, so
+// waiting is given up after the timeout.
+static constexpr uint32_t settleTimeoutMillis = 60 * 1000;
+static constexpr float settleToleranceRatio = 0.03f; // of the max power
+static constexpr float minSettleToleranceWatts = 10.0f;
+
+void CommandLatencyClass::init(Scheduler& scheduler)
+{
+    scheduler.addTask(_loopTask);
+    _loopTask.setCallback(TaskStatistics.wrap("CommandLatency", std::bind(&CommandLatencyClass::loop, this)));
+    _loopTask.setIterations(TASK_FOREVER);
+    _loopTask.setInterval(100 * TASK_MILLISECOND);
+    _loopTask.enable();
+}
+
+char const* CommandLatencyClass::getKindName(Kind kind)
+{
+    switch (kind) {
+        case Kind::Limit: return "limit";
+        case Kind::Power: return "power";
+        default: break;
+    }
+    return "unknown";
+}
+
+char const* CommandLatencyClass::getStageName(Stage stage)
+{
+    switch (stage) {
+        case Stage::Decision: return "decision";
+        case Stage::Queue: return "queue";
+        case Stage::Radio: return "radio";
+        case Stage::Statistics: return "statistics";
+        case Stage::Total: return "total";
+        default: break;
+    }
+    return "unknown";
+}
+
+void CommandLatencyClass::Histogram::add(uint32_t valueMs)
+{
+    size_t idx = 0;
+    while (idx < BoundCount && valueMs > Bounds[idx]) { ++idx; }
+    _buckets[idx]++;
+    _count++;
+    _sum += valueMs;
+    _max = std::max(_max, valueMs);
+}
+
+std::array<uint32_t, CommandLatencyClass::Histogram::BoundCount + 1> CommandLatencyClass::Histogram::getCumulativeCounts() const
+{
+    std::array<uint32_t, BoundCount + 1> res;
+    uint32_t cumulated = 0;
+    for (size_t idx = 0; idx < res.size(); ++idx) {
+        cumulated += _buckets[idx];
+        res[idx] = cumulated;
+    }
+    return res;
+}
+
+void CommandLatencyClass::notifyDecision(uint64_t serial, uint32_t decisionMillis)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& kind : _states[serial].kinds) {
+        kind.oDecisionMillis = decisionMillis;
+    }
+}
+
+std::map<uint64_t, CommandLatencyClass::InverterStatistics> CommandLatencyClass::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _statistics;
+}
+
+void CommandLatencyClass::loop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) { continue; }
+
+        auto& state = _states[inv->serial()];
+        auto& stats = _statistics[inv->serial()];
+
+        auto process = [&](Kind kind, command_timing_t const& timing) {
+            auto& kindState = state.kinds[static_cast<size_t>(kind)];
+            auto& kindStats = stats.kinds[static_cast<size_t>(kind)];
+            auto add = [&kindStats](Stage stage, uint32_t value) {
+                kindStats.stages[static_cast<size_t>(stage)].add(value);
+            };
+
+            if (timing.acknowledged != 0 && timing.acknowledged != kindState.lastAcknowledged) {
+                kindState.lastAcknowledged = timing.acknowledged;
+
+                kindStats.commands++;
+                kindStats.resends += (timing.sendCount > 0) ? (timing.sendCount - 1) : 0;
+                kindStats.retransmits += timing.retransmitCount;
+
+                add(Stage::Queue, timing.firstSent - timing.enqueued);
+                add(Stage::Radio, timing.acknowledged - timing.firstSent);
+
+                kindState.pendingStartMillis = timing.enqueued;
+
+                // a command enqueued before the decision was made does
+                // not belong to that decision, which is kept in that case.
+                uint32_t decisionAge = timing.enqueued - kindState.oDecisionMillis.value_or(timing.enqueued);
+                if (kindState.oDecisionMillis.has_value() && decisionAge < halfOfAllMillis) {
+                    if (decisionAge <= maxDecisionAgeMillis) {
+                        add(Stage::Decision, decisionAge);
+                        kindState.pendingStartMillis = *kindState.oDecisionMillis;
+                    }
+                    kindState.oDecisionMillis = std::nullopt;
+                }
+
+                kindState.oPendingAckMillis = timing.acknowledged;
+
+                // the limit was set to the commanded value when the command
+                // was acknowledged
+                uint16_t maxPower = inv->DevInfo()->getMaxPower();
+                kindState.oTargetPower = std::nullopt;
+                if (maxPower > 0) {
+                    kindState.oTargetPower = inv->SystemConfigPara()->getLimitPercent() * maxPower / 100;
+                }
+                kindState.targetProducing = inv->PowerCommand()->getLastPowerCommandOn();
+            }
+
+            if (!kindState.oPendingAckMillis.has_value()) { return; }
+
+            uint32_t ackMillis = *kindState.oPendingAckMillis;
+            if (millis() - ackMillis > settleTimeoutMillis) {
+                kindStats.unsettled++;
+                kindState.oPendingAckMillis = std::nullopt;
+                return;
+            }
+
+            // wait for statistics which were received after the acknowledgement
+            uint32_t lastStats = inv->Statistics()->getLastUpdate();
+            if ((lastStats - ackMillis) > halfOfAllMillis) { return; }
+            if (lastStats == ackMillis) { return; }
+
+            // without a known target, the first statistics update is used
+            if (kind == Kind::Limit && kindState.oTargetPower.has_value()) {
+                float tolerance = std::max(minSettleToleranceWatts,
+                        settleToleranceRatio * inv->DevInfo()->getMaxPower());
+                float power = inv->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
+                if (std::fabs(power - *kindState.oTargetPower) > tolerance) { return; }
+            }
+
+            if (kind == Kind::Power && inv->isProducing() != kindState.targetProducing) { return; }
+
+            add(Stage::Statistics, lastStats - ackMillis);
+            add(Stage::Total, lastStats - kindState.pendingStartMillis);
+            kindState.oPendingAckMillis = std::nullopt;
+        };
+
+        process(Kind::Limit, inv->SystemConfigPara()->getLastLimitCommandTiming());
+        process(Kind::Power, inv->PowerCommand()->getLastPowerCommandTiming());
+    }
+}
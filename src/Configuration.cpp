@@ -4,6 +4,7 @@
  */
 #include "Configuration.h"
 #include "MessageOutput.h"
+#include "SmlMeter.h"
 #include "Utils.h"
 #include "defaults.h"
 #include <ArduinoJson.h>
@@ -12,18 +13,44 @@
 
 CONFIG_T config;
 
+// the SML OBIS table is (de)serialized using a document of its own, such that
+// the configuration document does not need to be enlarged to hold it. the
+// remainder accounts for the enclosing objects and the keys when reading.
+static constexpr size_t SML_OBIS_JSON_SIZE = JSON_ARRAY_SIZE(POWERMETER_SML_MAX_OBIS)
+    + POWERMETER_SML_MAX_OBIS * (JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(6)) + 128;
+
+// all of the configuration except for the SML OBIS table
+static DynamicJsonDocument getConfigFilter()
+{
+    DynamicJsonDocument filter(JSON_OBJECT_SIZE(2) + JSON_OBJECT_SIZE(2));
+    filter["*"] = true;
+    filter["powermeter"]["*"] = true;
+    filter["powermeter"]["sml_obis"] = false;
+    return filter;
+}
+
 void ConfigurationClass::init()
 {
     memset(&config, 0x0, sizeof(config));
+    publishSnapshot();
 }
 
 bool ConfigurationClass::write()
 {
+    config.Cfg.SaveCount++;
+    publishSnapshot();
+
+    return _store.save(config);
+}
+
+bool ConfigurationClass::writeJson()
+{
+    std::lock_guard<std::mutex> lock(_jsonMutex);
+
     File f = LittleFS.open(CONFIG_FILENAME, "w");
     if (!f) {
         return false;
     }
-    config.Cfg.SaveCount++;
 
     DynamicJsonDocument doc(JSON_BUFFER_SIZE);
 
@@ -68,6 +95,7 @@ bool ConfigurationClass::write()
     mqtt["topic"] = config.Mqtt.Topic;
     mqtt["retain"] = config.Mqtt.Retain;
     mqtt["publish_interval"] = config.Mqtt.PublishInterval;
+    mqtt["task_stats_interval"] = config.Mqtt.TaskStatsInterval;
     mqtt["clean_session"] = config.Mqtt.CleanSession;
 
     JsonObject mqtt_lwt = mqtt.createNestedObject("lwt");
@@ -149,6 +177,7 @@ bool ConfigurationClass::write()
     vedirect["enabled"] = config.Vedirect.Enabled;
     vedirect["verbose_logging"] = config.Vedirect.VerboseLogging;
     vedirect["updates_only"] = config.Vedirect.UpdatesOnly;
+    vedirect["udp_port"] = config.Vedirect.UdpPort;
 
     JsonObject powermeter = doc.createNestedObject("powermeter");
     powermeter["enabled"] = config.PowerMeter.Enabled;
@@ -161,6 +190,18 @@ bool ConfigurationClass::write()
     powermeter["sdmbaudrate"] = config.PowerMeter.SdmBaudrate;
     powermeter["sdmaddress"] = config.PowerMeter.SdmAddress;
     powermeter["http_individual_requests"] = config.PowerMeter.HttpIndividualRequests;
+    powermeter["sma_hm_serial"] = config.PowerMeter.SmaHmSerial;
+    powermeter["filter_mode"] = config.PowerMeter.FilterMode;
+    powermeter["filter_window"] = config.PowerMeter.FilterWindow;
+    powermeter["filter_hampel_threshold"] = config.PowerMeter.FilterHampelThreshold;
+    powermeter["filter_time_constant"] = config.PowerMeter.FilterTimeConstant;
+    powermeter["fusion_time_constant"] = config.PowerMeter.FusionTimeConstant;
+
+    JsonArray powermeter_failover_sources = powermeter.createNestedArray("failover_sources");
+    for (uint8_t source : config.PowerMeter.FailoverSources) {
+        if (source == POWERMETER_SOURCE_NONE) { continue; }
+        powermeter_failover_sources.add(source);
+    }
 
     JsonArray powermeter_http_phases = powermeter.createNestedArray("http_phases");
     for (uint8_t i = 0; i < POWERMETER_MAX_PHASES; i++) {
@@ -177,6 +218,28 @@ bool ConfigurationClass::write()
         powermeter_phase["json_path"] = config.PowerMeter.Http_Phase[i].JsonPath;
     }
 
+    DynamicJsonDocument smlObisDoc(SML_OBIS_JSON_SIZE);
+    if (!Utils::checkJsonAlloc(smlObisDoc, __FUNCTION__, __LINE__)) {
+        return false;
+    }
+
+    JsonArray powermeter_sml_obis = smlObisDoc.to<JsonArray>();
+    for (uint8_t i = 0; i < POWERMETER_SML_MAX_OBIS; i++) {
+        if (config.PowerMeter.Sml_Obis[i].Value == 0) { continue; }
+
+        JsonObject powermeter_obis = powermeter_sml_obis.createNestedObject();
+        powermeter_obis["meter"] = config.PowerMeter.Sml_Obis[i].Meter;
+        powermeter_obis["value"] = config.PowerMeter.Sml_Obis[i].Value;
+
+        JsonArray obis = powermeter_obis.createNestedArray("obis");
+        for (uint8_t b : config.PowerMeter.Sml_Obis[i].Obis) { obis.add(b); }
+    }
+
+    // inserted as raw JSON, which is referenced rather than copied
+    String smlObis;
+    serializeJson(smlObisDoc, smlObis);
+    powermeter["sml_obis"] = serialized(smlObis.c_str(), smlObis.length());
+
     JsonObject powerlimiter = doc.createNestedObject("powerlimiter");
     powerlimiter["enabled"] = config.PowerLimiter.Enabled;
     powerlimiter["verbose_logging"] = config.PowerLimiter.VerboseLogging;
@@ -198,15 +261,29 @@ bool ConfigurationClass::write()
     powerlimiter["voltage_start_threshold"] = config.PowerLimiter.VoltageStartThreshold;
     powerlimiter["voltage_stop_threshold"] = config.PowerLimiter.VoltageStopThreshold;
     powerlimiter["voltage_load_correction_factor"] = config.PowerLimiter.VoltageLoadCorrectionFactor;
+    powerlimiter["voltage_load_correction_auto"] = config.PowerLimiter.VoltageLoadCorrectionAuto;
     powerlimiter["inverter_restart_hour"] = config.PowerLimiter.RestartHour;
     powerlimiter["full_solar_passthrough_soc"] = config.PowerLimiter.FullSolarPassThroughSoc;
     powerlimiter["full_solar_passthrough_start_voltage"] = config.PowerLimiter.FullSolarPassThroughStartVoltage;
     powerlimiter["full_solar_passthrough_stop_voltage"] = config.PowerLimiter.FullSolarPassThroughStopVoltage;
+    powerlimiter["use_battery_discharge_limit"] = config.PowerLimiter.UseBatteryDischargeLimit;
+    powerlimiter["battery_discharge_limit_margin"] = config.PowerLimiter.BatteryDischargeLimitMargin;
 
     JsonObject battery = doc.createNestedObject("battery");
     battery["enabled"] = config.Battery.Enabled;
     battery["verbose_logging"] = config.Battery.VerboseLogging;
     battery["provider"] = config.Battery.Provider;
+    battery["capacity"] = config.Battery.CapacityAmpHours;
+    JsonArray batteryAdditional = battery.createNestedArray("additional");
+    for (uint8_t i = 0; i < BATTERY_MAX_ADDITIONAL; i++) {
+        auto const& cfg = config.Battery.Additional[i];
+        if (cfg.Provider == BATTERY_PROVIDER_NONE) { continue; }
+
+        JsonObject additional = batteryAdditional.createNestedObject();
+        additional["provider"] = cfg.Provider;
+        additional["current_sensor"] = cfg.CurrentSensor;
+        additional["capacity"] = cfg.CapacityAmpHours;
+    }
     battery["jkbms_interface"] = config.Battery.JkBmsInterface;
     battery["jkbms_polling_interval"] = config.Battery.JkBmsPollingInterval;
     battery["mqtt_topic"] = config.Battery.MqttSocTopic;
@@ -221,6 +298,10 @@ bool ConfigurationClass::write()
     huawei["enable_voltage_limit"] = config.Huawei.Auto_Power_Enable_Voltage_Limit;
     huawei["lower_power_limit"] = config.Huawei.Auto_Power_Lower_Power_Limit;
     huawei["upper_power_limit"] = config.Huawei.Auto_Power_Upper_Power_Limit;
+    huawei["target_grid_power"] = config.Huawei.Auto_Power_Target_Grid_Power;
+    huawei["deadband"] = config.Huawei.Auto_Power_Deadband;
+    huawei["proportional_gain"] = config.Huawei.Auto_Power_Proportional_Gain;
+    huawei["integral_gain"] = config.Huawei.Auto_Power_Integral_Gain;
 
     // Serialize JSON to file
     if (serializeJson(doc, f) == 0) {
@@ -234,18 +315,78 @@ bool ConfigurationClass::write()
 
 bool ConfigurationClass::read()
 {
-    File f = LittleFS.open(CONFIG_FILENAME, "r", false);
+    uint32_t sections = _store.check();
+    bool convert = !_store.isLayoutCurrent();
+
+    // a configuration of another version is migrated using its JSON file
+    if (_store.getVersion() != CONFIG_VERSION && LittleFS.exists(CONFIG_FILENAME)) {
+        sections = 0;
+    }
+
+    if (sections == ConfigurationStore::AllSections
+            && _store.load(config, sections) == sections) {
+        publishSnapshot();
+        return true;
+    }
+
+    // the JSON file is only read to convert the configuration, i.e., if the
+    // binary file does not exist yet or the layout of a section changed.
+    // sections missing otherwise (corrupted data) are set to their defaults.
+    bool res = readJson(convert);
+    uint32_t jsonSaveCount = config.Cfg.SaveCount;
+    uint32_t loaded = _store.load(config, sections);
+
+    // the JSON file is only written on request, hence it is older than the
+    // binary file if the configuration was changed since. the sections read
+    // from it then lack the latest changes.
+    if (convert && (loaded & ConfigurationStore::CfgSection)
+            && jsonSaveCount < config.Cfg.SaveCount) {
+        MessageOutput.printf("Configuration file is older than the binary "
+                "configuration (save count %u < %u), some settings may be outdated\r\n",
+                jsonSaveCount, config.Cfg.SaveCount);
+    }
+
+    if (res && config.Cfg.Version == CONFIG_VERSION) {
+        _store.save(config);
+    }
+
+    publishSnapshot();
+    return res;
+}
 
+bool ConfigurationClass::readJson(bool fromFile)
+{
     DynamicJsonDocument doc(JSON_BUFFER_SIZE);
 
     if (!Utils::checkJsonAlloc(doc, __FUNCTION__, __LINE__)) {
         return false;
     }
 
-    // Deserialize the JSON document
-    const DeserializationError error = deserializeJson(doc, f);
-    if (error) {
-        MessageOutput.println("Failed to read file, using default configuration");
+    DynamicJsonDocument smlObisDoc(SML_OBIS_JSON_SIZE);
+
+    if (!Utils::checkJsonAlloc(smlObisDoc, __FUNCTION__, __LINE__)) {
+        return false;
+    }
+
+    // an empty document yields the default configuration
+    File f;
+    if (fromFile) {
+        f = LittleFS.open(CONFIG_FILENAME, "r", false);
+
+        // Deserialize the JSON document
+        const DeserializationError error = deserializeJson(doc, f,
+                DeserializationOption::Filter(getConfigFilter()));
+        if (error) {
+            MessageOutput.println("Failed to read file, using default configuration");
+        }
+
+        StaticJsonDocument<JSON_OBJECT_SIZE(1) + JSON_OBJECT_SIZE(1)> smlObisFilter;
+        smlObisFilter["powermeter"]["sml_obis"] = true;
+
+        if (!f.seek(0) || deserializeJson(smlObisDoc, f,
+                    DeserializationOption::Filter(smlObisFilter))) {
+            smlObisDoc.clear();
+        }
     }
 
     JsonObject cfg = doc["cfg"];
@@ -316,6 +457,7 @@ bool ConfigurationClass::read()
     strlcpy(config.Mqtt.Topic, mqtt["topic"] | MQTT_TOPIC, sizeof(config.Mqtt.Topic));
     config.Mqtt.Retain = mqtt["retain"] | MQTT_RETAIN;
     config.Mqtt.PublishInterval = mqtt["publish_interval"] | MQTT_PUBLISH_INTERVAL;
+    config.Mqtt.TaskStatsInterval = mqtt["task_stats_interval"] | MQTT_TASK_STATS_INTERVAL;
     config.Mqtt.CleanSession = mqtt["clean_session"] | MQTT_CLEAN_SESSION;
 
     JsonObject mqtt_lwt = mqtt["lwt"];
@@ -397,6 +539,7 @@ bool ConfigurationClass::read()
     config.Vedirect.Enabled = vedirect["enabled"] | VEDIRECT_ENABLED;
     config.Vedirect.VerboseLogging = vedirect["verbose_logging"] | VEDIRECT_VERBOSE_LOGGING;
     config.Vedirect.UpdatesOnly = vedirect["updates_only"] | VEDIRECT_UPDATESONLY;
+    config.Vedirect.UdpPort = vedirect["udp_port"] | VEDIRECT_UDP_PORT;
 
     JsonObject powermeter = doc["powermeter"];
     config.PowerMeter.Enabled = powermeter["enabled"] | POWERMETER_ENABLED;
@@ -409,6 +552,17 @@ bool ConfigurationClass::read()
     config.PowerMeter.SdmBaudrate =  powermeter["sdmbaudrate"] | POWERMETER_SDMBAUDRATE;
     config.PowerMeter.SdmAddress =  powermeter["sdmaddress"] | POWERMETER_SDMADDRESS;
     config.PowerMeter.HttpIndividualRequests = powermeter["http_individual_requests"] | false;
+    config.PowerMeter.SmaHmSerial = powermeter["sma_hm_serial"] | 0;
+    config.PowerMeter.FilterMode = powermeter["filter_mode"] | POWERMETER_FILTER_MODE;
+    config.PowerMeter.FilterWindow = powermeter["filter_window"] | POWERMETER_FILTER_WINDOW;
+    config.PowerMeter.FilterHampelThreshold = powermeter["filter_hampel_threshold"] | POWERMETER_FILTER_HAMPEL_THRESHOLD;
+    config.PowerMeter.FilterTimeConstant = powermeter["filter_time_constant"] | POWERMETER_FILTER_TIME_CONSTANT;
+    config.PowerMeter.FusionTimeConstant = powermeter["fusion_time_constant"] | 0;
+
+    JsonArray powermeter_failover_sources = powermeter["failover_sources"];
+    for (uint8_t i = 0; i < POWERMETER_MAX_SOURCES - 1; i++) {
+        config.PowerMeter.FailoverSources[i] = powermeter_failover_sources[i] | POWERMETER_SOURCE_NONE;
+    }
 
     JsonArray powermeter_http_phases = powermeter["http_phases"];
     for (uint8_t i = 0; i < POWERMETER_MAX_PHASES; i++) {
@@ -425,6 +579,26 @@ bool ConfigurationClass::read()
         strlcpy(config.PowerMeter.Http_Phase[i].JsonPath, powermeter_phase["json_path"] | "", sizeof(config.PowerMeter.Http_Phase[i].JsonPath));
     }
 
+    JsonArray powermeter_sml_obis = smlObisDoc["powermeter"]["sml_obis"];
+    if (!powermeter_sml_obis.isNull()) {
+        for (uint8_t i = 0; i < POWERMETER_SML_MAX_OBIS; i++) {
+            JsonObject powermeter_obis = powermeter_sml_obis[i].as<JsonObject>();
+            JsonArray obis = powermeter_obis["obis"];
+
+            config.PowerMeter.Sml_Obis[i].Meter = powermeter_obis["meter"] | 0;
+            config.PowerMeter.Sml_Obis[i].Value = (obis.size() == 6) ? (powermeter_obis["value"] | 0) : 0;
+            for (uint8_t b = 0; b < 6; b++) {
+                config.PowerMeter.Sml_Obis[i].Obis[b] = obis[b] | 0;
+            }
+        }
+    } else {
+        // the OBIS codes which were used before the table was configurable
+        using Value = SmlMeter::Value;
+        config.PowerMeter.Sml_Obis[0] = { 0, static_cast<uint8_t>(Value::PowerTotal), { 0x01, 0x00, 0x10, 0x07, 0x00, 0xff } };
+        config.PowerMeter.Sml_Obis[1] = { 0, static_cast<uint8_t>(Value::Import), { 0x01, 0x00, 0x01, 0x08, 0x00, 0xff } };
+        config.PowerMeter.Sml_Obis[2] = { 0, static_cast<uint8_t>(Value::Export), { 0x01, 0x00, 0x02, 0x08, 0x00, 0xff } };
+    }
+
     JsonObject powerlimiter = doc["powerlimiter"];
     config.PowerLimiter.Enabled = powerlimiter["enabled"] | POWERLIMITER_ENABLED;
     config.PowerLimiter.VerboseLogging = powerlimiter["verbose_logging"] | VERBOSE_LOGGING;
@@ -447,15 +621,27 @@ bool ConfigurationClass::read()
     config.PowerLimiter.VoltageStartThreshold = powerlimiter["voltage_start_threshold"] | POWERLIMITER_VOLTAGE_START_THRESHOLD;
     config.PowerLimiter.VoltageStopThreshold = powerlimiter["voltage_stop_threshold"] | POWERLIMITER_VOLTAGE_STOP_THRESHOLD;
     config.PowerLimiter.VoltageLoadCorrectionFactor = powerlimiter["voltage_load_correction_factor"] | POWERLIMITER_VOLTAGE_LOAD_CORRECTION_FACTOR;
+    config.PowerLimiter.VoltageLoadCorrectionAuto = powerlimiter["voltage_load_correction_auto"] | POWERLIMITER_VOLTAGE_LOAD_CORRECTION_AUTO;
     config.PowerLimiter.RestartHour = powerlimiter["inverter_restart_hour"] | POWERLIMITER_RESTART_HOUR;
     config.PowerLimiter.FullSolarPassThroughSoc = powerlimiter["full_solar_passthrough_soc"] | POWERLIMITER_FULL_SOLAR_PASSTHROUGH_SOC;
     config.PowerLimiter.FullSolarPassThroughStartVoltage = powerlimiter["full_solar_passthrough_start_voltage"] | POWERLIMITER_FULL_SOLAR_PASSTHROUGH_START_VOLTAGE;
     config.PowerLimiter.FullSolarPassThroughStopVoltage = powerlimiter["full_solar_passthrough_stop_voltage"] | POWERLIMITER_FULL_SOLAR_PASSTHROUGH_STOP_VOLTAGE;
+    config.PowerLimiter.UseBatteryDischargeLimit = powerlimiter["use_battery_discharge_limit"] | POWERLIMITER_USE_BATTERY_DISCHARGE_LIMIT;
+    config.PowerLimiter.BatteryDischargeLimitMargin = powerlimiter["battery_discharge_limit_margin"] | POWERLIMITER_BATTERY_DISCHARGE_LIMIT_MARGIN;
 
     JsonObject battery = doc["battery"];
     config.Battery.Enabled = battery["enabled"] | BATTERY_ENABLED;
     config.Battery.VerboseLogging = battery["verbose_logging"] | VERBOSE_LOGGING;
     config.Battery.Provider = battery["provider"] | BATTERY_PROVIDER;
+    config.Battery.CapacityAmpHours = battery["capacity"] | 0;
+    JsonArray batteryAdditional = battery["additional"];
+    for (uint8_t i = 0; i < BATTERY_MAX_ADDITIONAL; i++) {
+        auto& cfg = config.Battery.Additional[i];
+        JsonObject additional = batteryAdditional[i];
+        cfg.Provider = additional["provider"] | BATTERY_PROVIDER_NONE;
+        cfg.CurrentSensor = additional["current_sensor"] | false;
+        cfg.CapacityAmpHours = additional["capacity"] | 0;
+    }
     config.Battery.JkBmsInterface = battery["jkbms_interface"] | BATTERY_JKBMS_INTERFACE;
     config.Battery.JkBmsPollingInterval = battery["jkbms_polling_interval"] | BATTERY_JKBMS_POLLING_INTERVAL;
     strlcpy(config.Battery.MqttSocTopic, battery["mqtt_topic"] | "", sizeof(config.Battery.MqttSocTopic));
@@ -470,6 +656,10 @@ bool ConfigurationClass::read()
     config.Huawei.Auto_Power_Enable_Voltage_Limit =  huawei["enable_voltage_limit"] | HUAWEI_AUTO_POWER_ENABLE_VOLTAGE_LIMIT;
     config.Huawei.Auto_Power_Lower_Power_Limit = huawei["lower_power_limit"] | HUAWEI_AUTO_POWER_LOWER_POWER_LIMIT;
     config.Huawei.Auto_Power_Upper_Power_Limit = huawei["upper_power_limit"] | HUAWEI_AUTO_POWER_UPPER_POWER_LIMIT;
+    config.Huawei.Auto_Power_Target_Grid_Power = huawei["target_grid_power"] | HUAWEI_AUTO_POWER_TARGET_GRID_POWER;
+    config.Huawei.Auto_Power_Deadband = huawei["deadband"] | HUAWEI_AUTO_POWER_DEADBAND;
+    config.Huawei.Auto_Power_Proportional_Gain = huawei["proportional_gain"] | HUAWEI_AUTO_POWER_PROPORTIONAL_GAIN;
+    config.Huawei.Auto_Power_Integral_Gain = huawei["integral_gain"] | HUAWEI_AUTO_POWER_INTEGRAL_GAIN;
 
     f.close();
     return true;
@@ -490,7 +680,8 @@ void ConfigurationClass::migrate()
     }
 
     // Deserialize the JSON document
-    const DeserializationError error = deserializeJson(doc, f);
+    const DeserializationError error = deserializeJson(doc, f,
+            DeserializationOption::Filter(getConfigFilter()));
     if (error) {
         MessageOutput.printf("Failed to read file, cancel migration: %s\r\n", error.c_str());
         return;
@@ -541,6 +732,7 @@ void ConfigurationClass::migrate()
 
     config.Cfg.Version = CONFIG_VERSION;
     write();
+    writeJson();
     read();
 }
 
@@ -549,6 +741,46 @@ CONFIG_T& ConfigurationClass::get()
     return config;
 }
 
+std::shared_ptr<CONFIG_SNAPSHOT_T const> ConfigurationClass::getSnapshot() const
+{
+    return std::atomic_load(&_spSnapshot);
+}
+
+/**
+ * copies the respective sections of the configuration into a new snapshot,
+ * which replaces the previous one. readers still holding the previous
+ * snapshot keep using it until they fetch the new one. the version is only
+ * incremented if the snapshot's contents actually changed.
+ */
+void ConfigurationClass::publishSnapshot()
+{
+    std::lock_guard<std::mutex> lock(_snapshotMutex);
+
+    // value-initialized, i.e., padding bytes are zero as well
+    auto spSnapshot = std::make_shared<CONFIG_SNAPSHOT_T>();
+
+    spSnapshot->PowerMeter.Enabled = config.PowerMeter.Enabled;
+    spSnapshot->PowerMeter.VerboseLogging = config.PowerMeter.VerboseLogging;
+    spSnapshot->PowerMeter.Interval = config.PowerMeter.Interval;
+    spSnapshot->PowerMeter.Source = config.PowerMeter.Source;
+
+    memcpy(&spSnapshot->Vedirect, &config.Vedirect, sizeof(config.Vedirect));
+    memcpy(&spSnapshot->PowerLimiter, &config.PowerLimiter, sizeof(config.PowerLimiter));
+    memcpy(&spSnapshot->Battery, &config.Battery, sizeof(config.Battery));
+    memcpy(&spSnapshot->Huawei, &config.Huawei, sizeof(config.Huawei));
+
+    uint32_t version = _snapshotVersion.load();
+    spSnapshot->Version = version;
+
+    if (_spSnapshot && memcmp(spSnapshot.get(), _spSnapshot.get(), sizeof(CONFIG_SNAPSHOT_T)) == 0) {
+        return;
+    }
+
+    spSnapshot->Version = ++version;
+    std::atomic_store(&_spSnapshot, std::shared_ptr<CONFIG_SNAPSHOT_T const>(std::move(spSnapshot)));
+    _snapshotVersion.store(version);
+}
+
 INVERTER_CONFIG_T* ConfigurationClass::getFreeInverterSlot()
 {
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
@@ -0,0 +1,348 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "ConfigurationStore.h"
+#include "Configuration.h"
+#include "MessageOutput.h"
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include <type_traits>
+
+#define CONFIG_SECTION(id, layout, member) \
+    ConfigurationStore::Section { id, layout, offsetof(CONFIG_T, member), sizeof(CONFIG_T::member) }
+
+// the ids must never change. new members of CONFIG_T get new ids. increment
+// the layout version (second column) whenever the member's layout changes.
+const std::array<ConfigurationStore::Section, ConfigurationStore::SectionCount> ConfigurationStore::_sections = {{
+    CONFIG_SECTION(1, 1, Cfg),
+    CONFIG_SECTION(2, 1, WiFi),
+    CONFIG_SECTION(3, 1, Mdns),
+    CONFIG_SECTION(4, 1, Ntp),
+    CONFIG_SECTION(5, 2, Mqtt),
+    CONFIG_SECTION(6, 1, Dtu),
+    CONFIG_SECTION(7, 1, Security),
+    CONFIG_SECTION(8, 1, Display),
+    CONFIG_SECTION(9, 1, Led_Single),
+    CONFIG_SECTION(10, 1, Vedirect),
+    CONFIG_SECTION(11, 2, PowerMeter),
+    CONFIG_SECTION(12, 2, PowerLimiter),
+    CONFIG_SECTION(13, 2, Battery),
+    CONFIG_SECTION(14, 2, Huawei),
+    CONFIG_SECTION(15, 1, Inverter),
+    CONFIG_SECTION(16, 1, Dev_PinMapping)
+}};
+
+#undef CONFIG_SECTION
+
+// the sections are read and written as raw memory
+static_assert(std::is_trivially_copyable<CONFIG_T>::value, "CONFIG_T must be trivially copyable");
+
+static_assert(sizeof(CONFIG_T::Mqtt) <= UINT16_MAX, "section too large");
+static_assert(sizeof(CONFIG_T::PowerMeter) <= UINT16_MAX, "section too large");
+static_assert(sizeof(CONFIG_T::Inverter) <= UINT16_MAX, "section too large");
+
+namespace {
+
+constexpr uint32_t Magic = 0x42435444; // "DTCB"
+constexpr uint16_t FormatVersion = 2;
+constexpr uint16_t MaxStoredSections = 64;
+constexpr char const TempFilename[] = "/config.tmp";
+
+struct FileHeader {
+    uint32_t magic;
+    uint16_t formatVersion;
+    uint16_t sectionCount;
+    uint32_t configVersion;
+};
+
+struct TableEntry {
+    uint16_t id;
+    uint16_t size;
+    uint16_t layout;
+    uint16_t reserved;
+};
+
+// format version 1 did not store the layout version, all were 1
+struct TableEntryV1 {
+    uint16_t id;
+    uint16_t size;
+};
+
+struct SlotHeader {
+    uint32_t sequence;
+    uint16_t id;
+    uint16_t size;
+    uint32_t crc;
+};
+
+template<typename T>
+bool readStruct(File& f, T& t)
+{
+    return f.read(reinterpret_cast<uint8_t*>(&t), sizeof(T)) == sizeof(T);
+}
+
+template<typename T>
+bool writeStruct(File& f, T const& t)
+{
+    return f.write(reinterpret_cast<uint8_t const*>(&t), sizeof(T)) == sizeof(T);
+}
+
+uint32_t getSlotSize(uint16_t sectionSize)
+{
+    return sizeof(SlotHeader) + sectionSize;
+}
+
+} // namespace
+
+uint32_t ConfigurationStore::calcCrc(File& f, uint16_t size)
+{
+    uint8_t buffer[128];
+    uint32_t crc = 0;
+
+    while (size > 0) {
+        size_t chunk = std::min<size_t>(size, sizeof(buffer));
+        if (f.read(buffer, chunk) != chunk) { return ~crc; }
+        crc = esp_rom_crc32_le(crc, buffer, chunk);
+        size -= chunk;
+    }
+
+    return crc;
+}
+
+bool ConfigurationStore::findSlot(File& f, size_t idx, uint16_t size, uint32_t position)
+{
+    auto& state = _states[idx];
+    state.filePosition = position;
+
+    for (uint8_t slot = 0; slot < 2; ++slot) {
+        SlotHeader slotHeader;
+        if (!f.seek(position + slot * getSlotSize(size))) { continue; }
+        if (!readStruct(f, slotHeader)) { continue; }
+        if (slotHeader.id != _sections[idx].id || slotHeader.size != size) { continue; }
+
+        // the other slot holds more recent data
+        if (state.valid && static_cast<int32_t>(slotHeader.sequence - state.sequence) <= 0) { continue; }
+
+        if (calcCrc(f, size) != slotHeader.crc) { continue; }
+
+        state.valid = true;
+        state.slot = slot;
+        state.sequence = slotHeader.sequence;
+        state.crc = slotHeader.crc;
+    }
+
+    return state.valid;
+}
+
+uint32_t ConfigurationStore::check()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _states = {};
+    _version = 0;
+    _layoutMatches = false;
+
+    File f = LittleFS.open(CONFIG_STORE_FILENAME, "r", false);
+    if (!f) { return 0; }
+
+    FileHeader header;
+    if (!readStruct(f, header) || header.magic != Magic
+            || (header.formatVersion != FormatVersion && header.formatVersion != 1)
+            || header.sectionCount > MaxStoredSections) {
+        MessageOutput.println("Invalid binary configuration file header");
+        return 0;
+    }
+
+    bool v1 = (header.formatVersion == 1);
+    std::array<TableEntry, MaxStoredSections> table;
+    size_t tableSize = header.sectionCount * (v1 ? sizeof(TableEntryV1) : sizeof(TableEntry));
+    uint32_t tableCrc;
+    if (f.read(reinterpret_cast<uint8_t*>(table.data()), tableSize) != tableSize
+            || !readStruct(f, tableCrc)) {
+        return 0;
+    }
+
+    uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<uint8_t const*>(&header), sizeof(header));
+    crc = esp_rom_crc32_le(crc, reinterpret_cast<uint8_t const*>(table.data()), tableSize);
+    if (crc != tableCrc) {
+        MessageOutput.println("Invalid binary configuration section table");
+        return 0;
+    }
+
+    if (v1) {
+        // converts in place, starting with the last entry
+        auto raw = reinterpret_cast<uint8_t const*>(table.data());
+        for (size_t entry = header.sectionCount; entry-- > 0; ) {
+            TableEntryV1 old;
+            memcpy(&old, raw + entry * sizeof(old), sizeof(old));
+            table[entry] = { old.id, old.size, 1, 0 };
+        }
+    }
+
+    _version = header.configVersion;
+    _layoutMatches = (!v1 && header.sectionCount == SectionCount && _version == CONFIG_VERSION);
+
+    uint32_t res = 0;
+    uint32_t position = sizeof(header) + tableSize + sizeof(tableCrc);
+
+    for (size_t entry = 0; entry < header.sectionCount; ++entry) {
+        auto const& stored = table[entry];
+        uint32_t nextPosition = position + 2 * getSlotSize(stored.size);
+
+        bool matches = entry < SectionCount
+            && _sections[entry].id == stored.id
+            && _sections[entry].size == stored.size
+            && _sections[entry].layout == stored.layout;
+        _layoutMatches &= matches;
+
+        for (size_t idx = 0; idx < SectionCount; ++idx) {
+            if (_sections[idx].id != stored.id) { continue; }
+
+            // the layout of this section changed, its data cannot be used
+            if (_sections[idx].size != stored.size || _sections[idx].layout != stored.layout) {
+                MessageOutput.printf("Layout of configuration section %d changed\r\n", stored.id);
+                break;
+            }
+
+            if (findSlot(f, idx, stored.size, position)) { res |= (1UL << idx); }
+            break;
+        }
+
+        position = nextPosition;
+    }
+
+    return res;
+}
+
+uint32_t ConfigurationStore::load(CONFIG_T& config, uint32_t sections)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    File f = LittleFS.open(CONFIG_STORE_FILENAME, "r", false);
+    if (!f) { return 0; }
+
+    uint32_t res = 0;
+
+    for (size_t idx = 0; idx < SectionCount; ++idx) {
+        if ((sections & (1UL << idx)) == 0) { continue; }
+
+        auto const& section = _sections[idx];
+        auto& state = _states[idx];
+        if (!state.valid) { continue; }
+
+        auto data = reinterpret_cast<uint8_t*>(&config) + section.offset;
+        uint32_t position = state.filePosition + state.slot * getSlotSize(section.size) + sizeof(SlotHeader);
+
+        if (!f.seek(position)
+                || f.read(data, section.size) != section.size
+                || esp_rom_crc32_le(0, data, section.size) != state.crc) {
+            MessageOutput.printf("Failed to load configuration section %d\r\n", section.id);
+            state.valid = false;
+            continue;
+        }
+
+        res |= (1UL << idx);
+    }
+
+    return res;
+}
+
+bool ConfigurationStore::save(CONFIG_T const& config)
+{
+    // write() is called from the web server and the main loop. concurrent
+    // writers would use the same slots and sequence numbers otherwise.
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_layoutMatches) { return rewrite(config); }
+
+    File f = LittleFS.open(CONFIG_STORE_FILENAME, "r+");
+    if (!f) { return rewrite(config); }
+
+    bool res = true;
+
+    for (size_t idx = 0; idx < SectionCount; ++idx) {
+        auto const& section = _sections[idx];
+        auto& state = _states[idx];
+
+        auto data = reinterpret_cast<uint8_t const*>(&config) + section.offset;
+        uint32_t crc = esp_rom_crc32_le(0, data, section.size);
+        if (state.valid && state.crc == crc) { continue; }
+
+        // never overwrite the slot holding the current data
+        uint8_t slot = state.valid ? (1 - state.slot) : 0;
+        SlotHeader slotHeader = { state.sequence + 1, section.id, section.size, crc };
+
+        if (!f.seek(state.filePosition + slot * getSlotSize(section.size))
+                || !writeStruct(f, slotHeader)
+                || f.write(data, section.size) != section.size) {
+            MessageOutput.printf("Failed to write configuration section %d\r\n", section.id);
+            res = false;
+            continue;
+        }
+
+        state.valid = true;
+        state.slot = slot;
+        state.sequence = slotHeader.sequence;
+        state.crc = crc;
+    }
+
+    f.close();
+    return res;
+}
+
+/**
+ * creates the file with the current layout. it is written to a temporary
+ * file first, which then replaces the previous file (atomically). the mutex
+ * must be held by the caller.
+ */
+bool ConfigurationStore::rewrite(CONFIG_T const& config)
+{
+    _layoutMatches = false;
+
+    File f = LittleFS.open(TempFilename, "w");
+    if (!f) { return false; }
+
+    FileHeader header = { Magic, FormatVersion, SectionCount, CONFIG_VERSION };
+    std::array<TableEntry, SectionCount> table;
+    for (size_t idx = 0; idx < SectionCount; ++idx) {
+        table[idx] = { _sections[idx].id, _sections[idx].size, _sections[idx].layout, 0 };
+    }
+
+    uint32_t tableCrc = esp_rom_crc32_le(0, reinterpret_cast<uint8_t const*>(&header), sizeof(header));
+    tableCrc = esp_rom_crc32_le(tableCrc, reinterpret_cast<uint8_t const*>(table.data()), sizeof(table));
+
+    bool res = writeStruct(f, header) && writeStruct(f, table) && writeStruct(f, tableCrc);
+
+    uint32_t position = sizeof(header) + sizeof(table) + sizeof(tableCrc);
+    static uint8_t const zeros[64] = {};
+
+    for (size_t idx = 0; idx < SectionCount && res; ++idx) {
+        auto const& section = _sections[idx];
+        auto data = reinterpret_cast<uint8_t const*>(&config) + section.offset;
+        uint32_t crc = esp_rom_crc32_le(0, data, section.size);
+
+        SlotHeader slotHeader = { 1, section.id, section.size, crc };
+        res = writeStruct(f, slotHeader) && f.write(data, section.size) == section.size;
+
+        // the second slot is allocated, but holds no data yet
+        res = res && writeStruct(f, SlotHeader {});
+        for (size_t written = 0; res && written < section.size; written += sizeof(zeros)) {
+            size_t chunk = std::min<size_t>(section.size - written, sizeof(zeros));
+            res = f.write(zeros, chunk) == chunk;
+        }
+
+        _states[idx] = { true, position, 0, 1, crc };
+        position += 2 * getSlotSize(section.size);
+    }
+
+    f.close();
+
+    if (!res || !LittleFS.rename(TempFilename, CONFIG_STORE_FILENAME)) {
+        MessageOutput.println("Failed to write binary configuration file");
+        LittleFS.remove(TempFilename);
+        _states = {};
+        return false;
+    }
+
+    _version = CONFIG_VERSION;
+    _layoutMatches = true;
+    return true;
+}
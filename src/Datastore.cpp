@@ -4,12 +4,13 @@
  */
 #include "Datastore.h"
 #include "Configuration.h"
+#include "TaskStatistics.h"
 #include <Hoymiles.h>
 
 DatastoreClass Datastore;
 
 DatastoreClass::DatastoreClass()
-    : _loopTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&DatastoreClass::loop, this))
+    : _loopTask(1 * TASK_SECOND, TASK_FOREVER, TaskStatistics.wrap("Datastore", std::bind(&DatastoreClass::loop, this)))
 {
 }
 
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "DeltaPatcher.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if CONFIG_IDF_TARGET_ESP32S2
+#include <esp32s2/rom/miniz.h>
+#elif CONFIG_IDF_TARGET_ESP32S3
+#include <esp32s3/rom/miniz.h>
+#elif CONFIG_IDF_TARGET_ESP32C3
+#include <esp32c3/rom/miniz.h>
+#else
+#include <esp32/rom/miniz.h>
+#endif
+
+namespace {
+
+constexpr char Magic[4] = { 'O', 'D', 'T', 'D' };
+constexpr uint8_t FormatVersion = 1;
+
+uint32_t readUint32(uint8_t const* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+} // namespace
+
+DeltaPatcher::DeltaPatcher(Reader reader, Writer writer, Verifier verifier)
+    : _reader(std::move(reader))
+    , _writer(std::move(writer))
+    , _verifier(std::move(verifier))
+{
+}
+
+DeltaPatcher::~DeltaPatcher() = default;
+
+bool DeltaPatcher::fail(char const* error)
+{
+    if (_error == nullptr) { _error = error; }
+    return false;
+}
+
+bool DeltaPatcher::isComplete() const
+{
+    return _error == nullptr
+        && _headerLength == sizeof(_header)
+        && _written == _header.targetSize
+        && _state == State::Control
+        && _controlLength == 0;
+}
+
+bool DeltaPatcher::checkHeader()
+{
+    static_assert(sizeof(Header) == 48, "delta header layout");
+
+    if (memcmp(_header.magic, Magic, sizeof(Magic)) != 0) {
+        return fail("Not a delta update");
+    }
+
+    if (_header.version != FormatVersion) {
+        return fail("Delta format not supported");
+    }
+
+    if (!_verifier(_header.sourceSize, _header.sourceHash)) {
+        return fail("Delta was created for another firmware");
+    }
+
+    // the decompressor uses the output buffer as its dictionary,
+    // which must be TINFL_LZ_DICT_SIZE bytes in size.
+    _upInflator.reset(new (std::nothrow) tinfl_decompressor);
+    _upDictionary.reset(new (std::nothrow) uint8_t[TINFL_LZ_DICT_SIZE]);
+    if (!_upInflator || !_upDictionary) {
+        return fail("Out of memory");
+    }
+
+    tinfl_init(_upInflator.get());
+    return true;
+}
+
+bool DeltaPatcher::feed(uint8_t const* data, size_t len)
+{
+    if (_error != nullptr) { return false; }
+
+    if (_headerLength < sizeof(_header)) {
+        size_t chunk = std::min(len, sizeof(_header) - _headerLength);
+        memcpy(reinterpret_cast<uint8_t*>(&_header) + _headerLength, data, chunk);
+        _headerLength += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (_headerLength == sizeof(_header) && !checkHeader()) { return false; }
+    }
+
+    if (len == 0) { return true; }
+
+    for (;;) {
+        size_t inBytes = len;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - _dictionaryOffset;
+        uint8_t* out = _upDictionary.get() + _dictionaryOffset;
+
+        auto status = tinfl_decompress(_upInflator.get(), data, &inBytes,
+                _upDictionary.get(), out, &outBytes,
+                TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+
+        data += inBytes;
+        len -= inBytes;
+
+        if (!process(out, outBytes)) { return false; }
+        _dictionaryOffset = (_dictionaryOffset + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status < TINFL_STATUS_DONE) { return fail("Delta is corrupted"); }
+
+        if (status == TINFL_STATUS_DONE) {
+            if (len > 0) { return fail("Delta has trailing data"); }
+            break;
+        }
+
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT) { break; }
+
+        // TINFL_STATUS_HAS_MORE_OUTPUT: the end of the dictionary was reached
+    }
+
+    return true;
+}
+
+bool DeltaPatcher::startInstruction()
+{
+    uint32_t diffLength = readUint32(&_control[0]);
+    _extraLength = readUint32(&_control[4]);
+    _seek = static_cast<int32_t>(readUint32(&_control[8]));
+    _controlLength = 0;
+
+    if (diffLength > _header.targetSize - _written
+            || _extraLength > _header.targetSize - _written - diffLength) {
+        return fail("Delta exceeds the target size");
+    }
+
+    if (diffLength > _header.sourceSize - _sourcePosition) {
+        return fail("Delta exceeds the source size");
+    }
+
+    _state = State::Diff;
+    _remaining = diffLength;
+    return true;
+}
+
+bool DeltaPatcher::process(uint8_t const* data, size_t len)
+{
+    while (len > 0 || (_state != State::Control && _remaining == 0)) {
+        switch (_state) {
+            case State::Control: {
+                if (_written == _header.targetSize) {
+                    return fail("Delta has trailing data");
+                }
+
+                size_t chunk = std::min(len, _control.size() - _controlLength);
+                memcpy(&_control[_controlLength], data, chunk);
+                _controlLength += chunk;
+                data += chunk;
+                len -= chunk;
+
+                if (_controlLength == _control.size() && !startInstruction()) {
+                    return false;
+                }
+                break;
+            }
+
+            case State::Diff: {
+                if (_remaining == 0) {
+                    _state = State::Extra;
+                    _remaining = _extraLength;
+                    break;
+                }
+
+                size_t chunk = std::min({ len, static_cast<size_t>(_remaining), _buffer.size() });
+                if (!_reader(_sourcePosition, _buffer.data(), chunk)) {
+                    return fail("Reading the running firmware failed");
+                }
+
+                for (size_t i = 0; i < chunk; ++i) { _buffer[i] += data[i]; }
+
+                if (!_writer(_buffer.data(), chunk)) { return fail("Writing the new firmware failed"); }
+
+                _sourcePosition += chunk;
+                _written += chunk;
+                _remaining -= chunk;
+                data += chunk;
+                len -= chunk;
+                break;
+            }
+
+            case State::Extra: {
+                if (_remaining == 0) {
+                    int64_t position = static_cast<int64_t>(_sourcePosition) + _seek;
+                    if (position < 0 || position > _header.sourceSize) {
+                        return fail("Delta exceeds the source size");
+                    }
+
+                    _sourcePosition = position;
+                    _state = State::Control;
+                    break;
+                }
+
+                size_t chunk = std::min(len, static_cast<size_t>(_remaining));
+                if (!_writer(data, chunk)) { return fail("Writing the new firmware failed"); }
+
+                _written += chunk;
+                _remaining -= chunk;
+                data += chunk;
+                len -= chunk;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
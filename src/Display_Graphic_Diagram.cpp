@@ -5,11 +5,12 @@
 #include "Display_Graphic_Diagram.h"
 #include "Configuration.h"
 #include "Datastore.h"
+#include "TaskStatistics.h"
 #include <algorithm>
 
 DisplayGraphicDiagramClass::DisplayGraphicDiagramClass()
-    : _averageTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&DisplayGraphicDiagramClass::averageLoop, this))
-    , _dataPointTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&DisplayGraphicDiagramClass::dataPointLoop, this))
+    : _averageTask(1 * TASK_SECOND, TASK_FOREVER, TaskStatistics.wrap("DisplayDiagramAverage", std::bind(&DisplayGraphicDiagramClass::averageLoop, this)))
+    , _dataPointTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("DisplayDiagramDataPoint", std::bind(&DisplayGraphicDiagramClass::dataPointLoop, this)))
 {
 }
 
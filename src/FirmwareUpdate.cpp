@@ -0,0 +1,494 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "FirmwareUpdate.h"
+#include "Configuration.h"
+#include "MessageOutput.h"
+#include "Utils.h"
+#include <Ed25519.h>
+#include <HTTPClient.h>
+#include <Update.h>
+#include <WiFiClientSecure.h>
+#include <esp_ota_ops.h>
+
+FirmwareUpdateClass FirmwareUpdate;
+
+namespace {
+
+bool parseHex(char const* hex, uint8_t* out, size_t len)
+{
+    if (strlen(hex) != 2 * len) { return false; }
+
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') { return c - '0'; }
+        if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+        if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+        return -1;
+    };
+
+    for (size_t i = 0; i < len; ++i) {
+        int high = nibble(hex[2 * i]);
+        int low = nibble(hex[2 * i + 1]);
+        if (high < 0 || low < 0) { return false; }
+        out[i] = (high << 4) | low;
+    }
+
+    return true;
+}
+
+} // namespace
+
+void FirmwareUpdateClass::init(Scheduler& scheduler)
+{
+    scheduler.addTask(_loopTask);
+    _loopTask.setCallback(std::bind(&FirmwareUpdateClass::loop, this));
+    _loopTask.setIterations(TASK_FOREVER);
+    _loopTask.setInterval(TASK_SECOND);
+    _loopTask.enable();
+
+    if (!isSignatureRequired()) {
+        MessageOutput.println("[FirmwareUpdate] built without FIRMWARE_SIGNING_KEY, "
+                "unsigned images are accepted");
+    }
+}
+
+void FirmwareUpdateClass::loop()
+{
+    // the download task cannot restart the DTU itself, as
+    // the display and LEDs are owned by the main loop.
+    if (_restartPending) {
+        MessageOutput.println("[FirmwareUpdate] restarting to boot the new firmware");
+        Utils::restartDtu();
+    }
+}
+
+char const* FirmwareUpdateClass::getStateText() const
+{
+    switch (_state) {
+        case State::Idle:
+            return "idle";
+        case State::Receiving:
+            return "receiving";
+        case State::Finished:
+            return "finished";
+        case State::Failed:
+            return "failed";
+    }
+
+    return "unknown";
+}
+
+String FirmwareUpdateClass::getError()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error;
+}
+
+String FirmwareUpdateClass::getReceivedHash()
+{
+    SHA256 sha256;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        sha256 = _sha256;
+    }
+
+    uint8_t digest[32];
+    sha256.finalize(digest, sizeof(digest));
+
+    char hex[2 * sizeof(digest) + 1];
+    for (size_t i = 0; i < sizeof(digest); ++i) {
+        snprintf(&hex[2 * i], 3, "%02x", digest[i]);
+    }
+
+    return String(hex);
+}
+
+// to be called with the mutex held
+void FirmwareUpdateClass::fail(String const& reason)
+{
+    _error = reason;
+    _state = State::Failed;
+    _upPatcher = nullptr;
+
+    if (Update.isRunning()) { Update.abort(); }
+
+    MessageOutput.printf("[FirmwareUpdate] failed: %s\r\n", reason.c_str());
+}
+
+void FirmwareUpdateClass::abort(String const& reason)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    fail(reason);
+}
+
+bool FirmwareUpdateClass::readRunningImage(size_t offset, uint8_t* data, size_t len)
+{
+    auto partition = esp_ota_get_running_partition();
+    return partition != nullptr && esp_partition_read(partition, offset, data, len) == ESP_OK;
+}
+
+// checks whether the running firmware's image is the one a delta was created for
+bool FirmwareUpdateClass::checkRunningImage(size_t size, uint8_t const* sha256)
+{
+    auto partition = esp_ota_get_running_partition();
+    if (partition == nullptr || size > partition->size) { return false; }
+
+    SHA256 hash;
+    uint8_t buffer[512];
+    for (size_t offset = 0; offset < size; offset += sizeof(buffer)) {
+        size_t chunk = std::min(size - offset, sizeof(buffer));
+        if (!readRunningImage(offset, buffer, chunk)) { return false; }
+        hash.update(buffer, chunk);
+    }
+
+    uint8_t digest[32];
+    hash.finalize(digest, sizeof(digest));
+    return memcmp(digest, sha256, sizeof(digest)) == 0;
+}
+
+// to be called with the mutex held
+bool FirmwareUpdateClass::writeImage(uint8_t const* data, size_t len)
+{
+    if (Update.write(const_cast<uint8_t*>(data), len) != len) { return false; }
+
+    if (_delta) { _imageSha256.update(data, len); }
+
+    return true;
+}
+
+bool FirmwareUpdateClass::begin(size_t size, String const& md5, String const& signature, bool delta)
+{
+    return start(size, md5, signature, delta, true);
+}
+
+/**
+ * the download task owns the update while it is running, otherwise it would
+ * resume a new update, or uploads would write into the downloaded image. the
+ * flag is checked with the mutex held, as it is set before the update is
+ * started and cleared only after the download task finished the update.
+ */
+bool FirmwareUpdateClass::start(size_t size, String const& md5, String const& signature, bool delta, bool upload)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (upload && _pulling) {
+        _error = "Download is in progress";
+        return false;
+    }
+
+    if (Update.isRunning()) { Update.abort(); }
+
+    _state = State::Idle;
+    _received = 0;
+    _size = size;
+    _sha256.reset();
+    _imageSha256.reset();
+    _signature = signature;
+    _error = "";
+    _delta = delta;
+    _upPatcher = nullptr;
+
+    if (delta) {
+        using std::placeholders::_1;
+        using std::placeholders::_2;
+        _upPatcher = std::make_unique<DeltaPatcher>(&FirmwareUpdateClass::readRunningImage,
+                std::bind(&FirmwareUpdateClass::writeImage, this, _1, _2),
+                &FirmwareUpdateClass::checkRunningImage);
+    }
+
+#ifdef FIRMWARE_SIGNING_KEY
+    if (_signature.length() != 128) {
+        fail("Signature missing or invalid");
+        return false;
+    }
+#endif
+
+    if (!Update.setMD5(md5.c_str())) {
+        fail("MD5 parameter invalid");
+        return false;
+    }
+
+    // the size of the image created from a delta is not known yet
+    if (!Update.begin((size > 0 && !delta) ? size : UPDATE_SIZE_UNKNOWN, U_FLASH)) {
+        fail(Update.errorString());
+        return false;
+    }
+
+    _state = State::Receiving;
+    MessageOutput.printf("[FirmwareUpdate] started, %s size %u bytes\r\n", (delta ? "delta" : "image"), size);
+    return true;
+}
+
+bool FirmwareUpdateClass::write(size_t offset, uint8_t const* data, size_t len)
+{
+    bool sectorWritten;
+    return writeData(offset, data, len, true, sectorWritten);
+}
+
+bool FirmwareUpdateClass::writeData(size_t offset, uint8_t const* data, size_t len, bool upload, bool& sectorWritten)
+{
+    sectorWritten = false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_state != State::Receiving || (upload && _pulling)) { return false; }
+
+    // the data does not continue the image. the client is
+    // expected to resume at the offset reported in the status.
+    if (offset > _received) { return false; }
+
+    // skip data which was received already
+    size_t skip = std::min(_received - offset, len);
+    data += skip;
+    len -= skip;
+    if (len == 0) { return true; }
+
+    if (_size > 0 && _received + len > _size) {
+        fail("Image larger than announced");
+        return false;
+    }
+
+    size_t progress = Update.progress();
+    if (_upPatcher && !_upPatcher->feed(data, len)) {
+        fail(_upPatcher->getError());
+        return false;
+    }
+
+    if (!_upPatcher && !writeImage(data, len)) {
+        fail(Update.errorString());
+        return false;
+    }
+
+    _sha256.update(data, len);
+    _received += len;
+
+    // the updater buffers the data and writes whole flash sectors
+    sectorWritten = Update.progress() != progress;
+
+    return true;
+}
+
+bool FirmwareUpdateClass::verifySignature(uint8_t const* digest)
+{
+#ifdef FIRMWARE_SIGNING_KEY
+    uint8_t key[32];
+    uint8_t signature[64];
+    if (!parseHex(FIRMWARE_SIGNING_KEY, key, sizeof(key))) { return false; }
+    if (!parseHex(_signature.c_str(), signature, sizeof(signature))) { return false; }
+
+    return Ed25519::verify(signature, key, digest, 32);
+#else
+    (void)digest;
+    return true;
+#endif
+}
+
+bool FirmwareUpdateClass::end()
+{
+    return finish(true);
+}
+
+bool FirmwareUpdateClass::finish(bool upload)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_state != State::Receiving || (upload && _pulling)) { return false; }
+
+    if (_size > 0 && _received != _size) {
+        fail("Image incomplete");
+        return false;
+    }
+
+    if (_upPatcher && !_upPatcher->isComplete()) {
+        fail("Delta incomplete");
+        return false;
+    }
+
+    uint8_t digest[32];
+    if (_delta) {
+        _imageSha256.finalize(digest, sizeof(digest));
+    } else {
+        _sha256.finalize(digest, sizeof(digest));
+    }
+
+    if (!verifySignature(digest)) {
+        fail("Signature verification failed");
+        return false;
+    }
+
+    if (!Update.end(true)) { // true to set the size to the current progress
+        fail(Update.errorString());
+        return false;
+    }
+
+    _state = State::Finished;
+    _upPatcher = nullptr;
+    MessageOutput.printf("[FirmwareUpdate] finished, %u bytes written\r\n", Update.progress());
+
+    // the new firmware might use a different layout of the binary
+    // configuration file. it then reads the JSON file instead.
+    Configuration.writeJson();
+
+    return true;
+}
+
+bool FirmwareUpdateClass::startPull(String const& url, size_t size, String const& md5, String const& signature, bool delta)
+{
+    if (!url.startsWith("http://") && !url.startsWith("https://")) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _error = "URL invalid";
+        return false;
+    }
+
+    // claims the update before starting it, such that
+    // no upload can start or continue meanwhile.
+    if (_pulling.exchange(true)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _error = "Download is already in progress";
+        return false;
+    }
+
+    if (!start(size, md5, signature, delta, false)) {
+        _pulling = false;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pullUrl = url;
+    }
+
+    // the stack must be large enough for TLS connections. the priority
+    // is low, such that the control loops are preferred.
+    if (xTaskCreate(pullTask, "FW_PULL", 8192, this, tskIDLE_PRIORITY + 1, NULL) != pdPASS) {
+        _pulling = false;
+        abort("Could not start download task");
+        return false;
+    }
+
+    return true;
+}
+
+void FirmwareUpdateClass::pullTask(void* parameter)
+{
+    auto instance = static_cast<FirmwareUpdateClass*>(parameter);
+    instance->pull();
+    instance->_pulling = false;
+    vTaskDelete(NULL);
+}
+
+void FirmwareUpdateClass::pull()
+{
+    uint8_t failedAttempts = 0;
+
+    while (_state == State::Receiving) {
+        size_t received = _received;
+
+        if (pullOnce()) {
+            if (finish(false)) { _restartPending = true; }
+            return;
+        }
+
+        // attempts are only counted if they did not make any progress
+        if (_received > received) { failedAttempts = 0; }
+
+        if (++failedAttempts >= _maxPullAttempts) {
+            abort("Download failed");
+            return;
+        }
+
+        MessageOutput.printf("[FirmwareUpdate] download interrupted at %u bytes, resuming\r\n", _received.load());
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
+
+/**
+ * downloads the remaining part of the image. returns true if the
+ * image is complete, false if the download has to be resumed.
+ */
+bool FirmwareUpdateClass::pullOnce()
+{
+    String url;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        url = _pullUrl;
+    }
+
+    // the image is authenticated by its checksum and signature,
+    // not by the certificate of the server it is downloaded from.
+    std::unique_ptr<WiFiClient> upClient;
+    if (url.startsWith("https://")) {
+        auto upSecureClient = std::make_unique<WiFiClientSecure>();
+        upSecureClient->setInsecure();
+        upClient = std::move(upSecureClient);
+    } else {
+        upClient = std::make_unique<WiFiClient>();
+    }
+
+    HTTPClient httpClient;
+    if (!httpClient.begin(*upClient, url)) {
+        abort("URL invalid");
+        return false;
+    }
+
+    httpClient.setTimeout(_pullTimeoutMs);
+    httpClient.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+
+    size_t offset = _received;
+    if (offset > 0) {
+        httpClient.addHeader("Range", "bytes=" + String(offset) + "-");
+    }
+
+    int httpCode = httpClient.GET();
+
+    if (httpCode == HTTP_CODE_OK) {
+        // the server ignored the range, data received already is skipped
+        offset = 0;
+    } else if (httpCode != HTTP_CODE_PARTIAL_CONTENT) {
+        String reason = "HTTP request failed: " + ((httpCode < 0) ? HTTPClient::errorToString(httpCode) : String(httpCode));
+        httpClient.end();
+
+        // the server refuses to provide the image, retrying does not help
+        if (httpCode >= 400 && httpCode < 500) { abort(reason); }
+        else { MessageOutput.printf("[FirmwareUpdate] %s\r\n", reason.c_str()); }
+
+        return false;
+    }
+
+    if (_size == 0) {
+        int contentLength = httpClient.getSize();
+        if (contentLength <= 0) {
+            httpClient.end();
+            abort("Size of the image is unknown");
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _size = offset + contentLength;
+    }
+
+    WiFiClient* stream = httpClient.getStreamPtr();
+    uint8_t buffer[1024];
+    uint32_t lastData = millis();
+
+    while (_state == State::Receiving && _received < _size) {
+        size_t available = stream->available();
+        if (available == 0) {
+            if (!stream->connected() || millis() - lastData > _pullTimeoutMs) { break; }
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        int len = stream->read(buffer, std::min(available, sizeof(buffer)));
+        if (len <= 0) { break; }
+        lastData = millis();
+
+        bool sectorWritten;
+        if (!writeData(offset, buffer, len, false, sectorWritten)) { break; }
+        offset += len;
+
+        if (sectorWritten) { vTaskDelay(pdMS_TO_TICKS(_sectorPauseMs)); }
+    }
+
+    httpClient.end();
+
+    return _state == State::Receiving && _received == _size;
+}
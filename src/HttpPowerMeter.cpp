@@ -10,8 +10,19 @@
 #include <memory>
 #include <ESPmDNS.h>
 
+HttpPowerMeterClass::HttpPowerMeterClass()
+{
+    for (uint8_t i = 0; i < POWERMETER_MAX_PHASES; i++) {
+        _queries[i].phase = i;
+        _queries[i].busy = false;
+    }
+}
+
 void HttpPowerMeterClass::init()
 {
+    if (_queriesDone == nullptr) {
+        _queriesDone = xEventGroupCreate();
+    }
 }
 
 float HttpPowerMeterClass::getPower(int8_t phase)
@@ -23,35 +34,164 @@ bool HttpPowerMeterClass::updateValues()
 {
     const CONFIG_T& config = Configuration.get();
 
+    // with individual requests, phases 2 and 3 are queried by their own task
+    // while phase 1 is queried here. all of them share a single deadline, so
+    // the update takes as long as the slowest request instead of the sum.
+    // the deadline covers the request of phase 1 as well, which runs in
+    // this task while the others are running.
+    EventBits_t pendingBits = 0;
+    uint32_t maxTimeout = config.PowerMeter.Http_Phase[0].Enabled ? config.PowerMeter.Http_Phase[0].Timeout : 0;
+    uint32_t start = millis();
+
+    for (uint8_t i = 1; i < POWERMETER_MAX_PHASES && config.PowerMeter.HttpIndividualRequests; i++) {
+        const POWERMETER_HTTP_PHASE_CONFIG_T& phaseConfig = config.PowerMeter.Http_Phase[i];
+        if (!phaseConfig.Enabled) { continue; }
+
+        if (!startQueryTask(_queries[i], phaseConfig)) {
+            MessageOutput.printf("[HttpPowerMeter] Getting the power of phase %d failed.\r\n", i + 1);
+            MessageOutput.printf("%s\r\n", httpPowerMeterError);
+            return false;
+        }
+
+        pendingBits |= BIT(i);
+        maxTimeout = std::max<uint32_t>(maxTimeout, phaseConfig.Timeout);
+    }
+
+    bool success = true;
+
     for (uint8_t i = 0; i < POWERMETER_MAX_PHASES; i++) {
-        POWERMETER_HTTP_PHASE_CONFIG_T phaseConfig = config.PowerMeter.Http_Phase[i];
+        const POWERMETER_HTTP_PHASE_CONFIG_T& phaseConfig = config.PowerMeter.Http_Phase[i];
 
         if (!phaseConfig.Enabled) {
             power[i] = 0.0;
             continue;
         }
 
-        if (i == 0 || config.PowerMeter.HttpIndividualRequests) {
-            if (!queryPhase(i, phaseConfig.Url, phaseConfig.AuthType, phaseConfig.Username, phaseConfig.Password, phaseConfig.HeaderKey, phaseConfig.HeaderValue, phaseConfig.Timeout,
+        if (i == 0) {
+            auto& query = _queries[0];
+            if (!runQuery(query, phaseConfig.Url, phaseConfig.AuthType, phaseConfig.Username, phaseConfig.Password, phaseConfig.HeaderKey, phaseConfig.HeaderValue, phaseConfig.Timeout,
                     phaseConfig.JsonPath)) {
                 MessageOutput.printf("[HttpPowerMeter] Getting the power of phase %d failed.\r\n", i + 1);
-                MessageOutput.printf("%s\r\n", httpPowerMeterError);
-                return false;
+                MessageOutput.printf("%s\r\n", query.error);
+                success = false;
+                break;
             }
+            power[0] = query.power;
             continue;
         }
 
-        if(!tryGetFloatValueForPhase(i, phaseConfig.JsonPath)) {
+        if (config.PowerMeter.HttpIndividualRequests) {
+            // the connect and the response timeout apply one after another
+            uint32_t deadline = 2 * maxTimeout;
+            uint32_t elapsed = millis() - start;
+            TickType_t remaining = pdMS_TO_TICKS(deadline > elapsed ? deadline - elapsed : 0);
+
+            EventBits_t doneBits = xEventGroupWaitBits(_queriesDone, pendingBits, pdFALSE, pdTRUE, remaining);
+
+            auto& query = _queries[i];
+            if (!(doneBits & BIT(i))) {
+                MessageOutput.printf("[HttpPowerMeter] Getting the power of phase %d failed.\r\n", i + 1);
+                MessageOutput.printf("Request did not finish within %u ms\r\n", deadline);
+                success = false;
+                break;
+            }
+
+            if (!query.success) {
+                MessageOutput.printf("[HttpPowerMeter] Getting the power of phase %d failed.\r\n", i + 1);
+                MessageOutput.printf("%s\r\n", query.error);
+                success = false;
+                break;
+            }
+
+            power[i] = query.power;
+            continue;
+        }
+
+        if(!tryGetFloatValueForPhase(_queries[0], i, phaseConfig.JsonPath, power[i])) {
             MessageOutput.printf("[HttpPowerMeter] Getting the power of phase %d (from JSON fetched with Phase 1 config) failed.\r\n", i + 1);
-            MessageOutput.printf("%s\r\n", httpPowerMeterError);
+            MessageOutput.printf("%s\r\n", _queries[0].error);
             return false;
         }
     }
-    return true;
+
+    // tasks which are still running after a failure keep their phase busy,
+    // which is reported as error if they did not finish until the next update.
+    xEventGroupClearBits(_queriesDone, pendingBits);
+
+    return success;
 }
 
 bool HttpPowerMeterClass::queryPhase(int phase, const String& url, Auth authType, const char* username, const char* password,
     const char* httpHeader, const char* httpValue, uint32_t timeout, const char* jsonPath)
+{
+    auto& query = _queries[phase];
+
+    if (query.busy) {
+        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Previous request for phase %d is still running"), phase + 1);
+        return false;
+    }
+
+    if (!runQuery(query, url, authType, username, password, httpHeader, httpValue, timeout, jsonPath)) {
+        strlcpy(httpPowerMeterError, query.error, sizeof(httpPowerMeterError));
+        return false;
+    }
+
+    power[phase] = query.power;
+    return true;
+}
+
+void HttpPowerMeterClass::queryTask(void* parameter)
+{
+    auto& query = *static_cast<Query*>(parameter);
+    auto const& cfg = query.config;
+
+    query.success = HttpPowerMeter.runQuery(query, cfg.Url, cfg.AuthType, cfg.Username, cfg.Password,
+        cfg.HeaderKey, cfg.HeaderValue, cfg.Timeout, cfg.JsonPath);
+
+    // the waiting task may start the next query as soon as the bit is set,
+    // which fails if the query is still marked as busy then.
+    query.busy = false;
+    xEventGroupSetBits(HttpPowerMeter._queriesDone, BIT(query.phase));
+
+    vTaskDelete(NULL);
+}
+
+bool HttpPowerMeterClass::startQueryTask(Query& query, POWERMETER_HTTP_PHASE_CONFIG_T const& config)
+{
+    // the power meter source may have been changed to HTTP at runtime
+    init();
+    if (_queriesDone == nullptr) {
+        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Could not create event group"));
+        return false;
+    }
+
+    // a task which is still running owns the query, including its
+    // configuration and its error message.
+    if (query.busy) {
+        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Previous request for phase %d is still running"), query.phase + 1);
+        return false;
+    }
+
+    query.busy = true;
+    query.config = config;
+    query.success = false;
+    xEventGroupClearBits(_queriesDone, BIT(query.phase));
+
+    static constexpr char const* taskNames[] = { "HTTPPM_1", "HTTPPM_2", "HTTPPM_3" };
+    static_assert(sizeof(taskNames) / sizeof(taskNames[0]) == POWERMETER_MAX_PHASES);
+
+    // the stack must be large enough for TLS connections
+    if (xTaskCreate(queryTask, taskNames[query.phase], 8192, &query, uxTaskPriorityGet(NULL), NULL) != pdPASS) {
+        query.busy = false;
+        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Could not start request task for phase %d"), query.phase + 1);
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpPowerMeterClass::runQuery(Query& query, const String& url, Auth authType, const char* username, const char* password,
+    const char* httpHeader, const char* httpValue, uint32_t timeout, const char* jsonPath)
 {
     //hostByName in WiFiGeneric fails to resolve local names. issue described in
     //https://github.com/espressif/arduino-esp32/issues/3822
@@ -63,33 +203,11 @@ bool HttpPowerMeterClass::queryPhase(int phase, const String& url, Auth authType
     String uri;
     String base64Authorization;
     uint16_t port;
-    extractUrlComponents(url, protocol, host, uri, port, base64Authorization);
+    extractUrlComponents(query, url, protocol, host, uri, port, base64Authorization);
 
     IPAddress ipaddr((uint32_t)0);
-    //first check if "host" is already an IP adress
-    if (!ipaddr.fromString(host))
-    {
-        //"host"" is not an IP address so try to resolve the IP adress
-        //first try locally via mDNS, then via DNS. WiFiGeneric::hostByName() will spam the console if done the otherway around.
-        const bool mdnsEnabled = Configuration.get().Mdns.Enabled;
-        if (!mdnsEnabled) {
-            snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Error resolving host %s via DNS, try to enable mDNS in Network Settings"), host.c_str());
-            //ensure we try resolving via DNS even if mDNS is disabled
-            if(!WiFiGenericClass::hostByName(host.c_str(), ipaddr)){
-                    snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Error resolving host %s via DNS"), host.c_str());
-                }
-        }
-        else
-        {
-            ipaddr = MDNS.queryHost(host);
-            if (ipaddr == INADDR_NONE){
-                snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Error resolving host %s via mDNS"), host.c_str());
-                //when we cannot find local server via mDNS, try resolving via DNS
-                if(!WiFiGenericClass::hostByName(host.c_str(), ipaddr)){
-                    snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Error resolving host %s via DNS"), host.c_str());
-                }
-            }
-        }
+    if (!resolveHost(query, host, ipaddr)) {
+        return false;
     }
 
     // secureWifiClient MUST be created before HTTPClient
@@ -105,18 +223,56 @@ bool HttpPowerMeterClass::queryPhase(int phase, const String& url, Auth authType
       wifiClient = std::make_unique<WiFiClient>();
     }
 
-    return httpRequest(phase, *wifiClient, ipaddr.toString(), port, uri, https, authType,  username, password, httpHeader, httpValue, timeout, jsonPath);
+    return httpRequest(query, *wifiClient, ipaddr.toString(), port, uri, https, authType,  username, password, httpHeader, httpValue, timeout, jsonPath);
 }
 
-bool HttpPowerMeterClass::httpRequest(int phase, WiFiClient &wifiClient, const String& host, uint16_t port, const String& uri, bool https, Auth authType, const char* username,
+bool HttpPowerMeterClass::resolveHost(Query& query, const String& host, IPAddress& ipaddr)
+{
+    //first check if "host" is already an IP adress
+    if (ipaddr.fromString(host)) { return true; }
+
+    // WiFiGenericClass::hostByName() uses a single static result and must
+    // not be called by the request tasks of multiple phases at once.
+    std::lock_guard<std::mutex> lock(_resolveMutex);
+
+    //"host"" is not an IP address so try to resolve the IP adress
+    //first try locally via mDNS, then via DNS. WiFiGeneric::hostByName() will spam the console if done the otherway around.
+    const bool mdnsEnabled = Configuration.get().Mdns.Enabled;
+    if (!mdnsEnabled) {
+        snprintf_P(query.error, sizeof(query.error), PSTR("Error resolving host %s via DNS, try to enable mDNS in Network Settings"), host.c_str());
+        //ensure we try resolving via DNS even if mDNS is disabled
+        if(!WiFiGenericClass::hostByName(host.c_str(), ipaddr)){
+                snprintf_P(query.error, sizeof(query.error), PSTR("Error resolving host %s via DNS"), host.c_str());
+                return false;
+            }
+    }
+    else
+    {
+        ipaddr = MDNS.queryHost(host);
+        if (ipaddr == INADDR_NONE){
+            snprintf_P(query.error, sizeof(query.error), PSTR("Error resolving host %s via mDNS"), host.c_str());
+            //when we cannot find local server via mDNS, try resolving via DNS
+            if(!WiFiGenericClass::hostByName(host.c_str(), ipaddr)){
+                snprintf_P(query.error, sizeof(query.error), PSTR("Error resolving host %s via DNS"), host.c_str());
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool HttpPowerMeterClass::httpRequest(Query& query, WiFiClient &wifiClient, const String& host, uint16_t port, const String& uri, bool https, Auth authType, const char* username,
     const char* password, const char* httpHeader, const char* httpValue, uint32_t timeout, const char* jsonPath)
 {
+    HTTPClient& httpClient = query.httpClient;
+
     if(!httpClient.begin(wifiClient, host, port, uri, https)){
-        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("httpClient.begin() failed for %s://%s"), (https ? "https" : "http"), host.c_str());
+        snprintf_P(query.error, sizeof(query.error), PSTR("httpClient.begin() failed for %s://%s"), (https ? "https" : "http"), host.c_str());
         return false;
     }
 
-    prepareRequest(timeout, httpHeader, httpValue);
+    prepareRequest(query, timeout, httpHeader, httpValue);
     if (authType == Auth::digest) {
         const char *headers[1] = {"WWW-Authenticate"};
         httpClient.collectHeaders(headers, 1);
@@ -137,30 +293,30 @@ bool HttpPowerMeterClass::httpRequest(int phase, WiFiClient &wifiClient, const S
             String authorization = getDigestAuth(authReq, String(username), String(password), "GET", String(uri), 1);
             httpClient.end();
             if(!httpClient.begin(wifiClient, host, port, uri, https)){
-                snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("httpClient.begin() failed for  %s://%s using digest auth"), (https ? "https" : "http"), host.c_str());
+                snprintf_P(query.error, sizeof(query.error), PSTR("httpClient.begin() failed for  %s://%s using digest auth"), (https ? "https" : "http"), host.c_str());
                 return false;
             }
 
-            prepareRequest(timeout, httpHeader, httpValue);
+            prepareRequest(query, timeout, httpHeader, httpValue);
             httpClient.addHeader("Authorization", authorization);
             httpCode = httpClient.GET();
         }
     }
 
     if (httpCode <= 0) {
-        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("HTTP Error %s"), httpClient.errorToString(httpCode).c_str());
+        snprintf_P(query.error, sizeof(query.error), PSTR("HTTP Error %s"), httpClient.errorToString(httpCode).c_str());
         return false;
     }
 
     if (httpCode != HTTP_CODE_OK) {
-        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("Bad HTTP code: %d"), httpCode);
+        snprintf_P(query.error, sizeof(query.error), PSTR("Bad HTTP code: %d"), httpCode);
         return false;
     }
 
-    httpResponse = httpClient.getString(); // very unfortunate that we cannot parse WifiClient stream directly
+    query.httpResponse = httpClient.getString(); // very unfortunate that we cannot parse WifiClient stream directly
     httpClient.end();
 
-    return tryGetFloatValueForPhase(phase, jsonPath);
+    return tryGetFloatValueForPhase(query, query.phase, jsonPath, query.power);
 }
 
 String HttpPowerMeterClass::extractParam(String& authReq, const String& param, const char delimit) {
@@ -218,27 +374,27 @@ String HttpPowerMeterClass::getDigestAuth(String& authReq, const String& usernam
     return authorization;
 }
 
-bool HttpPowerMeterClass::tryGetFloatValueForPhase(int phase, const char* jsonPath)
+bool HttpPowerMeterClass::tryGetFloatValueForPhase(Query& query, int phase, const char* jsonPath, float& value)
 {
     FirebaseJson json;
-    json.setJsonData(httpResponse);
-    FirebaseJsonData value;
-    if (!json.get(value, jsonPath)) {
-        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("[HttpPowerMeter] Couldn't find a value for phase %i with Json query \"%s\""), phase, jsonPath);
+    json.setJsonData(query.httpResponse);
+    FirebaseJsonData jsonValue;
+    if (!json.get(jsonValue, jsonPath)) {
+        snprintf_P(query.error, sizeof(query.error), PSTR("[HttpPowerMeter] Couldn't find a value for phase %i with Json query \"%s\""), phase, jsonPath);
         return false;
     }
 
-    power[phase] = value.to<float>();
+    value = jsonValue.to<float>();
     return true;
 }
 
 //extract url component as done by httpClient::begin(String url, const char* expectedProtocol) https://github.com/espressif/arduino-esp32/blob/da6325dd7e8e152094b19fe63190907f38ef1ff0/libraries/HTTPClient/src/HTTPClient.cpp#L250
-bool HttpPowerMeterClass::extractUrlComponents(String url, String& _protocol, String& _host, String& _uri, uint16_t& _port, String& _base64Authorization)
+bool HttpPowerMeterClass::extractUrlComponents(Query& query, String url, String& _protocol, String& _host, String& _uri, uint16_t& _port, String& _base64Authorization)
 {
     // check for : (http: or https:
     int index = url.indexOf(':');
     if(index < 0) {
-        snprintf_P(httpPowerMeterError, sizeof(httpPowerMeterError), PSTR("failed to parse protocol"));
+        snprintf_P(query.error, sizeof(query.error), PSTR("failed to parse protocol"));
         return false;
     }
 
@@ -304,7 +460,9 @@ String HttpPowerMeterClass::sha256(const String& data) {
 
     return hashStr;
 }
-void HttpPowerMeterClass::prepareRequest(uint32_t timeout, const char* httpHeader, const char* httpValue) {
+void HttpPowerMeterClass::prepareRequest(Query& query, uint32_t timeout, const char* httpHeader, const char* httpValue) {
+    HTTPClient& httpClient = query.httpClient;
+
     httpClient.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
     httpClient.setUserAgent("OpenDTU-OnBattery");
     httpClient.setConnectTimeout(timeout);
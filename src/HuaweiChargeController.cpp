@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "HuaweiChargeController.h"
+#include <algorithm>
+#include <cmath>
+
+void HuaweiChargeController::reset()
+{
+    _integral = 0;
+    _lastSentPower = 0;
+    _initialized = false;
+}
+
+HuaweiChargeController::Output HuaweiChargeController::update(Input const& input)
+{
+    Output res = { 0, 0, false, false };
+
+    float efficiency = (input.efficiency > 0.5) ? input.efficiency : 1.0;
+
+    // start from the PSU's current output (converted to the power it draws,
+    // which is what the set-point refers to), so that taking over control
+    // does not cause a step.
+    if (!_initialized) {
+        _integral = std::max(input.outputPower, 0.0f) / efficiency;
+        _lastSentPower = _integral;
+        _initialized = true;
+        res.send = true;
+    }
+
+    // the PSU shall not output more power than the BMS allows to be charged
+    // into the battery, considering current from other sources (solar).
+    float maxPower = std::max(_params.upperPowerLimit, 0.0f);
+    if (input.chargeCurrentLimit < FLT_MAX && input.outputVoltage > 0) {
+        float permissibleCurrent = input.chargeCurrentLimit - (input.chargeCurrent - input.outputCurrent);
+        float permissiblePower = std::max(permissibleCurrent, 0.0f) * input.outputVoltage / efficiency;
+        if (permissiblePower < maxPower) {
+            maxPower = permissiblePower;
+            res.bmsLimited = true;
+        }
+    }
+
+    // positive if more power is exported than desired, i.e., the
+    // PSU shall increase its output to charge the battery.
+    float error = _params.targetGridPower - input.gridPower;
+
+    // a long pause between readings must not cause a huge step
+    float elapsedSeconds = std::min<uint32_t>(input.elapsedMillis, 10 * 1000) / 1000.0;
+
+    // errors within the deadband are not integrated. otherwise, the integral
+    // drifts while changes are not sent, until a change is sent which
+    // overshoots, and the output keeps hunting around the target.
+    if (std::abs(error) >= _params.deadbandWatts) {
+        _integral += _params.integralGain * error * elapsedSeconds;
+    }
+
+    // the integral is kept within the output range (anti-windup)
+    _integral = std::min(std::max(_integral, 0.0f), maxPower);
+
+    float setpoint = _params.proportionalGain * error + _integral;
+    setpoint = std::min(std::max(setpoint, 0.0f), maxPower);
+
+    // the PSU is turned off if the surplus is too small. while it is off,
+    // the integral follows the surplus, i.e., the power still drawn by the
+    // PSU plus the power exported, and the PSU is turned on again only once
+    // the surplus itself exceeds the lower limit, rather than toggling its
+    // output whenever the control error adds up to the lower limit.
+    float surplus = error + std::max(input.outputPower, 0.0f) / efficiency;
+    bool turnedOff = (_lastSentPower == 0) ? (surplus < _params.lowerPowerLimit)
+                                           : (setpoint < _params.lowerPowerLimit);
+    if (turnedOff) {
+        setpoint = 0;
+        _integral = std::min(std::max(surplus, 0.0f), maxPower);
+    }
+
+    res.powerSetpoint = setpoint;
+
+    // changes within the deadband are not sent to avoid flooding the CAN bus
+    // and the PSU toggling its output. however, turning off the PSU and
+    // lowering the output to respect the BMS limit is always done.
+    res.send |= std::abs(setpoint - _lastSentPower) >= _params.deadbandWatts;
+    res.send |= (setpoint == 0 && _lastSentPower > 0);
+    res.send |= (setpoint > maxPower - 1 && _lastSentPower > setpoint);
+
+    if (res.send) { _lastSentPower = setpoint; }
+
+    if (input.outputVoltage > 0) {
+        res.current = efficiency * _lastSentPower / input.outputVoltage;
+    }
+
+    return res;
+}
@@ -8,6 +8,7 @@
 #include "PowerMeter.h"
 #include "PowerLimiter.h"
 #include "Configuration.h"
+#include "TaskStatistics.h"
 #include <SPI.h>
 #include <mcp_can.h>
 
@@ -198,7 +199,7 @@ void HuaweiCanCommClass::sendRequest()
 void HuaweiCanClass::init(Scheduler& scheduler, uint8_t huawei_miso, uint8_t huawei_mosi, uint8_t huawei_clk, uint8_t huawei_irq, uint8_t huawei_cs, uint8_t huawei_power)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&HuaweiCanClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("Huawei", std::bind(&HuaweiCanClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
@@ -268,7 +269,9 @@ void HuaweiCanClass::processReceivedParameters()
 
 void HuaweiCanClass::loop()
 {
-  const CONFIG_T& config = Configuration.get();
+  // the snapshot does not change while it is held, i.e., during this iteration
+  auto spConfig = Configuration.getSnapshot();
+  auto const& config = *spConfig;
 
   if (!config.Huawei.Enabled || !_initialized) {
       return;
@@ -365,6 +368,7 @@ void HuaweiCanClass::loop()
     if (inverter != nullptr) {
         if(inverter->isProducing()) {
           _setValue(0.0, HUAWEI_ONLINE_CURRENT);
+          _chargeController.reset();
           // Don't run auto mode for a second now. Otherwise we may send too much over the CAN bus 
           _autoModeBlockedTillMillis = millis() + 1000;
           MessageOutput.printf("[HuaweiCanClass::loop] Inverter is active, disable\r\n");
@@ -377,14 +381,33 @@ void HuaweiCanClass::loop()
         // We have received a new PowerMeter value. Also we're _autoPowerEnabled
         // So we're good to calculate a new limit
 
+      uint32_t elapsedMillis = PowerMeter.getLastPowerMeterUpdate() - _lastPowerMeterUpdateReceivedMillis;
+      if (_lastPowerMeterUpdateReceivedMillis == 0) { elapsedMillis = 0; }
       _lastPowerMeterUpdateReceivedMillis = PowerMeter.getLastPowerMeterUpdate();
 
-      // Calculate new power limit
-      float newPowerLimit = -1 * round(PowerMeter.getPowerTotal());
-      newPowerLimit += _rp.output_power;
-      MessageOutput.printf("[HuaweiCanClass::loop] PL: %f, OP: %f \r\n", newPowerLimit, _rp.output_power);
-
-      if (newPowerLimit > config.Huawei.Auto_Power_Lower_Power_Limit) {
+      HuaweiChargeController::Parameters params;
+      params.proportionalGain = config.Huawei.Auto_Power_Proportional_Gain;
+      params.integralGain = config.Huawei.Auto_Power_Integral_Gain;
+      params.targetGridPower = config.Huawei.Auto_Power_Target_Grid_Power;
+      params.lowerPowerLimit = config.Huawei.Auto_Power_Lower_Power_Limit;
+      params.upperPowerLimit = config.Huawei.Auto_Power_Upper_Power_Limit;
+      params.deadbandWatts = config.Huawei.Auto_Power_Deadband;
+      _chargeController.setParameters(params);
+
+      HuaweiChargeController::Input input;
+      input.gridPower = PowerMeter.getPowerTotal();
+      input.outputPower = _rp.output_power;
+      input.outputVoltage = _rp.output_voltage;
+      input.efficiency = _rp.efficiency;
+      input.chargeCurrentLimit = stats->getChargeCurrentLimitation();
+      input.chargeCurrent = stats->getChargeCurrent();
+      input.outputCurrent = _rp.output_current;
+      input.elapsedMillis = elapsedMillis;
+
+      auto result = _chargeController.update(input);
+      MessageOutput.printf("[HuaweiCanClass::loop] PL: %f, OP: %f \r\n", result.powerSetpoint, _rp.output_power);
+
+      if (result.powerSetpoint > 0) {
 
         // Check if the output power has dropped below the lower limit (i.e. the battery is full)
         // and if the PSU should be turned off. Also we use a simple counter mechanism here to be able
@@ -394,6 +417,7 @@ void HuaweiCanClass::loop()
           _autoPowerEnabledCounter--;
           if (_autoPowerEnabledCounter == 0) {
             _autoPowerEnabled = false;
+            _chargeController.reset();
             _setValue(0, HUAWEI_ONLINE_CURRENT);
             return;
           }
@@ -401,30 +425,21 @@ void HuaweiCanClass::loop()
           _autoPowerEnabledCounter = 10;
         }
 
-        // Limit power to maximum
-        if (newPowerLimit > config.Huawei.Auto_Power_Upper_Power_Limit) {
-          newPowerLimit = config.Huawei.Auto_Power_Upper_Power_Limit;
-        }
-
-        // Calculate output current
-        float efficiency =  (_rp.efficiency > 0.5 ? _rp.efficiency : 1.0); 
-        float calculatedCurrent = efficiency * (newPowerLimit / _rp.output_voltage);
+        _autoPowerEnabled = true;
 
-        // Limit output current to value requested by BMS
-        float permissableCurrent = stats->getChargeCurrentLimitation() - (stats->getChargeCurrent() - _rp.output_current); // BMS current limit - current from other sources
-        float outputCurrent = std::min(calculatedCurrent, permissableCurrent);
-        outputCurrent= outputCurrent > 0 ? outputCurrent : 0;
+        // the change is too small to be worth sending to the PSU
+        if (!result.send) { return; }
 
-        MessageOutput.printf("[HuaweiCanClass::loop] Setting output current to %.2fA. This is the lower value of calculated %.2fA and BMS permissable %.2fA currents\r\n", outputCurrent, calculatedCurrent, permissableCurrent);
-        _autoPowerEnabled = true;
-        _setValue(outputCurrent, HUAWEI_ONLINE_CURRENT);
+        MessageOutput.printf("[HuaweiCanClass::loop] Setting output current to %.2fA%s\r\n",
+            result.current, (result.bmsLimited ? ", limited by BMS" : ""));
+        _setValue(result.current, HUAWEI_ONLINE_CURRENT);
 
         // Don't run auto mode some time to allow for output stabilization after issuing a new value
         _autoModeBlockedTillMillis = millis() + 2 * HUAWEI_DATA_REQUEST_INTERVAL_MS;
       } else {
         // requested PL is below minium. Set current to 0
         _autoPowerEnabled = false;
-        _setValue(0.0, HUAWEI_ONLINE_CURRENT);
+        if (result.send) { _setValue(0.0, HUAWEI_ONLINE_CURRENT); }
       }
     }
   } 
@@ -494,6 +509,7 @@ void HuaweiCanClass::setMode(uint8_t mode) {
 
   if (_mode == HUAWEI_MODE_AUTO_INT && mode != HUAWEI_MODE_AUTO_INT) {
     _autoPowerEnabled = false;
+    _chargeController.reset();
     _setValue(0, HUAWEI_ONLINE_CURRENT);
   }
 
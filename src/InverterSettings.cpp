@@ -7,6 +7,7 @@
 #include "MessageOutput.h"
 #include "PinMapping.h"
 #include "SunPosition.h"
+#include "TaskStatistics.h"
 #include <Hoymiles.h>
 
 // the NRF shall use the second externally usable HW SPI controller
@@ -26,8 +27,8 @@
 InverterSettingsClass InverterSettings;
 
 InverterSettingsClass::InverterSettingsClass()
-    : _settingsTask(INVERTER_UPDATE_SETTINGS_INTERVAL, TASK_FOREVER, std::bind(&InverterSettingsClass::settingsLoop, this))
-    , _hoyTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&InverterSettingsClass::hoyLoop, this))
+    : _settingsTask(INVERTER_UPDATE_SETTINGS_INTERVAL, TASK_FOREVER, TaskStatistics.wrap("InverterSettings", std::bind(&InverterSettingsClass::settingsLoop, this)))
+    , _hoyTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("Hoymiles", std::bind(&InverterSettingsClass::hoyLoop, this)))
 {
 }
 
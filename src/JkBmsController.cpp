@@ -10,6 +10,8 @@
 //#define JKBMS_DUMMY_SERIAL
 
 #ifdef JKBMS_DUMMY_SERIAL
+#include <vector>
+
 class DummySerial {
     public:
         DummySerial() = default;
@@ -337,9 +339,24 @@ void Controller::loop()
     }
 }
 
+bool Controller::addToBuffer(uint8_t inbyte)
+{
+    if (_bufferLength >= _buffer.size()) { return false; }
+
+    // the checksum covers all bytes but the last four. the frame size is
+    // unknown until the frame length was received, which is always
+    // followed by more than four bytes.
+    if (_frameSize == 0 || _bufferLength < _frameSize - 4) {
+        _checksum += inbyte;
+    }
+
+    _buffer[_bufferLength++] = inbyte;
+    return true;
+}
+
 void Controller::rxData(uint8_t inbyte)
 {
-    _buffer.push_back(inbyte);
+    if (!addToBuffer(inbyte)) { return reset(); }
 
     switch(_readState) {
         case ReadState::Idle: // unsolicited message from BMS
@@ -359,6 +376,10 @@ void Controller::rxData(uint8_t inbyte)
             break;
         case ReadState::FrameLengthMsbReceived:
             _frameLength |= inbyte;
+            _frameSize = _frameLength + 2; // including start marker
+            if (_frameSize < SerialMessage::minFrameSize || _frameSize > _maxFrameSize) {
+                break;
+            }
             _frameLength -= 2; // length field already read
             return setReadState(ReadState::ReadingFrame);
             break;
@@ -376,7 +397,9 @@ void Controller::rxData(uint8_t inbyte)
 
 void Controller::reset()
 {
-    _buffer.clear();
+    _bufferLength = 0;
+    _frameSize = 0;
+    _checksum = 0;
     return setReadState(ReadState::Idle);
 }
 
@@ -387,8 +410,8 @@ void Controller::frameComplete()
     if (_verboseLogging) {
         double ts = static_cast<double>(millis())/1000;
         MessageOutput.printf("[%11.3f] JK BMS: raw data (%d Bytes):",
-            ts, _buffer.size());
-        for (size_t ctr = 0; ctr < _buffer.size(); ++ctr) {
+            ts, _bufferLength);
+        for (size_t ctr = 0; ctr < _bufferLength; ++ctr) {
             if (ctr % 16 == 0) {
                 MessageOutput.printf("\r\n[%11.3f] JK BMS:", ts);
             }
@@ -397,9 +420,11 @@ void Controller::frameComplete()
         MessageOutput.println();
     }
 
-    auto pResponse = std::make_unique<SerialResponse>(std::move(_buffer), _protocolVersion);
-    if (pResponse->isValid()) {
-        processDataPoints(pResponse->getDataPoints());
+    _dataPoints.clear();
+    SerialResponse response({ _buffer.data(), _bufferLength }, _dataPoints,
+            _protocolVersion, _checksum);
+    if (response.isValid()) {
+        processDataPoints(_dataPoints);
     } // if invalid, error message has been produced by SerialResponse c'tor
 
     reset();
@@ -416,15 +441,13 @@ void Controller::processDataPoints(DataPointContainer const& dataPoints)
 
     if (!_verboseLogging) { return; }
 
-    auto iter = dataPoints.cbegin();
-    while ( iter != dataPoints.cend() ) {
+    dataPoints.forEach([](Label, DataPoint const& dataPoint) {
         MessageOutput.printf("[%11.3f] JK BMS: %s: %s%s\r\n",
-            static_cast<double>(iter->second.getTimestamp())/1000,
-            iter->second.getLabelText().c_str(),
-            iter->second.getValueText().c_str(),
-            iter->second.getUnitText().c_str());
-        ++iter;
-    }
+            static_cast<double>(dataPoint.getTimestamp())/1000,
+            dataPoint.getLabelText(),
+            dataPoint.getValueText().c_str(),
+            dataPoint.getUnitText());
+    });
 }
 
 } /* namespace JkBms */
@@ -20,8 +20,8 @@ template std::string dataPointValueToStr(uint16_t const& v);
 template std::string dataPointValueToStr(uint32_t const& v);
 
 template<>
-std::string dataPointValueToStr(std::string const& v) {
-    return v;
+std::string dataPointValueToStr(tString const& v) {
+    return v.c_str();
 }
 
 template<>
@@ -35,29 +35,34 @@ std::string dataPointValueToStr(tCells const& v) {
     res.reserve(v.size()*(2+2+1+4)); // separator, index, equal sign, value
     res += "(";
     std::string sep = "";
-    for(auto const& mapval : v) {
+    for(auto const& cell : v) {
         snprintf(conversionBuffer, sizeof(conversionBuffer), "%s%d=%d",
-                sep.c_str(), mapval.first, mapval.second);
+                sep.c_str(), cell.first, cell.second);
         res += conversionBuffer;
         sep = ", ";
     }
     res += ")";
-    return std::move(res);
+    return res;
 }
 
-void DataPointContainer::updateFrom(DataPointContainer const& source)
+template<size_t... I>
+void DataPointContainer::updateFrom(DataPointContainer const& source, std::index_sequence<I...>)
 {
-    for (auto iter = source.cbegin(); iter != source.cend(); ++iter) {
-        auto pos = _dataPoints.find(iter->first);
+    auto update = [](auto& slot, auto const& sourceSlot) {
+        if (!sourceSlot.valid) { return; }
 
-        if (pos != _dataPoints.end()) {
-            // do not update existing data points with the same value
-            if (pos->second == iter->second) { continue; }
+        // do not update existing data points with the same value
+        if (slot.valid && slot.value == sourceSlot.value) { return; }
 
-            _dataPoints.erase(pos);
-        }
-        _dataPoints.insert(*iter);
-    }
+        slot = sourceSlot;
+    };
+
+    (update(std::get<I>(_slots), std::get<I>(source._slots)), ...);
+}
+
+void DataPointContainer::updateFrom(DataPointContainer const& source)
+{
+    updateFrom(source, std::make_index_sequence<DataPointLabelCount>{});
 }
 
 } /* namespace JkBms */
@@ -6,30 +6,42 @@
 namespace JkBms {
 
 SerialCommand::SerialCommand(SerialCommand::Command cmd)
-    : SerialMessage(20, 0x00)
+    : SerialMessage({ nullptr, 0 })
 {
-    set(_raw.begin(), startMarker);
-    set(_raw.begin() + 2, static_cast<uint16_t>(_raw.size() - 2)); // frame length
-    set(_raw.begin() + 8, static_cast<uint8_t>(cmd));
-    set(_raw.begin() + 9, static_cast<uint8_t>(Source::Host));
-    set(_raw.begin() + 10, static_cast<uint8_t>(Type::Command));
-    set(_raw.end() - 5, endMarker);
-    updateChecksum();
+    _frame = { _raw.data(), _raw.size() };
+
+    set(0, startMarker);
+    set(2, static_cast<uint16_t>(_raw.size() - 2)); // frame length
+    set(8, static_cast<uint8_t>(cmd));
+    set(9, static_cast<uint8_t>(Source::Host));
+    set(10, static_cast<uint8_t>(Type::Command));
+    set(_raw.size() - 5, endMarker);
+    set(_raw.size() - 2, calcChecksum(_frame));
+    _valid = true;
 }
 
 using Label = JkBms::DataPointLabel;
 template<Label L> using Traits = DataPointLabelTraits<L>;
 
-SerialResponse::SerialResponse(tData&& raw, uint8_t protocolVersion)
-    : SerialMessage(std::move(raw))
+SerialResponse::SerialResponse(ByteSpan frame, DataPointContainer& dp, uint8_t protocolVersion)
+    : SerialResponse(frame, dp, protocolVersion, calcChecksum(frame))
 {
-    if (!isValid()) { return; }
+}
 
-    auto pos = _raw.cbegin() + 11;
-    auto end = pos + getVariableFieldLength();
+SerialResponse::SerialResponse(ByteSpan frame, DataPointContainer& dp, uint8_t protocolVersion, uint16_t checksum)
+    : SerialMessage(frame)
+    , _dp(dp)
+{
+    _valid = validate(checksum);
+    if (!_valid) { return; }
+
+    // the frame length was validated, so the variable fields
+    // are known to end before the trailer of the frame.
+    uint8_t const* pos = _frame.begin() + 11;
+    uint8_t const* end = pos + getVariableFieldLength();
 
     while ( pos < end ) {
-        uint8_t fieldType = *(pos++);
+        uint8_t fieldType = get<uint8_t>(pos);
 
         /**
          * there seems to be no way to make this more generic. the main reason
@@ -39,12 +51,12 @@ SerialResponse::SerialResponse(tData&& raw, uint8_t protocolVersion)
         switch(fieldType) {
             case 0x79:
             {
-                uint8_t cellAmount = *(pos++) / 3;
-                std::map<uint8_t, uint16_t> voltages;
+                uint8_t cellAmount = get<uint8_t>(pos) / 3;
+                tCells voltages;
                 for (size_t cellCounter = 0; cellCounter < cellAmount; ++cellCounter) {
-                    uint8_t idx = *(pos++);
+                    uint8_t idx = get<uint8_t>(pos);
                     auto cellMilliVolt = get<uint16_t>(pos);
-                    voltages[idx] = cellMilliVolt;
+                    voltages.add(idx, cellMilliVolt);
                 }
                 _dp.add<Label::CellsMilliVolt>(voltages);
                 break;
@@ -231,20 +243,18 @@ SerialResponse::SerialResponse(tData&& raw, uint8_t protocolVersion)
 }
 
 /**
- * NOTE that this function moves the iterator by the amount of bytes read.
+ * NOTE that this function moves the position by the amount of bytes read.
+ * reading beyond the end of the frame yields zero, without moving the
+ * position past the end of the frame.
  */
-template<typename T, typename It>
-T SerialMessage::get(It&& pos) const
+template<typename T>
+T SerialMessage::get(uint8_t const*& pos) const
 {
-    // add easy-to-understand error message when called with non-const iter,
-    // as compiler generated error message is hard to understand.
-    using ItNoRef = typename std::remove_reference<It>::type;
-    using PtrType = typename std::iterator_traits<ItNoRef>::pointer;
-    using ValueType = typename std::remove_pointer<PtrType>::type;
-    static_assert(std::is_const<ValueType>::value, "get() must be called with a const_iterator");
-
     // avoid out-of-bound read
-    if (std::distance(pos, _raw.cend()) < sizeof(T)) { return 0; }
+    if (pos < _frame.begin() || _frame.end() - pos < static_cast<ptrdiff_t>(sizeof(T))) {
+        pos = _frame.end();
+        return 0;
+    }
 
     T res = 0;
     for (unsigned i = 0; i < sizeof(T); ++i) {
@@ -253,42 +263,48 @@ T SerialMessage::get(It&& pos) const
     return res;
 }
 
-template<typename It>
-bool SerialMessage::getBool(It&& pos) const
+template<typename T>
+T SerialMessage::peek(size_t offset) const
+{
+    uint8_t const* pos = _frame.begin() + std::min(offset, _frame.size);
+    return get<T>(pos);
+}
+
+bool SerialMessage::getBool(uint8_t const*& pos) const
 {
     uint8_t raw = get<uint8_t>(pos);
     return raw > 0;
 }
 
-template<typename It>
-int16_t SerialMessage::getTemperature(It&& pos) const
+int16_t SerialMessage::getTemperature(uint8_t const*& pos) const
 {
     uint16_t raw = get<uint16_t>(pos);
     if (raw <= 100) { return static_cast<int16_t>(raw); }
     return static_cast<int16_t>(raw - 100) * (-1);
 }
 
-template<typename It>
-std::string SerialMessage::getString(It&& pos, size_t len, bool replaceZeroes) const
+tString SerialMessage::getString(uint8_t const*& pos, size_t len, bool replaceZeroes) const
 {
     // avoid out-of-bound read
-    len = std::min<size_t>(std::distance(pos, _raw.cend()), len);
+    len = std::min<size_t>(_frame.end() - pos, len);
 
-    auto start = pos;
+    uint8_t const* start = pos;
     pos += len;
 
-    if (replaceZeroes) {
-        std::vector<uint8_t> copy(start, pos);
-        for (auto& c : copy) {
-            if (c == 0) { c = 0x20; } // replace by ASCII space
-        }
-        return std::string(copy.cbegin(), copy.cend());
+    if (!replaceZeroes) {
+        return tString(reinterpret_cast<char const*>(start), len);
+    }
+
+    char copy[tString::MaxLength];
+    len = std::min(len, tString::MaxLength);
+    for (size_t i = 0; i < len; ++i) {
+        copy[i] = (start[i] == 0) ? 0x20 : start[i]; // replace by ASCII space
     }
 
-    return std::string(start, pos);
+    return tString(copy, len);
 }
 
-void SerialMessage::processBatteryCurrent(SerialMessage::tData::const_iterator& pos, uint8_t protocolVersion)
+void SerialResponse::processBatteryCurrent(uint8_t const*& pos, uint8_t protocolVersion)
 {
     uint16_t raw = get<uint16_t>(pos);
 
@@ -307,53 +323,55 @@ void SerialMessage::processBatteryCurrent(SerialMessage::tData::const_iterator&
 }
 
 template<typename T>
-void SerialMessage::set(tData::iterator const& pos, T val)
+void SerialCommand::set(size_t offset, T val)
 {
     // avoid out-of-bound write
-    if (std::distance(pos, _raw.end()) < sizeof(T)) { return; }
+    if (offset + sizeof(T) > _raw.size()) { return; }
 
     for (unsigned i = 0; i < sizeof(T); ++i) {
-        *(pos+i) = static_cast<uint8_t>(val >> (sizeof(T)-1-i)*8);
+        _raw[offset+i] = static_cast<uint8_t>(val >> (sizeof(T)-1-i)*8);
     }
 }
 
-uint16_t SerialMessage::calcChecksum() const
+uint16_t SerialMessage::calcChecksum(ByteSpan frame)
 {
-    return std::accumulate(_raw.cbegin(), _raw.cend()-4, 0);
+    if (frame.size < 4) { return 0; }
+    return std::accumulate(frame.begin(), frame.end()-4, 0);
 }
 
-void SerialMessage::updateChecksum()
+bool SerialMessage::validate(uint16_t checksum) const
 {
-    set(_raw.end()-2, calcChecksum());
-}
+    if (_frame.size < minFrameSize) {
+        MessageOutput.printf("JkBms::SerialMessage: frame too short (%d Bytes)\r\n",
+            _frame.size);
+        return false;
+    }
 
-bool SerialMessage::isValid() const {
-    uint16_t const actualStartMarker = get<uint16_t>(_raw.cbegin());
+    uint16_t const actualStartMarker = peek<uint16_t>(0);
     if (actualStartMarker != startMarker) {
         MessageOutput.printf("JkBms::SerialMessage: invalid start marker %04x, expected 0x%04x\r\n",
             actualStartMarker, startMarker);
         return false;
     }
 
-    uint16_t const frameLength = get<uint16_t>(_raw.cbegin()+2);
-    if (frameLength != _raw.size() - 2) {
+    uint16_t const frameLength = getFrameLength();
+    if (frameLength != _frame.size - 2) {
         MessageOutput.printf("JkBms::SerialMessage: unexpected frame length %04x, expected 0x%04x\r\n",
-            frameLength, _raw.size() - 2);
+            frameLength, _frame.size - 2);
         return false;
     }
 
-    uint8_t const actualEndMarker = *(_raw.cend()-5);
+    uint8_t const actualEndMarker = peek<uint8_t>(_frame.size - 5);
     if (actualEndMarker != endMarker) {
         MessageOutput.printf("JkBms::SerialMessage: invalid end marker %02x, expected 0x%02x\r\n",
             actualEndMarker, endMarker);
         return false;
     }
 
-    uint16_t const actualChecksum = get<uint16_t>(_raw.cend()-2);
-    uint16_t const expectedChecksum = calcChecksum();
-    if (actualChecksum != expectedChecksum) {
+    uint16_t const actualChecksum = peek<uint16_t>(_frame.size - 2);
+    if (actualChecksum != checksum) {
         MessageOutput.printf("JkBms::SerialMessage: invalid checksum 0x%04x, expected 0x%04x\r\n",
-            actualChecksum, expectedChecksum);
+            actualChecksum, checksum);
         return false;
     }
 
@@ -4,11 +4,12 @@
  */
 #include <HardwareSerial.h>
 #include "MessageOutput.h"
+#include "TaskStatistics.h"
 
 MessageOutputClass MessageOutput;
 
 MessageOutputClass::MessageOutputClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MessageOutputClass::loop, this))
+    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("MessageOutput", std::bind(&MessageOutputClass::loop, this)))
 {
 }
 
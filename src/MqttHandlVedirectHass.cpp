@@ -9,13 +9,14 @@
 #include "MessageOutput.h"
 #include "VictronMppt.h"
 #include "Utils.h"
+#include "TaskStatistics.h"
 
 MqttHandleVedirectHassClass MqttHandleVedirectHass;
 
 void MqttHandleVedirectHassClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback([this] { loop(); });
+    _loopTask.setCallback(TaskStatistics.wrap("MqttVedirectHass", [this] { loop(); }));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 }
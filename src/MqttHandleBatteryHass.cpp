@@ -6,13 +6,14 @@
 #include "Configuration.h"
 #include "MqttSettings.h"
 #include "Utils.h"
+#include "TaskStatistics.h"
 
 MqttHandleBatteryHassClass MqttHandleBatteryHass;
 
 void MqttHandleBatteryHassClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&MqttHandleBatteryHassClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("MqttBatteryHass", std::bind(&MqttHandleBatteryHassClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 }
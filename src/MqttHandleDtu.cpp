@@ -6,12 +6,13 @@
 #include "Configuration.h"
 #include "MqttSettings.h"
 #include "NetworkSettings.h"
+#include "TaskStatistics.h"
 #include <Hoymiles.h>
 
 MqttHandleDtuClass MqttHandleDtu;
 
 MqttHandleDtuClass::MqttHandleDtuClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MqttHandleDtuClass::loop, this))
+    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("MqttDtu", std::bind(&MqttHandleDtuClass::loop, this)))
 {
 }
 
@@ -38,4 +39,28 @@ void MqttHandleDtuClass::loop()
         MqttSettings.publish("dtu/rssi", String(WiFi.RSSI()));
         MqttSettings.publish("dtu/bssid", WiFi.BSSIDstr());
     }
+
+    // the task statistics are many topics, so they are only published if
+    // enabled, on their own interval, which is usually much longer.
+    uint32_t taskStatsInterval = Configuration.get().Mqtt.TaskStatsInterval;
+    if (taskStatsInterval > 0 && millis() - _lastTaskStatsPublish >= taskStatsInterval * 1000) {
+        _lastTaskStatsPublish = millis();
+        publishTaskStatistics();
+    }
+}
+
+void MqttHandleDtuClass::publishTaskStatistics()
+{
+    for (auto const& t : TaskStatistics.getTaskSnapshots()) {
+        String subtopic = String("dtu/tasks/") + t.name;
+        MqttSettings.publish(subtopic + "/avg_us", String(t.avgUs));
+        MqttSettings.publish(subtopic + "/max_us", String(t.maxUs));
+        MqttSettings.publish(subtopic + "/p99_us", String(t.p99Us));
+        MqttSettings.publish(subtopic + "/max_lateness_us", String(t.maxLatenessUs));
+        MqttSettings.publish(subtopic + "/cpu_percent", String(t.cpuPercent));
+    }
+
+    for (auto const& t : TaskStatistics.getRtosTaskSnapshots()) {
+        MqttSettings.publish(String("dtu/rtos_tasks/") + t.name + "/stack_free", String(t.stackHighWaterMark));
+    }
 }
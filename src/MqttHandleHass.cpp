@@ -8,11 +8,12 @@
 #include "NetworkSettings.h"
 #include "Utils.h"
 #include "defaults.h"
+#include "TaskStatistics.h"
 
 MqttHandleHassClass MqttHandleHass;
 
 MqttHandleHassClass::MqttHandleHassClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MqttHandleHassClass::loop, this))
+    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("MqttHass", std::bind(&MqttHandleHassClass::loop, this)))
 {
 }
 
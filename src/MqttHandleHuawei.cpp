@@ -8,6 +8,7 @@
 #include "Huawei_can.h"
 // #include "Failsafe.h"
 #include "WebApi_Huawei.h"
+#include "TaskStatistics.h"
 #include <ctime>
 
 MqttHandleHuaweiClass MqttHandleHuawei;
@@ -15,7 +16,7 @@ MqttHandleHuaweiClass MqttHandleHuawei;
 void MqttHandleHuaweiClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&MqttHandleHuaweiClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("MqttHuawei", std::bind(&MqttHandleHuaweiClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
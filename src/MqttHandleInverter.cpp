@@ -5,6 +5,7 @@
 #include "MqttHandleInverter.h"
 #include "MessageOutput.h"
 #include "MqttSettings.h"
+#include "TaskStatistics.h"
 #include <ctime>
 
 #define TOPIC_SUB_LIMIT_PERSISTENT_RELATIVE "limit_persistent_relative"
@@ -19,7 +20,7 @@
 MqttHandleInverterClass MqttHandleInverter;
 
 MqttHandleInverterClass::MqttHandleInverterClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MqttHandleInverterClass::loop, this))
+    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("MqttInverter", std::bind(&MqttHandleInverterClass::loop, this)))
 {
 }
 
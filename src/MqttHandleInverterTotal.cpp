@@ -6,12 +6,13 @@
 #include "Configuration.h"
 #include "Datastore.h"
 #include "MqttSettings.h"
+#include "TaskStatistics.h"
 #include <Hoymiles.h>
 
 MqttHandleInverterTotalClass MqttHandleInverterTotal;
 
 MqttHandleInverterTotalClass::MqttHandleInverterTotalClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&MqttHandleInverterTotalClass::loop, this))
+    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("MqttInverterTotal", std::bind(&MqttHandleInverterTotalClass::loop, this)))
 {
 }
 
@@ -6,6 +6,7 @@
 #include "MqttSettings.h"
 #include "MqttHandlePowerLimiter.h"
 #include "PowerLimiter.h"
+#include "TaskStatistics.h"
 #include <ctime>
 #include <string>
 
@@ -14,7 +15,7 @@ MqttHandlePowerLimiterClass MqttHandlePowerLimiter;
 void MqttHandlePowerLimiterClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&MqttHandlePowerLimiterClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("MqttPowerLimiter", std::bind(&MqttHandlePowerLimiterClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
@@ -81,6 +82,7 @@ void MqttHandlePowerLimiterClass::loop()
 
     MqttSettings.publish("powerlimiter/status/threshold/voltage/start", String(config.PowerLimiter.VoltageStartThreshold));
     MqttSettings.publish("powerlimiter/status/threshold/voltage/stop", String(config.PowerLimiter.VoltageStopThreshold));
+    MqttSettings.publish("powerlimiter/status/voltage_load_correction_factor", String(PowerLimiter.getVoltageLoadCorrectionFactor(), 5));
 
     if (config.Vedirect.Enabled) {
         MqttSettings.publish("powerlimiter/status/threshold/voltage/full_solar_passthrough_start", String(config.PowerLimiter.FullSolarPassThroughStartVoltage));
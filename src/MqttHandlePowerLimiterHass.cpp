@@ -8,13 +8,14 @@
 #include "NetworkSettings.h"
 #include "MessageOutput.h"
 #include "Utils.h"
+#include "TaskStatistics.h"
 
 MqttHandlePowerLimiterHassClass MqttHandlePowerLimiterHass;
 
 void MqttHandlePowerLimiterHassClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&MqttHandlePowerLimiterHassClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("MqttPowerLimiterHass", std::bind(&MqttHandlePowerLimiterHassClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 }
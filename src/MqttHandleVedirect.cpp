@@ -6,6 +6,7 @@
 #include "MqttHandleVedirect.h"
 #include "MqttSettings.h"
 #include "MessageOutput.h"
+#include "TaskStatistics.h"
 
 
 
@@ -17,7 +18,7 @@ MqttHandleVedirectClass MqttHandleVedirect;
 void MqttHandleVedirectClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback([this] { loop(); });
+    _loopTask.setCallback(TaskStatistics.wrap("MqttVedirect", [this] { loop(); }));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
@@ -67,6 +68,11 @@ void MqttHandleVedirectClass::loop()
             if (!_PublishFull) {
                 _kvFrames[optMpptData->SER] = *optMpptData;
             }
+
+            auto optStatistics = VictronMppt.getStatistics(idx);
+            if (optStatistics.has_value()) {
+                publish_statistics(optMpptData->SER, *optStatistics);
+            }
         }
 
         // now calculate next points of time to publish
@@ -131,3 +137,18 @@ void MqttHandleVedirectClass::publish_mppt_data(const VeDirectMpptController::da
     PUBLISH(H23,   "H23",  currentData.H23);
 #undef PUBLILSH
 }
+
+void MqttHandleVedirectClass::publish_statistics(char const* serial,
+                                                 const VeDirectMpptController::Statistics &statistics) const {
+    String topic = "victron/";
+    topic.concat(serial);
+    topic.concat("/statistics/");
+
+    MqttSettings.publish(topic + "frames_valid", String(statistics.framesValid));
+    MqttSettings.publish(topic + "frames_checksum_error", String(statistics.framesChecksumError));
+    MqttSettings.publish(topic + "frames_timeout", String(statistics.framesTimeout));
+    MqttSettings.publish(topic + "hex_overflows", String(statistics.hexOverflows));
+    MqttSettings.publish(topic + "hex_timeouts", String(statistics.hexTimeouts));
+    MqttSettings.publish(topic + "uart_overflows", String(statistics.uartOverflows));
+    MqttSettings.publish(topic + "uart_errors", String(statistics.uartErrors));
+}
@@ -8,11 +8,12 @@
 #include "PinMapping.h"
 #include "Utils.h"
 #include "defaults.h"
+#include "TaskStatistics.h"
 #include <ESPmDNS.h>
 #include <ETH.h>
 
 NetworkSettingsClass::NetworkSettingsClass()
-    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, std::bind(&NetworkSettingsClass::loop, this))
+    : _loopTask(TASK_IMMEDIATE, TASK_FOREVER, TaskStatistics.wrap("Network", std::bind(&NetworkSettingsClass::loop, this)))
     , _apIp(192, 168, 4, 1)
     , _apNetmask(255, 255, 255, 0)
 {
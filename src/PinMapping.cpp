@@ -120,6 +120,14 @@
 #define BATTERY_PIN_TXEN -1
 #endif
 
+#ifndef BATTERY_PIN_CAN_RX
+#define BATTERY_PIN_CAN_RX -1
+#endif
+
+#ifndef BATTERY_PIN_CAN_TX
+#define BATTERY_PIN_CAN_TX -1
+#endif
+
 #ifndef HUAWEI_PIN_MISO
 #define HUAWEI_PIN_MISO -1
 #endif
@@ -152,6 +160,10 @@
 #define POWERMETER_PIN_TX -1
 #endif
 
+#ifndef POWERMETER_PIN_RX2
+#define POWERMETER_PIN_RX2 -1
+#endif
+
 #ifndef POWERMETER_PIN_DERE
 #define POWERMETER_PIN_DERE -1
 #endif
@@ -208,6 +220,8 @@ PinMappingClass::PinMappingClass()
     _pinMapping.battery_rxen = BATTERY_PIN_RXEN;
     _pinMapping.battery_tx = BATTERY_PIN_TX;
     _pinMapping.battery_txen = BATTERY_PIN_TXEN;
+    _pinMapping.battery_can_rx = BATTERY_PIN_CAN_RX;
+    _pinMapping.battery_can_tx = BATTERY_PIN_CAN_TX;
 
     _pinMapping.huawei_miso = HUAWEI_PIN_MISO;
     _pinMapping.huawei_mosi = HUAWEI_PIN_MOSI;
@@ -219,6 +233,7 @@ PinMappingClass::PinMappingClass()
     _pinMapping.powermeter_rx = POWERMETER_PIN_RX;
     _pinMapping.powermeter_tx = POWERMETER_PIN_TX;
     _pinMapping.powermeter_dere = POWERMETER_PIN_DERE;
+    _pinMapping.powermeter_rx2 = POWERMETER_PIN_RX2;
 }
 
 PinMapping_t& PinMappingClass::get()
@@ -291,6 +306,8 @@ bool PinMappingClass::init(const String& deviceMapping)
             _pinMapping.battery_rxen = doc[i]["battery"]["rxen"] | BATTERY_PIN_RXEN;
             _pinMapping.battery_tx = doc[i]["battery"]["tx"] | BATTERY_PIN_TX;
             _pinMapping.battery_txen = doc[i]["battery"]["txen"] | BATTERY_PIN_TXEN;
+            _pinMapping.battery_can_rx = doc[i]["battery"]["can_rx"] | BATTERY_PIN_CAN_RX;
+            _pinMapping.battery_can_tx = doc[i]["battery"]["can_tx"] | BATTERY_PIN_CAN_TX;
 
             _pinMapping.huawei_miso = doc[i]["huawei"]["miso"] | HUAWEI_PIN_MISO;
             _pinMapping.huawei_mosi = doc[i]["huawei"]["mosi"] | HUAWEI_PIN_MOSI;
@@ -302,6 +319,7 @@ bool PinMappingClass::init(const String& deviceMapping)
             _pinMapping.powermeter_rx = doc[i]["powermeter"]["rx"] | POWERMETER_PIN_RX;
             _pinMapping.powermeter_tx = doc[i]["powermeter"]["tx"] | POWERMETER_PIN_TX;
             _pinMapping.powermeter_dere = doc[i]["powermeter"]["dere"] | POWERMETER_PIN_DERE;
+            _pinMapping.powermeter_rx2 = doc[i]["powermeter"]["rx2"] | POWERMETER_PIN_RX2;
 
             return true;
         }
@@ -4,6 +4,7 @@
  */
 
 #include "Battery.h"
+#include "CommandLatency.h"
 #include "PowerMeter.h"
 #include "PowerLimiter.h"
 #include "Configuration.h"
@@ -13,6 +14,7 @@
 #include <VictronMppt.h>
 #include "MessageOutput.h"
 #include "inverters/HMS_4CH.h"
+#include "TaskStatistics.h"
 #include <ctime>
 #include <cmath>
 #include <frozen/map.h>
@@ -22,7 +24,7 @@ PowerLimiterClass PowerLimiter;
 void PowerLimiterClass::init(Scheduler& scheduler) 
 { 
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&PowerLimiterClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("DPL", std::bind(&PowerLimiterClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 }
@@ -93,7 +95,7 @@ bool PowerLimiterClass::shutdown(PowerLimiterClass::Status status)
 
     _oTargetPowerState = false;
 
-    auto const& config = Configuration.get();
+    auto const& config = *_spConfig;
     if ( (Status::PowerMeterTimeout == status ||
           Status::CalculatedLimitBelowMinLimit == status)
         && config.PowerLimiter.IsInverterSolarPowered) {
@@ -106,8 +108,14 @@ bool PowerLimiterClass::shutdown(PowerLimiterClass::Status status)
 
 void PowerLimiterClass::loop()
 {
-    CONFIG_T const& config = Configuration.get();
-    _verboseLogging = config.PowerLimiter.VerboseLogging;
+    // the snapshot is only replaced here, such that all methods called
+    // during one iteration use the same configuration, even if it is
+    // changed concurrently by the web application or via MQTT.
+    if (!_spConfig || _spConfig->Version != Configuration.getSnapshotVersion()) {
+        _spConfig = Configuration.getSnapshot();
+        _verboseLogging = _spConfig->PowerLimiter.VerboseLogging;
+    }
+    auto const& config = *_spConfig;
 
     // we know that the Hoymiles library refuses to send any message to any
     // inverter until the system has valid time information. until then we can
@@ -210,6 +218,8 @@ void PowerLimiterClass::loop()
         return announceStatus(Status::PowerMeterPending);
     }
 
+    updateVoltageSagEstimate();
+
     // since _lastCalculation and _calculationBackoffMs are initialized to
     // zero, this test is passed the first time the condition is checked.
     if (millis() < (_lastCalculation + _calculationBackoffMs)) {
@@ -316,7 +326,7 @@ float PowerLimiterClass::getBatteryVoltage(bool log) {
         return 0.0;
     }
 
-    auto const& config = Configuration.get();
+    auto const& config = *_spConfig;
     auto channel = static_cast<ChannelNum_t>(config.PowerLimiter.InverterChannelId);
     float inverterVoltage = _inverter->Statistics()->getChannelFieldValue(TYPE_DC, channel, FLD_UDC);
     float res = inverterVoltage;
@@ -349,7 +359,7 @@ float PowerLimiterClass::getBatteryVoltage(bool log) {
  */
 int32_t PowerLimiterClass::inverterPowerDcToAc(std::shared_ptr<InverterAbstract> inverter, int32_t dcPower)
 {
-    CONFIG_T& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     float inverterEfficiencyPercent = inverter->Statistics()->getChannelFieldValue(
         TYPE_AC, CH0, FLD_EFF);
@@ -407,8 +417,11 @@ uint8_t PowerLimiterClass::getPowerLimiterState() {
 // | Case # | batteryPower | solarPower     | useFullSolarPassthrough | Resulting inverter limit                               |
 // | 1      | false        |  < 20 W        | doesn't matter          | 0 (inverter off)                                       |
 // | 2      | false        | >= 20 W        | doesn't matter          | min(PowerMeter value, solarPower)                      |
-// | 3      | true         | doesn't matter | false                   | PowerMeter value (Battery can supply unlimited energy) |
-// | 4      | true         | fully passed   | true                    | max(PowerMeter value, solarPower)                      |
+// | 3      | true         | doesn't matter | false                   | min(PowerMeter value, BMS discharge limit)             |
+// | 4      | true         | fully passed   | true                    | min(max(PowerMeter value, solarPower), BMS limit)      |
+//
+// the BMS discharge limit only applies if the battery reports one. otherwise
+// the battery is assumed to supply as much power as the inverter can use.
 
 bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t solarPowerDC, bool batteryPower)
 {
@@ -437,7 +450,7 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
 
     auto solarPowerAC = inverterPowerDcToAc(inverter, solarPowerDC);
 
-    auto const& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     if (_verboseLogging) {
         MessageOutput.printf("[DPL::calcPowerLimit] power meter: %d W, "
@@ -476,6 +489,20 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
         return setNewPowerLimit(inverter, newPowerLimit);
     }
 
+    auto oDischargeLimit = getBatteryDischargeLimit(inverter, solarPowerDC);
+
+    auto applyDischargeLimit = [this,&oDischargeLimit](int32_t limit) -> int32_t {
+        if (!oDischargeLimit.has_value() || limit <= *oDischargeLimit) { return limit; }
+
+        if (_verboseLogging) {
+            MessageOutput.printf("[DPL::calcPowerLimit] limit of %d W reduced "
+                    "to %d W due to battery discharge limit\r\n",
+                    limit, *oDischargeLimit);
+        }
+
+        return *oDischargeLimit;
+    };
+
     // Case 4:
     // convert all solar power if full solar-passthrough is active
     if (useFullSolarPassthrough()) {
@@ -486,7 +513,7 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
                 newPowerLimit);
         }
 
-        return setNewPowerLimit(inverter, newPowerLimit);
+        return setNewPowerLimit(inverter, applyDischargeLimit(newPowerLimit));
     }
 
     if (_verboseLogging) {
@@ -495,7 +522,87 @@ bool PowerLimiterClass::calcPowerLimit(std::shared_ptr<InverterAbstract> inverte
     }
 
     // Case 3:
-    return setNewPowerLimit(inverter, newPowerLimit);
+    return setNewPowerLimit(inverter, applyDischargeLimit(newPowerLimit));
+}
+
+/**
+ * calculates the AC power limit at which the current drawn from the battery
+ * matches the discharge current limit reported by the BMS (reduced by the
+ * configured margin). returns std::nullopt if no such limit is known. if the
+ * battery stopped reporting, the last limit is kept.
+ *
+ * the battery voltage sags when the inverter draws power. the load correction
+ * factor is used to predict the voltage at the new power, such that the
+ * battery current is not underestimated: with the load corrected voltage Vc,
+ * the factor k, the current limit I and the solar power Ps, the battery power
+ * Pb must satisfy Pb = I * (Vc - k * (Pb + Ps)).
+ */
+std::optional<int32_t> PowerLimiterClass::getBatteryDischargeLimit(std::shared_ptr<InverterAbstract> inverter, int32_t solarPowerDC)
+{
+    auto reset = [this]() -> std::optional<int32_t> {
+        _oBatteryDischargePowerLimit = std::nullopt;
+        return std::nullopt;
+    };
+
+    auto const& config = *_spConfig;
+    if (!config.Battery.Enabled || !config.PowerLimiter.UseBatteryDischargeLimit) {
+        return reset();
+    }
+
+    auto stats = Battery.getStats();
+
+    // the last limit is kept while the battery does not report, rather
+    // than dropping the cap when the battery is likely still limited.
+    if (stats->getAgeSeconds() >= 60) {
+        if (!_oBatteryDischargePowerLimit.has_value()) { return std::nullopt; }
+
+        auto res = inverterPowerDcToAc(inverter, static_cast<int32_t>(*_oBatteryDischargePowerLimit) + solarPowerDC);
+
+        if (_verboseLogging) {
+            MessageOutput.printf("[DPL::getBatteryDischargeLimit] battery stats outdated, "
+                    "keeping battery power of %.0f W, limit: %d W\r\n",
+                    *_oBatteryDischargePowerLimit, res);
+        }
+
+        return res;
+    }
+
+    float currentLimit = stats->getDischargeCurrentLimitation();
+    if (currentLimit >= FLT_MAX) { return reset(); }
+
+    currentLimit *= (100 - config.PowerLimiter.BatteryDischargeLimitMargin) / 100.0;
+    currentLimit = std::max(currentLimit, 0.0f);
+
+    float correctedVoltage = getLoadCorrectedVoltage();
+    if (correctedVoltage <= 0.0) { return reset(); }
+
+    float k = getVoltageLoadCorrectionFactor();
+    float predictedVoltage = correctedVoltage - k * solarPowerDC;
+    float batteryPower = std::max(0.0f, currentLimit * predictedVoltage / (1 + currentLimit * k));
+
+    // the limit is lowered immediately, but it is raised slowly (by at most a
+    // tenth of its value per second), e.g., when the BMS raises its current
+    // limit after the battery recovered. this avoids overshooting, as the
+    // voltage sag is only an estimate.
+    uint32_t now = millis();
+    if (_oBatteryDischargePowerLimit.has_value() && batteryPower > *_oBatteryDischargePowerLimit) {
+        float elapsedSeconds = (now - _lastBatteryDischargePowerLimit) / 1000.0;
+        float maxStep = std::max(batteryPower * 0.1f * elapsedSeconds, 1.0f);
+        batteryPower = std::min(batteryPower, *_oBatteryDischargePowerLimit + maxStep);
+    }
+    _oBatteryDischargePowerLimit = batteryPower;
+    _lastBatteryDischargePowerLimit = now;
+
+    auto res = inverterPowerDcToAc(inverter, static_cast<int32_t>(batteryPower) + solarPowerDC);
+
+    if (_verboseLogging) {
+        MessageOutput.printf("[DPL::getBatteryDischargeLimit] current limit: %.1f A, "
+                "predicted voltage: %.2f V, battery power: %.0f W, limit: %d W\r\n",
+                currentLimit, correctedVoltage - k * (batteryPower + solarPowerDC),
+                batteryPower, res);
+    }
+
+    return res;
 }
 
 /**
@@ -516,6 +623,7 @@ bool PowerLimiterClass::updateInverter()
 
     if (!_oUpdateStartMillis.has_value()) {
         _oUpdateStartMillis = millis();
+        CommandLatency.notifyDecision(_inverter->serial(), *_oUpdateStartMillis);
     }
 
     if ((millis() - *_oUpdateStartMillis) > 30 * 1000) {
@@ -686,7 +794,7 @@ static int32_t scalePowerLimit(std::shared_ptr<InverterAbstract> inverter, int32
  */
 bool PowerLimiterClass::setNewPowerLimit(std::shared_ptr<InverterAbstract> inverter, int32_t newPowerLimit)
 {
-    auto const& config = Configuration.get();
+    auto const& config = *_spConfig;
     auto lowerLimit = config.PowerLimiter.LowerPowerLimit;
     auto upperLimit = config.PowerLimiter.UpperPowerLimit;
     auto hysteresis = config.PowerLimiter.TargetPowerConsumptionHysteresis;
@@ -734,7 +842,7 @@ bool PowerLimiterClass::setNewPowerLimit(std::shared_ptr<InverterAbstract> inver
 
 int32_t PowerLimiterClass::getSolarPower()
 {
-    auto const& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     if (config.PowerLimiter.IsInverterSolarPowered) {
         // the returned value is arbitrary, as long as it's
@@ -762,7 +870,7 @@ float PowerLimiterClass::getLoadCorrectedVoltage()
         return 0.0;
     }
 
-    CONFIG_T& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     float acPower = _inverter->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
     float dcVoltage = getBatteryVoltage();
@@ -771,13 +879,60 @@ float PowerLimiterClass::getLoadCorrectedVoltage()
         return 0.0;
     }
 
-    return dcVoltage + (acPower * config.PowerLimiter.VoltageLoadCorrectionFactor);
+    return dcVoltage + (acPower * getVoltageLoadCorrectionFactor());
+}
+
+float PowerLimiterClass::getVoltageLoadCorrectionFactor() const
+{
+    auto spConfig = Configuration.getSnapshot();
+    auto const& config = *spConfig;
+
+    if (config.PowerLimiter.VoltageLoadCorrectionAuto) {
+        auto oFactor = _voltageSagEstimator.getFactor();
+        if (oFactor.has_value()) { return *oFactor; }
+    }
+
+    return config.PowerLimiter.VoltageLoadCorrectionFactor;
+}
+
+/**
+ * feeds the battery voltage and the inverter's output power into the voltage
+ * sag estimator, once for every statistics update of the inverter. samples
+ * are only used while the battery is not being charged, as the voltage is
+ * then determined by the charger rather than by the battery's load.
+ */
+void PowerLimiterClass::updateVoltageSagEstimate()
+{
+    auto const& config = *_spConfig;
+    if (config.PowerLimiter.IsInverterSolarPowered) { return; }
+
+    auto lastStats = _inverter->Statistics()->getLastUpdate();
+    if (lastStats == _lastVoltageSagSample) { return; }
+    _lastVoltageSagSample = lastStats;
+
+    if (VictronMppt.isDataValid() && VictronMppt.getPowerOutputWatts() >= 20) { return; }
+
+    if (HuaweiCan.getAutoPowerStatus()) { return; }
+
+    float dcVoltage = getBatteryVoltage();
+    if (dcVoltage <= 0.0) { return; }
+
+    float acPower = _inverter->Statistics()->getChannelFieldValue(TYPE_AC, CH0, FLD_PAC);
+    _voltageSagEstimator.addSample(dcVoltage, acPower);
+
+    if (_verboseLogging) {
+        auto oFactor = _voltageSagEstimator.getFactor();
+        MessageOutput.printf("[DPL::updateVoltageSagEstimate] %.2f V at %.0f W, "
+                "samples: %u, estimated factor: %s\r\n",
+                dcVoltage, acPower, _voltageSagEstimator.getSampleCount(),
+                (oFactor.has_value() ? String(*oFactor, 5).c_str() : "n/a"));
+    }
 }
 
 bool PowerLimiterClass::testThreshold(float socThreshold, float voltThreshold,
         std::function<bool(float, float)> compare)
 {
-    CONFIG_T& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     // prefer SoC provided through battery interface, unless disabled by user
     auto stats = Battery.getStats();
@@ -797,7 +952,7 @@ bool PowerLimiterClass::testThreshold(float socThreshold, float voltThreshold,
 
 bool PowerLimiterClass::isStartThresholdReached()
 {
-    CONFIG_T& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     return testThreshold(
             config.PowerLimiter.BatterySocStartThreshold,
@@ -808,7 +963,7 @@ bool PowerLimiterClass::isStartThresholdReached()
 
 bool PowerLimiterClass::isStopThresholdReached()
 {
-    CONFIG_T& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     return testThreshold(
             config.PowerLimiter.BatterySocStopThreshold,
@@ -819,7 +974,7 @@ bool PowerLimiterClass::isStopThresholdReached()
 
 bool PowerLimiterClass::isBelowStopThreshold()
 {
-    CONFIG_T& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     return testThreshold(
             config.PowerLimiter.BatterySocStopThreshold,
@@ -831,7 +986,8 @@ bool PowerLimiterClass::isBelowStopThreshold()
 /// @brief calculate next inverter restart in millis
 void PowerLimiterClass::calcNextInverterRestart()
 {
-    CONFIG_T& config = Configuration.get();
+    auto spConfig = Configuration.getSnapshot();
+    auto const& config = *spConfig;
 
     // first check if restart is configured at all
     if (config.PowerLimiter.RestartHour < 0) {
@@ -876,7 +1032,7 @@ void PowerLimiterClass::calcNextInverterRestart()
 
 bool PowerLimiterClass::useFullSolarPassthrough()
 {
-    auto const& config = Configuration.get();
+    auto const& config = *_spConfig;
 
     // solar passthrough only applies to setups with battery-powered inverters
     if (config.PowerLimiter.IsInverterSolarPowered) { return false; }
@@ -6,18 +6,33 @@
 #include "Configuration.h"
 #include "PinMapping.h"
 #include "HttpPowerMeter.h"
+#include "SerialPortManager.h"
 #include "MqttSettings.h"
 #include "NetworkSettings.h"
 #include "MessageOutput.h"
+#include "TaskStatistics.h"
+#include <cmath>
 #include <ctime>
 #include <SMA_HM.h>
 
 PowerMeterClass PowerMeter;
 
+// a source is stale once it missed a sample, i.e., no sample arrived within
+// one and a half sample periods. sources sending more often are given some
+// slack, as their samples are subject to network jitter.
+static constexpr uint32_t minSamplePeriodMs = 1000;
+
+// the SDM and SML sources use the power meter's RX pin
+static bool usesSerialPins(PowerMeterClass::Source source)
+{
+    using Source = PowerMeterClass::Source;
+    return source == Source::SDM1PH || source == Source::SDM3PH || source == Source::SML;
+}
+
 void PowerMeterClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&PowerMeterClass::loop, this));
+    _loopTask.setCallback(TaskStatistics.wrap("PowerMeter", std::bind(&PowerMeterClass::loop, this)));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
@@ -27,8 +42,15 @@ void PowerMeterClass::init(Scheduler& scheduler)
     for (auto const& s: _mqttSubscriptions) { MqttSettings.unsubscribe(s.first); }
     _mqttSubscriptions.clear();
 
+    _sourceCount = 0;
+    _activeSource = 0;
+    _fusionBias = 0;
+    _fusionLastUpdate = 0;
+
     CONFIG_T& config = Configuration.get();
 
+    _fusionTimeConstant = config.PowerMeter.FusionTimeConstant;
+
     if (!config.PowerMeter.Enabled) {
         return;
     }
@@ -37,7 +59,51 @@ void PowerMeterClass::init(Scheduler& scheduler)
     MessageOutput.printf("[PowerMeter] rx = %d, tx = %d, dere = %d\r\n",
             pin.powermeter_rx, pin.powermeter_tx, pin.powermeter_dere);
 
-    switch(static_cast<Source>(config.PowerMeter.Source)) {
+    uint8_t sources[POWERMETER_MAX_SOURCES] = { static_cast<uint8_t>(config.PowerMeter.Source) };
+    for (uint8_t i = 1; i < POWERMETER_MAX_SOURCES; ++i) {
+        sources[i] = config.PowerMeter.FailoverSources[i - 1];
+    }
+
+    for (uint8_t i = 0; i < POWERMETER_MAX_SOURCES; ++i) {
+        if (sources[i] > static_cast<uint8_t>(Source::SMAHM2)) { continue; }
+
+        auto source = static_cast<Source>(sources[i]);
+        bool conflict = false;
+        for (size_t j = 0; j < _sourceCount; ++j) {
+            conflict |= _sources[j].source == source
+                || (usesSerialPins(source) && usesSerialPins(_sources[j].source));
+        }
+
+        if (conflict) {
+            MessageOutput.printf("[PowerMeter] source %u is used already or shares the serial pins "
+                    "with another source, ignoring it\r\n", sources[i]);
+            continue;
+        }
+
+        auto& values = _sources[_sourceCount];
+        values = SourceValues();
+        values.source = source;
+        values.filter.configure(static_cast<PowerMeterFilter::Mode>(config.PowerMeter.FilterMode),
+                config.PowerMeter.FilterWindow, config.PowerMeter.FilterHampelThreshold,
+                config.PowerMeter.FilterTimeConstant);
+
+        if (!initSource(values)) { continue; }
+
+        if (_sourceCount > 0) {
+            MessageOutput.printf("[PowerMeter] using source %u as failover source %u\r\n",
+                    sources[i], _sourceCount);
+        }
+
+        ++_sourceCount;
+    }
+}
+
+bool PowerMeterClass::initSource(SourceValues& values)
+{
+    CONFIG_T& config = Configuration.get();
+    const PinMapping_t& pin = PinMapping.get();
+
+    switch (values.source) {
     case Source::MQTT: {
         auto subscribe = [this](char const* topic, float* target) {
             if (strlen(topic) == 0) { return; }
@@ -50,46 +116,46 @@ void PowerMeterClass::init(Scheduler& scheduler)
             _mqttSubscriptions.try_emplace(topic, target);
         };
 
-        subscribe(config.PowerMeter.MqttTopicPowerMeter1, &_powerMeter1Power);
-        subscribe(config.PowerMeter.MqttTopicPowerMeter2, &_powerMeter2Power);
-        subscribe(config.PowerMeter.MqttTopicPowerMeter3, &_powerMeter3Power);
-        break;
+        subscribe(config.PowerMeter.MqttTopicPowerMeter1, &values.power[0]);
+        subscribe(config.PowerMeter.MqttTopicPowerMeter2, &values.power[1]);
+        subscribe(config.PowerMeter.MqttTopicPowerMeter3, &values.power[2]);
+        return true;
     }
 
     case Source::SDM1PH:
     case Source::SDM3PH:
         if (pin.powermeter_rx < 0 || pin.powermeter_tx < 0) {
             MessageOutput.println("[PowerMeter] invalid pin config for SDM power meter (RX and TX pins must be defined)");
-            return;
+            return false;
         }
 
         _upSdm = std::make_unique<SDM>(Serial2, 9600, pin.powermeter_dere,
                 SERIAL_8N1, pin.powermeter_rx, pin.powermeter_tx);
         _upSdm->begin();
-        break;
+        return true;
 
     case Source::HTTP:
         HttpPowerMeter.init();
-        break;
+        return true;
 
     case Source::SML:
-        if (pin.powermeter_rx < 0) {
-            MessageOutput.println("[PowerMeter] invalid pin config for SML power meter (RX pin must be defined)");
-            return;
-        }
-
-        pinMode(pin.powermeter_rx, INPUT);
-        _upSmlSerial = std::make_unique<SoftwareSerial>();
-        _upSmlSerial->begin(9600, SWSERIAL_8N1, pin.powermeter_rx, -1, false, 128, 95);
-        _upSmlSerial->enableRx(true);
-        _upSmlSerial->enableTx(false);
-        _upSmlSerial->flush();
-        break;
+        initSmlMeters();
+        return !_smlMeters.empty();
 
     case Source::SMAHM2:
-        SMA_HM.init(scheduler, config.PowerMeter.VerboseLogging);
-        break;
+        SMA_HM.init(config.PowerMeter.VerboseLogging, config.PowerMeter.SmaHmSerial);
+        return true;
+    }
+
+    return false;
+}
+
+PowerMeterClass::SourceValues* PowerMeterClass::findSource(Source source)
+{
+    for (size_t i = 0; i < _sourceCount; ++i) {
+        if (_sources[i].source == source) { return &_sources[i]; }
     }
+    return nullptr;
 }
 
 void PowerMeterClass::onMqttMessage(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)
@@ -98,8 +164,9 @@ void PowerMeterClass::onMqttMessage(const espMqttClientTypes::MessageProperties&
         if (subscription.first != topic) { continue; }
 
         std::string value(reinterpret_cast<const char*>(payload), len);
+        float power = 0;
         try {
-            *subscription.second = std::stof(value);
+            power = std::stof(value);
         }
         catch(std::invalid_argument const& e) {
             MessageOutput.printf("PowerMeterClass: cannot parse payload of topic '%s' as float: %s\r\n",
@@ -107,12 +174,18 @@ void PowerMeterClass::onMqttMessage(const espMqttClientTypes::MessageProperties&
             return;
         }
 
+        {
+            std::lock_guard<std::mutex> l(_mutex);
+            *subscription.second = power;
+            auto pValues = findSource(Source::MQTT);
+            if (pValues != nullptr) { pValues->lastUpdate = millis(); }
+        }
+
+        // without forcing an update, as this runs in the MQTT client's task
         if (_verboseLogging) {
             MessageOutput.printf("PowerMeterClass: Updated from '%s', TotalPower: %5.2f\r\n",
-                    topic, getPowerTotal());
+                    topic, getPowerTotal(false));
         }
-
-        _lastPowerMeterUpdate = millis();
     }
 }
 
@@ -120,14 +193,147 @@ float PowerMeterClass::getPowerTotal(bool forceUpdate)
 {
     if (forceUpdate) {
         CONFIG_T& config = Configuration.get();
-        if (config.PowerMeter.Enabled
+        if (config.PowerMeter.Enabled && _sourceCount > 0
                 && (millis() - _lastPowerMeterUpdate) > (1000)) {
-            readPowerMeter();
+            readSource(_sources[_activeSource]);
         }
     }
 
     std::lock_guard<std::mutex> l(_mutex);
-    return _powerMeter1Power + _powerMeter2Power + _powerMeter3Power;
+    selectSource();
+    return _powerMeterTotal;
+}
+
+float PowerMeterClass::getRateOfChange()
+{
+    std::lock_guard<std::mutex> l(_mutex);
+    selectSource();
+    if (_sourceCount == 0) { return 0; }
+    return _sources[_activeSource].filter.getRateOfChange();
+}
+
+PowerMeterClass::Source PowerMeterClass::getActiveSource()
+{
+    std::lock_guard<std::mutex> l(_mutex);
+    if (_sourceCount == 0) {
+        return static_cast<Source>(Configuration.get().PowerMeter.Source);
+    }
+    return _sources[_activeSource].source;
+}
+
+// feeds the filter stage of a source with a new sample whenever its values
+// were updated. expects the mutex to be held.
+void PowerMeterClass::updateFilter(SourceValues& values)
+{
+    if (values.lastUpdate == 0 || values.lastUpdate == values.filter.getLastTimestamp()) {
+        return;
+    }
+
+    float total = values.power[0] + values.power[1] + values.power[2];
+    values.filter.addSample(values.lastUpdate, total);
+
+    if (_verboseLogging && values.filter.getValue() != total) {
+        MessageOutput.printf("PowerMeterClass: Filtered %5.2f to %5.2f (%u outliers so far)\r\n",
+                total, values.filter.getValue(), values.filter.getOutliers());
+    }
+}
+
+// tracks the deviation between the primary source and the first failover
+// source, i.e., the accurate one, whenever the latter sent a new sample.
+// expects the mutex to be held.
+void PowerMeterClass::updateFusion()
+{
+    if (_fusionTimeConstant == 0 || _sourceCount < 2) { return; }
+
+    auto const& fast = _sources[0];
+    auto const& accurate = _sources[1];
+    if (accurate.lastUpdate == _fusionLastUpdate) { return; }
+
+    uint32_t now = millis();
+    if (!isFresh(fast, now) || !isFresh(accurate, now)) { return; }
+
+    float deviation = accurate.filter.getValue() - fast.filter.getValue();
+    if (_fusionLastUpdate == 0) {
+        _fusionBias = deviation;
+    } else {
+        float elapsed = static_cast<float>(accurate.lastUpdate - _fusionLastUpdate);
+        _fusionBias += (1.0f - std::exp(-elapsed / _fusionTimeConstant)) * (deviation - _fusionBias);
+    }
+    _fusionLastUpdate = accurate.lastUpdate;
+
+    if (_verboseLogging) {
+        MessageOutput.printf("PowerMeterClass: Deviation of the primary source %5.2f, "
+                "correcting by %5.2f\r\n", deviation, _fusionBias);
+    }
+}
+
+// expects the mutex to be held
+bool PowerMeterClass::isFresh(SourceValues const& values, uint32_t now) const
+{
+    if (values.lastUpdate == 0 || values.failed) { return false; }
+
+    // polled sources are read at least once per interval, while the period
+    // of sources sending on their own is estimated from their samples
+    uint32_t period = Configuration.get().PowerMeter.Interval * 1000;
+    bool polled = values.source == Source::SDM1PH || values.source == Source::SDM3PH
+        || values.source == Source::HTTP;
+    if (!polled && values.filter.getSampleInterval() > 0) {
+        period = values.filter.getSampleInterval();
+    }
+    period = std::max(period, minSamplePeriodMs);
+
+    return static_cast<int32_t>(now - values.lastUpdate) <= static_cast<int32_t>(period + period / 2);
+}
+
+// uses the values of the source with the highest priority which is fresh.
+// if no source is fresh, the active source is kept, such that its age
+// tells the consumers that the values are outdated. expects the mutex to
+// be held.
+void PowerMeterClass::selectSource()
+{
+    if (_sourceCount == 0) { return; }
+
+    for (size_t i = 0; i < _sourceCount; ++i) { updateFilter(_sources[i]); }
+    updateFusion();
+
+    uint32_t now = millis();
+    size_t active = _activeSource;
+    for (size_t i = 0; i < _sourceCount; ++i) {
+        if (isFresh(_sources[i], now)) {
+            active = i;
+            break;
+        }
+    }
+
+    if (active != _activeSource) {
+        MessageOutput.printf("PowerMeterClass: switching from source %u to source %u\r\n",
+                static_cast<unsigned>(_sources[_activeSource].source),
+                static_cast<unsigned>(_sources[active].source));
+        _activeSource = active;
+    }
+
+    auto const& values = _sources[_activeSource];
+    _powerMeter1Power = values.power[0];
+    _powerMeter2Power = values.power[1];
+    _powerMeter3Power = values.power[2];
+    _powerMeter1Voltage = values.voltage[0];
+    _powerMeter2Voltage = values.voltage[1];
+    _powerMeter3Voltage = values.voltage[2];
+    _powerMeterFrequency = values.frequency;
+    _powerMeterImport = values.energyImport;
+    _powerMeterExport = values.energyExport;
+    _lastPowerMeterUpdate = values.lastUpdate;
+
+    if (!values.filter.hasSamples()) {
+        _powerMeterTotal = values.power[0] + values.power[1] + values.power[2];
+    } else {
+        _powerMeterTotal = values.filter.getValue();
+    }
+
+    if (_activeSource == 0 && _fusionLastUpdate != 0 && _fusionTimeConstant > 0
+            && isFresh(_sources[1], now)) {
+        _powerMeterTotal += _fusionBias;
+    }
 }
 
 uint32_t PowerMeterClass::getLastPowerMeterUpdate()
@@ -142,17 +348,26 @@ void PowerMeterClass::mqtt()
 
     String topic = "powermeter";
     auto totalPower = getPowerTotal();
+    auto rateOfChange = getRateOfChange();
 
     std::lock_guard<std::mutex> l(_mutex);
+    float rawPower = _powerMeter1Power + _powerMeter2Power + _powerMeter3Power;
     MqttSettings.publish(topic + "/power1", String(_powerMeter1Power));
     MqttSettings.publish(topic + "/power2", String(_powerMeter2Power));
     MqttSettings.publish(topic + "/power3", String(_powerMeter3Power));
     MqttSettings.publish(topic + "/powertotal", String(totalPower));
+    MqttSettings.publish(topic + "/powertotal_raw", String(rawPower));
+    MqttSettings.publish(topic + "/rateofchange", String(rateOfChange));
     MqttSettings.publish(topic + "/voltage1", String(_powerMeter1Voltage));
     MqttSettings.publish(topic + "/voltage2", String(_powerMeter2Voltage));
     MqttSettings.publish(topic + "/voltage3", String(_powerMeter3Voltage));
+    MqttSettings.publish(topic + "/frequency", String(_powerMeterFrequency));
     MqttSettings.publish(topic + "/import", String(_powerMeterImport));
     MqttSettings.publish(topic + "/export", String(_powerMeterExport));
+
+    if (_sourceCount > 0) {
+        MqttSettings.publish(topic + "/source", String(static_cast<unsigned>(_sources[_activeSource].source)));
+    }
 }
 
 void PowerMeterClass::loop()
@@ -162,10 +377,19 @@ void PowerMeterClass::loop()
 
     if (!config.PowerMeter.Enabled) { return; }
 
-    if (static_cast<Source>(config.PowerMeter.Source) == Source::SML &&
-            nullptr != _upSmlSerial) {
-        if (!smlReadLoop()) { return; }
-        _lastPowerMeterUpdate = millis();
+    // cheap, as the SML meters parse their telegrams in tasks of their own
+    // and the SMA datagrams are decoded as they are received. the source is
+    // selected in every iteration, such that a stale source is replaced as
+    // soon as a failover source has fresh values.
+    for (size_t i = 0; i < _sourceCount; ++i) {
+        auto& values = _sources[i];
+        if (values.source == Source::SML) { readSmlMeters(values); }
+        if (values.source == Source::SMAHM2) { readSmaHomeManager(values); }
+    }
+
+    {
+        std::lock_guard<std::mutex> l(_mutex);
+        selectSource();
     }
 
     if ((millis() - _lastPowerMeterCheck) < (config.PowerMeter.Interval * 1000)) {
@@ -181,94 +405,198 @@ void PowerMeterClass::loop()
     _lastPowerMeterCheck = millis();
 }
 
+// all sources are read, not only the active one, such that a failover
+// source has fresh values as soon as it is needed
 void PowerMeterClass::readPowerMeter()
 {
-    CONFIG_T& config = Configuration.get();
+    for (size_t i = 0; i < _sourceCount; ++i) { readSource(_sources[i]); }
+}
+
+void PowerMeterClass::readSource(SourceValues& values)
+{
+    switch (values.source) {
+    case Source::MQTT:
+        break; // the values are pushed
+    case Source::SDM1PH:
+        readSdm(values, false);
+        break;
+    case Source::SDM3PH:
+        readSdm(values, true);
+        break;
+    case Source::HTTP:
+        readHttp(values);
+        break;
+    case Source::SML:
+        readSmlMeters(values);
+        break;
+    case Source::SMAHM2:
+        readSmaHomeManager(values);
+        break;
+    }
+}
+
+void PowerMeterClass::readSdm(SourceValues& values, bool threePhases)
+{
+    if (!_upSdm) { return; }
 
+    CONFIG_T& config = Configuration.get();
     uint8_t _address = config.PowerMeter.SdmAddress;
-    Source configuredSource = static_cast<Source>(config.PowerMeter.Source);
 
-    if (configuredSource == Source::SDM1PH) {
-        if (!_upSdm) { return; }
+    // this takes a "very long" time as each readVal() is a synchronous
+    // exchange of serial messages. cache the values and write later.
+    float power[3] = { 0, 0, 0 };
+    float voltage[3] = { 0, 0, 0 };
+    power[0] = _upSdm->readVal(SDM_PHASE_1_POWER, _address);
+    voltage[0] = _upSdm->readVal(SDM_PHASE_1_VOLTAGE, _address);
+    if (threePhases) {
+        power[1] = _upSdm->readVal(SDM_PHASE_2_POWER, _address);
+        power[2] = _upSdm->readVal(SDM_PHASE_3_POWER, _address);
+        voltage[1] = _upSdm->readVal(SDM_PHASE_2_VOLTAGE, _address);
+        voltage[2] = _upSdm->readVal(SDM_PHASE_3_VOLTAGE, _address);
+    }
+    auto energyImport = _upSdm->readVal(SDM_IMPORT_ACTIVE_ENERGY, _address);
+    auto energyExport = _upSdm->readVal(SDM_EXPORT_ACTIVE_ENERGY, _address);
 
-        // this takes a "very long" time as each readVal() is a synchronous
-        // exchange of serial messages. cache the values and write later.
-        auto phase1Power = _upSdm->readVal(SDM_PHASE_1_POWER, _address);
-        auto phase1Voltage = _upSdm->readVal(SDM_PHASE_1_VOLTAGE, _address);
-        auto energyImport = _upSdm->readVal(SDM_IMPORT_ACTIVE_ENERGY, _address);
-        auto energyExport = _upSdm->readVal(SDM_EXPORT_ACTIVE_ENERGY, _address);
+    std::lock_guard<std::mutex> l(_mutex);
 
-        std::lock_guard<std::mutex> l(_mutex);
-        _powerMeter1Power = static_cast<float>(phase1Power);
-        _powerMeter2Power = 0;
-        _powerMeter3Power = 0;
-        _powerMeter1Voltage = static_cast<float>(phase1Voltage);
-        _powerMeter2Voltage = 0;
-        _powerMeter3Voltage = 0;
-        _powerMeterImport = static_cast<float>(energyImport);
-        _powerMeterExport = static_cast<float>(energyExport);
-        _lastPowerMeterUpdate = millis();
+    // readVal() returns NaN if the meter did not answer
+    values.failed = std::isnan(power[0]) || std::isnan(power[1]) || std::isnan(power[2]);
+    if (values.failed) { return; }
+
+    for (uint8_t phase = 0; phase < 3; ++phase) {
+        values.power[phase] = power[phase];
+        values.voltage[phase] = voltage[phase];
     }
-    else if (configuredSource == Source::SDM3PH) {
-        if (!_upSdm) { return; }
-
-        // this takes a "very long" time as each readVal() is a synchronous
-        // exchange of serial messages. cache the values and write later.
-        auto phase1Power = _upSdm->readVal(SDM_PHASE_1_POWER, _address);
-        auto phase2Power = _upSdm->readVal(SDM_PHASE_2_POWER, _address);
-        auto phase3Power = _upSdm->readVal(SDM_PHASE_3_POWER, _address);
-        auto phase1Voltage = _upSdm->readVal(SDM_PHASE_1_VOLTAGE, _address);
-        auto phase2Voltage = _upSdm->readVal(SDM_PHASE_2_VOLTAGE, _address);
-        auto phase3Voltage = _upSdm->readVal(SDM_PHASE_3_VOLTAGE, _address);
-        auto energyImport = _upSdm->readVal(SDM_IMPORT_ACTIVE_ENERGY, _address);
-        auto energyExport = _upSdm->readVal(SDM_EXPORT_ACTIVE_ENERGY, _address);
+    values.energyImport = energyImport;
+    values.energyExport = energyExport;
+    values.lastUpdate = millis();
+}
 
-        std::lock_guard<std::mutex> l(_mutex);
-        _powerMeter1Power = static_cast<float>(phase1Power);
-        _powerMeter2Power = static_cast<float>(phase2Power);
-        _powerMeter3Power = static_cast<float>(phase3Power);
-        _powerMeter1Voltage = static_cast<float>(phase1Voltage);
-        _powerMeter2Voltage = static_cast<float>(phase2Voltage);
-        _powerMeter3Voltage = static_cast<float>(phase3Voltage);
-        _powerMeterImport = static_cast<float>(energyImport);
-        _powerMeterExport = static_cast<float>(energyExport);
-        _lastPowerMeterUpdate = millis();
+void PowerMeterClass::readHttp(SourceValues& values)
+{
+    bool success = HttpPowerMeter.updateValues();
+
+    std::lock_guard<std::mutex> l(_mutex);
+    values.failed = !success;
+    if (!success) { return; }
+
+    values.power[0] = HttpPowerMeter.getPower(1);
+    values.power[1] = HttpPowerMeter.getPower(2);
+    values.power[2] = HttpPowerMeter.getPower(3);
+    values.lastUpdate = millis();
+}
+
+// the values are as recent as the datagram they were decoded from, not as
+// the time they are copied here.
+void PowerMeterClass::readSmaHomeManager(SourceValues& values)
+{
+    uint32_t lastUpdate = SMA_HM.getLastUpdate();
+    if (lastUpdate == 0) { return; }
+
+    std::lock_guard<std::mutex> l(_mutex);
+    if (lastUpdate == values.lastUpdate) { return; }
+
+    values.power[0] = SMA_HM.getPowerL1();
+    values.power[1] = SMA_HM.getPowerL2();
+    values.power[2] = SMA_HM.getPowerL3();
+    values.lastUpdate = lastUpdate;
+}
+
+void PowerMeterClass::initSmlMeters()
+{
+    const PinMapping_t& pin = PinMapping.get();
+    CONFIG_T const& config = Configuration.get();
+
+    SerialPortManager.invalidatePowerMeterPorts();
+
+    int8_t rxPins[POWERMETER_SML_MAX_METERS] = { pin.powermeter_rx, pin.powermeter_rx2 };
+    if (rxPins[0] < 0) {
+        MessageOutput.println("[PowerMeter] invalid pin config for SML power meter (RX pin must be defined)");
+        return;
     }
-    else if (configuredSource == Source::HTTP) {
-        if (HttpPowerMeter.updateValues()) {
-            std::lock_guard<std::mutex> l(_mutex);
-            _powerMeter1Power = HttpPowerMeter.getPower(1);
-            _powerMeter2Power = HttpPowerMeter.getPower(2);
-            _powerMeter3Power = HttpPowerMeter.getPower(3);
-            _lastPowerMeterUpdate = millis();
+
+    for (uint8_t i = 0; i < POWERMETER_SML_MAX_METERS; ++i) {
+        if (rxPins[i] < 0) { continue; }
+
+        // UART0 is used for the console. the SoftwareSerial is only
+        // used if all other UARTs are used by other peripherals.
+        int uart = -1;
+        for (int port = SOC_UART_NUM - 1; port > 0; --port) {
+            if (SerialPortManager.allocatePowerMeterPort(port)) {
+                uart = port;
+                break;
+            }
         }
-    }
-    else if (configuredSource == Source::SMAHM2) {
-        std::lock_guard<std::mutex> l(_mutex);
-        _powerMeter1Power = SMA_HM.getPowerL1();
-        _powerMeter2Power = SMA_HM.getPowerL2();
-        _powerMeter3Power = SMA_HM.getPowerL3();
-        _lastPowerMeterUpdate = millis();
+
+        if (uart < 0) {
+            MessageOutput.printf("[PowerMeter] no hardware UART available for SML meter %d, "
+                    "using software serial\r\n", i);
+        }
+
+        auto upMeter = std::make_unique<SmlMeter>(i, uart, rxPins[i], config.PowerMeter.VerboseLogging);
+        if (!upMeter->init(config.PowerMeter.Sml_Obis, POWERMETER_SML_MAX_OBIS)) { continue; }
+        _smlMeters.push_back(std::move(upMeter));
     }
 }
 
-bool PowerMeterClass::smlReadLoop()
+// combines the values of all SML meters. total power and energy are summed
+// up, while voltages and frequency are taken from the first meter providing
+// them. the phase powers of a meter are used if it provides any of them,
+// otherwise its total power is accounted to the first phase.
+void PowerMeterClass::readSmlMeters(SourceValues& values)
 {
-    while (_upSmlSerial->available()) {
-        double readVal = 0;
-        unsigned char smlCurrentChar = _upSmlSerial->read();
-        sml_states_t smlCurrentState = smlState(smlCurrentChar);
-        if (smlCurrentState == SML_LISTEND) {
-            for (auto& handler: smlHandlerList) {
-                if (smlOBISCheck(handler.OBIS)) {
-                    handler.Fn(readVal);
-                    *handler.Arg = readVal;
-                }
-            }
-        } else if (smlCurrentState == SML_FINAL) {
-            return true;
+    using Value = SmlMeter::Value;
+
+    if (_smlMeters.empty()) { return; }
+
+    std::array<SmlMeter::Data, POWERMETER_SML_MAX_METERS> data;
+    uint32_t telegrams = 0;
+    for (size_t i = 0; i < _smlMeters.size(); ++i) {
+        data[i] = _smlMeters[i]->getData();
+        telegrams += data[i].telegrams;
+
+        // a meter which did not send a valid telegram yet
+        if (data[i].telegrams == 0) { return; }
+    }
+
+    if (telegrams == _smlTelegrams) { return; }
+    _smlTelegrams = telegrams;
+
+    float power[3] = { 0, 0, 0 };
+    float voltage[3] = { 0, 0, 0 };
+    float frequency = 0;
+    float energyImport = 0;
+    float energyExport = 0;
+    uint32_t lastUpdate = data[0].lastUpdate;
+
+    Value const powerValues[3] = { Value::PowerL1, Value::PowerL2, Value::PowerL3 };
+    Value const voltageValues[3] = { Value::VoltageL1, Value::VoltageL2, Value::VoltageL3 };
+
+    for (size_t i = 0; i < _smlMeters.size(); ++i) {
+        auto const& meter = data[i];
+        bool hasPhases = meter.has(Value::PowerL1) || meter.has(Value::PowerL2) || meter.has(Value::PowerL3);
+
+        for (uint8_t phase = 0; phase < 3; ++phase) {
+            if (hasPhases) { power[phase] += meter.get(powerValues[phase]); }
+            if (voltage[phase] == 0) { voltage[phase] = meter.get(voltageValues[phase]); }
         }
+
+        if (!hasPhases) { power[0] += meter.get(Value::PowerTotal); }
+        if (frequency == 0) { frequency = meter.get(Value::Frequency); }
+        energyImport += meter.get(Value::Import);
+        energyExport += meter.get(Value::Export);
+
+        // the combined values are only as recent as the oldest telegram
+        if (static_cast<int32_t>(meter.lastUpdate - lastUpdate) < 0) { lastUpdate = meter.lastUpdate; }
     }
 
-    return false;
+    std::lock_guard<std::mutex> l(_mutex);
+    for (uint8_t phase = 0; phase < 3; ++phase) {
+        values.power[phase] = power[phase];
+        values.voltage[phase] = voltage[phase];
+    }
+    values.frequency = frequency;
+    values.energyImport = energyImport;
+    values.energyExport = energyExport;
+    values.lastUpdate = lastUpdate;
 }
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "PowerMeterFilter.h"
+#include <algorithm>
+#include <cmath>
+
+// scales the median absolute deviation to the standard deviation of
+// normally distributed samples
+static constexpr float madScale = 1.4826f;
+
+// lower bound of the deviation used by the Hampel filter. a steady signal,
+// or one quantized by the meter, has no deviation at all, which would make
+// every change, however small, an outlier.
+static constexpr float minDeviationWatts = 10.0f;
+static constexpr float minDeviationRatio = 0.02f; // of the median
+
+void PowerMeterFilter::configure(Mode mode, size_t window, float hampelThreshold, uint32_t timeConstantMs)
+{
+    _mode = mode;
+    _window = std::min(std::max(window, static_cast<size_t>(1)), MaxWindow);
+    _hampelThreshold = hampelThreshold;
+    _timeConstantMs = timeConstantMs;
+    reset();
+}
+
+void PowerMeterFilter::reset()
+{
+    _next = 0;
+    _count = 0;
+    _lastTimestamp = 0;
+    _value = 0;
+    _outliers = 0;
+}
+
+PowerMeterFilter::Sample const& PowerMeterFilter::at(size_t age) const
+{
+    return _samples[(_next + MaxWindow - 1 - age) % MaxWindow];
+}
+
+float PowerMeterFilter::getLastSample() const
+{
+    if (_count == 0) { return 0; }
+    return at(0).value;
+}
+
+void PowerMeterFilter::addSample(uint32_t timestamp, float value)
+{
+    _samples[_next] = { timestamp, value };
+    _next = (_next + 1) % MaxWindow;
+    _count = std::min(_count + 1, MaxWindow);
+
+    float filtered = filterOutliers();
+
+    if (_timeConstantMs == 0 || _count == 1) {
+        _value = filtered;
+    } else {
+        float elapsed = static_cast<float>(timestamp - _lastTimestamp);
+        float alpha = 1.0f - std::exp(-elapsed / _timeConstantMs);
+        _value += alpha * (filtered - _value);
+    }
+
+    _lastTimestamp = timestamp;
+}
+
+float PowerMeterFilter::median(float* values, size_t count)
+{
+    size_t middle = count / 2;
+    std::nth_element(values, values + middle, values + count);
+    float upper = values[middle];
+    if (count % 2 == 1) { return upper; }
+
+    float lower = *std::max_element(values, values + middle);
+    return (lower + upper) / 2;
+}
+
+float PowerMeterFilter::filterOutliers()
+{
+    float latest = at(0).value;
+
+    size_t count = std::min(_count, _window);
+    if (_mode == Mode::None || count < 3) { return latest; }
+
+    float values[MaxWindow];
+    for (size_t i = 0; i < count; ++i) { values[i] = at(i).value; }
+    float windowMedian = median(values, count);
+
+    if (_mode == Mode::Median) { return windowMedian; }
+
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = std::fabs(at(i).value - windowMedian);
+    }
+    float deviation = madScale * median(values, count);
+    deviation = std::max({ deviation, minDeviationWatts, minDeviationRatio * std::fabs(windowMedian) });
+
+    if (std::fabs(latest - windowMedian) <= _hampelThreshold * deviation) {
+        return latest;
+    }
+
+    ++_outliers;
+    return windowMedian;
+}
+
+float PowerMeterFilter::getRateOfChange() const
+{
+    size_t count = std::min(_count, std::max(_window, _minRateSamples));
+    if (count < 2) { return 0; }
+
+    // times relative to the oldest sample, in seconds
+    uint32_t oldest = at(count - 1).timestamp;
+    float meanTime = 0;
+    float meanValue = 0;
+    for (size_t i = 0; i < count; ++i) {
+        meanTime += (at(i).timestamp - oldest) / 1000.0f;
+        meanValue += at(i).value;
+    }
+    meanTime /= count;
+    meanValue /= count;
+
+    float covariance = 0;
+    float variance = 0;
+    for (size_t i = 0; i < count; ++i) {
+        float time = (at(i).timestamp - oldest) / 1000.0f - meanTime;
+        covariance += time * (at(i).value - meanValue);
+        variance += time * time;
+    }
+
+    if (variance == 0) { return 0; }
+    return covariance / variance;
+}
+
+uint32_t PowerMeterFilter::getSampleInterval() const
+{
+    if (_count < 2) { return 0; }
+
+    uint32_t intervals[MaxWindow - 1];
+    size_t count = _count - 1;
+    for (size_t i = 0; i < count; ++i) {
+        intervals[i] = at(i).timestamp - at(i + 1).timestamp;
+    }
+
+    std::nth_element(intervals, intervals + count / 2, intervals + count);
+    return intervals[count / 2];
+}
+
+float PowerMeterFilter::getLastRateOfChange() const
+{
+    if (_count < 2) { return 0; }
+
+    uint32_t elapsed = at(0).timestamp - at(1).timestamp;
+    if (elapsed == 0) { return 0; }
+
+    return (at(0).value - at(1).value) * 1000.0f / elapsed;
+}
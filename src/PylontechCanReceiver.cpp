@@ -4,6 +4,7 @@
 #include "MessageOutput.h"
 #include "PinMapping.h"
 #include <driver/twai.h>
+#include <algorithm>
 #include <ctime>
 
 //#define PYLONTECH_DUMMY
@@ -14,17 +15,29 @@ bool PylontechCanReceiver::init(bool verboseLogging)
 
     MessageOutput.println("[Pylontech] Initialize interface...");
 
+    if (_bus == Bus::Mcp2515) { return initMcp2515(); }
+
+    return initTwai();
+}
+
+bool PylontechCanReceiver::initTwai()
+{
+    // dedicated CAN pins allow to use the battery's serial pins otherwise
     const PinMapping_t& pin = PinMapping.get();
+    bool canPins = pin.battery_can_rx >= 0;
+    int8_t rxPin = canPins ? pin.battery_can_rx : pin.battery_rx;
+    int8_t txPin = canPins ? pin.battery_can_tx : pin.battery_tx;
+
     MessageOutput.printf("[Pylontech] Interface rx = %d, tx = %d\r\n",
-            pin.battery_rx, pin.battery_tx);
+            rxPin, txPin);
 
-    if (pin.battery_rx < 0 || pin.battery_tx < 0) {
+    if (rxPin < 0 || txPin < 0) {
         MessageOutput.println("[Pylontech] Invalid pin config");
         return false;
     }
 
-    auto tx = static_cast<gpio_num_t>(pin.battery_tx);
-    auto rx = static_cast<gpio_num_t>(pin.battery_rx);
+    auto tx = static_cast<gpio_num_t>(txPin);
+    auto rx = static_cast<gpio_num_t>(rxPin);
     twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(tx, rx, TWAI_MODE_NORMAL);
 
     // Initialize configuration structures using macro initializers
@@ -66,8 +79,50 @@ bool PylontechCanReceiver::init(bool verboseLogging)
     return true;
 }
 
+bool PylontechCanReceiver::initMcp2515()
+{
+    const PinMapping_t& pin = PinMapping.get();
+    MessageOutput.printf("[Pylontech] MCP2515 miso = %d, mosi = %d, clk = %d, cs = %d\r\n",
+            pin.huawei_miso, pin.huawei_mosi, pin.huawei_clk, pin.huawei_cs);
+
+    if (pin.huawei_miso < 0 || pin.huawei_mosi < 0 || pin.huawei_clk < 0 || pin.huawei_cs < 0) {
+        MessageOutput.println("[Pylontech] Invalid MCP2515 pin config");
+        return false;
+    }
+
+    _upSpi = std::make_unique<SPIClass>(HSPI);
+    _upSpi->begin(pin.huawei_clk, pin.huawei_miso, pin.huawei_mosi, pin.huawei_cs);
+    pinMode(pin.huawei_cs, OUTPUT);
+    digitalWrite(pin.huawei_cs, HIGH);
+
+    // the crystal of the MCP2515 is configured with the Huawei settings
+    auto frequency = MCP_8MHZ;
+    if (Configuration.get().Huawei.CAN_Controller_Frequency == 16000000UL) { frequency = MCP_16MHZ; }
+
+    _upCan = std::make_unique<MCP_CAN>(_upSpi.get(), pin.huawei_cs);
+    if (_upCan->begin(MCP_STDEXT, CAN_500KBPS, frequency) != CAN_OK) {
+        MessageOutput.println("[Pylontech] MCP2515 initialization failed");
+        _upCan = nullptr;
+        _upSpi->end();
+        _upSpi = nullptr;
+        return false;
+    }
+
+    _upCan->setMode(MCP_NORMAL);
+
+    MessageOutput.println("[Pylontech] MCP2515 initialized");
+    return true;
+}
+
 void PylontechCanReceiver::deinit()
 {
+    if (_bus == Bus::Mcp2515) {
+        _upCan = nullptr;
+        if (_upSpi) { _upSpi->end(); }
+        _upSpi = nullptr;
+        return;
+    }
+
     // Stop TWAI driver
     esp_err_t twaiLastResult = twai_stop();
     switch (twaiLastResult) {
@@ -97,6 +152,29 @@ void PylontechCanReceiver::loop()
     return dummyData();
 #endif
 
+    uint32_t id;
+    uint8_t data[8];
+    uint8_t len;
+    if (!receive(id, data, len)) { return; }
+
+    onMessage(id, data, len);
+}
+
+bool PylontechCanReceiver::receive(uint32_t& id, uint8_t* data, uint8_t& len)
+{
+    if (_bus == Bus::Mcp2515) {
+        if (!_upCan || _upCan->checkReceive() != CAN_MSGAVAIL) { return false; }
+
+        INT32U rxId;
+        if (_upCan->readMsgBuf(&rxId, &len, data) != CAN_OK) {
+            MessageOutput.println("[Pylontech] Failed to receive message");
+            return false;
+        }
+
+        id = rxId & 0x1FFFFFFF; // strip the extended frame flag
+        return true;
+    }
+
     // Check for messages. twai_receive is blocking when there is no data so we return if there are no frames in the buffer
     twai_status_info_t status_info;
     esp_err_t twaiLastResult = twai_get_status_info(&status_info);
@@ -109,24 +187,32 @@ void PylontechCanReceiver::loop()
                 MessageOutput.println("[Pylontech] Twai driver get status - invalid state");
                 break;
         }
-        return;
+        return false;
     }
     if (status_info.msgs_to_rx == 0) {
-        return;
+        return false;
     }
 
     // Wait for message to be received, function is blocking
     twai_message_t rx_message;
     if (twai_receive(&rx_message, pdMS_TO_TICKS(100)) != ESP_OK) {
         MessageOutput.println("[Pylontech] Failed to receive message");
-        return;
+        return false;
     }
 
-    switch (rx_message.identifier) {
+    id = rx_message.identifier;
+    len = std::min<uint8_t>(rx_message.data_length_code, 8);
+    memcpy(data, rx_message.data, len);
+    return true;
+}
+
+void PylontechCanReceiver::onMessage(uint32_t id, uint8_t* data, uint8_t len)
+{
+    switch (id) {
         case 0x351: {
-            _stats->_chargeVoltage = this->scaleValue(this->readUnsignedInt16(rx_message.data), 0.1);
-            _stats->_chargeCurrentLimitation = this->scaleValue(this->readSignedInt16(rx_message.data + 2), 0.1);
-            _stats->_dischargeCurrentLimitation = this->scaleValue(this->readSignedInt16(rx_message.data + 4), 0.1);
+            _stats->_chargeVoltage = this->scaleValue(this->readUnsignedInt16(data), 0.1);
+            _stats->_chargeCurrentLimitation = this->scaleValue(this->readSignedInt16(data + 2), 0.1);
+            _stats->_dischargeCurrentLimitation = this->scaleValue(this->readSignedInt16(data + 4), 0.1);
 
             if (_verboseLogging) {
                 MessageOutput.printf("[Pylontech] chargeVoltage: %f chargeCurrentLimitation: %f dischargeCurrentLimitation: %f\n",
@@ -136,8 +222,8 @@ void PylontechCanReceiver::loop()
         }
 
         case 0x355: {
-            _stats->setSoC(static_cast<uint8_t>(this->readUnsignedInt16(rx_message.data)), 0/*precision*/, millis());
-            _stats->_stateOfHealth = this->readUnsignedInt16(rx_message.data + 2);
+            _stats->setSoC(static_cast<uint8_t>(this->readUnsignedInt16(data)), 0/*precision*/, millis());
+            _stats->_stateOfHealth = this->readUnsignedInt16(data + 2);
 
             if (_verboseLogging) {
                 MessageOutput.printf("[Pylontech] soc: %d soh: %d\n",
@@ -147,9 +233,9 @@ void PylontechCanReceiver::loop()
         }
 
         case 0x356: {
-            _stats->setVoltage(this->scaleValue(this->readSignedInt16(rx_message.data), 0.01), millis());
-            _stats->_current = this->scaleValue(this->readSignedInt16(rx_message.data + 2), 0.1);
-            _stats->_temperature = this->scaleValue(this->readSignedInt16(rx_message.data + 4), 0.1);
+            _stats->setVoltage(this->scaleValue(this->readSignedInt16(data), 0.01), millis());
+            _stats->_current = this->scaleValue(this->readSignedInt16(data + 2), 0.1);
+            _stats->_temperature = this->scaleValue(this->readSignedInt16(data + 4), 0.1);
 
             if (_verboseLogging) {
                 MessageOutput.printf("[Pylontech] voltage: %f current: %f temperature: %f\n",
@@ -159,14 +245,14 @@ void PylontechCanReceiver::loop()
         }
 
         case 0x359: {
-            uint16_t alarmBits = rx_message.data[0];
+            uint16_t alarmBits = data[0];
             _stats->_alarmOverCurrentDischarge = this->getBit(alarmBits, 7);
             _stats->_alarmUnderTemperature = this->getBit(alarmBits, 4);
             _stats->_alarmOverTemperature = this->getBit(alarmBits, 3);
             _stats->_alarmUnderVoltage = this->getBit(alarmBits, 2);
             _stats->_alarmOverVoltage= this->getBit(alarmBits, 1);
 
-            alarmBits = rx_message.data[1];
+            alarmBits = data[1];
             _stats->_alarmBmsInternal= this->getBit(alarmBits, 3);
             _stats->_alarmOverCurrentCharge = this->getBit(alarmBits, 0);
 
@@ -181,14 +267,14 @@ void PylontechCanReceiver::loop()
                         _stats->_alarmOverCurrentCharge);
             }
 
-            uint16_t warningBits = rx_message.data[2];
+            uint16_t warningBits = data[2];
             _stats->_warningHighCurrentDischarge = this->getBit(warningBits, 7);
             _stats->_warningLowTemperature = this->getBit(warningBits, 4);
             _stats->_warningHighTemperature = this->getBit(warningBits, 3);
             _stats->_warningLowVoltage = this->getBit(warningBits, 2);
             _stats->_warningHighVoltage = this->getBit(warningBits, 1);
 
-            warningBits = rx_message.data[3];
+            warningBits = data[3];
             _stats->_warningBmsInternal= this->getBit(warningBits, 3);
             _stats->_warningHighCurrentCharge = this->getBit(warningBits, 0);
 
@@ -206,8 +292,8 @@ void PylontechCanReceiver::loop()
         }
 
         case 0x35E: {
-            String manufacturer(reinterpret_cast<char*>(rx_message.data),
-                    rx_message.data_length_code);
+            String manufacturer(reinterpret_cast<char*>(data),
+                    len);
 
             if (manufacturer.isEmpty()) { break; }
 
@@ -220,7 +306,7 @@ void PylontechCanReceiver::loop()
         }
 
         case 0x35C: {
-            uint16_t chargeStatusBits = rx_message.data[0];
+            uint16_t chargeStatusBits = data[0];
             _stats->_chargeEnabled = this->getBit(chargeStatusBits, 7);
             _stats->_dischargeEnabled = this->getBit(chargeStatusBits, 6);
             _stats->_chargeImmediately = this->getBit(chargeStatusBits, 5);
@@ -4,200 +4,224 @@
  */
 #include "SMA_HM.h"
 #include <Arduino.h>
-#include "Configuration.h"
-#include "NetworkSettings.h"
-#include <WiFiUdp.h>
 #include "MessageOutput.h"
 
-unsigned int multicastPort = 9522;  // local port to listen on
-IPAddress multicastIP(239, 12, 255, 254);
-WiFiUDP SMAUdp;
+static constexpr uint16_t multicastPort = 9522;
+static IPAddress const multicastIP(239, 12, 255, 254);
 
-constexpr uint32_t interval = 1000;
+// protocol ID of the data group sent by energy meters. other SMA devices,
+// e.g., inverters, use the same multicast group with other protocols.
+static constexpr uint16_t energyMeterProtocol = 0x6069;
 
 SMA_HMClass SMA_HM;
 
-void SMA_HMClass::Soutput(int kanal, int index, int art, int tarif,
-        char const* name, float value, uint32_t timestamp)
+static uint16_t readUint16(uint8_t const* data)
+{
+    return (data[0] << 8) | data[1];
+}
+
+static uint32_t readUint32(uint8_t const* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+void SMA_HMClass::Soutput(char const* name, float value, uint32_t timestamp)
 {
     if (!_verboseLogging) { return; }
 
-    MessageOutput.printf("SMA_HM: %s = %.1f (timestamp %d)\r\n",
+    MessageOutput.printf("SMA_HM: %s = %.1f (timestamp %u)\r\n",
             name, value, timestamp);
 }
 
-void SMA_HMClass::init(Scheduler& scheduler, bool verboseLogging)
+void SMA_HMClass::init(bool verboseLogging, uint32_t serial)
 {
     _verboseLogging = verboseLogging;
-    scheduler.addTask(_loopTask);
-    _loopTask.setCallback(std::bind(&SMA_HMClass::loop, this));
-    _loopTask.setIterations(TASK_FOREVER);
-    _loopTask.enable();
-    SMAUdp.begin(multicastPort);
-    SMAUdp.beginMulticast(multicastIP, multicastPort);
+    _configuredSerial = serial;
+    _serial = serial;
+
+    _udp.onPacket(std::bind(&SMA_HMClass::onPacket, this, std::placeholders::_1));
+
+    // the multicast group is joined on every interface which is up. it must
+    // be joined again whenever an interface (re)connects.
+    NetworkSettings.onEvent(std::bind(&SMA_HMClass::onNetworkEvent, this, std::placeholders::_1),
+            network_event::NETWORK_GOT_IP);
 }
 
-void SMA_HMClass::loop()
+void SMA_HMClass::onNetworkEvent(network_event event)
 {
-    uint32_t currentMillis = millis();
-    if (currentMillis - _previousMillis >= interval) {
-        _previousMillis = currentMillis;
-        event1();
+    _udp.close();
+
+    if (!_udp.listenMulticast(multicastIP, multicastPort)) {
+        MessageOutput.println("SMA_HM: Cannot join multicast group");
+        return;
     }
+
+    MessageOutput.printf("SMA_HM: Listening on %s:%u\r\n",
+            multicastIP.toString().c_str(), multicastPort);
 }
 
-uint8_t* SMA_HMClass::decodeGroup(uint8_t* offset, uint16_t grouplen)
+float SMA_HMClass::getPowerTotal() const
 {
-    float Pbezug = 0;
-    float BezugL1 = 0;
-    float BezugL2 = 0;
-    float BezugL3 = 0;
-    float Peinspeisung = 0;
-    float EinspeisungL1 = 0;
-    float EinspeisungL2 = 0;
-    float EinspeisungL3 = 0;
-
-    uint8_t* endOfGroup = offset + grouplen;
-
-    // not used: uint16_t protocolID = (offset[0] << 8) + offset[1];
-    offset += 2;
-
-    // not used: uint16_t susyID = (offset[0] << 8) + offset[1];
-    offset += 2;
-
-    _serial = (offset[0] << 24) + (offset[1] << 16) + (offset[2] << 8) + offset[3];
-    offset += 4;
-
-    uint32_t timestamp = (offset[0] << 24) + (offset[1] << 16) + (offset[2] << 8) + offset[3];
-    offset += 4;
-
-    unsigned count = 0;
-    while (offset < endOfGroup) {
-        uint8_t kanal = offset[0];
-        uint8_t index = offset[1];
-        uint8_t art = offset[2];
-        uint8_t tarif = offset[3];
-        offset += 4;
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _powerMeterPower;
+}
 
-        if (kanal == 144) {
-            // Optional: Versionsnummer auslesen... aber interessiert die?
-            offset += 4;
-            continue;
-        }
+float SMA_HMClass::getPowerL1() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _powerMeterL1;
+}
 
-        if (art == 8) {
-            offset += 8;
-            continue;
+float SMA_HMClass::getPowerL2() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _powerMeterL2;
+}
+
+float SMA_HMClass::getPowerL3() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _powerMeterL3;
+}
+
+uint32_t SMA_HMClass::getLastUpdate() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _lastUpdate;
+}
+
+uint32_t SMA_HMClass::getSerial() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _serial;
+}
+
+void SMA_HMClass::onPacket(AsyncUDPPacket& packet)
+{
+    uint32_t receivedMillis = millis();
+
+    uint8_t const* data = packet.data();
+    size_t len = packet.length();
+
+    if (len < 4 || data[0] != 'S' || data[1] != 'M' || data[2] != 'A') {
+        if (_verboseLogging) {
+            MessageOutput.println("SMA_HM: Not an SMA packet?");
         }
+        return;
+    }
 
-        if (art == 4) {
-            uint32_t data = (offset[0] << 24) +
-                (offset[1] << 16) +
-                (offset[2] << 8) +
-                offset[3];
-            offset += 4;
-
-            switch (index) {
-                case (1):
-                    Pbezug = data * 0.1;
-                    ++count;
-                    break;
-                case (2):
-                    Peinspeisung = data * 0.1;
-                    ++count;
-                    break;
-                case (21):
-                    BezugL1 = data * 0.1;
-                    ++count;
-                    break;
-                case (22):
-                    EinspeisungL1 = data * 0.1;
-                    ++count;
-                    break;
-                case (41):
-                    BezugL2 = data * 0.1;
-                    ++count;
-                    break;
-                case (42):
-                    EinspeisungL2 = data * 0.1;
-                    ++count;
-                    break;
-                case (61):
-                    BezugL3 = data * 0.1;
-                    ++count;
-                    break;
-                case (62):
-                    EinspeisungL3 = data * 0.1;
-                    ++count;
-                    break;
-                default:
-                    break;
-            }
+    size_t offset = 4; // skips the header 'SMA\0'
+
+    while (offset + 4 <= len) {
+        uint16_t grouplen = readUint16(data + offset);
+        uint16_t grouptag = readUint16(data + offset + 2);
+        offset += 4;
 
-            if (count == 8) {
-                _powerMeterPower = Pbezug - Peinspeisung;
-                _powerMeterL1 = BezugL1 - EinspeisungL1;
-                _powerMeterL2 = BezugL2 - EinspeisungL2;
-                _powerMeterL3 = BezugL3 - EinspeisungL3;
-                Soutput(kanal, index, art, tarif, "Leistung", _powerMeterPower, timestamp);
-                Soutput(kanal, index, art, tarif, "Leistung L1", _powerMeterL1, timestamp);
-                Soutput(kanal, index, art, tarif, "Leistung L2", _powerMeterL2, timestamp);
-                Soutput(kanal, index, art, tarif, "Leistung L3", _powerMeterL3, timestamp);
-                count = 0;
+        if (grouptag == 0 || grouplen == 0xffff) { return; } // end marker
+
+        if (offset + grouplen > len) {
+            if (_verboseLogging) {
+                MessageOutput.printf("SMA_HM: Truncated group 0x%04x with length %u\r\n",
+                        grouptag, grouplen);
             }
+            return;
+        }
 
-            continue;
+        if (grouptag == 0x0010) {
+            decodeGroup(data + offset, grouplen, receivedMillis);
+        }
+        else if (grouptag != 0x02A0 && _verboseLogging) {
+            MessageOutput.printf("SMA_HM: Unhandled group 0x%04x with length %u\r\n",
+                    grouptag, grouplen);
         }
 
-        MessageOutput.printf("SMA_HM: Skipped unknown measurement: %d %d %d %d\r\n",
-                kanal, index, art, tarif);
-        offset += art;
+        offset += grouplen;
     }
-
-    return offset;
 }
 
-void SMA_HMClass::event1()
+void SMA_HMClass::decodeGroup(uint8_t const* data, size_t len, uint32_t receivedMillis)
 {
-    int packetSize = SMAUdp.parsePacket();
-    if (!packetSize) { return; }
+    if (len < 12) { return; }
 
-    uint8_t buffer[1024];
-    int rSize = SMAUdp.read(buffer, 1024);
-    if (buffer[0] != 'S' || buffer[1] != 'M' || buffer[2] != 'A') {
-        MessageOutput.println("SMA_HM: Not an SMA packet?");
-        return;
-    }
+    if (readUint16(data) != energyMeterProtocol) { return; }
 
-    uint16_t grouplen;
-    uint16_t grouptag;
-    uint8_t* offset = buffer + 4; // skips the header 'SMA\0'
+    // not used: uint16_t susyID = readUint16(data + 2);
+    uint32_t serial = readUint32(data + 4);
+    uint32_t timestamp = readUint32(data + 8);
 
-    do {
-        grouplen = (offset[0] << 8) + offset[1];
-        grouptag = (offset[2] << 8) + offset[3];
-        offset += 4;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
 
-        if (grouplen == 0xffff) return;
+        if (_serial == 0) {
+            _serial = serial;
+            MessageOutput.printf("SMA_HM: Using meter with serial %u, "
+                    "configure its serial to select another one\r\n", serial);
+        }
 
-        if (grouptag == 0x02A0 && grouplen == 4) {
-            offset += 4;
-            continue;
+        if (serial != _serial) {
+            if (_verboseLogging) {
+                MessageOutput.printf("SMA_HM: Ignoring meter with serial %u\r\n", serial);
+            }
+            return;
         }
 
-        if (grouptag == 0x0010) {
-            offset = decodeGroup(offset, grouplen);
-            continue;
+        // the same datagram may arrive through several interfaces
+        if (_lastUpdate != 0 && timestamp == _meterTimestamp) { return; }
+    }
+
+    // indices of the active power measurements, import and export of the
+    // sum and of each phase
+    static constexpr uint8_t indices[8] = { 1, 2, 21, 22, 41, 42, 61, 62 };
+    float values[8] = {};
+    uint8_t received = 0;
+
+    size_t offset = 12;
+    while (offset + 4 <= len) {
+        uint8_t kanal = data[offset];
+        uint8_t index = data[offset + 1];
+        uint8_t art = data[offset + 2];
+        uint8_t tarif = data[offset + 3];
+        offset += 4;
+
+        // the software version is sent as four bytes of channel 144
+        uint8_t size = (kanal == 144) ? 4 : art;
+        if (size != 4 && size != 8 && _verboseLogging) {
+            MessageOutput.printf("SMA_HM: Skipped unknown measurement: %d %d %d %d\r\n",
+                    kanal, index, art, tarif);
         }
 
-        if (grouptag == 0) {
-            // end marker
-            offset += grouplen;
-            continue;
+        if (offset + size > len) { break; }
+
+        if (kanal != 144 && art == 4) {
+            for (uint8_t i = 0; i < sizeof(indices); ++i) {
+                if (indices[i] != index) { continue; }
+                values[i] = readUint32(data + offset) * 0.1;
+                received |= (1 << i);
+            }
         }
 
-        MessageOutput.printf("SMA_HM: Unhandled group 0x%04x with length %d\r\n",
-                grouptag, grouplen);
-        offset += grouplen;
-    } while (grouplen > 0 && offset + 4 < buffer + rSize);
+        offset += size;
+    }
+
+    if (received != 0xff) {
+        if (_verboseLogging) {
+            MessageOutput.printf("SMA_HM: Incomplete datagram of meter %u\r\n", serial);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _powerMeterPower = values[0] - values[1];
+        _powerMeterL1 = values[2] - values[3];
+        _powerMeterL2 = values[4] - values[5];
+        _powerMeterL3 = values[6] - values[7];
+        _meterTimestamp = timestamp;
+        _lastUpdate = receivedMillis;
+    }
+
+    Soutput("Leistung", values[0] - values[1], timestamp);
+    Soutput("Leistung L1", values[2] - values[3], timestamp);
+    Soutput("Leistung L2", values[4] - values[5], timestamp);
+    Soutput("Leistung L3", values[6] - values[7], timestamp);
 }
@@ -16,6 +16,11 @@ bool SerialPortManagerClass::allocateMpptPort(int port)
     return allocatePort(port, Owner::MPPT);
 }
 
+bool SerialPortManagerClass::allocatePowerMeterPort(int port)
+{
+    return allocatePort(port, Owner::POWERMETER);
+}
+
 bool SerialPortManagerClass::allocatePort(uint8_t port, Owner owner)
 {
     if (port >= MAX_CONTROLLERS) {
@@ -36,6 +41,11 @@ void SerialPortManagerClass::invalidateMpptPorts()
     invalidate(Owner::MPPT);
 }
 
+void SerialPortManagerClass::invalidatePowerMeterPorts()
+{
+    invalidate(Owner::POWERMETER);
+}
+
 void SerialPortManagerClass::invalidate(Owner owner)
 {
     for (auto it = allocatedPorts.begin(); it != allocatedPorts.end();) {
@@ -55,6 +65,8 @@ const char* SerialPortManagerClass::print(Owner owner)
             return "BATTERY";
         case MPPT:
             return "MPPT";
+        case POWERMETER:
+            return "POWERMETER";
     }
     return "unknown";
 }
@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "SmlMeter.h"
+#include "MessageOutput.h"
+#include "sml.h"
+#include <HardwareSerial.h>
+#include <SoftwareSerial.h>
+
+std::mutex SmlMeter::_parserMutex;
+
+namespace {
+
+// SML transport protocol version 1: a telegram starts with four escape bytes
+// followed by four bytes 0x01, and ends with four escape bytes followed by
+// 0x1a, the number of padding bytes and the CRC. four escape bytes within
+// the data are sent twice.
+constexpr uint8_t StartSequence[8] = { 0x1b, 0x1b, 0x1b, 0x1b, 0x01, 0x01, 0x01, 0x01 };
+constexpr uint8_t EscapeByte = 0x1b;
+constexpr uint8_t EndMarker = 0x1a;
+
+// CRC-16/X-25, as used by the SML transport protocol
+uint16_t calcCrc(uint8_t const* data, size_t len)
+{
+    uint16_t crc = 0xffff;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+        }
+    }
+    return crc ^ 0xffff;
+}
+
+} // namespace
+
+SmlMeter::SmlMeter(uint8_t index, int uart, int8_t rxPin, bool verboseLogging)
+    : _index(index)
+    , _uart(uart)
+    , _rxPin(rxPin)
+    , _verboseLogging(verboseLogging)
+{
+}
+
+bool SmlMeter::init(POWERMETER_SML_OBIS_CONFIG_T const* obisTable, size_t obisCount)
+{
+    for (size_t i = 0; i < obisCount; ++i) {
+        auto const& entry = obisTable[i];
+        if (entry.Meter != _index || entry.Value == 0
+                || entry.Value >= static_cast<uint8_t>(Value::Count)) {
+            continue;
+        }
+
+        ObisEntry obisEntry;
+        memcpy(obisEntry.obis, entry.Obis, sizeof(obisEntry.obis));
+        obisEntry.value = static_cast<Value>(entry.Value);
+        _obisTable.push_back(obisEntry);
+    }
+
+    if (_obisTable.empty()) {
+        MessageOutput.printf("[SmlMeter %d] no OBIS codes configured\r\n", _index);
+        return false;
+    }
+
+    MessageOutput.printf("[SmlMeter %d] rx = %d, %s, %u OBIS codes\r\n", _index, _rxPin,
+            (_uart >= 0 ? "hardware UART" : "software serial"), _obisTable.size());
+
+    _telegram.reserve(512);
+    pinMode(_rxPin, INPUT);
+
+    if (_uart >= 0) {
+        auto upSerial = std::make_unique<HardwareSerial>(_uart);
+        upSerial->setRxBufferSize(1024);
+        upSerial->begin(9600, SERIAL_8N1, _rxPin, -1);
+        _upSerial = std::move(upSerial);
+    } else {
+        auto upSerial = std::make_unique<SoftwareSerial>();
+        upSerial->begin(9600, SWSERIAL_8N1, _rxPin, -1, false, 128, 95);
+        upSerial->enableRx(true);
+        upSerial->enableTx(false);
+        upSerial->flush();
+        _upSerial = std::move(upSerial);
+    }
+
+    if (xTaskCreate(SmlMeter::taskEntry, "SML", 4096, this, tskIDLE_PRIORITY + 1, &_taskHandle) != pdPASS) {
+        MessageOutput.printf("[SmlMeter %d] cannot create task\r\n", _index);
+        return false;
+    }
+
+    // the UART driver signals received data, the software serial is polled
+    if (_uart >= 0) {
+        static_cast<HardwareSerial*>(_upSerial.get())->onReceive([this]() {
+            xTaskNotifyGive(_taskHandle);
+        });
+    }
+
+    return true;
+}
+
+SmlMeter::Data SmlMeter::getData() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _data;
+}
+
+void SmlMeter::taskEntry(void* parameter)
+{
+    static_cast<SmlMeter*>(parameter)->task();
+}
+
+void SmlMeter::task()
+{
+    uint32_t waitMs = (_uart >= 0) ? 1000 : _softwareSerialPollMs;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+
+        while (_upSerial->available()) {
+            receive(_upSerial->read());
+        }
+    }
+}
+
+void SmlMeter::receive(uint8_t byte)
+{
+    // a start sequence always starts a new telegram. it is not necessarily
+    // aligned to the data received before, e.g., if a telegram is truncated.
+    if (byte == StartSequence[_startMatch]) {
+        ++_startMatch;
+    } else if (byte == EscapeByte) {
+        _startMatch = (_startMatch == 4) ? 4 : 1;
+    } else {
+        _startMatch = 0;
+    }
+
+    if (_startMatch == sizeof(StartSequence)) {
+        _telegram.assign(StartSequence, StartSequence + sizeof(StartSequence));
+        _receiving = true;
+        _escapeCount = 0;
+        _escapeBytes = 0;
+        _startMatch = 0;
+        return;
+    }
+
+    if (!_receiving) { return; }
+
+    _telegram.push_back(byte);
+
+    if (_telegram.size() > _maxTelegramSize) {
+        MessageOutput.printf("[SmlMeter %d] telegram exceeds %u bytes\r\n", _index, _maxTelegramSize);
+        _receiving = false;
+        return;
+    }
+
+    if (_escapeBytes == 0) {
+        _escapeCount = (byte == EscapeByte) ? _escapeCount + 1 : 0;
+        if (_escapeCount == 4) {
+            _escapeCount = 0;
+            _escapeBytes = 4;
+        }
+        return;
+    }
+
+    // the four bytes following an escape sequence tell its meaning
+    if (--_escapeBytes > 0) { return; }
+
+    uint8_t const* escaped = &_telegram[_telegram.size() - 4];
+    if (escaped[0] == EscapeByte && escaped[1] == EscapeByte
+            && escaped[2] == EscapeByte && escaped[3] == EscapeByte) {
+        return; // escape bytes within the data
+    }
+
+    if (escaped[0] == EndMarker) { parseTelegram(); }
+
+    _receiving = false;
+}
+
+void SmlMeter::parseTelegram()
+{
+    // the checksum covers the telegram as transmitted, i.e., including
+    // escape sequences, and is transmitted with the low byte first.
+    size_t size = _telegram.size();
+    uint16_t crc = _telegram[size - 2] | (_telegram[size - 1] << 8);
+    if (calcCrc(_telegram.data(), size - 2) != crc) {
+        if (_verboseLogging) {
+            MessageOutput.printf("[SmlMeter %d] discarding telegram with invalid checksum (%u bytes)\r\n",
+                    _index, size);
+        }
+        return;
+    }
+
+    decltype(Data::values) values = {};
+    uint16_t received = 0;
+    sml_states_t state = SML_START;
+
+    {
+        std::lock_guard<std::mutex> lock(_parserMutex);
+        smlReset();
+
+        uint8_t escapeCount = 0;
+        for (size_t i = 0; i < size; ++i) {
+            // the parser expects escape bytes within the data only once
+            escapeCount = (_telegram[i] == EscapeByte) ? escapeCount + 1 : 0;
+            if (escapeCount == 4 && i + 4 < size && _telegram[i + 1] == EscapeByte
+                    && _telegram[i + 2] == EscapeByte && _telegram[i + 3] == EscapeByte
+                    && _telegram[i + 4] == EscapeByte) {
+                i += 4;
+                escapeCount = 0;
+            }
+
+            unsigned char currentByte = _telegram[i];
+            state = smlState(currentByte);
+            if (state != SML_LISTEND) { continue; }
+
+            for (auto const& entry : _obisTable) {
+                if (!smlOBISCheck(entry.obis)) { continue; }
+
+                double value = 0;
+                switch (entry.value) {
+                    case Value::PowerTotal:
+                    case Value::PowerL1:
+                    case Value::PowerL2:
+                    case Value::PowerL3:
+                        smlOBISW(value);
+                        break;
+                    case Value::VoltageL1:
+                    case Value::VoltageL2:
+                    case Value::VoltageL3:
+                        smlOBISVolt(value);
+                        break;
+                    case Value::Frequency:
+                        smlOBISHertz(value);
+                        break;
+                    case Value::Import:
+                    case Value::Export:
+                        smlOBISWh(value);
+                        break;
+                    default:
+                        continue;
+                }
+
+                uint8_t idx = static_cast<uint8_t>(entry.value);
+                values[idx] = static_cast<float>(value);
+                received |= (1 << idx);
+            }
+        }
+    }
+
+    // the parser's own checksum does not match if escape bytes were removed
+    if (state != SML_FINAL && state != SML_CHECKSUM_ERROR) {
+        if (_verboseLogging) {
+            MessageOutput.printf("[SmlMeter %d] discarding malformed telegram (%u bytes)\r\n",
+                    _index, size);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _data.values = values;
+    _data.received = received;
+    _data.lastUpdate = millis();
+    ++_data.telegrams;
+
+    if (_verboseLogging) {
+        MessageOutput.printf("[SmlMeter %d] telegram with %u bytes, %d values\r\n",
+                _index, size, __builtin_popcount(received));
+    }
+}
@@ -5,12 +5,13 @@
 #include "SunPosition.h"
 #include "Configuration.h"
 #include "Utils.h"
+#include "TaskStatistics.h"
 #include <Arduino.h>
 
 SunPositionClass SunPosition;
 
 SunPositionClass::SunPositionClass()
-    : _loopTask(5 * TASK_SECOND, TASK_FOREVER, std::bind(&SunPositionClass::loop, this))
+    : _loopTask(5 * TASK_SECOND, TASK_FOREVER, TaskStatistics.wrap("SunPosition", std::bind(&SunPositionClass::loop, this)))
 {
 }
 
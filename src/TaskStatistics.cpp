@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2024 Thomas Basler and others
+ */
+#include "TaskStatistics.h"
+#include "Scheduler.h"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <memory>
+#include <new>
+
+TaskStatisticsClass TaskStatistics;
+
+TaskCallback TaskStatisticsClass::wrap(char const* name, TaskCallback callback)
+{
+    // tasks are only registered while starting up, i.e., before the
+    // scheduler (and any other task) runs. no locking is required here,
+    // which also avoids using the mutex before FreeRTOS is up.
+    if (_entryCount >= _maxEntries) { return callback; }
+
+    size_t idx = _entryCount++;
+    _entries[idx].name = name;
+
+    return [this, idx, callback]() {
+        int64_t startUs = esp_timer_get_time();
+        callback();
+        int64_t endUs = esp_timer_get_time();
+        record(idx, startUs, endUs, scheduler.currentTask().getInterval());
+    };
+}
+
+void TaskStatisticsClass::record(size_t idx, int64_t startUs, int64_t endUs, uint32_t intervalMs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto& entry = _entries[idx];
+    auto runtimeUs = static_cast<uint32_t>(endUs - startUs);
+
+    entry.runs++;
+    entry.totalUs += runtimeUs;
+    entry.minUs = std::min(entry.minUs, runtimeUs);
+    entry.maxUs = std::max(entry.maxUs, runtimeUs);
+
+    size_t bucket = 0;
+    while ((runtimeUs >> (bucket + 1)) > 0 && bucket < (_bucketCount - 1)) { ++bucket; }
+    entry.buckets[bucket]++;
+
+    // tasks which run as often as possible cannot be late
+    if (entry.lastStartUs >= 0 && intervalMs > 0) {
+        int64_t expectedUs = static_cast<int64_t>(intervalMs) * 1000;
+        int64_t elapsedUs = startUs - entry.lastStartUs;
+        uint32_t latenessUs = (elapsedUs > expectedUs) ? static_cast<uint32_t>(elapsedUs - expectedUs) : 0;
+        entry.latenessRuns++;
+        entry.totalLatenessUs += latenessUs;
+        entry.maxLatenessUs = std::max(entry.maxLatenessUs, latenessUs);
+    }
+
+    entry.lastStartUs = startUs;
+}
+
+std::vector<TaskStatisticsClass::TaskSnapshot> TaskStatisticsClass::getTaskSnapshots()
+{
+    std::vector<TaskSnapshot> res;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    res.reserve(_entryCount);
+
+    float uptimeUs = static_cast<float>(esp_timer_get_time());
+
+    for (size_t idx = 0; idx < _entryCount; ++idx) {
+        auto const& entry = _entries[idx];
+
+        TaskSnapshot snapshot = { entry.name, entry.runs, 0, 0, 0, 0, 0, 0, 0.0 };
+
+        if (entry.runs > 0) {
+            snapshot.minUs = entry.minUs;
+            snapshot.avgUs = entry.totalUs / entry.runs;
+            snapshot.maxUs = entry.maxUs;
+            snapshot.cpuPercent = entry.totalUs * 100 / uptimeUs;
+
+            // the p99 value is the upper bound of the bucket which contains
+            // the 99th percentile, but never more than the maximum.
+            uint32_t threshold = entry.runs - entry.runs / 100;
+            uint32_t cumulated = 0;
+            for (size_t bucket = 0; bucket < _bucketCount; ++bucket) {
+                cumulated += entry.buckets[bucket];
+                if (cumulated < threshold) { continue; }
+                snapshot.p99Us = std::min<uint32_t>((2 << bucket) - 1, entry.maxUs);
+                break;
+            }
+        }
+
+        if (entry.latenessRuns > 0) {
+            snapshot.avgLatenessUs = entry.totalLatenessUs / entry.latenessRuns;
+            snapshot.maxLatenessUs = entry.maxLatenessUs;
+        }
+
+        res.push_back(snapshot);
+    }
+
+    return res;
+}
+
+std::vector<TaskStatisticsClass::RtosTaskSnapshot> TaskStatisticsClass::getRtosTaskSnapshots()
+{
+    std::vector<RtosTaskSnapshot> res;
+
+#if configUSE_TRACE_FACILITY == 1
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    std::unique_ptr<TaskStatus_t[]> status(new (std::nothrow) TaskStatus_t[count]);
+    if (!status) { return res; }
+
+    uint32_t totalRunTime = 0;
+    count = uxTaskGetSystemState(status.get(), count, &totalRunTime);
+
+    res.reserve(count);
+
+    for (UBaseType_t i = 0; i < count; ++i) {
+        float cpuPercent = -1;
+#if configGENERATE_RUN_TIME_STATS == 1
+        if (totalRunTime > 0) {
+            cpuPercent = static_cast<float>(status[i].ulRunTimeCounter) * 100 / totalRunTime;
+        }
+#endif
+
+        // ESP-IDF reports the stack high water mark in bytes
+        res.push_back({ status[i].pcTaskName,
+                static_cast<uint32_t>(status[i].usStackHighWaterMark),
+                cpuPercent });
+    }
+#endif
+
+    return res;
+}
@@ -89,16 +89,49 @@ bool Utils::checkJsonOverflow(const DynamicJsonDocument& doc, const char* functi
     return false;
 }
 
+namespace {
+
+void removeDirectory(const String& path)
+{
+    auto dir = LittleFS.open(path);
+    auto file = dir.openNextFile();
+
+    while (file) {
+        String name = file.path();
+        bool isDirectory = file.isDirectory();
+        file.close();
+
+        if (isDirectory) {
+            removeDirectory(name);
+        } else {
+            LittleFS.remove(name);
+        }
+        file = dir.openNextFile();
+    }
+
+    dir.close();
+    LittleFS.rmdir(path);
+}
+
+} // namespace
+
 /// @brief Remove all files but the PINMAPPING_FILENAME
 void Utils::removeAllFiles()
 {
     auto root = LittleFS.open("/");
-    auto file = root.getNextFileName();
-
-    while (file != "") {
-        if (file != PINMAPPING_FILENAME) {
-            LittleFS.remove(file);
+    auto file = root.openNextFile();
+
+    while (file) {
+        String name = file.path();
+        bool isDirectory = file.isDirectory();
+        file.close();
+
+        // directories, e.g., the web application overlay, are removed as well
+        if (isDirectory) {
+            removeDirectory(name);
+        } else if (name != PINMAPPING_FILENAME) {
+            LittleFS.remove(name);
         }
-        file = root.getNextFileName();
+        file = root.openNextFile();
     }
 }
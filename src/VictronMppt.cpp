@@ -3,25 +3,40 @@
 #include "Configuration.h"
 #include "PinMapping.h"
 #include "MessageOutput.h"
+#include "NetworkSettings.h"
 #include "SerialPortManager.h"
+#include "TaskStatistics.h"
 
 VictronMpptClass VictronMppt;
 
 void VictronMpptClass::init(Scheduler& scheduler)
 {
     scheduler.addTask(_loopTask);
-    _loopTask.setCallback([this] { loop(); });
+    _loopTask.setCallback(TaskStatistics.wrap("VictronMppt", [this] { loop(); }));
     _loopTask.setIterations(TASK_FOREVER);
     _loopTask.enable();
 
+    // the UDP listener cannot be opened before the network stack is up
+    NetworkSettings.onEvent(std::bind(&VictronMpptClass::onNetworkEvent, this, std::placeholders::_1),
+            network_event::NETWORK_GOT_IP);
+
     this->updateSettings();
 }
 
+void VictronMpptClass::onNetworkEvent(network_event event)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _networkReady = true;
+    if (!_upUdp) { openUdp(); }
+}
+
 void VictronMpptClass::updateSettings()
 {
     std::lock_guard<std::mutex> lock(_mutex);
 
     _controllers.clear();
+    _forwardedControllers.clear();
+    _upUdp.reset();
     SerialPortManager.invalidateMpptPorts();
 
     CONFIG_T& config = Configuration.get();
@@ -36,6 +51,24 @@ void VictronMpptClass::updateSettings()
     }
 
     initController(pin.victron_rx2, pin.victron_tx2, config.Vedirect.VerboseLogging, hwSerialPort);
+
+    if (_networkReady) { openUdp(); }
+}
+
+// expects the mutex to be held
+void VictronMpptClass::openUdp()
+{
+    CONFIG_T& config = Configuration.get();
+    if (!config.Vedirect.Enabled || config.Vedirect.UdpPort == 0) { return; }
+
+    _upUdp = std::make_unique<WiFiUDP>();
+    if (!_upUdp->begin(config.Vedirect.UdpPort)) {
+        MessageOutput.printf("[VictronMppt] Cannot listen on UDP port %d\r\n", config.Vedirect.UdpPort);
+        _upUdp.reset();
+        return;
+    }
+    MessageOutput.printf("[VictronMppt] Listening for forwarded VE.Direct data on UDP port %d\r\n",
+            config.Vedirect.UdpPort);
 }
 
 bool VictronMpptClass::initController(int8_t rx, int8_t tx, bool logging, int hwSerialPort)
@@ -66,6 +99,39 @@ void VictronMpptClass::loop()
     for (auto const& upController : _controllers) {
         upController->loop();
     }
+
+    loopForwarded();
+}
+
+void VictronMpptClass::loopForwarded()
+{
+    if (!_upUdp) { return; }
+
+    while (_upUdp->parsePacket() > 0) {
+        uint32_t source = _upUdp->remoteIP();
+
+        auto iter = _forwardedControllers.find(source);
+        if (iter == _forwardedControllers.end()) {
+            if (_forwardedControllers.size() >= _maxForwardedControllers) {
+                continue; // the packet is discarded by parsePacket()
+            }
+
+            auto upController = std::make_unique<VeDirectMpptController>();
+            upController->init(_upUdp->remoteIP().toString().c_str(), &MessageOutput,
+                    Configuration.get().Vedirect.VerboseLogging);
+            _controllers.push_back(std::move(upController));
+            iter = _forwardedControllers.emplace(source, _controllers.size() - 1).first;
+
+            MessageOutput.printf("[VictronMppt] Receiving forwarded VE.Direct data from %s\r\n",
+                    _upUdp->remoteIP().toString().c_str());
+        }
+
+        uint8_t buffer[128];
+        int len;
+        while ((len = _upUdp->read(buffer, sizeof(buffer))) > 0) {
+            _controllers[iter->second]->receive(buffer, len);
+        }
+    }
 }
 
 bool VictronMpptClass::isDataValid() const
@@ -134,48 +200,128 @@ std::optional<VeDirectMpptController::data_t> VictronMpptClass::getData(size_t i
     return _controllers[idx]->getData();
 }
 
+std::optional<VeDirectMpptController::Statistics> VictronMpptClass::getStatistics(size_t idx) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_controllers.empty() || idx >= _controllers.size()) { return std::nullopt; }
+
+    return _controllers[idx]->getStatistics();
+}
+
+float VictronMpptClass::getFreshnessWeight(VeDirectMpptController const& controller) const
+{
+    // a charge controller sends a text frame every second. data which is
+    // a few frames old is used as is. the weight of older data decreases
+    // linearly until it is no longer valid, instead of the controller's
+    // contribution dropping to zero all at once.
+    static constexpr uint32_t freshMillis = 3 * 1000;
+    static constexpr uint32_t validMillis = 10 * 1000;
+
+    if (!controller.isDataValid()) { return 0; }
+
+    uint32_t age = millis() - controller.getLastUpdate();
+    if (age <= freshMillis) { return 1; }
+    if (age >= validMillis) { return 0; }
+
+    return static_cast<float>(validMillis - age) / (validMillis - freshMillis);
+}
+
+// the charge controllers' text frames are sent once per second. some values
+// are polled more often using the HEX protocol. those are used if they were
+// received after the last text frame.
+static bool isMoreRecent(uint32_t timestamp, uint32_t lastTextFrame)
+{
+    return timestamp > 0 && (timestamp - lastTextFrame) < UINT32_MAX / 2;
+}
+
+static float getOutputPower(VeDirectMpptController const& controller)
+{
+    auto const& data = controller.getData();
+    auto const& voltage = data.BatteryVoltageMilliVolts;
+    auto const& current = data.BatteryCurrentMilliAmps;
+
+    if (isMoreRecent(voltage.first, controller.getLastUpdate()) &&
+            isMoreRecent(current.first, controller.getLastUpdate())) {
+        return voltage.second / 1000.0 * current.second / 1000.0;
+    }
+
+    return data.P;
+}
+
+static float getPanelPower(VeDirectMpptController const& controller)
+{
+    auto const& data = controller.getData();
+
+    if (isMoreRecent(data.PanelPowerMilliWatts.first, controller.getLastUpdate())) {
+        return data.PanelPowerMilliWatts.second / 1000.0;
+    }
+
+    return data.PPV;
+}
+
 int32_t VictronMpptClass::getPowerOutputWatts() const
 {
-    int32_t sum = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    float sum = 0;
+    VeDirectMpptController const* networkController = nullptr;
 
     for (const auto& upController : _controllers) {
-        if (!upController->isDataValid()) { continue; }
+        float weight = getFreshnessWeight(*upController);
+        if (weight <= 0) { continue; }
 
         // if any charge controller is part of a VE.Smart network, and if the
         // charge controller is connected in a way that allows to send
         // requests, we should have the "network total DC input power"
-        // available. if so, to estimate the output power, we multiply by
-        // the calculated efficiency of the connected charge controller.
+        // available. if so, we use the most recent value of any controller.
         auto networkPower = upController->getData().NetworkTotalDcInputPowerMilliWatts;
-        if (networkPower.first > 0) {
-            return static_cast<int32_t>(networkPower.second / 1000.0 * upController->getData().E / 100);
+        if (networkPower.first > 0 && (networkController == nullptr ||
+                (networkPower.first - networkController->getData().NetworkTotalDcInputPowerMilliWatts.first) < UINT32_MAX / 2)) {
+            networkController = upController.get();
         }
 
-        sum += upController->getData().P;
+        sum += weight * getOutputPower(*upController);
     }
 
-    return sum;
+    if (networkController != nullptr) {
+        // to estimate the output power, we multiply by the calculated
+        // efficiency of the connected charge controller.
+        auto const& data = networkController->getData();
+        return static_cast<int32_t>(data.NetworkTotalDcInputPowerMilliWatts.second / 1000.0 * data.E / 100);
+    }
+
+    return static_cast<int32_t>(sum);
 }
 
 int32_t VictronMpptClass::getPanelPowerWatts() const
 {
-    int32_t sum = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    float sum = 0;
+    VeDirectMpptController const* networkController = nullptr;
 
     for (const auto& upController : _controllers) {
-        if (!upController->isDataValid()) { continue; }
+        float weight = getFreshnessWeight(*upController);
+        if (weight <= 0) { continue; }
 
         // if any charge controller is part of a VE.Smart network, and if the
         // charge controller is connected in a way that allows to send
         // requests, we should have the "network total DC input power" available.
         auto networkPower = upController->getData().NetworkTotalDcInputPowerMilliWatts;
-        if (networkPower.first > 0) {
-            return static_cast<int32_t>(networkPower.second / 1000.0);
+        if (networkPower.first > 0 && (networkController == nullptr ||
+                (networkPower.first - networkController->getData().NetworkTotalDcInputPowerMilliWatts.first) < UINT32_MAX / 2)) {
+            networkController = upController.get();
         }
 
-        sum += upController->getData().PPV;
+        sum += weight * getPanelPower(*upController);
     }
 
-    return sum;
+    if (networkController != nullptr) {
+        return static_cast<int32_t>(networkController->getData().NetworkTotalDcInputPowerMilliWatts.second / 1000.0);
+    }
+
+    return static_cast<int32_t>(sum);
 }
 
 float VictronMpptClass::getYieldTotal() const
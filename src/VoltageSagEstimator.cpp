@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "VoltageSagEstimator.h"
+#include <cmath>
+
+void VoltageSagEstimator::reset()
+{
+    _theta = {};
+    _covariance = {};
+    _meanPowerKw = 0;
+    _sampleCount = 0;
+}
+
+void VoltageSagEstimator::addSample(float voltage, float powerWatts)
+{
+    if (voltage <= 0) { return; }
+
+    float powerKw = powerWatts / 1000;
+
+    if (_sampleCount == 0) {
+        // start without any assumption about the factor
+        _meanPowerKw = powerKw;
+        _theta = { voltage, 0 };
+        _covariance = {{ { 100, 0 }, { 0, 100 } }};
+        _sampleCount = 1;
+        return;
+    }
+
+    // the load is relative to its (slowly moving) average, so the voltage
+    // changes over time, e.g., as the battery is discharged, are attributed
+    // to the voltage at average load rather than to the factor.
+    _meanPowerKw += (1 - _forgettingFactor) * (powerKw - _meanPowerKw);
+    std::array<float, 2> phi = { 1, -(powerKw - _meanPowerKw) };
+
+    float error = voltage - (phi[0] * _theta[0] + phi[1] * _theta[1]);
+    if (std::abs(error) > _maxErrorVolts) { return; }
+
+    // covariance times regressor
+    std::array<float, 2> pPhi = {
+        _covariance[0][0] * phi[0] + _covariance[0][1] * phi[1],
+        _covariance[1][0] * phi[0] + _covariance[1][1] * phi[1]
+    };
+
+    float denominator = _forgettingFactor + phi[0] * pPhi[0] + phi[1] * pPhi[1];
+    std::array<float, 2> gain = { pPhi[0] / denominator, pPhi[1] / denominator };
+
+    _theta[0] += gain[0] * error;
+    _theta[1] += gain[1] * error;
+
+    // the covariance is symmetric, hence phi^T * P equals (P * phi)^T
+    float trace = 0;
+    for (size_t row = 0; row < 2; ++row) {
+        for (size_t col = 0; col < 2; ++col) {
+            _covariance[row][col] = (_covariance[row][col] - gain[row] * pPhi[col]) / _forgettingFactor;
+        }
+        trace += _covariance[row][row];
+    }
+
+    if (trace > _maxCovarianceTrace) {
+        for (auto& row : _covariance) {
+            for (auto& value : row) { value *= _maxCovarianceTrace / trace; }
+        }
+    }
+
+    ++_sampleCount;
+}
+
+std::optional<float> VoltageSagEstimator::getFactor() const
+{
+    if (_sampleCount < _minSamples) { return std::nullopt; }
+
+    if (_covariance[1][1] > _maxFactorVariance) { return std::nullopt; }
+
+    if (_theta[1] < 0 || _theta[1] > _maxFactor) { return std::nullopt; }
+
+    return _theta[1] / 1000;
+}
+
+std::optional<float> VoltageSagEstimator::getUnloadedVoltage() const
+{
+    if (!getFactor().has_value()) { return std::nullopt; }
+
+    return _theta[0] + _theta[1] * _meanPowerKw;
+}
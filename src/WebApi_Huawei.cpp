@@ -193,6 +193,10 @@ void WebApiHuaweiClass::onAdminGet(AsyncWebServerRequest* request)
     root["enable_voltage_limit"] = static_cast<int>(config.Huawei.Auto_Power_Enable_Voltage_Limit * 100) / 100.0;
     root["lower_power_limit"] = config.Huawei.Auto_Power_Lower_Power_Limit;
     root["upper_power_limit"] = config.Huawei.Auto_Power_Upper_Power_Limit;   
+    root["target_grid_power"] = config.Huawei.Auto_Power_Target_Grid_Power;
+    root["deadband"] = config.Huawei.Auto_Power_Deadband;
+    root["proportional_gain"] = config.Huawei.Auto_Power_Proportional_Gain;
+    root["integral_gain"] = config.Huawei.Auto_Power_Integral_Gain;
 
     response->setLength();
     request->send(response);
@@ -260,6 +264,20 @@ void WebApiHuaweiClass::onAdminPost(AsyncWebServerRequest* request)
     config.Huawei.Auto_Power_Enable_Voltage_Limit = root["enable_voltage_limit"].as<float>();
     config.Huawei.Auto_Power_Lower_Power_Limit = root["lower_power_limit"].as<float>();
     config.Huawei.Auto_Power_Upper_Power_Limit = root["upper_power_limit"].as<float>();    
+
+    // not (yet) part of the web application's form
+    if (root.containsKey("target_grid_power")) {
+        config.Huawei.Auto_Power_Target_Grid_Power = root["target_grid_power"].as<float>();
+    }
+    if (root.containsKey("deadband")) {
+        config.Huawei.Auto_Power_Deadband = root["deadband"].as<float>();
+    }
+    if (root.containsKey("proportional_gain")) {
+        config.Huawei.Auto_Power_Proportional_Gain = root["proportional_gain"].as<float>();
+    }
+    if (root.containsKey("integral_gain")) {
+        config.Huawei.Auto_Power_Integral_Gain = root["integral_gain"].as<float>();
+    }
     WebApi.writeConfig(retMsg);
 
     response->setLength();
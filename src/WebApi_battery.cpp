@@ -38,6 +38,15 @@ void WebApiBatteryClass::onStatus(AsyncWebServerRequest* request)
     root["enabled"] = config.Battery.Enabled;
     root["verbose_logging"] = config.Battery.VerboseLogging;
     root["provider"] = config.Battery.Provider;
+    root["capacity"] = config.Battery.CapacityAmpHours;
+    JsonArray additional = root.createNestedArray("additional");
+    for (uint8_t i = 0; i < BATTERY_MAX_ADDITIONAL; i++) {
+        auto const& cfg = config.Battery.Additional[i];
+        JsonObject entry = additional.createNestedObject();
+        entry["provider"] = cfg.Provider;
+        entry["current_sensor"] = cfg.CurrentSensor;
+        entry["capacity"] = cfg.CapacityAmpHours;
+    }
     root["jkbms_interface"] = config.Battery.JkBmsInterface;
     root["jkbms_polling_interval"] = config.Battery.JkBmsPollingInterval;
     root["mqtt_soc_topic"] = config.Battery.MqttSocTopic;
@@ -103,6 +112,19 @@ void WebApiBatteryClass::onAdminPost(AsyncWebServerRequest* request)
     config.Battery.Enabled = root["enabled"].as<bool>();
     config.Battery.VerboseLogging = root["verbose_logging"].as<bool>();
     config.Battery.Provider = root["provider"].as<uint8_t>();
+    if (root.containsKey("capacity")) {
+        config.Battery.CapacityAmpHours = root["capacity"].as<uint16_t>();
+    }
+    if (root.containsKey("additional")) {
+        JsonArray additional = root["additional"].as<JsonArray>();
+        for (uint8_t i = 0; i < BATTERY_MAX_ADDITIONAL; i++) {
+            auto& cfg = config.Battery.Additional[i];
+            JsonObject entry = additional[i];
+            cfg.Provider = entry["provider"] | BATTERY_PROVIDER_NONE;
+            cfg.CurrentSensor = entry["current_sensor"] | false;
+            cfg.CapacityAmpHours = entry["capacity"] | 0;
+        }
+    }
     config.Battery.JkBmsInterface = root["jkbms_interface"].as<uint8_t>();
     config.Battery.JkBmsPollingInterval = root["jkbms_polling_interval"].as<uint8_t>();
     strlcpy(config.Battery.MqttSocTopic, root["mqtt_soc_topic"].as<String>().c_str(), sizeof(config.Battery.MqttSocTopic));
@@ -34,6 +34,12 @@ void WebApiConfigClass::onConfigGet(AsyncWebServerRequest* request)
     }
 
     String requestFile = CONFIG_FILENAME;
+
+    // the JSON file is only written on request
+    if (!request->hasParam("file") || request->getParam("file")->value() == &CONFIG_FILENAME[1]) {
+        Configuration.writeJson();
+    }
+
     if (request->hasParam("file")) {
         String name = "/" + request->getParam("file")->value();
         if (LittleFS.exists(name)) {
@@ -126,6 +132,7 @@ void WebApiConfigClass::onConfigListGet(AsyncWebServerRequest* request)
     File file = rootfs.openNextFile();
     while (file) {
         if (file.isDirectory()) {
+            file = rootfs.openNextFile();
             continue;
         }
         JsonObject obj = data.createNestedObject();
@@ -167,8 +174,9 @@ void WebApiConfigClass::onConfigUpload(AsyncWebServerRequest* request, String fi
             request->send(500);
             return;
         }
+        // files of the web application overlay are stored in subdirectories
         const String name = "/" + request->getParam("file")->value();
-        request->_tempFile = LittleFS.open(name, "w");
+        request->_tempFile = LittleFS.open(name, "w", true);
     }
 
     if (len) {
@@ -177,7 +185,12 @@ void WebApiConfigClass::onConfigUpload(AsyncWebServerRequest* request, String fi
     }
 
     if (final) {
+        // an uploaded JSON configuration replaces the binary configuration
+        bool isConfig = (String(request->_tempFile.path()) == CONFIG_FILENAME);
+
         // close the file handle as the upload is now done
         request->_tempFile.close();
+
+        if (isConfig) { LittleFS.remove(CONFIG_STORE_FILENAME); }
     }
 }
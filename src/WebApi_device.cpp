@@ -97,6 +97,8 @@ void WebApiDeviceClass::onDeviceAdminGet(AsyncWebServerRequest* request)
     batteryPinObj["rxen"] = pin.battery_rxen;
     batteryPinObj["tx"] = pin.battery_tx;
     batteryPinObj["txen"] = pin.battery_txen;
+    batteryPinObj["can_rx"] = pin.battery_can_rx;
+    batteryPinObj["can_tx"] = pin.battery_can_tx;
 
     JsonObject huaweiPinObj = curPin.createNestedObject("huawei");
     huaweiPinObj["miso"] = pin.huawei_miso;
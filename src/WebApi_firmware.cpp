@@ -3,10 +3,10 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "WebApi_firmware.h"
-#include "Configuration.h"
-#include "Update.h"
+#include "FirmwareUpdate.h"
 #include "Utils.h"
 #include "WebApi.h"
+#include "WebApi_errors.h"
 #include "helper.h"
 #include <AsyncJson.h>
 
@@ -22,6 +22,8 @@ void WebApiFirmwareClass::init(AsyncWebServer& server, Scheduler& scheduler)
     server.on("/api/firmware/update", HTTP_POST,
         std::bind(&WebApiFirmwareClass::onFirmwareUpdateFinish, this, _1),
         std::bind(&WebApiFirmwareClass::onFirmwareUpdateUpload, this, _1, _2, _3, _4, _5, _6));
+    server.on("/api/firmware/status", HTTP_GET, std::bind(&WebApiFirmwareClass::onFirmwareStatus, this, _1));
+    server.on("/api/firmware/pull", HTTP_POST, std::bind(&WebApiFirmwareClass::onFirmwarePull, this, _1));
 }
 
 void WebApiFirmwareClass::onFirmwareUpdateFinish(AsyncWebServerRequest* request)
@@ -33,48 +35,172 @@ void WebApiFirmwareClass::onFirmwareUpdateFinish(AsyncWebServerRequest* request)
     // the request handler is triggered after the upload has finished...
     // create the response, add header, and send response
 
-    AsyncWebServerResponse* response = request->beginResponse((Update.hasError()) ? 500 : 200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
+    auto state = FirmwareUpdate.getState();
+
+    // the image is incomplete, the client shall resume the upload
+    // at the offset reported by the status.
+    if (state == FirmwareUpdateClass::State::Receiving) {
+        AsyncWebServerResponse* response = request->beginResponse(202, "text/plain", "INCOMPLETE");
+        response->addHeader("Access-Control-Allow-Origin", "*");
+        request->send(response);
+        return;
+    }
+
+    bool success = (state == FirmwareUpdateClass::State::Finished);
+    AsyncWebServerResponse* response = request->beginResponse(success ? 200 : 500, "text/plain", success ? "OK" : "FAIL");
     response->addHeader("Connection", "close");
     response->addHeader("Access-Control-Allow-Origin", "*");
     request->send(response);
-    Utils::restartDtu();
+
+    if (success) { Utils::restartDtu(); }
 }
 
+/**
+ * the image may be uploaded using multiple requests, e.g., to resume an
+ * interrupted upload. the optional "offset" parameter is the position of the
+ * request's data within the image. the update is started by the request with
+ * offset zero, which must provide the MD5 checksum and, optionally, the size
+ * of the image and its signature. the update is finished by the request
+ * which completes the image or, if the size is not known, by any request.
+ * if the "delta" parameter is set to 1, a delta update is uploaded instead of
+ * the image. offset and size then refer to the delta, while MD5 checksum and
+ * signature refer to the image created from it.
+ */
 void WebApiFirmwareClass::onFirmwareUpdateUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final)
 {
     if (!WebApi.checkCredentials(request)) {
         return;
     }
 
+    auto getParam = [request](char const* name) -> String {
+        if (!request->hasParam(name, true)) { return String(); }
+        return request->getParam(name, true)->value();
+    };
+
     // Upload handler chunks in data
     if (!index) {
-        if (!request->hasParam("MD5", true)) {
-            return request->send(400, "text/plain", "MD5 parameter missing");
+        // the update belongs to the download until it ends
+        if (FirmwareUpdate.isPulling()) {
+            return request->send(409, "text/plain", "OTA download is in progress");
         }
 
-        if (!Update.setMD5(request->getParam("MD5", true)->value().c_str())) {
-            return request->send(400, "text/plain", "MD5 parameter invalid");
-        }
+        _uploadOffset = getParam("offset").toInt();
+
+        if (_uploadOffset == 0) {
+            if (!request->hasParam("MD5", true)) {
+                return request->send(400, "text/plain", "MD5 parameter missing");
+            }
 
-        if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH)) { // Start with max available size
-            Update.printError(Serial);
-            return request->send(400, "text/plain", "OTA could not begin");
+            if (!FirmwareUpdate.begin(getParam("size").toInt(), getParam("MD5"), getParam("signature"),
+                        getParam("delta") == "1")) {
+                return request->send(400, "text/plain", FirmwareUpdate.getError());
+            }
+        } else if (FirmwareUpdate.getState() != FirmwareUpdateClass::State::Receiving
+                || _uploadOffset > FirmwareUpdate.getReceived()) {
+            return request->send(409, "text/plain", "OTA cannot be resumed at this offset");
         }
     }
 
     // Write chunked data to the free sketch space
     if (len) {
-        if (Update.write(data, len) != len) {
-            return request->send(400, "text/plain", "OTA could not begin");
+        if (!FirmwareUpdate.write(_uploadOffset + index, data, len)) {
+            return request->send(400, "text/plain", "OTA write failed");
         }
     }
 
-    if (final) { // if the final flag is set then this is the last frame of data
-        if (!Update.end(true)) { // true to set the size to the current progress
-            Update.printError(Serial);
-            return request->send(400, "text/plain", "Could not end OTA");
-        }
-    } else {
+    if (!final) { return; }
+
+    // if the final flag is set then this is the last frame of data
+    size_t size = FirmwareUpdate.getSize();
+    if (size > 0 && FirmwareUpdate.getReceived() < size) { return; }
+
+    if (!FirmwareUpdate.end()) {
+        return request->send(400, "text/plain", "Could not end OTA: " + FirmwareUpdate.getError());
+    }
+}
+
+void WebApiFirmwareClass::onFirmwareStatus(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& root = response->getRoot();
+
+    root["state"] = FirmwareUpdate.getStateText();
+    root["received"] = FirmwareUpdate.getReceived();
+    root["size"] = FirmwareUpdate.getSize();
+    root["delta"] = FirmwareUpdate.isDelta();
+    root["sha256"] = FirmwareUpdate.getReceivedHash();
+    root["pull"] = FirmwareUpdate.isPulling();
+    root["error"] = FirmwareUpdate.getError();
+    root["signature_required"] = FirmwareUpdateClass::isSignatureRequired();
+
+    response->setLength();
+    request->send(response);
+}
+
+void WebApiFirmwareClass::onFirmwarePull(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto& retMsg = response->getRoot();
+    retMsg["type"] = "warning";
+
+    if (!request->hasParam("data", true)) {
+        retMsg["message"] = "No values found!";
+        retMsg["code"] = WebApiError::GenericNoValueFound;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    String json = request->getParam("data", true)->value();
+
+    if (json.length() > 1024) {
+        retMsg["message"] = "Data too large!";
+        retMsg["code"] = WebApiError::GenericDataTooLarge;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    DynamicJsonDocument root(1024);
+    DeserializationError error = deserializeJson(root, json);
+
+    if (error) {
+        retMsg["message"] = "Failed to parse data!";
+        retMsg["code"] = WebApiError::GenericParseError;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    if (!root.containsKey("url") || !root.containsKey("md5")) {
+        retMsg["message"] = "Values are missing!";
+        retMsg["code"] = WebApiError::GenericValueMissing;
+        response->setLength();
+        request->send(response);
         return;
     }
+
+    if (!FirmwareUpdate.startPull(root["url"].as<String>(), root["size"] | 0,
+                root["md5"].as<String>(), root["signature"] | "", root["delta"] | false)) {
+        retMsg["message"] = FirmwareUpdate.getError();
+        retMsg["code"] = WebApiError::FirmwarePullFailed;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    retMsg["type"] = "success";
+    retMsg["message"] = "Download started!";
+    retMsg["code"] = WebApiError::FirmwarePullStarted;
+
+    response->setLength();
+    request->send(response);
 }
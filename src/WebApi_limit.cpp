@@ -3,6 +3,7 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "WebApi_limit.h"
+#include "CommandLatency.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "defaults.h"
@@ -16,6 +17,7 @@ void WebApiLimitClass::init(AsyncWebServer& server, Scheduler& scheduler)
 
     server.on("/api/limit/status", HTTP_GET, std::bind(&WebApiLimitClass::onLimitStatus, this, _1));
     server.on("/api/limit/config", HTTP_POST, std::bind(&WebApiLimitClass::onLimitPost, this, _1));
+    server.on("/api/limit/latency", HTTP_GET, std::bind(&WebApiLimitClass::onLimitLatency, this, _1));
 }
 
 void WebApiLimitClass::onLimitStatus(AsyncWebServerRequest* request)
@@ -153,3 +155,60 @@ void WebApiLimitClass::onLimitPost(AsyncWebServerRequest* request)
     response->setLength();
     request->send(response);
 }
+
+void WebApiLimitClass::onLimitLatency(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    using Kind = CommandLatencyClass::Kind;
+    using Stage = CommandLatencyClass::Stage;
+    using Histogram = CommandLatencyClass::Histogram;
+
+    auto statistics = CommandLatency.getStatistics();
+
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 256 + 4096 * statistics.size());
+    auto& root = response->getRoot();
+
+    for (auto const& [serial, stats] : statistics) {
+        auto inv = Hoymiles.getInverterBySerial(serial);
+        if (inv == nullptr) { continue; }
+
+        JsonObject invObj = root.createNestedObject(inv->serialString());
+
+        for (size_t k = 0; k < static_cast<size_t>(Kind::Count); ++k) {
+            auto kind = static_cast<Kind>(k);
+            auto const& kindStats = stats.get(kind);
+
+            JsonObject kindObj = invObj.createNestedObject(CommandLatencyClass::getKindName(kind));
+            kindObj["commands"] = kindStats.commands;
+            kindObj["resends"] = kindStats.resends;
+            kindObj["retransmits"] = kindStats.retransmits;
+            kindObj["unsettled"] = kindStats.unsettled;
+
+            for (size_t s = 0; s < static_cast<size_t>(Stage::Count); ++s) {
+                auto stage = static_cast<Stage>(s);
+                auto const& histogram = kindStats.get(stage);
+
+                JsonObject stageObj = kindObj.createNestedObject(CommandLatencyClass::getStageName(stage));
+                stageObj["count"] = histogram.getCount();
+                stageObj["sum_ms"] = histogram.getSum();
+                stageObj["max_ms"] = histogram.getMax();
+
+                JsonArray buckets = stageObj.createNestedArray("buckets");
+                auto counts = histogram.getCumulativeCounts();
+                for (size_t b = 0; b < counts.size(); ++b) {
+                    JsonObject bucket = buckets.createNestedObject();
+                    if (b < Histogram::BoundCount) {
+                        bucket["le_ms"] = Histogram::Bounds[b];
+                    }
+                    bucket["count"] = counts[b];
+                }
+            }
+        }
+    }
+
+    response->setLength();
+    request->send(response);
+}
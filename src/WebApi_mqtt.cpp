@@ -87,6 +87,7 @@ void WebApiMqttClass::onMqttAdminGet(AsyncWebServerRequest* request)
     root["mqtt_lwt_offline"] = config.Mqtt.Lwt.Value_Offline;
     root["mqtt_lwt_qos"] = config.Mqtt.Lwt.Qos;
     root["mqtt_publish_interval"] = config.Mqtt.PublishInterval;
+    root["mqtt_task_stats_interval"] = config.Mqtt.TaskStatsInterval;
     root["mqtt_clean_session"] = config.Mqtt.CleanSession;
     root["mqtt_hass_enabled"] = config.Mqtt.Hass.Enabled;
     root["mqtt_hass_expire"] = config.Mqtt.Hass.Expire;
@@ -291,6 +292,15 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
             return;
         }
 
+        // optional, publishing the task statistics is disabled by zero
+        if (root.containsKey("mqtt_task_stats_interval")
+                && root["mqtt_task_stats_interval"].as<uint32_t>() > 65535) {
+            retMsg["message"] = "Task statistics interval must be a number between 0 and 65535!";
+            response->setLength();
+            request->send(response);
+            return;
+        }
+
         if (root["mqtt_hass_enabled"].as<bool>()) {
             if (root["mqtt_hass_topic"].as<String>().length() > MQTT_MAX_TOPIC_STRLEN) {
                 retMsg["message"] = "Hass topic must not be longer than " STR(MQTT_MAX_TOPIC_STRLEN) " characters!";
@@ -330,6 +340,9 @@ void WebApiMqttClass::onMqttAdminPost(AsyncWebServerRequest* request)
     strlcpy(config.Mqtt.Lwt.Value_Offline, root["mqtt_lwt_offline"].as<String>().c_str(), sizeof(config.Mqtt.Lwt.Value_Offline));
     config.Mqtt.Lwt.Qos = root["mqtt_lwt_qos"].as<uint8_t>();
     config.Mqtt.PublishInterval = root["mqtt_publish_interval"].as<uint32_t>();
+    if (root.containsKey("mqtt_task_stats_interval")) {
+        config.Mqtt.TaskStatsInterval = root["mqtt_task_stats_interval"].as<uint32_t>();
+    }
     config.Mqtt.CleanSession = root["mqtt_clean_session"].as<bool>();
     config.Mqtt.Hass.Enabled = root["mqtt_hass_enabled"].as<bool>();
     config.Mqtt.Hass.Expire = root["mqtt_hass_expire"].as<bool>();
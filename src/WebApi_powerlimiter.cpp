@@ -51,10 +51,13 @@ void WebApiPowerLimiterClass::onStatus(AsyncWebServerRequest* request)
     root["voltage_start_threshold"] = static_cast<int>(config.PowerLimiter.VoltageStartThreshold * 100 +0.5) / 100.0;
     root["voltage_stop_threshold"] = static_cast<int>(config.PowerLimiter.VoltageStopThreshold * 100 +0.5) / 100.0;;
     root["voltage_load_correction_factor"] = config.PowerLimiter.VoltageLoadCorrectionFactor;
+    root["voltage_load_correction_auto"] = config.PowerLimiter.VoltageLoadCorrectionAuto;
     root["inverter_restart_hour"] = config.PowerLimiter.RestartHour;
     root["full_solar_passthrough_soc"] = config.PowerLimiter.FullSolarPassThroughSoc;
     root["full_solar_passthrough_start_voltage"] = static_cast<int>(config.PowerLimiter.FullSolarPassThroughStartVoltage * 100 + 0.5) / 100.0;
     root["full_solar_passthrough_stop_voltage"] = static_cast<int>(config.PowerLimiter.FullSolarPassThroughStopVoltage * 100 + 0.5) / 100.0;
+    root["use_battery_discharge_limit"] = config.PowerLimiter.UseBatteryDischargeLimit;
+    root["battery_discharge_limit_margin"] = config.PowerLimiter.BatteryDischargeLimitMargin;
 
     response->setLength();
     request->send(response);
@@ -197,6 +200,14 @@ void WebApiPowerLimiterClass::onAdminPost(AsyncWebServerRequest* request)
         if (config.Vedirect.Enabled) {
             config.PowerLimiter.FullSolarPassThroughSoc = root["full_solar_passthrough_soc"].as<uint32_t>();
         }
+
+        // not (yet) part of the web application's form
+        if (root.containsKey("use_battery_discharge_limit")) {
+            config.PowerLimiter.UseBatteryDischargeLimit = root["use_battery_discharge_limit"].as<bool>();
+        }
+        if (root.containsKey("battery_discharge_limit_margin")) {
+            config.PowerLimiter.BatteryDischargeLimitMargin = std::min<uint8_t>(root["battery_discharge_limit_margin"].as<uint8_t>(), 90);
+        }
     }
 
     config.PowerLimiter.VoltageStartThreshold = root["voltage_start_threshold"].as<float>();
@@ -204,6 +215,9 @@ void WebApiPowerLimiterClass::onAdminPost(AsyncWebServerRequest* request)
     config.PowerLimiter.VoltageStopThreshold = root["voltage_stop_threshold"].as<float>();
     config.PowerLimiter.VoltageStopThreshold = static_cast<int>(config.PowerLimiter.VoltageStopThreshold * 100) / 100.0;
     config.PowerLimiter.VoltageLoadCorrectionFactor = root["voltage_load_correction_factor"].as<float>();
+    if (root.containsKey("voltage_load_correction_auto")) {
+        config.PowerLimiter.VoltageLoadCorrectionAuto = root["voltage_load_correction_auto"].as<bool>();
+    }
     config.PowerLimiter.RestartHour = root["inverter_restart_hour"].as<int8_t>();
 
     WebApi.writeConfig(retMsg);
@@ -12,6 +12,7 @@
 #include "MqttSettings.h"
 #include "PowerLimiter.h"
 #include "PowerMeter.h"
+#include "defaults.h"
 #include "HttpPowerMeter.h"
 #include "WebApi.h"
 #include "helper.h"
@@ -30,7 +31,7 @@ void WebApiPowerMeterClass::init(AsyncWebServer& server, Scheduler& scheduler)
 
 void WebApiPowerMeterClass::onStatus(AsyncWebServerRequest* request)
 {
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, 2048);
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 4096);
     auto& root = response->getRoot();
     const CONFIG_T& config = Configuration.get();
 
@@ -44,6 +45,18 @@ void WebApiPowerMeterClass::onStatus(AsyncWebServerRequest* request)
     root["sdmbaudrate"] = config.PowerMeter.SdmBaudrate;
     root["sdmaddress"] = config.PowerMeter.SdmAddress;
     root["http_individual_requests"] = config.PowerMeter.HttpIndividualRequests;
+    root["sma_hm_serial"] = config.PowerMeter.SmaHmSerial;
+    root["filter_mode"] = config.PowerMeter.FilterMode;
+    root["filter_window"] = config.PowerMeter.FilterWindow;
+    root["filter_hampel_threshold"] = config.PowerMeter.FilterHampelThreshold;
+    root["filter_time_constant"] = config.PowerMeter.FilterTimeConstant;
+    root["fusion_time_constant"] = config.PowerMeter.FusionTimeConstant;
+
+    JsonArray failoverSources = root.createNestedArray("failover_sources");
+    for (uint8_t source : config.PowerMeter.FailoverSources) {
+        if (source == POWERMETER_SOURCE_NONE) { continue; }
+        failoverSources.add(source);
+    }
 
     JsonArray httpPhases = root.createNestedArray("http_phases");
 
@@ -62,6 +75,19 @@ void WebApiPowerMeterClass::onStatus(AsyncWebServerRequest* request)
         phaseObject["timeout"] = config.PowerMeter.Http_Phase[i].Timeout;
     }
 
+    JsonArray smlObis = root.createNestedArray("sml_obis");
+
+    for (uint8_t i = 0; i < POWERMETER_SML_MAX_OBIS; i++) {
+        if (config.PowerMeter.Sml_Obis[i].Value == 0) { continue; }
+
+        JsonObject obisObject = smlObis.createNestedObject();
+        obisObject["meter"] = config.PowerMeter.Sml_Obis[i].Meter;
+        obisObject["value"] = config.PowerMeter.Sml_Obis[i].Value;
+
+        JsonArray obis = obisObject.createNestedArray("obis");
+        for (uint8_t b : config.PowerMeter.Sml_Obis[i].Obis) { obis.add(b); }
+    }
+
     response->setLength();
     request->send(response);
 }
@@ -118,7 +144,46 @@ void WebApiPowerMeterClass::onAdminPost(AsyncWebServerRequest* request)
         return;
     }
 
-    if (static_cast<PowerMeterClass::Source>(root["source"].as<uint8_t>()) == PowerMeterClass::Source::HTTP) {
+    if (root["filter_mode"].as<uint8_t>() > static_cast<uint8_t>(PowerMeterFilter::Mode::Hampel)
+            || root["filter_window"].as<uint8_t>() > PowerMeterFilter::MaxWindow) {
+        retMsg["message"] = "Invalid filter settings!";
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    if (root.containsKey("failover_sources")) {
+        JsonArray failover_sources = root["failover_sources"];
+        if (failover_sources.size() > POWERMETER_MAX_SOURCES - 1) {
+            retMsg["message"] = "Too many failover sources!";
+            response->setLength();
+            request->send(response);
+            return;
+        }
+
+        for (JsonVariant source : failover_sources) {
+            if (source.as<uint8_t>() > static_cast<uint8_t>(PowerMeterClass::Source::SMAHM2)
+                    || source.as<uint8_t>() == root["source"].as<uint8_t>()) {
+                retMsg["message"] = "Invalid failover source!";
+                response->setLength();
+                request->send(response);
+                return;
+            }
+        }
+    }
+
+    // the HTTP settings are validated if HTTP is the source or a failover
+    // source. failover sources missing from the request are kept.
+    auto const httpSource = static_cast<uint8_t>(PowerMeterClass::Source::HTTP);
+    bool usesHttp = (root["source"].as<uint8_t>() == httpSource);
+    for (uint8_t i = 0; i < POWERMETER_MAX_SOURCES - 1; i++) {
+        uint8_t source = root.containsKey("failover_sources")
+            ? (root["failover_sources"][i] | POWERMETER_SOURCE_NONE)
+            : Configuration.get().PowerMeter.FailoverSources[i];
+        usesHttp |= (source == httpSource);
+    }
+
+    if (usesHttp) {
         JsonArray http_phases = root["http_phases"];
         for (uint8_t i = 0; i < http_phases.size(); i++) {
             JsonObject phase = http_phases[i].as<JsonObject>();
@@ -176,6 +241,28 @@ void WebApiPowerMeterClass::onAdminPost(AsyncWebServerRequest* request)
     config.PowerMeter.SdmAddress = root["sdmaddress"].as<uint8_t>();
     config.PowerMeter.HttpIndividualRequests = root["http_individual_requests"].as<bool>();
 
+    if (root.containsKey("sma_hm_serial")) {
+        config.PowerMeter.SmaHmSerial = root["sma_hm_serial"].as<uint32_t>();
+    }
+
+    if (root.containsKey("filter_mode")) {
+        config.PowerMeter.FilterMode = root["filter_mode"].as<uint8_t>();
+        config.PowerMeter.FilterWindow = root["filter_window"] | POWERMETER_FILTER_WINDOW;
+        config.PowerMeter.FilterHampelThreshold = root["filter_hampel_threshold"] | POWERMETER_FILTER_HAMPEL_THRESHOLD;
+        config.PowerMeter.FilterTimeConstant = root["filter_time_constant"] | POWERMETER_FILTER_TIME_CONSTANT;
+    }
+
+    if (root.containsKey("failover_sources")) {
+        JsonArray failover_sources = root["failover_sources"];
+        for (uint8_t i = 0; i < POWERMETER_MAX_SOURCES - 1; i++) {
+            config.PowerMeter.FailoverSources[i] = failover_sources[i] | POWERMETER_SOURCE_NONE;
+        }
+    }
+
+    if (root.containsKey("fusion_time_constant")) {
+        config.PowerMeter.FusionTimeConstant = root["fusion_time_constant"].as<uint32_t>();
+    }
+
     JsonArray http_phases = root["http_phases"];
     for (uint8_t i = 0; i < http_phases.size(); i++) {
         JsonObject phase = http_phases[i].as<JsonObject>();
@@ -191,6 +278,21 @@ void WebApiPowerMeterClass::onAdminPost(AsyncWebServerRequest* request)
         strlcpy(config.PowerMeter.Http_Phase[i].JsonPath, phase["json_path"].as<String>().c_str(), sizeof(config.PowerMeter.Http_Phase[i].JsonPath));
     }
 
+    // the OBIS table is optional, such that clients unaware of it keep it
+    if (root.containsKey("sml_obis")) {
+        JsonArray sml_obis = root["sml_obis"];
+        for (uint8_t i = 0; i < POWERMETER_SML_MAX_OBIS; i++) {
+            JsonObject entry = sml_obis[i].as<JsonObject>();
+            JsonArray obis = entry["obis"];
+
+            config.PowerMeter.Sml_Obis[i].Meter = entry["meter"] | 0;
+            config.PowerMeter.Sml_Obis[i].Value = (obis.size() == 6) ? (entry["value"] | 0) : 0;
+            for (uint8_t b = 0; b < 6; b++) {
+                config.PowerMeter.Sml_Obis[i].Obis[b] = obis[b] | 0;
+            }
+        }
+    }
+
     WebApi.writeConfig(retMsg);
 
     response->setLength();
@@ -4,9 +4,12 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "WebApi_prometheus.h"
+#include "CommandLatency.h"
 #include "Configuration.h"
 #include "MessageOutput.h"
 #include "NetworkSettings.h"
+#include "PowerLimiter.h"
+#include "TaskStatistics.h"
 #include "WebApi.h"
 #include <Hoymiles.h>
 #include "MessageOutput.h"
@@ -64,6 +67,12 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
         stream->print("# TYPE wifi_station gauge\n");
         stream->printf("wifi_station{bssid=\"%s\"} 1\n", WiFi.BSSIDstr().c_str());
 
+        addTaskStatistics(stream);
+
+        addCommandLatency(stream);
+
+        addVoltageSagEstimate(stream);
+
         for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
             auto inv = Hoymiles.getInverterByPos(i);
 
@@ -92,6 +101,8 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
                     serial.c_str(), i, name, inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0);
             }
 
+            addRadioStats(stream, serial, i, inv);
+
             // Loop all channels if Statistics have been updated at least once since DTU boot
             if (inv->Statistics()->getLastUpdate() > 0) {
                 for (auto& t : inv->Statistics()->getChannelTypes()) {
@@ -137,6 +148,69 @@ void WebApiPrometheusClass::addField(AsyncResponseStream* stream, const String&
     }
 }
 
+void WebApiPrometheusClass::addRadioStats(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv)
+{
+    const radio_stats_t& stats = inv->getRadioStats();
+    const bool printHelp = (idx == 0);
+
+    if (printHelp) {
+        stream->print("# HELP opendtu_radio_tx requests sent to the inverter\n");
+        stream->print("# TYPE opendtu_radio_tx counter\n");
+    }
+    stream->printf("opendtu_radio_tx{serial=\"%s\",unit=\"%d\",name=\"%s\",type=\"request\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.TxRequestData);
+    stream->printf("opendtu_radio_tx{serial=\"%s\",unit=\"%d\",name=\"%s\",type=\"re_request\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.TxReRequestFragment);
+
+    if (printHelp) {
+        stream->print("# HELP opendtu_radio_rx results of the requests sent to the inverter\n");
+        stream->print("# TYPE opendtu_radio_rx counter\n");
+    }
+    stream->printf("opendtu_radio_rx{serial=\"%s\",unit=\"%d\",name=\"%s\",result=\"success\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.RxSuccess);
+    stream->printf("opendtu_radio_rx{serial=\"%s\",unit=\"%d\",name=\"%s\",result=\"fail_nothing\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.RxFailNoAnswer);
+    stream->printf("opendtu_radio_rx{serial=\"%s\",unit=\"%d\",name=\"%s\",result=\"fail_partial\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.RxFailPartialAnswer);
+    stream->printf("opendtu_radio_rx{serial=\"%s\",unit=\"%d\",name=\"%s\",result=\"fail_corrupt\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.RxFailCorruptData);
+
+    if (printHelp) {
+        stream->print("# HELP opendtu_radio_rx_fragments fragments received from the inverter\n");
+        stream->print("# TYPE opendtu_radio_rx_fragments counter\n");
+    }
+    stream->printf("opendtu_radio_rx_fragments{serial=\"%s\",unit=\"%d\",name=\"%s\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.RxFragments);
+
+    if (printHelp) {
+        stream->print("# HELP opendtu_radio_rx_crc_errors corrupted fragments received while waiting for the inverter\n");
+        stream->print("# TYPE opendtu_radio_rx_crc_errors counter\n");
+    }
+    stream->printf("opendtu_radio_rx_crc_errors{serial=\"%s\",unit=\"%d\",name=\"%s\"} %u\n",
+        serial.c_str(), idx, inv->name(), stats.RxCrcErrors);
+
+    if (printHelp) {
+        stream->print("# HELP opendtu_radio_rssi average RSSI of the received fragments in dBm\n");
+        stream->print("# TYPE opendtu_radio_rssi gauge\n");
+    }
+    stream->printf("opendtu_radio_rssi{serial=\"%s\",unit=\"%d\",name=\"%s\"} %f\n",
+        serial.c_str(), idx, inv->name(), stats.RssiAverage);
+
+    if (printHelp) {
+        stream->print("# HELP opendtu_radio_rtt average round trip time of requests in ms\n");
+        stream->print("# TYPE opendtu_radio_rtt gauge\n");
+    }
+    stream->printf("opendtu_radio_rtt{serial=\"%s\",unit=\"%d\",name=\"%s\"} %f\n",
+        serial.c_str(), idx, inv->name(), stats.RttAverage);
+
+    if (printHelp) {
+        stream->print("# HELP opendtu_radio_link_quality share of recent requests answered completely in percent\n");
+        stream->print("# TYPE opendtu_radio_link_quality gauge\n");
+    }
+    stream->printf("opendtu_radio_link_quality{serial=\"%s\",unit=\"%d\",name=\"%s\"} %d\n",
+        serial.c_str(), idx, inv->name(), inv->getLinkQuality());
+}
+
 void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const String& serial, const uint8_t idx, std::shared_ptr<InverterAbstract> inv, const ChannelType_t type, const ChannelNum_t channel)
 {
     if (type != TYPE_DC) {
@@ -179,3 +253,145 @@ void WebApiPrometheusClass::addPanelInfo(AsyncResponseStream* stream, const Stri
         channel,
         config.Inverter[idx].channel[channel].YieldTotalOffset);
 }
+
+void WebApiPrometheusClass::addTaskStatistics(AsyncResponseStream* stream)
+{
+    auto tasks = TaskStatistics.getTaskSnapshots();
+
+    stream->print("# HELP opendtu_task_runs Number of scheduler task executions\n");
+    stream->print("# TYPE opendtu_task_runs counter\n");
+    for (auto const& t : tasks) {
+        stream->printf("opendtu_task_runs{task=\"%s\"} %u\n", t.name, t.runs);
+    }
+
+    stream->print("# HELP opendtu_task_runtime_us Runtime of scheduler task callbacks in microseconds\n");
+    stream->print("# TYPE opendtu_task_runtime_us gauge\n");
+    for (auto const& t : tasks) {
+        stream->printf("opendtu_task_runtime_us{task=\"%s\",stat=\"min\"} %u\n", t.name, t.minUs);
+        stream->printf("opendtu_task_runtime_us{task=\"%s\",stat=\"avg\"} %u\n", t.name, t.avgUs);
+        stream->printf("opendtu_task_runtime_us{task=\"%s\",stat=\"max\"} %u\n", t.name, t.maxUs);
+        stream->printf("opendtu_task_runtime_us{task=\"%s\",stat=\"p99\"} %u\n", t.name, t.p99Us);
+    }
+
+    stream->print("# HELP opendtu_task_lateness_us Scheduling lateness of scheduler tasks in microseconds\n");
+    stream->print("# TYPE opendtu_task_lateness_us gauge\n");
+    for (auto const& t : tasks) {
+        stream->printf("opendtu_task_lateness_us{task=\"%s\",stat=\"avg\"} %u\n", t.name, t.avgLatenessUs);
+        stream->printf("opendtu_task_lateness_us{task=\"%s\",stat=\"max\"} %u\n", t.name, t.maxLatenessUs);
+    }
+
+    stream->print("# HELP opendtu_task_cpu_percent Share of CPU time used by scheduler tasks since boot\n");
+    stream->print("# TYPE opendtu_task_cpu_percent gauge\n");
+    for (auto const& t : tasks) {
+        stream->printf("opendtu_task_cpu_percent{task=\"%s\"} %f\n", t.name, t.cpuPercent);
+    }
+
+    auto rtosTasks = TaskStatistics.getRtosTaskSnapshots();
+
+    stream->print("# HELP opendtu_rtos_task_stack_free Minimum free stack of FreeRTOS tasks in bytes\n");
+    stream->print("# TYPE opendtu_rtos_task_stack_free gauge\n");
+    for (auto const& t : rtosTasks) {
+        stream->printf("opendtu_rtos_task_stack_free{task=\"%s\"} %u\n", t.name.c_str(), t.stackHighWaterMark);
+    }
+
+    stream->print("# HELP opendtu_rtos_task_cpu_percent Share of CPU time used by FreeRTOS tasks\n");
+    stream->print("# TYPE opendtu_rtos_task_cpu_percent gauge\n");
+    for (auto const& t : rtosTasks) {
+        if (t.cpuPercent < 0) { continue; }
+        stream->printf("opendtu_rtos_task_cpu_percent{task=\"%s\"} %f\n", t.name.c_str(), t.cpuPercent);
+    }
+}
+
+void WebApiPrometheusClass::addCommandLatency(AsyncResponseStream* stream)
+{
+    using Kind = CommandLatencyClass::Kind;
+    using Stage = CommandLatencyClass::Stage;
+    using Histogram = CommandLatencyClass::Histogram;
+
+    auto statistics = CommandLatency.getStatistics();
+
+    stream->print("# HELP opendtu_command_latency_ms Latency of inverter commands per stage in milliseconds\n");
+    stream->print("# TYPE opendtu_command_latency_ms histogram\n");
+    for (auto const& [serial, stats] : statistics) {
+        auto inv = Hoymiles.getInverterBySerial(serial);
+        if (inv == nullptr) { continue; }
+
+        for (size_t k = 0; k < static_cast<size_t>(Kind::Count); ++k) {
+            auto kind = static_cast<Kind>(k);
+            for (size_t s = 0; s < static_cast<size_t>(Stage::Count); ++s) {
+                auto stage = static_cast<Stage>(s);
+                auto const& histogram = stats.get(kind).get(stage);
+
+                char labels[96];
+                snprintf(labels, sizeof(labels), "serial=\"%s\",name=\"%s\",kind=\"%s\",stage=\"%s\"",
+                    inv->serialString().c_str(), inv->name(),
+                    CommandLatencyClass::getKindName(kind),
+                    CommandLatencyClass::getStageName(stage));
+
+                auto counts = histogram.getCumulativeCounts();
+                for (size_t b = 0; b < Histogram::BoundCount; ++b) {
+                    stream->printf("opendtu_command_latency_ms_bucket{%s,le=\"%u\"} %u\n", labels, Histogram::Bounds[b], counts[b]);
+                }
+                stream->printf("opendtu_command_latency_ms_bucket{%s,le=\"+Inf\"} %u\n", labels, counts[Histogram::BoundCount]);
+                stream->printf("opendtu_command_latency_ms_sum{%s} %llu\n", labels, histogram.getSum());
+                stream->printf("opendtu_command_latency_ms_count{%s} %u\n", labels, histogram.getCount());
+            }
+        }
+    }
+
+    stream->print("# HELP opendtu_command_retransmits Number of fragment retransmit requests for inverter commands\n");
+    stream->print("# TYPE opendtu_command_retransmits counter\n");
+    for (auto const& [serial, stats] : statistics) {
+        auto inv = Hoymiles.getInverterBySerial(serial);
+        if (inv == nullptr) { continue; }
+
+        for (size_t k = 0; k < static_cast<size_t>(Kind::Count); ++k) {
+            auto kind = static_cast<Kind>(k);
+            stream->printf("opendtu_command_retransmits{serial=\"%s\",name=\"%s\",kind=\"%s\"} %u\n",
+                inv->serialString().c_str(), inv->name(),
+                CommandLatencyClass::getKindName(kind), stats.get(kind).retransmits);
+        }
+    }
+
+    stream->print("# HELP opendtu_command_unsettled Number of inverter commands whose commanded state was not reported within the timeout\n");
+    stream->print("# TYPE opendtu_command_unsettled counter\n");
+    for (auto const& [serial, stats] : statistics) {
+        auto inv = Hoymiles.getInverterBySerial(serial);
+        if (inv == nullptr) { continue; }
+
+        for (size_t k = 0; k < static_cast<size_t>(Kind::Count); ++k) {
+            auto kind = static_cast<Kind>(k);
+            stream->printf("opendtu_command_unsettled{serial=\"%s\",name=\"%s\",kind=\"%s\"} %u\n",
+                inv->serialString().c_str(), inv->name(),
+                CommandLatencyClass::getKindName(kind), stats.get(kind).unsettled);
+        }
+    }
+}
+
+void WebApiPrometheusClass::addVoltageSagEstimate(AsyncResponseStream* stream)
+{
+    auto const& estimator = PowerLimiter.getVoltageSagEstimator();
+
+    stream->print("# HELP opendtu_dpl_voltage_load_correction_factor Voltage load correction factor in V/W\n");
+    stream->print("# TYPE opendtu_dpl_voltage_load_correction_factor gauge\n");
+    stream->printf("opendtu_dpl_voltage_load_correction_factor{source=\"configured\"} %f\n",
+        Configuration.get().PowerLimiter.VoltageLoadCorrectionFactor);
+    stream->printf("opendtu_dpl_voltage_load_correction_factor{source=\"effective\"} %f\n",
+        PowerLimiter.getVoltageLoadCorrectionFactor());
+
+    auto oFactor = estimator.getFactor();
+    if (oFactor.has_value()) {
+        stream->printf("opendtu_dpl_voltage_load_correction_factor{source=\"estimated\"} %f\n", *oFactor);
+    }
+
+    auto oVoltage = estimator.getUnloadedVoltage();
+    if (oVoltage.has_value()) {
+        stream->print("# HELP opendtu_dpl_unloaded_battery_voltage Estimated battery voltage without load\n");
+        stream->print("# TYPE opendtu_dpl_unloaded_battery_voltage gauge\n");
+        stream->printf("opendtu_dpl_unloaded_battery_voltage %f\n", *oVoltage);
+    }
+
+    stream->print("# HELP opendtu_dpl_voltage_sag_samples Number of samples used to estimate the voltage load correction factor\n");
+    stream->print("# TYPE opendtu_dpl_voltage_sag_samples counter\n");
+    stream->printf("opendtu_dpl_voltage_sag_samples %u\n", estimator.getSampleCount());
+}
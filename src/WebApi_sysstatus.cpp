@@ -6,6 +6,7 @@
 #include "Configuration.h"
 #include "NetworkSettings.h"
 #include "PinMapping.h"
+#include "TaskStatistics.h"
 #include "WebApi.h"
 #include <AsyncJson.h>
 #include <Hoymiles.h>
@@ -33,7 +34,18 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse();
+    auto const taskSnapshots = TaskStatistics.getTaskSnapshots();
+    auto const rtosTaskSnapshots = TaskStatistics.getRtosTaskSnapshots();
+
+    // the default buffer size covers the static part of the status. task
+    // names are stored by reference, FreeRTOS task names are copied.
+    size_t const size = DYNAMIC_JSON_DOCUMENT_SIZE
+        + JSON_ARRAY_SIZE(taskSnapshots.size())
+        + taskSnapshots.size() * JSON_OBJECT_SIZE(9)
+        + JSON_ARRAY_SIZE(rtosTaskSnapshots.size())
+        + rtosTaskSnapshots.size() * (JSON_OBJECT_SIZE(3) + configMAX_TASK_NAME_LEN);
+
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, size);
     auto& root = response->getRoot();
 
     root["hostname"] = NetworkSettings.getHostname();
@@ -81,6 +93,28 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
     root["cmt_configured"] = PinMapping.isValidCmt2300Config();
     root["cmt_connected"] = Hoymiles.getRadioCmt()->isConnected();
 
+    JsonArray tasks = root.createNestedArray("tasks");
+    for (auto const& t : taskSnapshots) {
+        JsonObject task = tasks.createNestedObject();
+        task["name"] = t.name;
+        task["runs"] = t.runs;
+        task["min_us"] = t.minUs;
+        task["avg_us"] = t.avgUs;
+        task["max_us"] = t.maxUs;
+        task["p99_us"] = t.p99Us;
+        task["avg_lateness_us"] = t.avgLatenessUs;
+        task["max_lateness_us"] = t.maxLatenessUs;
+        task["cpu_percent"] = t.cpuPercent;
+    }
+
+    JsonArray rtosTasks = root.createNestedArray("rtos_tasks");
+    for (auto const& t : rtosTaskSnapshots) {
+        JsonObject task = rtosTasks.createNestedObject();
+        task["name"] = t.name;
+        task["stack_free"] = t.stackHighWaterMark;
+        if (t.cpuPercent >= 0) { task["cpu_percent"] = t.cpuPercent; }
+    }
+
     response->setLength();
     request->send(response);
 }
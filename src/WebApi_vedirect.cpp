@@ -36,6 +36,7 @@ void WebApiVedirectClass::onVedirectStatus(AsyncWebServerRequest* request)
     root["vedirect_enabled"] = config.Vedirect.Enabled;
     root["verbose_logging"] = config.Vedirect.VerboseLogging;
     root["vedirect_updatesonly"] = config.Vedirect.UpdatesOnly;
+    root["vedirect_udp_port"] = config.Vedirect.UdpPort;
 
     response->setLength();
     request->send(response);
@@ -54,6 +55,7 @@ void WebApiVedirectClass::onVedirectAdminGet(AsyncWebServerRequest* request)
     root["vedirect_enabled"] = config.Vedirect.Enabled;
     root["verbose_logging"] = config.Vedirect.VerboseLogging;
     root["vedirect_updatesonly"] = config.Vedirect.UpdatesOnly;
+    root["vedirect_udp_port"] = config.Vedirect.UdpPort;
 
     response->setLength();
     request->send(response);
@@ -112,6 +114,10 @@ void WebApiVedirectClass::onVedirectAdminPost(AsyncWebServerRequest* request)
     config.Vedirect.Enabled = root["vedirect_enabled"].as<bool>();
     config.Vedirect.VerboseLogging = root["verbose_logging"].as<bool>();
     config.Vedirect.UpdatesOnly = root["vedirect_updatesonly"].as<bool>();
+    // optional, as older clients do not know about forwarded frames
+    if (root.containsKey("vedirect_udp_port")) {
+        config.Vedirect.UdpPort = root["vedirect_udp_port"].as<uint16_t>();
+    }
 
     WebApi.writeConfig(retMsg);
 
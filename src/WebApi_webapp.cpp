@@ -3,6 +3,8 @@
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
 #include "WebApi_webapp.h"
+#include "MessageOutput.h"
+#include <LittleFS.h>
 #include <MD5Builder.h>
 
 extern const uint8_t file_index_html_start[] asm("_binary_webapp_dist_index_html_gz_start");
@@ -19,16 +21,123 @@ extern const uint8_t file_zones_json_end[] asm("_binary_webapp_dist_zones_json_g
 extern const uint8_t file_app_js_end[] asm("_binary_webapp_dist_js_app_js_gz_end");
 extern const uint8_t file_site_webmanifest_end[] asm("_binary_webapp_dist_site_webmanifest_end");
 
-void WebApiWebappClass::responseBinaryDataWithETagCache(AsyncWebServerRequest *request, const String &contentType, const String &contentEncoding, const uint8_t *content, size_t len)
+namespace {
+
+// number of hex digits of the MD5 hash used in content-hashed URLs
+constexpr unsigned int HashLength = 8;
+
+} // namespace
+
+String WebApiWebappClass::getContentType(const String& url)
+{
+    if (url.endsWith(".html")) { return "text/html"; }
+    if (url.endsWith(".js")) { return "text/javascript"; }
+    if (url.endsWith(".css")) { return "text/css"; }
+    if (url.endsWith(".json") || url.endsWith(".webmanifest")) { return "application/json"; }
+    if (url.endsWith(".ico")) { return "image/x-icon"; }
+    if (url.endsWith(".png")) { return "image/png"; }
+    if (url.endsWith(".svg")) { return "image/svg+xml"; }
+    return "application/octet-stream";
+}
+
+void WebApiWebappClass::addEmbeddedAsset(const String& url, const String& contentType, const String& contentEncoding, const uint8_t* start, const uint8_t* end)
 {
+    Asset asset;
+    asset.contentType = contentType;
+    asset.contentEncoding = contentEncoding;
+    asset.content = start;
+    asset.len = end - start;
+
     auto md5 = MD5Builder();
     md5.begin();
-    md5.add(const_cast<uint8_t *>(content), len);
+    md5.add(const_cast<uint8_t*>(asset.content), asset.len);
     md5.calculate();
+    asset.md5 = md5.toString();
+
+    _assets[url] = asset;
+}
+
+// files in the overlay directory are named like the files in webapp_dist
+void WebApiWebappClass::loadOverlay(const String& directory)
+{
+    File dir = LittleFS.open(directory);
+    if (!dir || !dir.isDirectory()) {
+        return;
+    }
+
+    File file = dir.openNextFile();
+    while (file) {
+        String path = file.path();
+
+        if (file.isDirectory()) {
+            loadOverlay(path);
+        } else {
+            Asset asset;
+            String url = path.substring(strlen(WEBAPP_OVERLAY_DIR));
+            if (url.endsWith(".gz")) {
+                url.remove(url.length() - 3);
+                asset.contentEncoding = "gzip";
+            }
+            asset.contentType = getContentType(url);
+            asset.file = path;
+
+            auto md5 = MD5Builder();
+            md5.begin();
+            md5.addStream(file, file.size());
+            md5.calculate();
+            asset.md5 = md5.toString();
+
+            MessageOutput.printf("Web application overlay: %s\r\n", url.c_str());
+            _assets[url] = asset;
+        }
+
+        file = dir.openNextFile();
+    }
+}
+
+const WebApiWebappClass::Asset* WebApiWebappClass::findAsset(const String& url, bool& immutable) const
+{
+    immutable = false;
+
+    auto it = _assets.find((url == "/") ? String("/index.html") : url);
+    if (it != _assets.end()) {
+        return &it->second;
+    }
+
+    // "<name>.<hash>.<extension>" refers to "<name>.<extension>", but only
+    // if the hash matches, as the URL is cached for good otherwise.
+    int extension = url.lastIndexOf('.');
+    int hash = (extension > 0) ? url.lastIndexOf('.', extension - 1) : -1;
+    if (hash >= 0 && static_cast<unsigned int>(extension - hash - 1) == HashLength) {
+        it = _assets.find(url.substring(0, hash) + url.substring(extension));
+        if (it != _assets.end() && it->second.md5.startsWith(url.substring(hash + 1, extension))) {
+            immutable = true;
+            return &it->second;
+        }
+    }
+
+    // all other URLs are routes of the web application
+    it = _assets.find("/index.html");
+    return (it != _assets.end()) ? &it->second : nullptr;
+}
+
+void WebApiWebappClass::onAssetRequest(AsyncWebServerRequest* request)
+{
+    bool immutable;
+    const Asset* asset = findAsset(request->url(), immutable);
+    if (asset == nullptr) {
+        request->send(404);
+        return;
+    }
+
+    responseAssetWithCache(request, *asset, immutable);
+}
 
+void WebApiWebappClass::responseAssetWithCache(AsyncWebServerRequest* request, const Asset& asset, bool immutable)
+{
     String expectedEtag;
     expectedEtag = "\"";
-    expectedEtag += md5.toString();
+    expectedEtag += asset.md5;
     expectedEtag += "\"";
 
     bool eTagMatch = false;
@@ -42,14 +151,22 @@ void WebApiWebappClass::responseBinaryDataWithETagCache(AsyncWebServerRequest *r
     if (eTagMatch) {
         response = request->beginResponse(304);
     } else {
-        response = request->beginResponse_P(200, contentType, content, len);
-        if (contentEncoding.length() > 0) {
-            response->addHeader("Content-Encoding", contentEncoding);
+        if (asset.file.length() > 0) {
+            response = request->beginResponse(LittleFS, asset.file, asset.contentType);
+        } else {
+            response = request->beginResponse_P(200, asset.contentType, asset.content, asset.len);
+        }
+        if (asset.contentEncoding.length() > 0) {
+            response->addHeader("Content-Encoding", asset.contentEncoding);
         }
     }
 
     // HTTP requires cache headers in 200 and 304 to be identical
-    response->addHeader("Cache-Control", "public, must-revalidate");
+    if (immutable) {
+        response->addHeader("Cache-Control", "public, max-age=31536000, immutable");
+    } else {
+        response->addHeader("Cache-Control", "public, must-revalidate");
+    }
     response->addHeader("ETag", expectedEtag);
 
     request->send(response);
@@ -62,35 +179,15 @@ void WebApiWebappClass::init(AsyncWebServer& server, Scheduler& scheduler)
        We just have the gzipped data available - so we ship them!
     */
 
-    server.on("/", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/html", "gzip", file_index_html_start, file_index_html_end - file_index_html_start);
-    });
-
-    server.onNotFound([&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/html", "gzip", file_index_html_start, file_index_html_end - file_index_html_start);
-    });
-
-    server.on("/index.html", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/html", "gzip", file_index_html_start, file_index_html_end - file_index_html_start);
-    });
-
-    server.on("/favicon.ico", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "image/x-icon", "", file_favicon_ico_start, file_favicon_ico_end - file_favicon_ico_start);
-    });
-
-    server.on("/favicon.png", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "image/png", "", file_favicon_png_start, file_favicon_png_end - file_favicon_png_start);
-    });
-
-    server.on("/zones.json", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "application/json", "gzip", file_zones_json_start, file_zones_json_end - file_zones_json_start);
-    });
+    addEmbeddedAsset("/index.html", "text/html", "gzip", file_index_html_start, file_index_html_end);
+    addEmbeddedAsset("/favicon.ico", "image/x-icon", "", file_favicon_ico_start, file_favicon_ico_end);
+    addEmbeddedAsset("/favicon.png", "image/png", "", file_favicon_png_start, file_favicon_png_end);
+    addEmbeddedAsset("/zones.json", "application/json", "gzip", file_zones_json_start, file_zones_json_end);
+    addEmbeddedAsset("/site.webmanifest", "application/json", "", file_site_webmanifest_start, file_site_webmanifest_end);
+    addEmbeddedAsset("/js/app.js", "text/javascript", "gzip", file_app_js_start, file_app_js_end);
 
-    server.on("/site.webmanifest", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "application/json", "", file_site_webmanifest_start, file_site_webmanifest_end - file_site_webmanifest_start);
-    });
+    // replaces the embedded files of the same name
+    loadOverlay(WEBAPP_OVERLAY_DIR);
 
-    server.on("/js/app.js", HTTP_GET, [&](AsyncWebServerRequest* request) {
-        responseBinaryDataWithETagCache(request, "text/javascript", "gzip", file_app_js_start, file_app_js_end - file_app_js_start);
-    });
+    server.onNotFound(std::bind(&WebApiWebappClass::onAssetRequest, this, std::placeholders::_1));
 }
@@ -10,6 +10,7 @@
 #include "Utils.h"
 #include "WebApi.h"
 #include "defaults.h"
+#include "TaskStatistics.h"
 
 WebApiWsHuaweiLiveClass::WebApiWsHuaweiLiveClass()
     : _ws("/huaweilivedata")
@@ -38,7 +39,7 @@ void WebApiWsHuaweiLiveClass::init(AsyncWebServer& server, Scheduler& scheduler)
     _wsCleanupTask.enable();
 
     scheduler.addTask(_sendDataTask);
-    _sendDataTask.setCallback(std::bind(&WebApiWsHuaweiLiveClass::sendDataTaskCb, this));
+    _sendDataTask.setCallback(TaskStatistics.wrap("WsHuaweiLive", std::bind(&WebApiWsHuaweiLiveClass::sendDataTaskCb, this)));
     _sendDataTask.setIterations(TASK_FOREVER);
     _sendDataTask.setInterval(1 * TASK_SECOND);
     _sendDataTask.enable();
@@ -10,6 +10,7 @@
 #include "WebApi.h"
 #include "defaults.h"
 #include "Utils.h"
+#include "TaskStatistics.h"
 
 WebApiWsBatteryLiveClass::WebApiWsBatteryLiveClass()
     : _ws("/batterylivedata")
@@ -38,7 +39,7 @@ void WebApiWsBatteryLiveClass::init(AsyncWebServer& server, Scheduler& scheduler
     _wsCleanupTask.enable();
 
     scheduler.addTask(_sendDataTask);
-    _sendDataTask.setCallback(std::bind(&WebApiWsBatteryLiveClass::sendDataTaskCb, this));
+    _sendDataTask.setCallback(TaskStatistics.wrap("WsBatteryLive", std::bind(&WebApiWsBatteryLiveClass::sendDataTaskCb, this)));
     _sendDataTask.setIterations(TASK_FOREVER);
     _sendDataTask.setInterval(1 * TASK_SECOND);
     _sendDataTask.enable();
@@ -62,7 +63,7 @@ void WebApiWsBatteryLiveClass::sendDataTaskCb()
 
     try {
         std::lock_guard<std::mutex> lock(_mutex);
-        DynamicJsonDocument root(_responseSize);
+        DynamicJsonDocument root(getResponseSize());
          if (Utils::checkJsonAlloc(root, __FUNCTION__, __LINE__)) {
             JsonVariant var = root;
             generateJsonResponse(var);
@@ -90,6 +91,13 @@ void WebApiWsBatteryLiveClass::sendDataTaskCb()
     }
 }
 
+size_t WebApiWsBatteryLiveClass::getResponseSize()
+{
+    size_t packs = Battery.getPackCount();
+    if (packs <= 1) { return _responseSize; }
+    return _responseSize * (packs + 1);
+}
+
 void WebApiWsBatteryLiveClass::generateJsonResponse(JsonVariant& root)
 {
     Battery.getStats()->getLiveViewData(root);
@@ -111,7 +119,7 @@ void WebApiWsBatteryLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
     }
     try {
         std::lock_guard<std::mutex> lock(_mutex);
-        AsyncJsonResponse* response = new AsyncJsonResponse(false, _responseSize);
+        AsyncJsonResponse* response = new AsyncJsonResponse(false, getResponseSize());
         auto& root = response->getRoot();
         generateJsonResponse(root);
 
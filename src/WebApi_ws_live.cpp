@@ -12,12 +12,13 @@
 #include "PowerMeter.h"
 #include "VictronMppt.h"
 #include "defaults.h"
+#include "TaskStatistics.h"
 #include <AsyncJson.h>
 
 WebApiWsLiveClass::WebApiWsLiveClass()
     : _ws("/livedata")
     , _wsCleanupTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WebApiWsLiveClass::wsCleanupTaskCb, this))
-    , _sendDataTask(1 * TASK_SECOND, TASK_FOREVER, std::bind(&WebApiWsLiveClass::sendDataTaskCb, this))
+    , _sendDataTask(1 * TASK_SECOND, TASK_FOREVER, TaskStatistics.wrap("WsLive", std::bind(&WebApiWsLiveClass::sendDataTaskCb, this)))
 {
 }
 
@@ -56,7 +57,8 @@ void WebApiWsLiveClass::wsCleanupTaskCb()
 
 void WebApiWsLiveClass::generateOnBatteryJsonResponse(JsonVariant& root, bool all)
 {
-    auto const& config = Configuration.get();
+    auto spConfig = Configuration.getSnapshot();
+    auto const& config = *spConfig;
     auto constexpr halfOfAllMillis = std::numeric_limits<uint32_t>::max() / 2;
 
     auto victronAge = VictronMppt.getDataAgeMillis();
@@ -218,6 +220,26 @@ void WebApiWsLiveClass::generateInverterCommonJsonResponse(JsonObject& root, std
     }
 }
 
+void WebApiWsLiveClass::generateInverterRadioJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
+{
+    const radio_stats_t& stats = inv->getRadioStats();
+
+    JsonObject radioObj = root.createNestedObject("radio_stats");
+    radioObj["tx_request"] = stats.TxRequestData;
+    radioObj["tx_re_request"] = stats.TxReRequestFragment;
+    radioObj["rx_fragments"] = stats.RxFragments;
+    radioObj["rx_crc_errors"] = stats.RxCrcErrors;
+    radioObj["rx_success"] = stats.RxSuccess;
+    radioObj["rx_fail_nothing"] = stats.RxFailNoAnswer;
+    radioObj["rx_fail_partial"] = stats.RxFailPartialAnswer;
+    radioObj["rx_fail_corrupt"] = stats.RxFailCorruptData;
+    radioObj["rssi"] = stats.RssiLast;
+    radioObj["rssi_avg"] = stats.RssiAverage;
+    radioObj["rtt"] = stats.RttLast;
+    radioObj["rtt_avg"] = stats.RttAverage;
+    radioObj["link_quality"] = inv->getLinkQuality();
+}
+
 void WebApiWsLiveClass::generateInverterChannelJsonResponse(JsonObject& root, std::shared_ptr<InverterAbstract> inv)
 {
     const INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
@@ -321,6 +343,7 @@ void WebApiWsLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
                 JsonObject invObject = invArray.createNestedObject();
                 generateInverterCommonJsonResponse(invObject, inv);
                 generateInverterChannelJsonResponse(invObject, inv);
+                generateInverterRadioJsonResponse(invObject, inv);
             }
         } else {
             // Loop all inverters
@@ -11,6 +11,7 @@
 #include "defaults.h"
 #include "PowerLimiter.h"
 #include "VictronMppt.h"
+#include "TaskStatistics.h"
 
 WebApiWsVedirectLiveClass::WebApiWsVedirectLiveClass()
     : _ws("/vedirectlivedata")
@@ -40,7 +41,7 @@ void WebApiWsVedirectLiveClass::init(AsyncWebServer& server, Scheduler& schedule
     _wsCleanupTask.enable();
 
     scheduler.addTask(_sendDataTask);
-    _sendDataTask.setCallback(std::bind(&WebApiWsVedirectLiveClass::sendDataTaskCb, this));
+    _sendDataTask.setCallback(TaskStatistics.wrap("WsVedirectLive", std::bind(&WebApiWsVedirectLiveClass::sendDataTaskCb, this)));
     _sendDataTask.setIterations(TASK_FOREVER);
     _sendDataTask.setInterval(500 * TASK_MILLISECOND);
     _sendDataTask.enable();
@@ -63,7 +64,7 @@ bool WebApiWsVedirectLiveClass::hasUpdate(size_t idx)
 uint16_t WebApiWsVedirectLiveClass::responseSize() const
 {
     // estimated with ArduinoJson assistant
-    return VictronMppt.controllerAmount() * (1024 + 512) + 128/*DPL status and structure*/;
+    return VictronMppt.controllerAmount() * (1024 + 512 + 128/*statistics*/) + 128/*DPL status and structure*/;
 }
 
 void WebApiWsVedirectLiveClass::sendDataTaskCb()
@@ -134,6 +135,18 @@ void WebApiWsVedirectLiveClass::generateJsonResponse(JsonVariant& root, bool ful
         const JsonObject &nested = array.createNestedObject(serial);
         nested["data_age_ms"] = VictronMppt.getDataAgeMillis(idx);
         populateJson(nested, *optMpptData);
+
+        auto optStatistics = VictronMppt.getStatistics(idx);
+        if (optStatistics.has_value()) {
+            const JsonObject &statistics = nested.createNestedObject("statistics");
+            statistics["frames_valid"] = optStatistics->framesValid;
+            statistics["frames_checksum_error"] = optStatistics->framesChecksumError;
+            statistics["frames_timeout"] = optStatistics->framesTimeout;
+            statistics["hex_overflows"] = optStatistics->hexOverflows;
+            statistics["hex_timeouts"] = optStatistics->hexTimeouts;
+            statistics["uart_overflows"] = optStatistics->uartOverflows;
+            statistics["uart_errors"] = optStatistics->uartErrors;
+        }
     }
 
     _lastPublish = millis();
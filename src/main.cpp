@@ -2,9 +2,11 @@
 /*
  * Copyright (C) 2022-2024 Thomas Basler and others
  */
+#include "CommandLatency.h"
 #include "Configuration.h"
 #include "Datastore.h"
 #include "Display_Graphic.h"
+#include "FirmwareUpdate.h"
 #include "InverterSettings.h"
 #include "Led_Single.h"
 #include "MessageOutput.h"
@@ -33,12 +35,98 @@
 #include "PowerLimiter.h"
 #include "defaults.h"
 #include <Arduino.h>
+#include <Hoymiles.h>
 #include <LittleFS.h>
+#include <ResetReason.h>
 #include <TaskScheduler.h>
 #include <esp_heap_caps.h>
+#include <utility>
+#include <vector>
+
+// the startup is split into stages. the stages required to control the
+// inverter run first, such that the DPL is operational as soon as possible,
+// e.g., after a watchdog reset. the web application, the display and the
+// Home Assistant auto-discovery are initialized once the scheduler runs.
+static std::vector<std::pair<char const*, uint32_t>> bootStages;
+static uint32_t bootStageStart = 0;
+static Task deferredInitTask;
+
+static void finishBootStage(char const* name)
+{
+    uint32_t now = millis();
+    bootStages.emplace_back(name, now - bootStageStart);
+    bootStageStart = now;
+}
+
+static void printBootTiming()
+{
+    MessageOutput.printf("Boot timing (reset reason: %s):",
+            ResetReason::get_reset_reason_short(0).c_str());
+
+    uint32_t total = 0;
+    for (auto const& stage : bootStages) {
+        MessageOutput.printf(" %s %u ms,", stage.first, stage.second);
+        total += stage.second;
+    }
+
+    MessageOutput.printf(" total %u ms\r\n", total);
+}
+
+static void deferredInit()
+{
+    auto const& config = Configuration.get();
+    const auto& pin = PinMapping.get();
+
+    // the scheduler executed the tasks of the previous stages at least once
+    // when this task runs, as it was added to the scheduler last.
+    finishBootStage("scheduler");
+
+    // Initialize Home Assistant auto-discovery
+    MessageOutput.print("Initialize MqTT HASS... ");
+    MqttHandleHass.init(scheduler);
+    MqttHandleVedirectHass.init(scheduler);
+    MqttHandleBatteryHass.init(scheduler);
+    MqttHandlePowerLimiterHass.init(scheduler);
+    MessageOutput.println("done");
+
+    // Initialize WebApi
+    MessageOutput.print("Initialize WebApi... ");
+    WebApi.init(scheduler);
+    FirmwareUpdate.init(scheduler);
+    MessageOutput.println("done");
+
+    // Initialize Display
+    MessageOutput.print("Initialize Display... ");
+    Display.init(
+        scheduler,
+        static_cast<DisplayType_t>(pin.display_type),
+        pin.display_data,
+        pin.display_clk,
+        pin.display_cs,
+        pin.display_reset);
+    Display.setDiagramMode(static_cast<DiagramMode_t>(config.Display.Diagram.Mode));
+    Display.setOrientation(config.Display.Rotation);
+    Display.enablePowerSafe = config.Display.PowerSafe;
+    Display.enableScreensaver = config.Display.ScreenSaver;
+    Display.setContrast(config.Display.Contrast);
+    Display.setLanguage(config.Display.Language);
+    Display.setStartupDisplay();
+    MessageOutput.println("done");
+
+    // Initialize Single LEDs
+    MessageOutput.print("Initialize LEDs... ");
+    LedSingle.init(scheduler);
+    MessageOutput.println("done");
+
+    finishBootStage("deferred");
+    printBootTiming();
+}
 
 void setup()
 {
+    // time passed since the reset, before setup() is called
+    finishBootStage("startup");
+
     // Move all dynamic allocations >512byte to psram (if available)
     heap_caps_malloc_extmem_enable(512);
 
@@ -96,65 +184,6 @@ void setup()
     const auto& pin = PinMapping.get();
     MessageOutput.println("done");
 
-    // Initialize WiFi
-    MessageOutput.print("Initialize Network... ");
-    NetworkSettings.init(scheduler);
-    MessageOutput.println("done");
-    NetworkSettings.applyConfig();
-
-    // Initialize NTP
-    MessageOutput.print("Initialize NTP... ");
-    NtpSettings.init();
-    MessageOutput.println("done");
-
-    // Initialize SunPosition
-    MessageOutput.print("Initialize SunPosition... ");
-    SunPosition.init(scheduler);
-    MessageOutput.println("done");
-
-    // Initialize MqTT
-    MessageOutput.print("Initialize MqTT... ");
-    MqttSettings.init();
-    MqttHandleDtu.init(scheduler);
-    MqttHandleInverter.init(scheduler);
-    MqttHandleInverterTotal.init(scheduler);
-    MqttHandleVedirect.init(scheduler);
-    MqttHandleHass.init(scheduler);
-    MqttHandleVedirectHass.init(scheduler);
-    MqttHandleBatteryHass.init(scheduler);
-    MqttHandleHuawei.init(scheduler);
-    MqttHandlePowerLimiter.init(scheduler);
-    MqttHandlePowerLimiterHass.init(scheduler);
-    MessageOutput.println("done");
-
-    // Initialize WebApi
-    MessageOutput.print("Initialize WebApi... ");
-    WebApi.init(scheduler);
-    MessageOutput.println("done");
-
-    // Initialize Display
-    MessageOutput.print("Initialize Display... ");
-    Display.init(
-        scheduler,
-        static_cast<DisplayType_t>(pin.display_type),
-        pin.display_data,
-        pin.display_clk,
-        pin.display_cs,
-        pin.display_reset);
-    Display.setDiagramMode(static_cast<DiagramMode_t>(config.Display.Diagram.Mode));
-    Display.setOrientation(config.Display.Rotation);
-    Display.enablePowerSafe = config.Display.PowerSafe;
-    Display.enableScreensaver = config.Display.ScreenSaver;
-    Display.setContrast(config.Display.Contrast);
-    Display.setLanguage(config.Display.Language);
-    Display.setStartupDisplay();
-    MessageOutput.println("done");
-
-    // Initialize Single LEDs
-    MessageOutput.print("Initialize LEDs... ");
-    LedSingle.init(scheduler);
-    MessageOutput.println("done");
-
     // Check for default DTU serial
     MessageOutput.print("Check for default DTU serial... ");
     if (config.Dtu.Serial == DTU_SERIAL) {
@@ -167,20 +196,29 @@ void setup()
         Configuration.write();
     }
     MessageOutput.println("done");
-    MessageOutput.println("done");
+
+    finishBootStage("config");
 
     InverterSettings.init(scheduler);
 
+    CommandLatency.init(scheduler);
+
     Datastore.init(scheduler);
 
     VictronMppt.init(scheduler);
 
+    Battery.init(scheduler);
+
     // Power meter
     PowerMeter.init(scheduler);
 
     // Dynamic power limiter
     PowerLimiter.init(scheduler);
 
+    // the DPL needs the inverter's statistics and device info before it
+    // sends a limit. they are requested now if the time survived the reset.
+    Hoymiles.requestInitialData();
+
     // Initialize Huawei AC-charger PSU / CAN bus
     MessageOutput.println("Initialize Huawei AC charger interface... ");
     if (PinMapping.isValidHuaweiConfig()) {
@@ -191,7 +229,41 @@ void setup()
         MessageOutput.println("Invalid pin config");
     }
 
-    Battery.init(scheduler);
+    finishBootStage("control");
+
+    // Initialize WiFi
+    MessageOutput.print("Initialize Network... ");
+    NetworkSettings.init(scheduler);
+    MessageOutput.println("done");
+    NetworkSettings.applyConfig();
+
+    // Initialize NTP
+    MessageOutput.print("Initialize NTP... ");
+    NtpSettings.init();
+    MessageOutput.println("done");
+
+    // Initialize SunPosition
+    MessageOutput.print("Initialize SunPosition... ");
+    SunPosition.init(scheduler);
+    MessageOutput.println("done");
+
+    // Initialize MqTT
+    MessageOutput.print("Initialize MqTT... ");
+    MqttSettings.init();
+    MqttHandleDtu.init(scheduler);
+    MqttHandleInverter.init(scheduler);
+    MqttHandleInverterTotal.init(scheduler);
+    MqttHandleVedirect.init(scheduler);
+    MqttHandleHuawei.init(scheduler);
+    MqttHandlePowerLimiter.init(scheduler);
+    MessageOutput.println("done");
+
+    finishBootStage("network");
+
+    scheduler.addTask(deferredInitTask);
+    deferredInitTask.setCallback(deferredInit);
+    deferredInitTask.setIterations(TASK_ONCE);
+    deferredInitTask.enable();
 }
 
 void loop()
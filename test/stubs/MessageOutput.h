@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+
+// discards the output, but counts the messages, such
+// that tests can check whether a message was printed.
+class MessageOutputClass {
+public:
+    size_t printf(char const* format, ...)
+    {
+        (void)format;
+        ++messages;
+        return 0;
+    }
+
+    size_t println(char const* str)
+    {
+        (void)str;
+        ++messages;
+        return 0;
+    }
+
+    size_t messages = 0;
+};
+
+inline MessageOutputClass MessageOutput;
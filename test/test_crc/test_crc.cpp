@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * compares the table driven CRC functions of the Hoymiles library with the
+ * bitwise implementation they replaced and measures both.
+ */
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+// the library requires the Arduino framework, hence only the unit under
+// test is compiled for the host.
+#include <crc.cpp>
+
+static uint8_t bitwiseCrc8(const uint8_t buf[], const uint8_t len)
+{
+    uint8_t crc = CRC8_INIT;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
+        }
+    }
+    return crc;
+}
+
+static uint16_t bitwiseCrc16(const uint8_t buf[], const uint8_t len, const uint16_t start)
+{
+    uint16_t crc = start;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x0001) ? ((crc >> 1) ^ CRC16_MODBUS_POLYNOM) : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+void setUp() { }
+void tearDown() { }
+
+static void test_crc16_check_value()
+{
+    // check value of CRC-16/MODBUS
+    const uint8_t data[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX16(0x4b37, crc16(data, sizeof(data)));
+    TEST_ASSERT_EQUAL_HEX16(0xffff, crc16(data, 0));
+}
+
+static void test_every_single_byte()
+{
+    for (uint16_t value = 0; value < 256; value++) {
+        const uint8_t data[] = { static_cast<uint8_t>(value) };
+        TEST_ASSERT_EQUAL_HEX8(bitwiseCrc8(data, 1), crc8(data, 1));
+        TEST_ASSERT_EQUAL_HEX16(bitwiseCrc16(data, 1, 0xffff), crc16(data, 1));
+        TEST_ASSERT_EQUAL_HEX16(bitwiseCrc16(data, 1, 0x0000), crc16(data, 1, 0x0000));
+    }
+}
+
+static void test_random_buffers()
+{
+    std::mt19937 rng(4711);
+    uint8_t data[255];
+
+    for (int n = 0; n < 20000; n++) {
+        uint8_t len = rng() % (sizeof(data) + 1);
+        for (uint8_t i = 0; i < len; i++) { data[i] = rng(); }
+        uint16_t start = rng();
+
+        TEST_ASSERT_EQUAL_HEX8(bitwiseCrc8(data, len), crc8(data, len));
+        TEST_ASSERT_EQUAL_HEX16(bitwiseCrc16(data, len, start), crc16(data, len, start));
+    }
+}
+
+static void test_chained_crc16()
+{
+    // the CRC of a buffer may be calculated in parts
+    std::mt19937 rng(815);
+    uint8_t data[200];
+    for (auto& b : data) { b = rng(); }
+
+    uint16_t partial = crc16(data, 77);
+    TEST_ASSERT_EQUAL_HEX16(crc16(data, sizeof(data)), crc16(data + 77, sizeof(data) - 77, partial));
+}
+
+template<typename Fn>
+static double nanosPerByte(Fn fn, uint8_t const* data, uint8_t len, int rounds)
+{
+    volatile uint16_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) { sink = sink + fn(data, len); }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(rounds) * len);
+}
+
+static void test_benchmark()
+{
+    // the length of a typical radio fragment, and the longest buffer
+    for (uint8_t len : { 27, 255 }) {
+        uint8_t data[255];
+        for (uint8_t i = 0; i < len; i++) { data[i] = i * 31 + 7; }
+
+        constexpr int rounds = 20000;
+        double tableCrc8 = nanosPerByte(crc8, data, len, rounds);
+        double bitwiseCrc8Ns = nanosPerByte(bitwiseCrc8, data, len, rounds);
+        auto table16 = [](uint8_t const* d, uint8_t l) { return crc16(d, l); };
+        auto bitwise16 = [](uint8_t const* d, uint8_t l) { return bitwiseCrc16(d, l, 0xffff); };
+        double tableCrc16 = nanosPerByte(table16, data, len, rounds);
+        double bitwiseCrc16Ns = nanosPerByte(bitwise16, data, len, rounds);
+
+        char msg[160];
+        snprintf(msg, sizeof(msg), "%3u bytes: crc8 %.2f ns/byte (bitwise %.2f), crc16 %.2f ns/byte (bitwise %.2f)",
+            len, tableCrc8, bitwiseCrc8Ns, tableCrc16, bitwiseCrc16Ns);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc16_check_value);
+    RUN_TEST(test_every_single_byte);
+    RUN_TEST(test_random_buffers);
+    RUN_TEST(test_chained_crc16);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * drives the charge controller of the Huawei PSU with a simulated rectifier
+ * and a simulated household with solar surplus.
+ */
+#include <unity.h>
+#include <cfloat>
+#include <cmath>
+
+#include <HuaweiChargeController.cpp>
+
+using Controller = HuaweiChargeController;
+
+// the rectifier follows the current set with a delay. the power meter
+// measures the household (negative if surplus is exported) plus the AC
+// power drawn by the rectifier.
+class Simulation {
+public:
+    static constexpr uint32_t intervalMillis = 2000; // power meter readings
+    static constexpr float voltage = 52;
+    static constexpr float efficiency = 0.95;
+
+    explicit Simulation(Controller::Parameters const& params)
+    {
+        _controller.setParameters(params);
+    }
+
+    void setSurplus(float watts) { _surplus = watts; }
+    void setChargeCurrentLimit(float amps) { _chargeCurrentLimit = amps; }
+    void setOutputPower(float watts) { _outputPower = watts; }
+
+    // advances the simulation by one reading of the power meter
+    Controller::Output step()
+    {
+        Controller::Input input = {};
+        input.gridPower = getGridPower();
+        input.outputPower = _outputPower;
+        input.outputVoltage = voltage;
+        input.efficiency = efficiency;
+        input.chargeCurrentLimit = _chargeCurrentLimit;
+        input.outputCurrent = _outputPower / voltage;
+        input.chargeCurrent = input.outputCurrent;
+        input.elapsedMillis = intervalMillis;
+
+        auto output = _controller.update(input);
+        if (output.send) {
+            _current = output.current;
+            ++_sent;
+        }
+
+        // first order lag with a time constant of about two seconds
+        _outputPower += 0.6f * (_current * voltage - _outputPower);
+        return output;
+    }
+
+    float getGridPower() const { return -_surplus + _outputPower / efficiency; }
+    float getOutputPower() const { return _outputPower; }
+    float getCurrent() const { return _current; }
+    uint32_t getSent() const { return _sent; }
+
+private:
+    Controller _controller;
+    float _surplus = 0;
+    float _chargeCurrentLimit = FLT_MAX;
+    float _outputPower = 0;
+    float _current = 0;
+    uint32_t _sent = 0;
+};
+
+static Controller::Parameters parameters()
+{
+    Controller::Parameters params;
+    params.lowerPowerLimit = 150;
+    params.upperPowerLimit = 2000;
+    params.deadbandWatts = 25;
+    return params;
+}
+
+void setUp() { }
+void tearDown() { }
+
+static void test_tracks_target_grid_power()
+{
+    Simulation sim(parameters());
+    sim.setSurplus(1000);
+
+    for (int i = 0; i < 60; ++i) { sim.step(); }
+    TEST_ASSERT_FLOAT_WITHIN(50, 0, sim.getGridPower());
+
+    // and follows a change of the surplus
+    sim.setSurplus(1600);
+    for (int i = 0; i < 60; ++i) { sim.step(); }
+    TEST_ASSERT_FLOAT_WITHIN(50, 0, sim.getGridPower());
+
+    auto params = parameters();
+    params.targetGridPower = -100; // keep exporting a little
+    Simulation exporting(params);
+    exporting.setSurplus(1000);
+    for (int i = 0; i < 60; ++i) { exporting.step(); }
+    TEST_ASSERT_FLOAT_WITHIN(50, -100, exporting.getGridPower());
+}
+
+static void test_takes_over_without_step()
+{
+    Simulation sim(parameters());
+    sim.setSurplus(800);
+    sim.setOutputPower(800 * Simulation::efficiency);
+
+    // the PSU already matches the surplus. the set-point refers to
+    // the power drawn by the PSU, rather than its output.
+    auto output = sim.step();
+    TEST_ASSERT_TRUE(output.send);
+    TEST_ASSERT_FLOAT_WITHIN(1, 800, output.powerSetpoint);
+    TEST_ASSERT_FLOAT_WITHIN(1, 800 * Simulation::efficiency, sim.getOutputPower());
+}
+
+static void test_deadband_limits_commands()
+{
+    Simulation sim(parameters());
+    sim.setSurplus(1000);
+    for (int i = 0; i < 60; ++i) { sim.step(); }
+
+    // in steady state, new currents are hardly ever sent
+    uint32_t sent = sim.getSent();
+    for (int i = 0; i < 60; ++i) { sim.step(); }
+    TEST_ASSERT_LESS_OR_EQUAL(2, sim.getSent() - sent);
+}
+
+static void test_upper_limit_without_windup()
+{
+    Simulation sim(parameters());
+    sim.setSurplus(5000);
+
+    for (int i = 0; i < 150; ++i) {
+        auto output = sim.step();
+        TEST_ASSERT_LESS_OR_EQUAL_FLOAT(2000, output.powerSetpoint);
+    }
+
+    // the integral did not grow beyond the limit while saturated, so
+    // the output follows a smaller surplus quickly.
+    sim.setSurplus(500);
+    for (int i = 0; i < 15; ++i) { sim.step(); }
+    TEST_ASSERT_FLOAT_WITHIN(50, 0, sim.getGridPower());
+}
+
+static void test_bms_charge_current_limit()
+{
+    Simulation sim(parameters());
+    sim.setSurplus(1500);
+    for (int i = 0; i < 60; ++i) { sim.step(); }
+
+    sim.setChargeCurrentLimit(10);
+    auto output = sim.step();
+    TEST_ASSERT_TRUE(output.bmsLimited);
+    TEST_ASSERT_TRUE(output.send);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(10.01, sim.getCurrent());
+
+    for (int i = 0; i < 30; ++i) {
+        sim.step();
+        TEST_ASSERT_LESS_OR_EQUAL_FLOAT(10.01, sim.getCurrent());
+    }
+}
+
+static void test_turns_off_below_lower_limit()
+{
+    Simulation sim(parameters());
+    sim.setSurplus(1000);
+    for (int i = 0; i < 60; ++i) { sim.step(); }
+
+    // the PSU stays off, rather than toggling its output
+    sim.setSurplus(100);
+    for (int i = 0; i < 5; ++i) { sim.step(); }
+    uint32_t sent = sim.getSent();
+    for (int i = 0; i < 30; ++i) { sim.step(); }
+    TEST_ASSERT_EQUAL(sent, sim.getSent());
+    TEST_ASSERT_EQUAL_FLOAT(0, sim.getCurrent());
+    TEST_ASSERT_FLOAT_WITHIN(1, 0, sim.getOutputPower());
+
+    // and is turned on again once the surplus exceeds the lower limit
+    sim.setSurplus(400);
+    for (int i = 0; i < 30; ++i) { sim.step(); }
+    TEST_ASSERT_FLOAT_WITHIN(50, 0, sim.getGridPower());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tracks_target_grid_power);
+    RUN_TEST(test_takes_over_without_step);
+    RUN_TEST(test_deadband_limits_commands);
+    RUN_TEST(test_upper_limit_without_windup);
+    RUN_TEST(test_bms_charge_current_limit);
+    RUN_TEST(test_turns_off_below_lower_limit);
+    return UNITY_END();
+}
@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * parses a frame captured from a JK BMS as well as many damaged copies of it,
+ * which must be rejected or parsed without reading beyond the frame.
+ */
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// only the parser is compiled for the host, see test/stubs
+#include <JkBmsSerialMessage.cpp>
+
+using namespace JkBms;
+using Label = DataPointLabel;
+
+// as sent by the dummy serial of the JkBmsController
+static std::vector<uint8_t> const capturedFrame = {
+        0x4e, 0x57, 0x01, 0x21, 0x00, 0x00, 0x00, 0x00,
+        0x06, 0x00, 0x01, 0x79, 0x30, 0x01, 0x0c, 0xfb,
+        0x02, 0x0c, 0xfb, 0x03, 0x0c, 0xfb, 0x04, 0x0c,
+        0xfb, 0x05, 0x0c, 0xfb, 0x06, 0x0c, 0xfb, 0x07,
+        0x0c, 0xfb, 0x08, 0x0c, 0xf7, 0x09, 0x0d, 0x01,
+        0x0a, 0x0c, 0xf9, 0x0b, 0x0c, 0xfb, 0x0c, 0x0c,
+        0xfb, 0x0d, 0x0c, 0xfb, 0x0e, 0x0c, 0xf8, 0x0f,
+        0x0c, 0xf9, 0x10, 0x0c, 0xfb, 0x80, 0x00, 0x1a,
+        0x81, 0x00, 0x12, 0x82, 0x00, 0x12, 0x83, 0x14,
+        0xc3, 0x84, 0x83, 0xf4, 0x85, 0x2e, 0x86, 0x02,
+        0x87, 0x00, 0x15, 0x89, 0x00, 0x00, 0x13, 0x52,
+        0x8a, 0x00, 0x10, 0x8b, 0x00, 0x00, 0x8c, 0x00,
+        0x03, 0x8e, 0x16, 0x80, 0x8f, 0x12, 0xc0, 0x90,
+        0x0e, 0x10, 0x91, 0x0c, 0xda, 0x92, 0x00, 0x05,
+        0x93, 0x0b, 0xb8, 0x94, 0x0c, 0x80, 0x95, 0x00,
+        0x05, 0x96, 0x01, 0x2c, 0x97, 0x00, 0x28, 0x98,
+        0x01, 0x2c, 0x99, 0x00, 0x28, 0x9a, 0x00, 0x1e,
+        0x9b, 0x0b, 0xb8, 0x9c, 0x00, 0x0a, 0x9d, 0x01,
+        0x9e, 0x00, 0x64, 0x9f, 0x00, 0x50, 0xa0, 0x00,
+        0x64, 0xa1, 0x00, 0x64, 0xa2, 0x00, 0x14, 0xa3,
+        0x00, 0x46, 0xa4, 0x00, 0x46, 0xa5, 0x00, 0x00,
+        0xa6, 0x00, 0x02, 0xa7, 0xff, 0xec, 0xa8, 0xff,
+        0xf6, 0xa9, 0x10, 0xaa, 0x00, 0x00, 0x00, 0xe6,
+        0xab, 0x01, 0xac, 0x01, 0xad, 0x04, 0x4d, 0xae,
+        0x01, 0xaf, 0x00, 0xb0, 0x00, 0x0a, 0xb1, 0x14,
+        0xb2, 0x32, 0x32, 0x31, 0x31, 0x38, 0x37, 0x00,
+        0x00, 0x00, 0x00, 0xb3, 0x00, 0xb4, 0x62, 0x65,
+        0x6b, 0x69, 0x00, 0x00, 0x00, 0x00, 0xb5, 0x32,
+        0x33, 0x30, 0x36, 0xb6, 0x00, 0x01, 0x4a, 0xc3,
+        0xb7, 0x31, 0x31, 0x2e, 0x58, 0x57, 0x5f, 0x53,
+        0x31, 0x31, 0x2e, 0x32, 0x36, 0x32, 0x48, 0x5f,
+        0xb8, 0x00, 0xb9, 0x00, 0x00, 0x00, 0xe6, 0xba,
+        0x62, 0x65, 0x6b, 0x69, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x4a, 0x4b, 0x5f, 0x42,
+        0x31, 0x41, 0x32, 0x34, 0x53, 0x31, 0x35, 0x50,
+        0xc0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x68, 0x00,
+        0x00, 0x53, 0xbb
+};
+
+static constexpr uint8_t protocolVersion = 0x01;
+
+void setUp() { }
+void tearDown() { }
+
+static void setChecksum(std::vector<uint8_t>& frame)
+{
+    if (frame.size() < 4) { return; }
+    uint16_t checksum = SerialMessage::calcChecksum({ frame.data(), frame.size() });
+    frame[frame.size() - 2] = checksum >> 8;
+    frame[frame.size() - 1] = checksum & 0xff;
+}
+
+static void test_captured_frame()
+{
+    DataPointContainer dp;
+    SerialResponse response({ capturedFrame.data(), capturedFrame.size() }, dp, protocolVersion);
+
+    TEST_ASSERT_TRUE(response.isValid());
+    TEST_ASSERT_EQUAL(capturedFrame.size() - 2, response.getFrameLength());
+    TEST_ASSERT_TRUE(response.getCommand() == SerialMessage::Command::ReadAll);
+    TEST_ASSERT_TRUE(response.getType() == SerialMessage::Type::Response);
+
+    TEST_ASSERT_EQUAL(46, *dp.get<Label::BatterySoCPercent>());
+    TEST_ASSERT_EQUAL_UINT32(53150, *dp.get<Label::BatteryVoltageMilliVolt>());
+    TEST_ASSERT_EQUAL_INT32(10120, *dp.get<Label::BatteryCurrentMilliAmps>());
+    TEST_ASSERT_EQUAL(26, *dp.get<Label::BmsTempCelsius>());
+    TEST_ASSERT_EQUAL(-20, *dp.get<Label::DischargeLowTempThresholdCelsius>());
+    TEST_ASSERT_EQUAL(1, *dp.get<Label::ProtocolVersion>());
+
+    auto cells = *dp.get<Label::CellsMilliVolt>();
+    TEST_ASSERT_EQUAL(16, cells.size());
+    TEST_ASSERT_EQUAL(1, cells.begin()->first);
+    TEST_ASSERT_EQUAL_UINT16(0x0cfb, cells.begin()->second);
+
+    TEST_ASSERT_EQUAL_STRING("11.XW_S11.262H_", dp.get<Label::BmsSoftwareVersion>()->c_str());
+    TEST_ASSERT_EQUAL_STRING("beki        JK_B1A24S15P", dp.get<Label::ProductId>()->c_str());
+}
+
+static void test_checksum_calculated_while_receiving()
+{
+    // the controller adds up the bytes while they arrive
+    uint16_t checksum = 0;
+    for (size_t i = 0; i < capturedFrame.size() - 4; ++i) { checksum += capturedFrame[i]; }
+
+    DataPointContainer dp;
+    SerialResponse valid({ capturedFrame.data(), capturedFrame.size() }, dp, protocolVersion, checksum);
+    TEST_ASSERT_TRUE(valid.isValid());
+
+    SerialResponse invalid({ capturedFrame.data(), capturedFrame.size() }, dp, protocolVersion, checksum + 1);
+    TEST_ASSERT_FALSE(invalid.isValid());
+}
+
+static void test_damaged_frames()
+{
+    DataPointContainer dp;
+
+    auto frame = capturedFrame;
+    frame[100] ^= 0x10;
+    TEST_ASSERT_FALSE(SerialResponse({ frame.data(), frame.size() }, dp, protocolVersion).isValid());
+
+    frame = capturedFrame;
+    frame[0] = 0x00; // start marker
+    setChecksum(frame);
+    TEST_ASSERT_FALSE(SerialResponse({ frame.data(), frame.size() }, dp, protocolVersion).isValid());
+
+    frame = capturedFrame;
+    frame[frame.size() - 5] = 0x00; // end marker
+    setChecksum(frame);
+    TEST_ASSERT_FALSE(SerialResponse({ frame.data(), frame.size() }, dp, protocolVersion).isValid());
+
+    // every length, including frames shorter than the minimum frame size.
+    // the copy is sized exactly, such that reading beyond it is detected by
+    // the address sanitizer, if enabled.
+    for (size_t len = 0; len < capturedFrame.size(); ++len) {
+        std::vector<uint8_t> truncated(capturedFrame.begin(), capturedFrame.begin() + len);
+        TEST_ASSERT_FALSE(SerialResponse({ truncated.data(), truncated.size() }, dp, protocolVersion).isValid());
+    }
+}
+
+static void test_command()
+{
+    SerialCommand cmd(SerialCommand::Command::ReadAll);
+
+    TEST_ASSERT_TRUE(cmd.isValid());
+    TEST_ASSERT_EQUAL(SerialMessage::minFrameSize, cmd.size());
+    TEST_ASSERT_EQUAL(cmd.size() - 2, cmd.getFrameLength());
+    TEST_ASSERT_TRUE(cmd.getCommand() == SerialMessage::Command::ReadAll);
+    TEST_ASSERT_TRUE(cmd.getSource() == SerialMessage::Source::Host);
+
+    uint16_t checksum = SerialMessage::calcChecksum({ cmd.data(), cmd.size() });
+    TEST_ASSERT_EQUAL_HEX16(checksum, (cmd.data()[cmd.size() - 2] << 8) | cmd.data()[cmd.size() - 1]);
+}
+
+static void test_fuzz()
+{
+    std::mt19937 rng(1234);
+    DataPointContainer dp;
+    size_t valid = 0;
+
+    for (int n = 0; n < 50000; ++n) {
+        auto frame = capturedFrame;
+
+        // flip some bytes, at least one, in the body most of the time
+        size_t flips = 1 + rng() % 8;
+        for (size_t i = 0; i < flips; ++i) {
+            frame[rng() % frame.size()] = rng();
+        }
+
+        // shorten the frame and fix its length field, such that
+        // the variable fields are parsed up to the new trailer
+        if (rng() % 4 == 0) {
+            size_t len = rng() % (frame.size() + 1);
+            frame.resize(len);
+            if (len >= SerialMessage::minFrameSize) {
+                frame[2] = (len - 2) >> 8;
+                frame[3] = (len - 2) & 0xff;
+                frame[len - 5] = SerialMessage::endMarker;
+            }
+        }
+
+        // a correct checksum makes the damaged fields being parsed
+        if (rng() % 4 != 0) { setChecksum(frame); }
+
+        // exactly sized, see test_damaged_frames()
+        frame.shrink_to_fit();
+
+        dp.clear();
+        SerialResponse response({ frame.data(), frame.size() }, dp, protocolVersion);
+        if (!response.isValid()) { continue; }
+
+        ++valid;
+        TEST_ASSERT_EQUAL(frame.size() - 2, response.getFrameLength());
+
+        auto cells = dp.get<Label::CellsMilliVolt>();
+        if (cells) { TEST_ASSERT_LESS_OR_EQUAL(tCells::MaxCells, cells->size()); }
+    }
+
+    // otherwise the fuzzer did not reach the parser of the variable fields
+    TEST_ASSERT_GREATER_THAN(10000, valid);
+}
+
+static void test_benchmark()
+{
+    constexpr int rounds = 20000;
+    DataPointContainer dp;
+    size_t valid = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        dp.clear();
+        SerialResponse response({ capturedFrame.data(), capturedFrame.size() }, dp, protocolVersion);
+        valid += response.isValid();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    TEST_ASSERT_EQUAL(rounds, valid);
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%.2f us per frame",
+        std::chrono::duration<double, std::micro>(end - start).count() / rounds);
+    TEST_MESSAGE(msg);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_captured_frame);
+    RUN_TEST(test_checksum_calculated_while_receiving);
+    RUN_TEST(test_damaged_frames);
+    RUN_TEST(test_command);
+    RUN_TEST(test_fuzz);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
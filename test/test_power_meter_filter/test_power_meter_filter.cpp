@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * feeds the power meter filter with readings containing single bogus values,
+ * which must be rejected, and genuine steps, which must be followed.
+ */
+#include <unity.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <PowerMeterFilter.cpp>
+
+using Mode = PowerMeterFilter::Mode;
+
+static constexpr uint32_t intervalMillis = 1000;
+
+// adds the readings one second apart and returns the filter's outputs
+static std::vector<float> feed(PowerMeterFilter& filter, std::vector<float> const& readings)
+{
+    std::vector<float> outputs;
+    uint32_t timestamp = filter.getLastTimestamp();
+    for (float reading : readings) {
+        timestamp += intervalMillis;
+        filter.addSample(timestamp, reading);
+        outputs.push_back(filter.getValue());
+    }
+    return outputs;
+}
+
+void setUp() { }
+void tearDown() { }
+
+static void test_none_passes_readings()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::None, 5, 3, 0);
+
+    auto outputs = feed(filter, { 300, 310, 3000, 305 });
+    TEST_ASSERT_EQUAL_FLOAT(3000, outputs[2]);
+    TEST_ASSERT_EQUAL_FLOAT(305, outputs[3]);
+    TEST_ASSERT_EQUAL(0, filter.getOutliers());
+}
+
+static void test_median_rejects_spike()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::Median, 3, 3, 0);
+
+    auto outputs = feed(filter, { 300, 310, 305, -2500, 300 });
+    TEST_ASSERT_EQUAL_FLOAT(305, outputs[3]);
+    TEST_ASSERT_EQUAL_FLOAT(300, outputs[4]);
+}
+
+static void test_hampel_rejects_spike()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::Hampel, 5, 3, 0);
+
+    // replaced by the median of 310, 290, 305, 295 and 3000
+    auto outputs = feed(filter, { 300, 310, 290, 305, 295, 3000, 300 });
+    TEST_ASSERT_EQUAL_FLOAT(305, outputs[5]);
+    TEST_ASSERT_EQUAL_FLOAT(300, outputs[6]);
+    TEST_ASSERT_EQUAL(1, filter.getOutliers());
+
+    // the raw reading is still available
+    TEST_ASSERT_EQUAL_FLOAT(300, filter.getLastSample());
+}
+
+static void test_hampel_keeps_small_changes()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::Hampel, 5, 3, 0);
+
+    // a steady signal has no deviation, but the minimum deviation of 10 W
+    // still lets changes within three times that value pass unaltered.
+    auto outputs = feed(filter, { 300, 300, 300, 300, 300, 325, 270 });
+    TEST_ASSERT_EQUAL_FLOAT(325, outputs[5]);
+    TEST_ASSERT_EQUAL_FLOAT(270, outputs[6]);
+    TEST_ASSERT_EQUAL(0, filter.getOutliers());
+}
+
+static void test_hampel_follows_step()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::Hampel, 5, 3, 0);
+
+    // e.g., an electric kettle is switched on. the first readings at the
+    // new level are considered outliers, until they are the majority.
+    auto outputs = feed(filter, { 300, 300, 300, 300, 300, 2300, 2300, 2300, 2300 });
+    TEST_ASSERT_EQUAL_FLOAT(300, outputs[5]);
+    TEST_ASSERT_EQUAL_FLOAT(300, outputs[6]);
+    TEST_ASSERT_EQUAL_FLOAT(2300, outputs[7]);
+    TEST_ASSERT_EQUAL_FLOAT(2300, outputs[8]);
+}
+
+static void test_ema_step_response()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::None, 1, 3, 2 * intervalMillis);
+
+    // the first sample initializes the average
+    auto outputs = feed(filter, { 100, 1100, 1100 });
+    TEST_ASSERT_EQUAL_FLOAT(100, outputs[0]);
+
+    // 63 % of the step are reached after one time constant, i.e., two samples
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 100 + 1000 * (1 - std::exp(-0.5f)), outputs[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 100 + 1000 * (1 - std::exp(-1.0f)), outputs[2]);
+}
+
+static void test_ema_uses_elapsed_time()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::None, 1, 3, 2 * intervalMillis);
+
+    // a reading after a long gap is taken almost as it is
+    filter.addSample(1000, 100);
+    filter.addSample(21000, 1100);
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 1100, filter.getValue());
+}
+
+static void test_hampel_then_ema()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::Hampel, 5, 3, 2 * intervalMillis);
+
+    // the spike does not reach the smoothing stage at all
+    auto outputs = feed(filter, { 300, 300, 300, 300, 300, 5000, 300 });
+    TEST_ASSERT_EQUAL_FLOAT(300, outputs[5]);
+    TEST_ASSERT_EQUAL_FLOAT(300, outputs[6]);
+    TEST_ASSERT_EQUAL(1, filter.getOutliers());
+}
+
+static void test_rate_of_change()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::Hampel, 5, 3, 0);
+
+    feed(filter, { 100, 150, 200, 250, 300 });
+    TEST_ASSERT_EQUAL(intervalMillis, filter.getSampleInterval());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 50, filter.getRateOfChange());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 50, filter.getLastRateOfChange());
+}
+
+static void test_reset()
+{
+    PowerMeterFilter filter;
+    filter.configure(Mode::Hampel, 5, 3, 0);
+
+    feed(filter, { 300, 300, 300, 300, 300, 5000 });
+    TEST_ASSERT_TRUE(filter.hasSamples());
+    TEST_ASSERT_EQUAL(1, filter.getOutliers());
+
+    filter.reset();
+    TEST_ASSERT_FALSE(filter.hasSamples());
+    TEST_ASSERT_EQUAL(0, filter.getOutliers());
+
+    // the window is empty, such that the first reading is taken as it is
+    auto outputs = feed(filter, { 5000 });
+    TEST_ASSERT_EQUAL_FLOAT(5000, outputs[0]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_none_passes_readings);
+    RUN_TEST(test_median_rejects_spike);
+    RUN_TEST(test_hampel_rejects_spike);
+    RUN_TEST(test_hampel_keeps_small_changes);
+    RUN_TEST(test_hampel_follows_step);
+    RUN_TEST(test_ema_step_response);
+    RUN_TEST(test_ema_uses_elapsed_time);
+    RUN_TEST(test_hampel_then_ema);
+    RUN_TEST(test_rate_of_change);
+    RUN_TEST(test_reset);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * feeds the voltage sag estimator with synthetic traces of a battery with a
+ * known internal resistance, i.e., V = V0 - k * P plus measurement noise.
+ */
+#include <unity.h>
+#include <cstdint>
+#include <random>
+
+#include <VoltageSagEstimator.cpp>
+
+// a battery discharged by an inverter whose load changes every sample
+class Battery {
+public:
+    Battery(float unloadedVoltage, float factor)
+        : _unloadedVoltage(unloadedVoltage)
+        , _factor(factor) { }
+
+    void setFactor(float factor) { _factor = factor; }
+
+    // the voltage drops slowly as the battery is discharged
+    void setDischargeVoltsPerSample(float volts) { _discharge = volts; }
+
+    void step(VoltageSagEstimator& estimator, float powerWatts)
+    {
+        _unloadedVoltage -= _discharge;
+        float voltage = _unloadedVoltage - _factor * powerWatts + _noise(_random);
+        estimator.addSample(voltage, powerWatts);
+    }
+
+    void step(VoltageSagEstimator& estimator)
+    {
+        step(estimator, _load(_random));
+    }
+
+    float getUnloadedVoltage() const { return _unloadedVoltage; }
+
+private:
+    float _unloadedVoltage;
+    float _factor;
+    float _discharge = 0;
+    std::mt19937 _random{42};
+    std::normal_distribution<float> _noise{0, 0.05};
+    std::uniform_real_distribution<float> _load{100, 1500};
+};
+
+void setUp() { }
+void tearDown() { }
+
+static void test_converges_to_factor()
+{
+    VoltageSagEstimator estimator;
+    Battery battery(53.2, 0.002);
+
+    for (int i = 0; i < 200; ++i) { battery.step(estimator); }
+
+    auto factor = estimator.getFactor();
+    TEST_ASSERT_TRUE(factor.has_value());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.002, *factor);
+
+    auto unloaded = estimator.getUnloadedVoltage();
+    TEST_ASSERT_TRUE(unloaded.has_value());
+    TEST_ASSERT_FLOAT_WITHIN(0.1, battery.getUnloadedVoltage(), *unloaded);
+}
+
+static void test_no_factor_with_few_samples()
+{
+    VoltageSagEstimator estimator;
+    Battery battery(53.2, 0.002);
+
+    for (int i = 0; i < 20; ++i) { battery.step(estimator); }
+
+    TEST_ASSERT_EQUAL(20, estimator.getSampleCount());
+    TEST_ASSERT_FALSE(estimator.getFactor().has_value());
+    TEST_ASSERT_FALSE(estimator.getUnloadedVoltage().has_value());
+}
+
+static void test_no_factor_with_constant_load()
+{
+    VoltageSagEstimator estimator;
+    Battery battery(53.2, 0.002);
+
+    // the voltage changes, but not due to the load
+    for (int i = 0; i < 500; ++i) { battery.step(estimator, 800); }
+
+    TEST_ASSERT_FALSE(estimator.getFactor().has_value());
+}
+
+static void test_discharge_does_not_bias_factor()
+{
+    VoltageSagEstimator estimator;
+    Battery battery(53.2, 0.002);
+    battery.setDischargeVoltsPerSample(0.002);
+
+    for (int i = 0; i < 500; ++i) { battery.step(estimator); }
+
+    auto factor = estimator.getFactor();
+    TEST_ASSERT_TRUE(factor.has_value());
+    TEST_ASSERT_FLOAT_WITHIN(0.0002, 0.002, *factor);
+}
+
+static void test_follows_changing_factor()
+{
+    VoltageSagEstimator estimator;
+    Battery battery(53.2, 0.002);
+
+    for (int i = 0; i < 300; ++i) { battery.step(estimator); }
+
+    // e.g., the battery got colder
+    battery.setFactor(0.004);
+    for (int i = 0; i < 1000; ++i) { battery.step(estimator); }
+
+    auto factor = estimator.getFactor();
+    TEST_ASSERT_TRUE(factor.has_value());
+    TEST_ASSERT_FLOAT_WITHIN(0.0002, 0.004, *factor);
+}
+
+static void test_ignores_bogus_samples()
+{
+    VoltageSagEstimator estimator;
+    Battery battery(53.2, 0.002);
+
+    for (int i = 0; i < 200; ++i) {
+        battery.step(estimator);
+        if (i % 10 == 0) {
+            estimator.addSample(0, 500); // not a valid reading
+            estimator.addSample(20, 500); // far off the estimate
+        }
+    }
+
+    auto factor = estimator.getFactor();
+    TEST_ASSERT_TRUE(factor.has_value());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.002, *factor);
+}
+
+static void test_reset()
+{
+    VoltageSagEstimator estimator;
+    Battery battery(53.2, 0.002);
+
+    for (int i = 0; i < 200; ++i) { battery.step(estimator); }
+    TEST_ASSERT_TRUE(estimator.getFactor().has_value());
+
+    estimator.reset();
+    TEST_ASSERT_EQUAL(0, estimator.getSampleCount());
+    TEST_ASSERT_FALSE(estimator.getFactor().has_value());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_converges_to_factor);
+    RUN_TEST(test_no_factor_with_few_samples);
+    RUN_TEST(test_no_factor_with_constant_load);
+    RUN_TEST(test_discharge_does_not_bias_factor);
+    RUN_TEST(test_follows_changing_factor);
+    RUN_TEST(test_ignores_bogus_samples);
+    RUN_TEST(test_reset);
+    return UNITY_END();
+}
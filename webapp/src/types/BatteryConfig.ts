@@ -1,7 +1,15 @@
+export interface AdditionalBatteryConfig {
+    provider: number;
+    current_sensor: boolean;
+    capacity: number;
+}
+
 export interface BatteryConfig {
     enabled: boolean;
     verbose_logging: boolean;
     provider: number;
+    capacity: number;
+    additional: Array<AdditionalBatteryConfig>;
     jkbms_interface: number;
     jkbms_polling_interval: number;
     mqtt_soc_topic: string;
@@ -2,9 +2,19 @@ import type { ValueObject } from '@/types/LiveDataStatus';
 
 type BatteryData = (ValueObject | string)[];
 
+export interface BatteryPack {
+    manufacturer: string;
+    data_age: number;
+    values: BatteryData[];
+    issues: number[];
+    current_sensor: boolean;
+    capacity?: number;
+}
+
 export interface Battery {
     manufacturer: string;
     data_age: number;
     values: BatteryData[];
     issues: number[];
+    packs?: BatteryPack[];
 }
\ No newline at end of file
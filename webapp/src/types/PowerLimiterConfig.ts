@@ -38,6 +38,8 @@ export interface PowerLimiterConfig {
     voltage_start_threshold: number;
     voltage_stop_threshold: number;
     voltage_load_correction_factor: number;
+    use_battery_discharge_limit: boolean;
+    battery_discharge_limit_margin: number;
     inverter_restart_hour: number;
     full_solar_passthrough_soc: number;
     full_solar_passthrough_start_voltage: number;
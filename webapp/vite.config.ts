@@ -1,6 +1,8 @@
 import { fileURLToPath, URL } from 'node:url'
+import { createHash } from 'node:crypto'
+import { gzipSync } from 'node:zlib'
 
-import { defineConfig } from 'vite'
+import { defineConfig, type Plugin } from 'vite'
 import vue from '@vitejs/plugin-vue'
 
 import viteCompression from 'vite-plugin-compression';
@@ -17,6 +19,35 @@ try {
     proxy_target = '192.168.20.110';
 }
 
+// The firmware embeds 'js/app.js.gz' by its fixed name, but index.html refers
+// to it as 'js/app.<hash>.js', <hash> being the first eight hex digits of the
+// MD5 hash of the compressed file. The firmware serves such URLs with a
+// long-lived cache header, as they change whenever the content changes.
+function contentHashedApp(): Plugin {
+  return {
+    name: 'content-hashed-app',
+    apply: 'build',
+    enforce: 'post',
+    generateBundle: {
+      order: 'post',
+      handler(_options, bundle) {
+        const app = bundle['js/app.js']
+        const html = bundle['index.html']
+        if (app?.type !== 'chunk' || html?.type !== 'asset') {
+          return
+        }
+
+        const compressed = gzipSync(app.code, { level: 9 })
+        const hash = createHash('md5').update(compressed).digest('hex').substring(0, 8)
+
+        delete bundle['js/app.js']
+        this.emitFile({ type: 'asset', fileName: 'js/app.js.gz', source: compressed })
+        html.source = html.source.toString().replace('"/js/app.js"', `"/js/app.${hash}.js"`)
+      },
+    },
+  }
+}
+
 // https://vitejs.dev/config/
 export default defineConfig({
   plugins: [
@@ -31,6 +62,7 @@ export default defineConfig({
         strictMessage: false,
         jitCompilation: false,
     }),
+    contentHashedApp(),
   ],
   resolve: {
     alias: {
@@ -48,7 +80,7 @@ export default defineConfig({
       output: {
         // Only create one js file
         inlineDynamicImports: true,
-        // Get rid of hash on js file
+        // Get rid of hash on js file, it is added by contentHashedApp()
         entryFileNames: 'js/app.js',
         // Get rid of hash on css file
         assetFileNames: "assets/[name].[ext]",